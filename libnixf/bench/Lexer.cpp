@@ -0,0 +1,124 @@
+/// \file
+/// \brief Benchmark lexing real Nix files, in MB/s.
+///
+/// The corpus is all "*.nix" files under the directory in the environment
+/// variable NIXF_BENCH_CORPUS, e.g. a nixpkgs checkout, or under the source
+/// tree of nixd by default. Tokens are lexed as the parser would, switching to
+/// strings, indented strings and paths, and back on interpolations.
+
+#include <benchmark/benchmark.h>
+
+#include "Lexer.h"
+
+#include "nixf/Basic/Diagnostic.h"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace nixf;
+using namespace tok;
+
+std::vector<std::string> loadCorpus() {
+  const char *Dir = std::getenv("NIXF_BENCH_CORPUS");
+  std::filesystem::path Root = Dir ? Dir : NIXF_BENCH_CORPUS;
+  std::vector<std::string> Files;
+  for (const auto &Entry :
+       std::filesystem::recursive_directory_iterator(Root)) {
+    if (!Entry.is_regular_file() || Entry.path().extension() != ".nix")
+      continue;
+    std::ifstream In(Entry.path(), std::ios::binary);
+    std::stringstream SS;
+    SS << In.rdbuf();
+    Files.emplace_back(SS.str());
+  }
+  return Files;
+}
+
+enum class Mode { Expr, String, IndString, Path };
+
+/// Lex \p Src like the parser, and return the number of tokens.
+std::size_t lexAll(std::string_view Src, std::vector<Diagnostic> &Diags) {
+  Lexer Lex(Src, Diags);
+  std::vector<Mode> Modes{Mode::Expr};
+  std::size_t Tokens = 0;
+  while (true) {
+    Token Tok = [&]() {
+      switch (Modes.back()) {
+      case Mode::Expr:
+        return Lex.lex();
+      case Mode::String:
+        return Lex.lexString();
+      case Mode::IndString:
+        return Lex.lexIndString();
+      case Mode::Path:
+        return Lex.lexPath();
+      }
+      __builtin_unreachable();
+    }();
+    ++Tokens;
+    if (Tok.kind() == tok_eof)
+      return Tokens;
+    switch (Tok.kind()) {
+    case tok_dquote:
+      if (Modes.back() == Mode::String)
+        Modes.pop_back();
+      else
+        Modes.emplace_back(Mode::String);
+      break;
+    case tok_quote2:
+      if (Modes.back() == Mode::IndString)
+        Modes.pop_back();
+      else
+        Modes.emplace_back(Mode::IndString);
+      break;
+    case tok_path_fragment:
+      if (Modes.back() == Mode::Expr)
+        Modes.emplace_back(Mode::Path);
+      break;
+    case tok_path_end:
+      Modes.pop_back();
+      break;
+    case tok_dollar_curly:
+    case tok_l_curly:
+      Modes.emplace_back(Mode::Expr);
+      break;
+    case tok_r_curly:
+      if (Modes.size() > 1)
+        Modes.pop_back();
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+void BM_Lex(benchmark::State &State) {
+  const std::vector<std::string> Corpus = loadCorpus();
+  std::size_t Bytes = 0;
+  for (const std::string &Src : Corpus)
+    Bytes += Src.size();
+  std::size_t Tokens = 0;
+  for (auto _ : State) {
+    Tokens = 0;
+    for (const std::string &Src : Corpus) {
+      std::vector<Diagnostic> Diags;
+      Tokens += lexAll(Src, Diags);
+    }
+    benchmark::DoNotOptimize(Tokens);
+  }
+  State.SetBytesProcessed(State.iterations() * Bytes);
+  State.counters["files"] = static_cast<double>(Corpus.size());
+  State.counters["tokens"] = static_cast<double>(Tokens);
+}
+
+BENCHMARK(BM_Lex)->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,80 @@
+/// \file
+/// \brief Benchmark building the parent map, and walking upward with it.
+///
+/// The source is a generated package set, similar to hackage-packages.nix.
+/// "BM_ParentMap" measures `runOnAST`, which is done for each document
+/// version. "BM_UpTo" walks from every node up to the enclosing attribute set
+/// and expression, as completion, definition and code actions do.
+
+#include <benchmark/benchmark.h>
+
+#include "nixf/Basic/Diagnostic.h"
+#include "nixf/Parse/Parser.h"
+#include "nixf/Sema/ParentMap.h"
+
+#include <string>
+
+namespace {
+
+using namespace nixf;
+
+std::string makePackageSet(int Packages) {
+  std::string Src = "{ pkgs, lib, callPackage, ... }:\n{\n";
+  for (int I = 0; I < Packages; ++I) {
+    std::string Name = "pkg" + std::to_string(I);
+    Src += "  " + Name + " = callPackage ({ mkDerivation, fetchurl }:\n";
+    Src += "    mkDerivation {\n";
+    Src += "      pname = \"" + Name + "\";\n";
+    Src += "      version = \"1.0." + std::to_string(I) + "\";\n";
+    Src += "      src = fetchurl { url = \"https://example.org/" + Name +
+           ".tar.gz\"; };\n";
+    Src += "      meta.description = \"Package " + Name + "\";\n";
+    Src += "    }) { };\n";
+  }
+  Src += "}\n";
+  return Src;
+}
+
+void collect(const Node *N, std::vector<const Node *> &Nodes) {
+  if (!N)
+    return;
+  Nodes.emplace_back(N);
+  for (const Node *Ch : N->children())
+    collect(Ch, Nodes);
+}
+
+void BM_ParentMap(benchmark::State &State) {
+  const std::string Src = makePackageSet(static_cast<int>(State.range(0)));
+  std::vector<Diagnostic> Diags;
+  std::shared_ptr<Node> AST = parse(Src, Diags);
+  for (auto _ : State) {
+    ParentMapAnalysis PMA;
+    PMA.runOnAST(*AST);
+    benchmark::DoNotOptimize(PMA);
+  }
+  State.SetBytesProcessed(State.iterations() * Src.size());
+}
+
+void BM_UpTo(benchmark::State &State) {
+  const std::string Src = makePackageSet(static_cast<int>(State.range(0)));
+  std::vector<Diagnostic> Diags;
+  std::shared_ptr<Node> AST = parse(Src, Diags);
+  ParentMapAnalysis PMA;
+  PMA.runOnAST(*AST);
+  std::vector<const Node *> Nodes;
+  collect(AST.get(), Nodes);
+  for (auto _ : State) {
+    for (const Node *N : Nodes) {
+      benchmark::DoNotOptimize(PMA.upTo(*N, Node::NK_ExprAttrs));
+      benchmark::DoNotOptimize(PMA.upExpr(*N));
+    }
+  }
+  State.SetItemsProcessed(State.iterations() * Nodes.size());
+}
+
+BENCHMARK(BM_ParentMap)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_UpTo)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
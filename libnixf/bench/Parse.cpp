@@ -0,0 +1,113 @@
+/// \file
+/// \brief Benchmark parsing and freeing ASTs of large files.
+///
+/// The source is a generated package set, similar to hackage-packages.nix.
+/// "BM_Parse" measures parsing and tearing down the AST, "BM_Teardown" only
+/// the latter. Heap allocations and deallocations are counted by replacing the
+/// global allocator, and reported per iteration as "allocs" and "frees",
+/// together with the number of AST nodes as "nodes" and the memory they take
+/// in the AST context as "ast_bytes".
+
+#include <benchmark/benchmark.h>
+
+#include "nixf/Basic/ASTContext.h"
+#include "nixf/Basic/Diagnostic.h"
+#include "nixf/Parse/Parser.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+namespace {
+
+std::atomic<std::size_t> Allocations;
+std::atomic<std::size_t> Deallocations;
+
+} // namespace
+
+void *operator new(std::size_t Size) {
+  Allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *Ptr = std::malloc(Size ? Size : 1))
+    return Ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *Ptr) noexcept {
+  if (Ptr)
+    Deallocations.fetch_add(1, std::memory_order_relaxed);
+  std::free(Ptr);
+}
+
+void operator delete(void *Ptr, std::size_t) noexcept { operator delete(Ptr); }
+
+namespace {
+
+using namespace nixf;
+
+std::string makePackageSet(int Packages) {
+  std::string Src = "{ pkgs, lib, callPackage, ... }:\n{\n";
+  for (int I = 0; I < Packages; ++I) {
+    std::string Name = "pkg" + std::to_string(I);
+    Src += "  " + Name + " = callPackage ({ mkDerivation, fetchurl }:\n";
+    Src += "    mkDerivation {\n";
+    Src += "      pname = \"" + Name + "\";\n";
+    Src += "      version = \"1.0." + std::to_string(I) + "\";\n";
+    Src += "      src = fetchurl { url = \"https://example.org/" + Name +
+           ".tar.gz\"; };\n";
+    Src += "      meta.description = \"Package " + Name + "\";\n";
+    Src += "      inherit (lib) licenses;\n";
+    Src += "    }) { };\n";
+  }
+  Src += "}\n";
+  return Src;
+}
+
+void report(benchmark::State &State, const std::string &Src,
+            const char *Name, std::size_t Count,
+            const std::shared_ptr<Node> &AST) {
+  std::shared_ptr<const ASTContext> Ctx = ASTContext::of(AST);
+  State.counters[Name] = benchmark::Counter(
+      static_cast<double>(Count), benchmark::Counter::kAvgIterations);
+  State.counters["nodes"] = static_cast<double>(Ctx->nodes());
+  State.counters["ast_bytes"] =
+      benchmark::Counter(static_cast<double>(Ctx->bytes()),
+                         benchmark::Counter::kDefaults,
+                         benchmark::Counter::kIs1024);
+  State.SetBytesProcessed(State.iterations() * Src.size());
+}
+
+void BM_Parse(benchmark::State &State) {
+  const std::string Src = makePackageSet(static_cast<int>(State.range(0)));
+  std::shared_ptr<Node> AST;
+  std::size_t Before = Allocations.load();
+  for (auto _ : State) {
+    std::vector<Diagnostic> Diags;
+    AST = parse(Src, Diags); // Also frees the AST of the last iteration.
+    benchmark::DoNotOptimize(AST);
+  }
+  report(State, Src, "allocs", Allocations.load() - Before, AST);
+}
+
+void BM_Teardown(benchmark::State &State) {
+  const std::string Src = makePackageSet(static_cast<int>(State.range(0)));
+  std::size_t Freed = 0;
+  for (auto _ : State) {
+    State.PauseTiming();
+    std::vector<Diagnostic> Diags;
+    std::shared_ptr<Node> AST = parse(Src, Diags);
+    std::size_t Before = Deallocations.load();
+    State.ResumeTiming();
+    AST.reset();
+    Freed += Deallocations.load() - Before;
+  }
+  std::vector<Diagnostic> Diags;
+  report(State, Src, "frees", Freed, parse(Src, Diags));
+}
+
+BENCHMARK(BM_Parse)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Teardown)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
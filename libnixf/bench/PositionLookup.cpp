@@ -0,0 +1,116 @@
+/// \file
+/// \brief Benchmark looking up the node under the cursor.
+///
+/// Every hover, completion, definition and references request starts with
+/// this lookup. "BM_Descend" uses `Node::descend`, and "BM_Lookup" uses the
+/// PositionLookupAnalysis, which is built once per document in "BM_Build".
+/// Sources are a wide package set, deeply nested attribute sets, and a long
+/// chain of binary operators.
+
+#include <benchmark/benchmark.h>
+
+#include "nixf/Basic/Diagnostic.h"
+#include "nixf/Basic/LineIndex.h"
+#include "nixf/Parse/Parser.h"
+#include "nixf/Sema/PositionLookup.h"
+
+#include <string>
+
+namespace {
+
+using namespace nixf;
+
+std::string makePackageSet(int Packages) {
+  std::string Src = "{ pkgs, lib, callPackage, ... }:\n{\n";
+  for (int I = 0; I < Packages; ++I) {
+    std::string Name = "pkg" + std::to_string(I);
+    Src += "  " + Name + " = callPackage ({ mkDerivation, fetchurl }:\n";
+    Src += "    mkDerivation {\n";
+    Src += "      pname = \"" + Name + "\";\n";
+    Src += "      version = \"1.0." + std::to_string(I) + "\";\n";
+    Src += "      src = fetchurl { url = \"https://example.org/" + Name +
+           ".tar.gz\"; };\n";
+    Src += "      meta.description = \"Package " + Name + "\";\n";
+    Src += "    }) { };\n";
+  }
+  Src += "}\n";
+  return Src;
+}
+
+std::string makeNestedAttrs(int Depth) {
+  std::string Src;
+  for (int I = 0; I < Depth; ++I)
+    Src += "{ a" + std::to_string(I) + " = 1;\n  b = ";
+  Src += "1";
+  for (int I = 0; I < Depth; ++I)
+    Src += "; }";
+  return Src + "\n";
+}
+
+std::string makeOperatorChain(int Length) {
+  std::string Src = "x0";
+  for (int I = 1; I < Length; ++I)
+    Src += (I % 8 ? " + x" : "\n  + x") + std::to_string(I);
+  return Src + "\n";
+}
+
+/// About a thousand positions, spread over the source.
+std::vector<Position> samplePositions(const std::string &Src) {
+  LineIndex Lines(Src);
+  std::vector<Position> Positions;
+  std::size_t Step = Src.size() / 1000 + 1;
+  for (std::size_t Offset = 0; Offset < Src.size(); Offset += Step)
+    Positions.emplace_back(Lines.cursor(Offset).position());
+  return Positions;
+}
+
+void BM_Descend(benchmark::State &State, const std::string &Src) {
+  std::vector<Diagnostic> Diags;
+  std::shared_ptr<Node> AST = parse(Src, Diags);
+  std::vector<Position> Positions = samplePositions(Src);
+  for (auto _ : State) {
+    for (Position Pos : Positions)
+      benchmark::DoNotOptimize(AST->descend(PositionRange{Pos}));
+  }
+  State.SetItemsProcessed(State.iterations() * Positions.size());
+}
+
+void BM_Lookup(benchmark::State &State, const std::string &Src) {
+  std::vector<Diagnostic> Diags;
+  std::shared_ptr<Node> AST = parse(Src, Diags);
+  PositionLookupAnalysis PLA;
+  PLA.runOnAST(*AST);
+  std::vector<Position> Positions = samplePositions(Src);
+  for (auto _ : State) {
+    for (Position Pos : Positions)
+      benchmark::DoNotOptimize(PLA.descend(PositionRange{Pos}));
+  }
+  State.SetItemsProcessed(State.iterations() * Positions.size());
+}
+
+void BM_Build(benchmark::State &State, const std::string &Src) {
+  std::vector<Diagnostic> Diags;
+  std::shared_ptr<Node> AST = parse(Src, Diags);
+  for (auto _ : State) {
+    PositionLookupAnalysis PLA;
+    PLA.runOnAST(*AST);
+    benchmark::DoNotOptimize(PLA);
+  }
+  State.SetBytesProcessed(State.iterations() * Src.size());
+}
+
+#define SOURCES(BM)                                                            \
+  BENCHMARK_CAPTURE(BM, packages, makePackageSet(10000))                       \
+      ->Unit(benchmark::kMicrosecond);                                         \
+  BENCHMARK_CAPTURE(BM, nested, makeNestedAttrs(500))                          \
+      ->Unit(benchmark::kMicrosecond);                                         \
+  BENCHMARK_CAPTURE(BM, operators, makeOperatorChain(2000))                    \
+      ->Unit(benchmark::kMicrosecond);
+
+SOURCES(BM_Descend)
+SOURCES(BM_Lookup)
+SOURCES(BM_Build)
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,97 @@
+/// \file
+/// \brief Benchmark keystroke-to-diagnostics latency on large files.
+///
+/// The source is a generated package set, similar to hackage-packages.nix.
+/// Each iteration inserts a character, then re-runs the parser and variable
+/// lookup analysis, as the language server does for "textDocument/didChange".
+
+#include <benchmark/benchmark.h>
+
+#include "nixf/Basic/Diagnostic.h"
+#include "nixf/Parse/Parser.h"
+#include "nixf/Sema/VariableLookup.h"
+
+#include <string>
+
+namespace {
+
+using namespace nixf;
+
+std::string makePackageSet(int Packages) {
+  std::string Src = "{ pkgs, lib, callPackage, ... }:\n{\n";
+  for (int I = 0; I < Packages; ++I) {
+    std::string Name = "pkg" + std::to_string(I);
+    Src += "  " + Name + " = callPackage ({ mkDerivation, fetchurl }:\n";
+    Src += "    mkDerivation {\n";
+    Src += "      pname = \"" + Name + "\";\n";
+    Src += "      version = \"1.0." + std::to_string(I) + "\";\n";
+    Src += "      src = fetchurl { url = \"https://example.org/" + Name +
+           ".tar.gz\"; };\n";
+    Src += "      meta.description = \"Package " + Name + "\";\n";
+    Src += "    }) { };\n";
+  }
+  Src += "}\n";
+  return Src;
+}
+
+/// Offset of the package at \p Percent of the file, right after its "=".
+std::size_t editOffset(const std::string &Src, int Packages, int Percent) {
+  std::string Name = "pkg" + std::to_string(Packages * Percent / 100) + " =";
+  return Src.find(Name) + Name.size();
+}
+
+void analyze(const std::shared_ptr<Node> &AST,
+             std::vector<Diagnostic> &Diags) {
+  VariableLookupAnalysis VLA(Diags);
+  VLA.runOnAST(*AST);
+}
+
+void BM_FullParse(benchmark::State &State) {
+  const int Packages = static_cast<int>(State.range(0));
+  std::string Src = makePackageSet(Packages);
+  std::size_t Offset = editOffset(Src, Packages, State.range(1));
+  for (auto _ : State) {
+    Src.insert(Offset, " ");
+    std::vector<Diagnostic> Diags;
+    auto AST = parse(Src, Diags);
+    analyze(AST, Diags);
+    benchmark::DoNotOptimize(AST);
+  }
+  State.SetBytesProcessed(State.iterations() * Src.size());
+}
+
+void BM_Reparse(benchmark::State &State) {
+  const int Packages = static_cast<int>(State.range(0));
+  std::string Src = makePackageSet(Packages);
+  std::size_t Offset = editOffset(Src, Packages, State.range(1));
+  std::vector<Diagnostic> Diags;
+  std::shared_ptr<Node> AST = parse(Src, Diags);
+  for (auto _ : State) {
+    std::string NewSrc = Src;
+    NewSrc.insert(Offset, " ");
+    std::vector<Diagnostic> NewDiags;
+    std::shared_ptr<Node> NewAST = reparse(NewSrc, Src, AST, Diags, NewDiags);
+    std::vector<Diagnostic> ParseDiags = NewDiags;
+    analyze(NewAST, NewDiags);
+    benchmark::DoNotOptimize(NewAST);
+
+    State.PauseTiming();
+    Src = std::move(NewSrc);
+    AST = std::move(NewAST);
+    Diags = std::move(ParseDiags);
+    State.ResumeTiming();
+  }
+  State.SetBytesProcessed(State.iterations() * Src.size());
+}
+
+// Arguments: number of packages, position of the edit (percent).
+BENCHMARK(BM_FullParse)
+    ->ArgsProduct({{1000, 5000}, {10, 50, 90}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Reparse)
+    ->ArgsProduct({{1000, 5000}, {10, 50, 90}})
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,113 @@
+/// \file
+/// \brief Benchmark traversing the whole AST.
+///
+/// The source is a generated package set, similar to hackage-packages.nix.
+/// "BM_Children" recurses with `Node::children()`, as traversals used to.
+/// "BM_Recursive" and "BM_Iterative" use `RecursiveASTVisitor`, on the thread
+/// stack and on an explicit stack.
+
+#include <benchmark/benchmark.h>
+
+#include "nixf/Basic/Diagnostic.h"
+#include "nixf/Basic/RecursiveASTVisitor.h"
+#include "nixf/Parse/Parser.h"
+
+#include <string>
+
+namespace {
+
+using namespace nixf;
+
+std::string makePackageSet(int Packages) {
+  std::string Src = "{ pkgs, lib, callPackage, ... }:\n{\n";
+  for (int I = 0; I < Packages; ++I) {
+    std::string Name = "pkg" + std::to_string(I);
+    Src += "  " + Name + " = callPackage ({ mkDerivation, fetchurl }:\n";
+    Src += "    mkDerivation {\n";
+    Src += "      pname = \"" + Name + "\";\n";
+    Src += "      version = \"1.0." + std::to_string(I) + "\";\n";
+    Src += "      src = fetchurl { url = \"https://example.org/" + Name +
+           ".tar.gz\"; };\n";
+    Src += "      meta.description = \"Package " + Name + "\";\n";
+    Src += "    }) { };\n";
+  }
+  Src += "}\n";
+  return Src;
+}
+
+void countChildren(const Node *N, std::size_t &Count) {
+  if (!N)
+    return;
+  ++Count;
+  for (const Node *Ch : N->children())
+    countChildren(Ch, Count);
+}
+
+struct Counter : RecursiveASTVisitor<Counter> {
+  std::size_t Count = 0;
+  bool visit(const Node &) {
+    ++Count;
+    return true;
+  }
+};
+
+void BM_Children(benchmark::State &State) {
+  const std::string Src = makePackageSet(static_cast<int>(State.range(0)));
+  std::vector<Diagnostic> Diags;
+  std::shared_ptr<Node> AST = parse(Src, Diags);
+  std::size_t Count = 0;
+  for (auto _ : State) {
+    Count = 0;
+    countChildren(AST.get(), Count);
+    benchmark::DoNotOptimize(Count);
+  }
+  State.SetItemsProcessed(State.iterations() * Count);
+}
+
+void BM_Recursive(benchmark::State &State) {
+  const std::string Src = makePackageSet(static_cast<int>(State.range(0)));
+  std::vector<Diagnostic> Diags;
+  std::shared_ptr<Node> AST = parse(Src, Diags);
+  std::size_t Count = 0;
+  for (auto _ : State) {
+    Counter C;
+    C.traverse(AST.get());
+    Count = C.Count;
+    benchmark::DoNotOptimize(Count);
+  }
+  State.SetItemsProcessed(State.iterations() * Count);
+}
+
+void BM_Iterative(benchmark::State &State) {
+  const std::string Src = makePackageSet(static_cast<int>(State.range(0)));
+  std::vector<Diagnostic> Diags;
+  std::shared_ptr<Node> AST = parse(Src, Diags);
+  std::size_t Count = 0;
+  for (auto _ : State) {
+    Counter C;
+    C.traverseIteratively(AST.get());
+    Count = C.Count;
+    benchmark::DoNotOptimize(Count);
+  }
+  State.SetItemsProcessed(State.iterations() * Count);
+}
+
+BENCHMARK(BM_Children)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Recursive)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Iterative)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,93 @@
+/// \file
+/// \brief Benchmark variable lookup, and querying its results.
+///
+/// The source is a generated package set, similar to all-packages.nix: a large
+/// recursive attribute set under `with`, with `let` bindings and lambdas in
+/// each package. "BM_VariableLookup" measures `runOnAST`, which is done for
+/// each document version. "BM_Query" looks up every variable, as semantic
+/// tokens do.
+
+#include <benchmark/benchmark.h>
+
+#include "nixf/Basic/Diagnostic.h"
+#include "nixf/Basic/RecursiveASTVisitor.h"
+#include "nixf/Parse/Parser.h"
+#include "nixf/Sema/VariableLookup.h"
+
+#include <string>
+
+namespace {
+
+using namespace nixf;
+
+std::string makePackageSet(int Packages) {
+  std::string Src = "{ lib, pkgs, config, ... }:\n"
+                    "let\n"
+                    "  inherit (lib) optional optionals mkIf;\n"
+                    "  callPackage = pkgs.callPackage;\n"
+                    "in\n"
+                    "with pkgs;\n"
+                    "rec {\n";
+  for (int I = 0; I < Packages; ++I) {
+    std::string Name = "pkg" + std::to_string(I);
+    std::string Dep = I > 0 ? "pkg" + std::to_string(I - 1) : "hello";
+    Src += "  " + Name + " = callPackage ./pkgs/" + Name + " {\n";
+    Src += "    inherit stdenv fetchurl;\n";
+    Src += "    dep = " + Dep + ";\n";
+    Src += "  };\n";
+    Src += "  " + Name + "-wrapped = let\n";
+    Src += "    enable = config." + Name + ".enable or false;\n";
+    Src += "    inner = " + Name + ".override { inherit enable; };\n";
+    Src += "  in if lib.isDerivation inner then inner else null;\n";
+    Src += "  " + Name + "-fun = { a, b ? " + Dep + " }: a ++ optional b " +
+           Name + ";\n";
+  }
+  Src += "}\n";
+  return Src;
+}
+
+struct VarCollector : RecursiveASTVisitor<VarCollector> {
+  std::vector<const ExprVar *> Vars;
+  bool visit(const ExprVar &Var) {
+    Vars.emplace_back(&Var);
+    return true;
+  }
+};
+
+void BM_VariableLookup(benchmark::State &State) {
+  const std::string Src = makePackageSet(static_cast<int>(State.range(0)));
+  std::vector<Diagnostic> Diags;
+  std::shared_ptr<Node> AST = parse(Src, Diags);
+  for (auto _ : State) {
+    std::vector<Diagnostic> VLADiags;
+    VariableLookupAnalysis VLA(VLADiags);
+    VLA.runOnAST(*AST);
+    benchmark::DoNotOptimize(VLA);
+  }
+  State.SetBytesProcessed(State.iterations() * Src.size());
+}
+
+void BM_Query(benchmark::State &State) {
+  const std::string Src = makePackageSet(static_cast<int>(State.range(0)));
+  std::vector<Diagnostic> Diags;
+  std::shared_ptr<Node> AST = parse(Src, Diags);
+  VariableLookupAnalysis VLA(Diags);
+  VLA.runOnAST(*AST);
+  VarCollector C;
+  C.traverse(AST.get());
+  for (auto _ : State) {
+    for (const ExprVar *Var : C.Vars)
+      benchmark::DoNotOptimize(VLA.query(*Var));
+  }
+  State.SetItemsProcessed(State.iterations() * C.Vars.size());
+}
+
+BENCHMARK(BM_VariableLookup)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Query)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,99 @@
+/// \file
+/// \brief Memory of AST nodes.
+///
+/// All nodes of a parse are bump-allocated in one ASTContext, and refer to each
+/// other by raw pointers. They are destroyed together with the context.
+#pragma once
+
+#include "nixf/Basic/LineIndex.h"
+#include "nixf/Basic/Nodes/Basic.h"
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace nixf {
+
+class ASTContext {
+  struct Slab {
+    std::unique_ptr<std::byte[]> Begin;
+    std::size_t Size;
+  };
+
+  std::vector<Slab> Slabs;
+  std::byte *Cur = nullptr;
+  std::byte *End = nullptr;
+  std::size_t Bytes = 0;
+
+  /// Lines of the source, nodes only store offsets into it.
+  LineIndex Lines;
+
+  /// Nodes to be destroyed, in the order of creation.
+  std::vector<Node *> Nodes;
+
+  /// Contexts owning nodes shared with this one, e.g. by incremental parsing.
+  std::vector<std::shared_ptr<const ASTContext>> Deps;
+
+  void *allocate(std::size_t Size, std::size_t Align);
+
+public:
+  ASTContext() = default;
+
+  /// \brief A context for nodes of \p Src.
+  explicit ASTContext(std::string_view Src) : Lines(Src) {}
+  ASTContext(const ASTContext &) = delete;
+  ASTContext &operator=(const ASTContext &) = delete;
+  ~ASTContext();
+
+  /// \brief Allocate and construct a node, owned by this context.
+  template <class T, class... ArgTys> T *create(ArgTys &&...Args) {
+    static_assert(std::is_base_of_v<Node, T>, "only nodes live in ASTContext");
+    void *Mem = allocate(sizeof(T), alignof(T));
+    T *N = new (Mem) T(std::forward<ArgTys>(Args)...);
+    N->Ctx = this;
+    N->Index = Nodes.size();
+    Nodes.emplace_back(N);
+    return N;
+  }
+
+  /// \brief Check if \p N is allocated in this context.
+  [[nodiscard]] bool owns(const Node *N) const;
+
+  /// \brief Keep \p Ctx alive as long as this context, because some nodes
+  /// created here refer to nodes there.
+  void retain(std::shared_ptr<const ASTContext> Ctx);
+
+  /// \brief Contexts retained by this one.
+  [[nodiscard]] const std::vector<std::shared_ptr<const ASTContext>> &
+  deps() const {
+    return Deps;
+  }
+
+  /// \brief Number of nodes created in this context.
+  [[nodiscard]] std::size_t nodes() const { return Nodes.size(); }
+
+  /// \brief Bytes allocated for nodes in this context.
+  [[nodiscard]] std::size_t bytes() const { return Bytes; }
+
+  /// \brief Lines of the source, where positions of nodes are looked up.
+  [[nodiscard]] const LineIndex &lines() const { return Lines; }
+
+  /// \brief Create a context for \p Src that could be found by `of()` later.
+  static std::shared_ptr<ASTContext> make(std::string_view Src = {});
+
+  /// \brief Share ownership of \p Ctx with the node \p Root allocated in it.
+  static std::shared_ptr<Node> share(std::shared_ptr<ASTContext> Ctx,
+                                     Node *Root);
+
+  /// \brief The context owning \p AST, returned by `share()`.
+  ///
+  /// \returns nullptr if \p AST is not owned by a context.
+  static std::shared_ptr<const ASTContext>
+  of(const std::shared_ptr<Node> &AST);
+};
+
+} // namespace nixf
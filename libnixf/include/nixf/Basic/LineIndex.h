@@ -0,0 +1,41 @@
+/// \file
+/// \brief Line table of a source file.
+///
+/// AST nodes only store byte offsets. Lines and columns are recovered from
+/// this table on demand.
+#pragma once
+
+#include "nixf/Basic/Range.h"
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace nixf {
+
+class LineIndex {
+  /// Offsets of the first byte of each line. The first line starts at 0.
+  std::vector<std::uint32_t> Starts;
+
+public:
+  /// \brief A table of a single line, every offset maps to line 0.
+  LineIndex() : Starts{0} {}
+
+  /// \brief Build the table of \p Src, in one pass.
+  explicit LineIndex(std::string_view Src);
+
+  /// \brief Number of lines.
+  [[nodiscard]] std::size_t lines() const { return Starts.size(); }
+
+  /// \brief Offset of the first byte of line \p Line.
+  [[nodiscard]] std::size_t lineStart(std::size_t Line) const {
+    return Starts[Line];
+  }
+
+  /// \brief Cursor (line, column, offset) of the byte \p Offset.
+  ///
+  /// Columns are counted in bytes, as the lexer does.
+  [[nodiscard]] LexerCursor cursor(std::size_t Offset) const;
+};
+
+} // namespace nixf
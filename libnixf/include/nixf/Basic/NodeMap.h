@@ -0,0 +1,75 @@
+/// \file
+/// \brief Maps from AST nodes to values of analyses.
+///
+/// Nodes allocated in an ASTContext are numbered by `Node::index()`, so values
+/// are kept in a vector per context, and each lookup is an array access.
+
+#pragma once
+
+#include "nixf/Basic/ASTContext.h"
+#include "nixf/Basic/Nodes/Basic.h"
+
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace nixf {
+
+/// \brief Map from nodes to \p T.
+///
+/// Nodes that were never assigned have a value-initialized \p T, so analyses
+/// use a value like nullptr for "not found".
+template <class T> class NodeMap {
+  using ValueVector = std::vector<T>;
+
+  /// Values of nodes of each context. An AST is allocated in one context, or
+  /// a few after incremental parsing.
+  std::vector<std::pair<const ASTContext *, ValueVector>> Dense;
+
+  /// Values of nodes not allocated in any context.
+  std::map<const Node *, T> Detached;
+
+public:
+  /// \brief The value of \p N, or nullptr if no node near it was assigned.
+  [[nodiscard]] const T *find(const Node &N) const {
+    if (const ASTContext *Ctx = N.context()) {
+      for (const auto &[C, Values] : Dense) {
+        if (C == Ctx)
+          return N.index() < Values.size() ? &Values[N.index()] : nullptr;
+      }
+      return nullptr;
+    }
+    auto It = Detached.find(&N);
+    return It != Detached.end() ? &It->second : nullptr;
+  }
+
+  /// \brief The value of \p N, or a value-initialized \p T.
+  [[nodiscard]] T lookup(const Node &N) const {
+    const T *V = find(N);
+    return V ? *V : T{};
+  }
+
+  /// \brief The value of \p N, to be assigned.
+  T &operator[](const Node &N) {
+    const ASTContext *Ctx = N.context();
+    if (!Ctx)
+      return Detached[&N];
+    auto It = std::find_if(Dense.begin(), Dense.end(),
+                           [&](const auto &P) { return P.first == Ctx; });
+    if (It == Dense.end())
+      It = Dense.emplace(It, Ctx, ValueVector());
+    ValueVector &Values = It->second;
+    // Nodes may be created after the first assignment, e.g. in tests.
+    if (N.index() >= Values.size())
+      Values.resize(std::max(Ctx->nodes(), N.index() + 1));
+    return Values[N.index()];
+  }
+
+  void clear() {
+    Dense.clear();
+    Detached.clear();
+  }
+};
+
+} // namespace nixf
@@ -13,27 +13,26 @@ public:
 
 private:
   const AttrNameKind Kind;
-  const std::shared_ptr<Identifier> ID;
-  const std::shared_ptr<ExprString> String;
-  const std::shared_ptr<Interpolation> Interp;
+  Identifier *const ID = nullptr;
+  ExprString *const String = nullptr;
+  Interpolation *const Interp = nullptr;
 
 public:
   [[nodiscard]] AttrNameKind kind() const { return Kind; }
 
-  AttrName(std::shared_ptr<Identifier> ID, LexerCursorRange Range)
-      : Node(NK_AttrName, Range), Kind(ANK_ID), ID(std::move(ID)) {
+  AttrName(Identifier *ID, LexerCursorRange Range)
+      : Node(NK_AttrName, Range), Kind(ANK_ID), ID(ID) {
     assert(this->ID && "ID must not be null");
   }
 
-  AttrName(std::shared_ptr<ExprString> String)
-      : Node(NK_AttrName, String->range()), Kind(ANK_String),
-        String(std::move(String)) {
+  AttrName(ExprString *String)
+      : Node(NK_AttrName, String->range()), Kind(ANK_String), String(String) {
     assert(this->String && "String must not be null");
   }
 
-  AttrName(std::shared_ptr<Interpolation> Interp)
+  AttrName(Interpolation *Interp)
       : Node(NK_AttrName, Interp->range()), Kind(ANK_Interpolation),
-        Interp(std::move(Interp)) {
+        Interp(Interp) {
     assert(this->Interp && "Interpolation must not be null");
   }
 
@@ -61,7 +60,7 @@ public:
     return *Interp;
   }
 
-  [[nodiscard]] const std::shared_ptr<Identifier> &id() const {
+  [[nodiscard]] Identifier *id() const {
     assert(Kind == ANK_ID);
     return ID;
   }
@@ -72,14 +71,17 @@ public:
     return *String;
   }
 
-  [[nodiscard]] ChildVector children() const override {
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
     switch (Kind) {
     case ANK_ID:
-      return {ID.get()};
+      Visit(ID);
+      return;
     case ANK_String:
-      return {String.get()};
+      Visit(String);
+      return;
     case ANK_Interpolation:
-      return {Interp.get()};
+      Visit(Interp);
+      return;
     default:
       assert(false && "invalid AttrNameKind");
     }
@@ -88,42 +90,37 @@ public:
 };
 
 class AttrPath : public Node {
-  const std::vector<std::shared_ptr<AttrName>> Names;
-  const std::vector<std::shared_ptr<Dot>> Dots;
+  const std::vector<AttrName *> Names;
+  const std::vector<Dot *> Dots;
 
 public:
-  AttrPath(LexerCursorRange Range, std::vector<std::shared_ptr<AttrName>> Names,
-           std::vector<std::shared_ptr<Dot>> Dots)
+  AttrPath(LexerCursorRange Range, std::vector<AttrName *> Names,
+           std::vector<Dot *> Dots)
       : Node(NK_AttrPath, Range), Names(std::move(Names)),
         Dots(std::move(Dots)) {}
 
-  [[nodiscard]] const std::vector<std::shared_ptr<AttrName>> &names() const {
+  [[nodiscard]] const std::vector<AttrName *> &names() const {
     return Names;
   }
 
-  [[nodiscard]] ChildVector children() const override {
-    ChildVector Children;
-    Children.reserve(Names.size() + Dots.size());
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
     for (const auto &Name : Names)
-      Children.push_back(Name.get());
+      Visit(Name);
     for (const auto &Dot : Dots)
-      Children.emplace_back(Dot.get());
-    return Children;
+      Visit(Dot);
   }
 };
 
 class Binding : public Node {
-  const std::shared_ptr<AttrPath> Path;
-  const std::shared_ptr<Expr> Value;
+  AttrPath *const Path;
+  Expr *const Value;
   // Represents the '=' token in the syntax tree
   // preserving its position and presence.
-  const std::shared_ptr<Misc> Eq;
+  Misc *const Eq;
 
 public:
-  Binding(LexerCursorRange Range, std::shared_ptr<AttrPath> Path,
-          std::shared_ptr<Expr> Value, std::shared_ptr<Misc> Eq)
-      : Node(NK_Binding, Range), Path(std::move(Path)), Value(std::move(Value)),
-        Eq(std::move(Eq)) {
+  Binding(LexerCursorRange Range, AttrPath *Path, Expr *Value, Misc *Eq)
+      : Node(NK_Binding, Range), Path(Path), Value(Value), Eq(Eq) {
     assert(this->Path && "Path must not be null");
     // Value can be null, if missing in the syntax.
   }
@@ -133,61 +130,54 @@ public:
     return *Path;
   }
 
-  [[nodiscard]] const std::shared_ptr<Expr> &value() const { return Value; }
+  [[nodiscard]] Expr *value() const { return Value; }
 
-  [[nodiscard]] const std::shared_ptr<Misc> &eq() const { return Eq; }
+  [[nodiscard]] Misc *eq() const { return Eq; }
 
-  [[nodiscard]] ChildVector children() const override {
-    return {Path.get(), Eq.get(), Value.get()};
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
+    Visit(Path);
+    Visit(Eq);
+    Visit(Value);
   }
 };
 
 class Inherit : public Node {
-  const std::vector<std::shared_ptr<AttrName>> Names;
-  const std::shared_ptr<Expr> E;
+  const std::vector<AttrName *> Names;
+  Expr *const E;
 
 public:
-  Inherit(LexerCursorRange Range, std::vector<std::shared_ptr<AttrName>> Names,
-          std::shared_ptr<Expr> E)
-      : Node(NK_Inherit, Range), Names(std::move(Names)), E(std::move(E)) {}
+  Inherit(LexerCursorRange Range, std::vector<AttrName *> Names, Expr *E)
+      : Node(NK_Inherit, Range), Names(std::move(Names)), E(E) {}
 
-  [[nodiscard]] const std::vector<std::shared_ptr<AttrName>> &names() const {
+  [[nodiscard]] const std::vector<AttrName *> &names() const {
     return Names;
   }
 
   [[nodiscard]] bool hasExpr() { return E != nullptr; }
 
-  [[nodiscard]] const std::shared_ptr<Expr> &expr() const { return E; }
+  [[nodiscard]] Expr *expr() const { return E; }
 
-  [[nodiscard]] ChildVector children() const override {
-    ChildVector Children;
-    Children.reserve(Names.size() + 1);
-    for (const auto &Name : Names) {
-      Children.push_back(Name.get());
-    }
-    Children.push_back(E.get());
-    return Children;
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
+    for (const auto &Name : Names)
+      Visit(Name);
+    Visit(E);
   }
 };
 
 class Binds : public Node {
-  const std::vector<std::shared_ptr<Node>> Bindings;
+  const std::vector<Node *> Bindings;
 
 public:
-  Binds(LexerCursorRange Range, std::vector<std::shared_ptr<Node>> Bindings)
+  Binds(LexerCursorRange Range, std::vector<Node *> Bindings)
       : Node(NK_Binds, Range), Bindings(std::move(Bindings)) {}
 
-  [[nodiscard]] const std::vector<std::shared_ptr<Node>> &bindings() const {
+  [[nodiscard]] const std::vector<Node *> &bindings() const {
     return Bindings;
   }
 
-  [[nodiscard]] ChildVector children() const override {
-    ChildVector Children;
-    Children.reserve(Bindings.size());
-    for (const auto &Binding : Bindings) {
-      Children.push_back(Binding.get());
-    }
-    return Children;
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
+    for (const auto &Binding : Bindings)
+      Visit(Binding);
   }
 };
 
@@ -203,20 +193,19 @@ public:
   };
 
 private:
-  const std::shared_ptr<Node> Key;
-  const std::shared_ptr<Expr> Value;
+  Node *const Key;
+  Expr *const Value;
   AttributeKind Kind;
 
 public:
-  Attribute(std::shared_ptr<Node> Key, std::shared_ptr<Expr> Value,
-            AttributeKind Kind)
-      : Key(std::move(Key)), Value(std::move(Value)), Kind(Kind) {
+  Attribute(Node *Key, Expr *Value, AttributeKind Kind)
+      : Key(Key), Value(Value), Kind(Kind) {
     assert(this->Key && "Key must not be null");
   }
 
   [[nodiscard]] Node &key() const { return *Key; }
 
-  [[nodiscard]] Expr *value() const { return Value.get(); }
+  [[nodiscard]] Expr *value() const { return Value; }
 
   [[nodiscard]] AttributeKind kind() const { return Kind; }
 
@@ -270,26 +259,25 @@ public:
 };
 
 class ExprAttrs : public Expr {
-  const std::shared_ptr<Binds> Body;
-  const std::shared_ptr<Misc> Rec;
+  Binds *const Body;
+  Misc *const Rec;
   SemaAttrs SA; // Let this mutable for "Sema" class only.
   friend class Sema;
 
 public:
-  ExprAttrs(LexerCursorRange Range, std::shared_ptr<Binds> Body,
-            std::shared_ptr<Misc> Rec, SemaAttrs SA)
-      : Expr(NK_ExprAttrs, Range), Body(std::move(Body)), Rec(std::move(Rec)),
-        SA(std::move(SA)) {}
+  ExprAttrs(LexerCursorRange Range, Binds *Body, Misc *Rec, SemaAttrs SA)
+      : Expr(NK_ExprAttrs, Range), Body(Body), Rec(Rec), SA(std::move(SA)) {}
 
-  [[nodiscard]] const Binds *binds() const { return Body.get(); }
-  [[nodiscard]] const Misc *rec() const { return Rec.get(); }
+  [[nodiscard]] const Binds *binds() const { return Body; }
+  [[nodiscard]] const Misc *rec() const { return Rec; }
 
   [[nodiscard]] bool isRecursive() const { return Rec != nullptr; }
 
   [[nodiscard]] const SemaAttrs &sema() const { return SA; }
 
-  [[nodiscard]] ChildVector children() const override {
-    return {Body.get(), Rec.get()};
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
+    Visit(Body);
+    Visit(Rec);
   }
 };
 
@@ -5,10 +5,13 @@
 #include <boost/container/small_vector.hpp>
 
 #include <cassert>
+#include <cstdint>
 #include <string>
 
 namespace nixf {
 
+class ASTContext;
+
 class Node {
 public:
   enum NodeKind {
@@ -24,24 +27,55 @@ public:
 
 private:
   NodeKind Kind;
-  LexerCursorRange Range;
+  std::uint32_t LOffset;
+  std::uint32_t ROffset;
+  std::uint32_t Index = 0;
+
+  /// The context allocating this node, where lines of the source are.
+  /// Nodes created elsewhere have no lines, their columns are offsets.
+  const ASTContext *Ctx = nullptr;
+
+  friend class ASTContext;
+
+  [[nodiscard]] LexerCursor cursor(std::uint32_t Offset) const;
 
 protected:
   explicit Node(NodeKind Kind, LexerCursorRange Range)
-      : Kind(Kind), Range(Range) {}
+      : Kind(Kind), LOffset(Range.lCur().offset()),
+        ROffset(Range.rCur().offset()) {}
 
 public:
   [[nodiscard]] NodeKind kind() const { return Kind; }
-  [[nodiscard]] LexerCursorRange range() const { return Range; }
-  [[nodiscard]] PositionRange positionRange() const { return Range.range(); }
-  [[nodiscard]] LexerCursor lCur() const { return Range.lCur(); }
-  [[nodiscard]] LexerCursor rCur() const { return Range.rCur(); }
+  [[nodiscard]] LexerCursorRange range() const { return {lCur(), rCur()}; }
+  [[nodiscard]] PositionRange positionRange() const { return range().range(); }
+  [[nodiscard]] LexerCursor lCur() const { return cursor(LOffset); }
+  [[nodiscard]] LexerCursor rCur() const { return cursor(ROffset); }
+
+  /// \brief Offset of the beginning, without looking up lines.
+  [[nodiscard]] std::size_t lOffset() const { return LOffset; }
+
+  /// \brief Offset of the end, without looking up lines.
+  [[nodiscard]] std::size_t rOffset() const { return ROffset; }
+
+  /// \brief The context allocating this node, or nullptr.
+  [[nodiscard]] const ASTContext *context() const { return Ctx; }
+
+  /// \brief Index of this node in its context, in the order of creation.
+  ///
+  /// Indices are dense, so analyses could keep per-node data in vectors.
+  [[nodiscard]] std::size_t index() const { return Index; }
+
   [[nodiscard]] static const char *name(NodeKind Kind);
   [[nodiscard]] const char *name() const { return name(Kind); }
 
   using ChildVector = boost::container::small_vector<Node *, 8>;
 
-  [[nodiscard]] virtual ChildVector children() const = 0;
+  /// \brief Children of this node, null ones included.
+  ///
+  /// Each concrete node lists its children in `forEachChild`, which does not
+  /// allocate. Traversals should use `nixf::forEachChild` or
+  /// `RecursiveASTVisitor` instead.
+  [[nodiscard]] ChildVector children() const;
 
   virtual ~Node() = default;
 
@@ -61,9 +95,7 @@ public:
   }
 
   [[nodiscard]] std::string_view src(std::string_view Src) const {
-    auto Begin = lCur().offset();
-    auto Length = rCur().offset() - Begin;
-    return Src.substr(Begin, Length);
+    return Src.substr(LOffset, ROffset - LOffset);
   }
 };
 
@@ -107,7 +139,7 @@ class Misc : public Node {
 public:
   Misc(LexerCursorRange Range) : Node(NK_Misc, Range) {}
 
-  [[nodiscard]] ChildVector children() const override { return {}; }
+  template <class VisitFn> void forEachChild(VisitFn && /*Visit*/) const {}
 };
 
 /// \brief Identifier. Variable names, attribute names, etc.
@@ -119,7 +151,7 @@ public:
       : Node(NK_Identifier, Range), Name(std::move(Name)) {}
   [[nodiscard]] const std::string &name() const { return Name; }
 
-  [[nodiscard]] ChildVector children() const override { return {}; }
+  template <class VisitFn> void forEachChild(VisitFn && /*Visit*/) const {}
 };
 
 /// \brief Holds a "." in the language.
@@ -133,7 +165,7 @@ public:
     assert(Prev);
   }
 
-  [[nodiscard]] ChildVector children() const override { return {}; }
+  template <class VisitFn> void forEachChild(VisitFn && /*Visit*/) const {}
 
   [[nodiscard]] const Node &prev() const {
     assert(Prev);
@@ -5,18 +5,16 @@
 namespace nixf {
 
 class ExprSelect : public Expr {
-  const std::shared_ptr<Expr> E;
-  const std::shared_ptr<Dot> Do;
-  const std::shared_ptr<AttrPath> Path;
-  const std::shared_ptr<Expr> Default;
+  Expr *const E;
+  Dot *const Do;
+  AttrPath *const Path;
+  Expr *const Default;
   const Expr *DesugaredFrom;
 
 public:
-  ExprSelect(LexerCursorRange Range, std::shared_ptr<Expr> E,
-             std::shared_ptr<Dot> Do, std::shared_ptr<AttrPath> Path,
-             std::shared_ptr<Expr> Default, const Expr *DesugaredFrom)
-      : Expr(NK_ExprSelect, Range), E(std::move(E)), Do(std::move(Do)),
-        Path(std::move(Path)), Default(std::move(Default)),
+  ExprSelect(LexerCursorRange Range, Expr *E, Dot *Do, AttrPath *Path,
+             Expr *Default, const Expr *DesugaredFrom)
+      : Expr(NK_ExprSelect, Range), E(E), Do(Do), Path(Path), Default(Default),
         DesugaredFrom(DesugaredFrom) {
     assert(this->E && "E must not be null");
   }
@@ -28,26 +26,27 @@ public:
 
   [[nodiscard]] const Expr *desugaredFrom() const { return DesugaredFrom; }
 
-  [[nodiscard]] Dot *dot() const { return Do.get(); }
+  [[nodiscard]] Dot *dot() const { return Do; }
 
-  [[nodiscard]] Expr *defaultExpr() const { return Default.get(); }
+  [[nodiscard]] Expr *defaultExpr() const { return Default; }
 
-  [[nodiscard]] AttrPath *path() const { return Path.get(); }
+  [[nodiscard]] AttrPath *path() const { return Path; }
 
-  [[nodiscard]] ChildVector children() const override {
-    return {E.get(), Path.get(), Default.get()};
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
+    Visit(E);
+    Visit(Path);
+    Visit(Default);
   }
 };
 
 /// A call/apply to some function.
 class ExprCall : public Expr {
-  const std::shared_ptr<Expr> Fn;
-  const std::vector<std::shared_ptr<Expr>> Args;
+  Expr *const Fn;
+  const std::vector<Expr *> Args;
 
 public:
-  ExprCall(LexerCursorRange Range, std::shared_ptr<Expr> Fn,
-           std::vector<std::shared_ptr<Expr>> Args)
-      : Expr(NK_ExprCall, Range), Fn(std::move(Fn)), Args(std::move(Args)) {
+  ExprCall(LexerCursorRange Range, Expr *Fn, std::vector<Expr *> Args)
+      : Expr(NK_ExprCall, Range), Fn(Fn), Args(std::move(Args)) {
     assert(this->Fn && "Fn must not be null");
   }
 
@@ -56,152 +55,144 @@ public:
     return *Fn;
   }
 
-  [[nodiscard]] const std::vector<std::shared_ptr<Expr>> &args() const {
+  [[nodiscard]] const std::vector<Expr *> &args() const {
     return Args;
   }
 
-  [[nodiscard]] ChildVector children() const override {
-    ChildVector Children;
-    Children.reserve(Args.size() + 1);
-    Children.emplace_back(Fn.get());
-    for (const auto &Member : Args) {
-      Children.emplace_back(Member.get());
-    }
-    return Children;
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
+    Visit(Fn);
+    for (const auto &Member : Args)
+      Visit(Member);
   }
 };
 
 class ExprList : public Expr {
-  const std::vector<std::shared_ptr<Expr>> Elements;
+  const std::vector<Expr *> Elements;
 
 public:
-  ExprList(LexerCursorRange Range, std::vector<std::shared_ptr<Expr>> Elements)
+  ExprList(LexerCursorRange Range, std::vector<Expr *> Elements)
       : Expr(NK_ExprList, Range), Elements(std::move(Elements)) {}
 
-  [[nodiscard]] const std::vector<std::shared_ptr<Expr>> &elements() const {
+  [[nodiscard]] const std::vector<Expr *> &elements() const {
     return Elements;
   }
 
-  [[nodiscard]] ChildVector children() const override {
-    ChildVector Children;
-    Children.reserve(Elements.size());
-    for (const auto &Element : Elements) {
-      Children.emplace_back(Element.get());
-    }
-    return Children;
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
+    for (const auto &Element : Elements)
+      Visit(Element);
   }
 };
 
 class ExprIf : public Expr {
-  const std::shared_ptr<Expr> Cond;
-  const std::shared_ptr<Expr> Then;
-  const std::shared_ptr<Expr> Else;
+  Expr *const Cond;
+  Expr *const Then;
+  Expr *const Else;
 
 public:
-  ExprIf(LexerCursorRange Range, std::shared_ptr<Expr> Cond,
-         std::shared_ptr<Expr> Then, std::shared_ptr<Expr> Else)
-      : Expr(NK_ExprIf, Range), Cond(std::move(Cond)), Then(std::move(Then)),
-        Else(std::move(Else)) {}
+  ExprIf(LexerCursorRange Range, Expr *Cond, Expr *Then, Expr *Else)
+      : Expr(NK_ExprIf, Range), Cond(Cond), Then(Then), Else(Else) {}
 
-  [[nodiscard]] Expr *cond() const { return Cond.get(); }
-  [[nodiscard]] Expr *then() const { return Then.get(); }
-  [[nodiscard]] Expr *elseExpr() const { return Else.get(); }
+  [[nodiscard]] Expr *cond() const { return Cond; }
+  [[nodiscard]] Expr *then() const { return Then; }
+  [[nodiscard]] Expr *elseExpr() const { return Else; }
 
-  [[nodiscard]] ChildVector children() const override {
-    return {Cond.get(), Then.get(), Else.get()};
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
+    Visit(Cond);
+    Visit(Then);
+    Visit(Else);
   }
 };
 
 class ExprAssert : public Expr {
-  const std::shared_ptr<Expr> Cond;
-  const std::shared_ptr<Expr>
-      Value; // If "cond" is true, then "value" is returned.
+  Expr *const Cond;
+  Expr *const Value; // If "cond" is true, then "value" is returned.
 
 public:
-  ExprAssert(LexerCursorRange Range, std::shared_ptr<Expr> Cond,
-             std::shared_ptr<Expr> Value)
-      : Expr(NK_ExprAssert, Range), Cond(std::move(Cond)),
-        Value(std::move(Value)) {}
+  ExprAssert(LexerCursorRange Range, Expr *Cond, Expr *Value)
+      : Expr(NK_ExprAssert, Range), Cond(Cond), Value(Value) {}
 
-  [[nodiscard]] Expr *cond() const { return Cond.get(); }
-  [[nodiscard]] Expr *value() const { return Value.get(); }
+  [[nodiscard]] Expr *cond() const { return Cond; }
+  [[nodiscard]] Expr *value() const { return Value; }
 
-  [[nodiscard]] ChildVector children() const override {
-    return {Cond.get(), Value.get()};
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
+    Visit(Cond);
+    Visit(Value);
   }
 };
 
 class ExprLet : public Expr {
   // 'let' binds 'in' expr
 
-  const std::shared_ptr<Misc> KwLet; // 'let', not null
-  const std::shared_ptr<Misc> KwIn;
-  const std::shared_ptr<Expr> E;
+  Misc *const KwLet; // 'let', not null
+  Misc *const KwIn;
+  Expr *const E;
 
-  const std::shared_ptr<ExprAttrs> Attrs;
+  ExprAttrs *const Attrs;
 
 public:
-  ExprLet(LexerCursorRange Range, std::shared_ptr<Misc> KwLet,
-          std::shared_ptr<Misc> KwIn, std::shared_ptr<Expr> E,
-          std::shared_ptr<ExprAttrs> Attrs)
-      : Expr(NK_ExprLet, Range), KwLet(std::move(KwLet)), KwIn(std::move(KwIn)),
-        E(std::move(E)), Attrs(std::move(Attrs)) {
+  ExprLet(LexerCursorRange Range, Misc *KwLet, Misc *KwIn, Expr *E,
+          ExprAttrs *Attrs)
+      : Expr(NK_ExprLet, Range), KwLet(KwLet), KwIn(KwIn), E(E), Attrs(Attrs) {
     assert(this->KwLet && "KwLet should not be empty!");
   }
 
   [[nodiscard]] const Binds *binds() const {
     return Attrs ? Attrs->binds() : nullptr;
   }
-  [[nodiscard]] const ExprAttrs *attrs() const { return Attrs.get(); }
-  [[nodiscard]] const Expr *expr() const { return E.get(); }
+  [[nodiscard]] const ExprAttrs *attrs() const { return Attrs; }
+  [[nodiscard]] const Expr *expr() const { return E; }
   [[nodiscard]] const Misc &let() const { return *KwLet; }
-  [[nodiscard]] const Misc *in() const { return KwIn.get(); }
+  [[nodiscard]] const Misc *in() const { return KwIn; }
 
-  [[nodiscard]] ChildVector children() const override {
-    return {KwLet.get(), Attrs.get(), KwIn.get(), E.get()};
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
+    Visit(KwLet);
+    Visit(Attrs);
+    Visit(KwIn);
+    Visit(E);
   }
 };
 
 class ExprLegacyLet : public Expr {
-  const std::shared_ptr<Misc> KwLet;
-  const std::shared_ptr<ExprAttrs> Attrs;
+  Misc *const KwLet;
+  ExprAttrs *const Attrs;
 
 public:
-  ExprLegacyLet(LexerCursorRange Range, std::shared_ptr<Misc> KwLet,
-                std::shared_ptr<ExprAttrs> Attrs)
-      : Expr(NK_ExprLegacyLet, Range), KwLet(std::move(KwLet)),
-        Attrs(std::move(Attrs)) {
+  ExprLegacyLet(LexerCursorRange Range, Misc *KwLet, ExprAttrs *Attrs)
+      : Expr(NK_ExprLegacyLet, Range), KwLet(KwLet), Attrs(Attrs) {
     assert(this->KwLet && "KwLet should not be empty!");
   }
 
   [[nodiscard]] const Misc &let() const { return *KwLet; }
-  [[nodiscard]] const ExprAttrs *attrs() const { return Attrs.get(); }
+  [[nodiscard]] const ExprAttrs *attrs() const { return Attrs; }
 
-  [[nodiscard]] ChildVector children() const override {
-    return {KwLet.get(), Attrs.get()};
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
+    Visit(KwLet);
+    Visit(Attrs);
   }
 };
 
 class ExprWith : public Expr {
-  const std::shared_ptr<Misc> KwWith;
-  const std::shared_ptr<Misc> TokSemi;
-  const std::shared_ptr<Expr> With;
-  const std::shared_ptr<Expr> E;
+  Misc *const KwWith;
+  Misc *const TokSemi;
+  Expr *const With;
+  Expr *const E;
 
 public:
-  ExprWith(LexerCursorRange Range, std::shared_ptr<Misc> KwWith,
-           std::shared_ptr<Misc> TokSemi, std::shared_ptr<Expr> With,
-           std::shared_ptr<Expr> E)
-      : Expr(NK_ExprWith, Range), KwWith(std::move(KwWith)),
-        TokSemi(std::move(TokSemi)), With(std::move(With)), E(std::move(E)) {}
+  ExprWith(LexerCursorRange Range, Misc *KwWith, Misc *TokSemi, Expr *With,
+           Expr *E)
+      : Expr(NK_ExprWith, Range), KwWith(KwWith), TokSemi(TokSemi), With(With),
+        E(E) {}
 
   [[nodiscard]] const Misc &kwWith() const { return *KwWith; }
-  [[nodiscard]] const Misc *tokSemi() const { return TokSemi.get(); }
-  [[nodiscard]] Expr *with() const { return With.get(); }
-  [[nodiscard]] Expr *expr() const { return E.get(); }
-
-  [[nodiscard]] ChildVector children() const override {
-    return {KwWith.get(), TokSemi.get(), With.get(), E.get()};
+  [[nodiscard]] const Misc *tokSemi() const { return TokSemi; }
+  [[nodiscard]] Expr *with() const { return With; }
+  [[nodiscard]] Expr *expr() const { return E; }
+
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
+    Visit(KwWith);
+    Visit(TokSemi);
+    Visit(With);
+    Visit(E);
   }
 };
 
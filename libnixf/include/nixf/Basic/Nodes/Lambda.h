@@ -3,27 +3,22 @@
 #include "Basic.h"
 
 #include <map>
-#include <memory>
 #include <vector>
 
 namespace nixf {
 
 class Formal : public Node {
-  const std::shared_ptr<Misc> Comma;
-  const std::shared_ptr<Identifier> ID;
-  const std::shared_ptr<Expr> Default;
-  const std::shared_ptr<Misc> Ellipsis; // ...
+  Misc *const Comma;
+  Identifier *const ID = nullptr;
+  Expr *const Default = nullptr;
+  Misc *const Ellipsis = nullptr; // ...
 
 public:
-  Formal(LexerCursorRange Range, std::shared_ptr<Misc> Comma,
-         std::shared_ptr<Identifier> ID, std::shared_ptr<Expr> Default)
-      : Node(NK_Formal, Range), Comma(std::move(Comma)), ID(std::move(ID)),
-        Default(std::move(Default)) {}
-
-  Formal(LexerCursorRange Range, std::shared_ptr<Misc> Comma,
-         std::shared_ptr<Misc> Ellipsis)
-      : Node(NK_Formal, Range), Comma(std::move(Comma)),
-        Ellipsis(std::move(Ellipsis)) {
+  Formal(LexerCursorRange Range, Misc *Comma, Identifier *ID, Expr *Default)
+      : Node(NK_Formal, Range), Comma(Comma), ID(ID), Default(Default) {}
+
+  Formal(LexerCursorRange Range, Misc *Comma, Misc *Ellipsis)
+      : Node(NK_Formal, Range), Comma(Comma), Ellipsis(Ellipsis) {
     assert(this->Ellipsis && "Ellipsis must not be null");
   }
 
@@ -34,17 +29,19 @@ public:
 
   [[nodiscard]] bool isEllipsis() const { return Ellipsis != nullptr; }
 
-  [[nodiscard]] Identifier *id() const { return ID.get(); }
+  [[nodiscard]] Identifier *id() const { return ID; }
 
-  [[nodiscard]] Misc *comma() const { return Comma.get(); }
+  [[nodiscard]] Misc *comma() const { return Comma; }
 
-  [[nodiscard]] Expr *defaultExpr() const { return Default.get(); }
+  [[nodiscard]] Expr *defaultExpr() const { return Default; }
 
-  [[nodiscard]] ChildVector children() const override {
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
     if (isEllipsis()) {
-      return {Ellipsis.get()};
+      Visit(Ellipsis);
+      return;
     }
-    return {ID.get(), Default.get()};
+    Visit(ID);
+    Visit(Default);
   }
 };
 
@@ -56,13 +53,13 @@ public:
 /// 2. Ellipsis can only occur once.
 ///        { b, ..., a, ... } -> { a, ... }
 class Formals : public Node {
-  const std::vector<std::shared_ptr<Formal>> Members;
+  const std::vector<Formal *> Members;
 
   /// Deduplicated formals, useful for encoding
   const std::map<std::string, const Formal *> Dedup;
 
 public:
-  using FormalVector = std::vector<std::shared_ptr<Formal>>;
+  using FormalVector = std::vector<Formal *>;
   Formals(LexerCursorRange Range, FormalVector Members,
           std::map<std::string, const Formal *> Dedup)
       : Node(NK_Formals, Range), Members(std::move(Members)),
@@ -77,49 +74,48 @@ public:
     return Dedup;
   }
 
-  [[nodiscard]] ChildVector children() const override {
-    ChildVector Children;
-    Children.reserve(Members.size());
-    for (const auto &Member : Members) {
-      Children.emplace_back(Member.get());
-    }
-    return Children;
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
+    for (const auto &Member : Members)
+      Visit(Member);
   }
 };
 
 class LambdaArg : public Node {
-  const std::shared_ptr<Identifier> ID;
-  const std::shared_ptr<Formals> F;
+  Identifier *const ID;
+  Formals *const F;
 
 public:
-  LambdaArg(LexerCursorRange Range, std::shared_ptr<Identifier> ID,
-            std::shared_ptr<Formals> F)
-      : Node(NK_LambdaArg, Range), ID(std::move(ID)), F(std::move(F)) {}
+  LambdaArg(LexerCursorRange Range, Identifier *ID, Formals *F)
+      : Node(NK_LambdaArg, Range), ID(ID), F(F) {}
 
-  [[nodiscard]] Identifier *id() const { return ID.get(); }
+  [[nodiscard]] Identifier *id() const { return ID; }
 
-  [[nodiscard]] Formals *formals() const { return F.get(); }
+  [[nodiscard]] Formals *formals() const { return F; }
 
-  [[nodiscard]] ChildVector children() const override {
-    return {ID.get(), F.get()};
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
+    Visit(ID);
+    Visit(F);
   }
 };
 
 class ExprLambda : public Expr {
-  const std::shared_ptr<LambdaArg> Arg;
-  const std::shared_ptr<Expr> Body;
+  LambdaArg *const Arg;
+  Expr *const Body;
+
+  // Incremental parsing shares "Arg" with the previous AST.
+  friend class Parser;
 
 public:
-  ExprLambda(LexerCursorRange Range, std::shared_ptr<LambdaArg> Arg,
-             std::shared_ptr<Expr> Body)
-      : Expr(NK_ExprLambda, Range), Arg(std::move(Arg)), Body(std::move(Body)) {
+  ExprLambda(LexerCursorRange Range, LambdaArg *Arg, Expr *Body)
+      : Expr(NK_ExprLambda, Range), Arg(Arg), Body(Body) {
   }
 
-  [[nodiscard]] LambdaArg *arg() const { return Arg.get(); }
-  [[nodiscard]] Expr *body() const { return Body.get(); }
+  [[nodiscard]] LambdaArg *arg() const { return Arg; }
+  [[nodiscard]] Expr *body() const { return Body; }
 
-  [[nodiscard]] ChildVector children() const override {
-    return {Arg.get(), Body.get()};
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
+    Visit(Arg);
+    Visit(Body);
   }
 };
 
@@ -5,7 +5,6 @@
 
 #include "nixf/Basic/Nodes/Attrs.h"
 
-#include <memory>
 
 namespace nixf {
 
@@ -18,72 +17,69 @@ public:
 
   [[nodiscard]] tok::TokenKind op() const { return OpKind; }
 
-  [[nodiscard]] ChildVector children() const override { return {}; }
+  template <class VisitFn> void forEachChild(VisitFn && /*Visit*/) const {}
 };
 
 /// \brief Abstract class for binary operators and unary operators.
 class ExprOp : public Expr {
-  const std::shared_ptr<Op> O;
+  Op *const O;
 
 public:
-  ExprOp(NodeKind Kind, LexerCursorRange Range, std::shared_ptr<Op> O)
-      : Expr(Kind, Range), O(std::move(O)) {
+  ExprOp(NodeKind Kind, LexerCursorRange Range, Op *O)
+      : Expr(Kind, Range), O(O) {
     assert(this->O && "O must not be null");
   }
 
   [[nodiscard]] Op &op() const { return *O; }
-
-  [[nodiscard]] ChildVector children() const override { return {O.get()}; }
 };
 
 class ExprBinOp : public ExprOp {
-  const std::shared_ptr<Expr> LHS;
-  const std::shared_ptr<Expr> RHS;
+  Expr *const LHS;
+  Expr *const RHS;
 
 public:
-  ExprBinOp(LexerCursorRange Range, std::shared_ptr<Op> O,
-            std::shared_ptr<Expr> LHS, std::shared_ptr<Expr> RHS)
-      : ExprOp(NK_ExprBinOp, Range, std::move(O)), LHS(std::move(LHS)),
-        RHS(std::move(RHS)) {}
+  ExprBinOp(LexerCursorRange Range, Op *O, Expr *LHS, Expr *RHS)
+      : ExprOp(NK_ExprBinOp, Range, O), LHS(LHS), RHS(RHS) {}
 
-  [[nodiscard]] Expr *lhs() const { return LHS.get(); }
-  [[nodiscard]] Expr *rhs() const { return RHS.get(); }
+  [[nodiscard]] Expr *lhs() const { return LHS; }
+  [[nodiscard]] Expr *rhs() const { return RHS; }
 
-  [[nodiscard]] ChildVector children() const override {
-    return {&op(), LHS.get(), RHS.get()};
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
+    Visit(&op());
+    Visit(LHS);
+    Visit(RHS);
   }
 };
 
 class ExprOpHasAttr : public ExprOp {
-  const std::shared_ptr<Expr> E;
-  const std::shared_ptr<AttrPath> Path;
+  Expr *const E;
+  AttrPath *const Path;
 
 public:
-  ExprOpHasAttr(LexerCursorRange Range, std::shared_ptr<Op> O,
-                std::shared_ptr<Expr> E, std::shared_ptr<AttrPath> Path)
-      : ExprOp(NK_ExprOpHasAttr, Range, std::move(O)), E(std::move(E)),
-        Path(std::move(Path)) {}
+  ExprOpHasAttr(LexerCursorRange Range, Op *O, Expr *E, AttrPath *Path)
+      : ExprOp(NK_ExprOpHasAttr, Range, O), E(E), Path(Path) {}
 
-  [[nodiscard]] Expr *expr() const { return E.get(); }
-  [[nodiscard]] AttrPath *attrpath() const { return Path.get(); }
+  [[nodiscard]] Expr *expr() const { return E; }
+  [[nodiscard]] AttrPath *attrpath() const { return Path; }
 
-  [[nodiscard]] ChildVector children() const override {
-    return {E.get(), Path.get()};
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
+    Visit(E);
+    Visit(Path);
   }
 };
 
 class ExprUnaryOp : public ExprOp {
-  const std::shared_ptr<Expr> E;
+  Expr *const E;
 
 public:
-  ExprUnaryOp(LexerCursorRange Range, std::shared_ptr<Op> O,
-              std::shared_ptr<Expr> E)
-      : ExprOp(NK_ExprUnaryOp, Range, std::move(O)), E(std::move(E)) {}
+  ExprUnaryOp(LexerCursorRange Range, Op *O, Expr *E)
+      : ExprOp(NK_ExprUnaryOp, Range, O), E(E) {}
 
-  [[nodiscard]] Expr *expr() const { return E.get(); }
+  [[nodiscard]] Expr *expr() const { return E; }
 
-  [[nodiscard]] ChildVector children() const override {
-    return {&op(), E.get()};
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
+    Visit(&op());
+    Visit(E);
   }
 };
 
@@ -4,7 +4,6 @@
 
 #include <boost/container/small_vector.hpp>
 
-#include <memory>
 #include <vector>
 
 namespace nixf {
@@ -20,7 +19,7 @@ public:
       : Expr(NK_ExprInt, Range), Value(Value) {}
   [[nodiscard]] NixInt value() const { return Value; }
 
-  [[nodiscard]] ChildVector children() const override { return {}; }
+  template <class VisitFn> void forEachChild(VisitFn && /*Visit*/) const {}
 };
 
 class ExprFloat : public Expr {
@@ -31,20 +30,22 @@ public:
       : Expr(NK_ExprFloat, Range), Value(Value) {}
   [[nodiscard]] NixFloat value() const { return Value; }
 
-  [[nodiscard]] ChildVector children() const override { return {}; }
+  template <class VisitFn> void forEachChild(VisitFn && /*Visit*/) const {}
 };
 
 /// \brief `${expr}` construct
 class Interpolation : public Node {
-  const std::shared_ptr<Expr> E;
+  Expr *const E;
 
 public:
-  Interpolation(LexerCursorRange Range, std::shared_ptr<Expr> E)
-      : Node(NK_Interpolation, Range), E(std::move(E)) {}
+  Interpolation(LexerCursorRange Range, Expr *E)
+      : Node(NK_Interpolation, Range), E(E) {}
 
-  [[nodiscard]] Expr *expr() const { return E.get(); }
+  [[nodiscard]] Expr *expr() const { return E; }
 
-  [[nodiscard]] ChildVector children() const override { return {E.get()}; }
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
+    Visit(E);
+  }
 };
 
 class InterpolablePart {
@@ -57,14 +58,14 @@ public:
 private:
   const InterpolablePartKind Kind;
   const std::string Escaped;
-  const std::shared_ptr<Interpolation> Interp;
+  Interpolation *const Interp;
 
 public:
   explicit InterpolablePart(std::string Escaped)
       : Kind(SPK_Escaped), Escaped(std::move(Escaped)), Interp(nullptr) {}
 
-  explicit InterpolablePart(std::shared_ptr<Interpolation> Interp)
-      : Kind(SPK_Interpolation), Interp(std::move(Interp)) {
+  explicit InterpolablePart(Interpolation *Interp)
+      : Kind(SPK_Interpolation), Interp(Interp) {
     assert(this->Interp && "interpolation must not be null");
   }
 
@@ -103,22 +104,20 @@ public:
     return Fragments[0].escaped();
   }
 
-  [[nodiscard]] ChildVector children() const override {
-    ChildVector Children;
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
     for (const auto &Frag : Fragments) {
       if (Frag.kind() == InterpolablePart::SPK_Interpolation)
-        Children.emplace_back(&Frag.interpolation());
+        Visit(&Frag.interpolation());
     }
-    return Children;
   }
 };
 
 class ExprString : public Expr {
-  const std::shared_ptr<InterpolatedParts> Parts;
+  InterpolatedParts *const Parts;
 
 public:
-  ExprString(LexerCursorRange Range, std::shared_ptr<InterpolatedParts> Parts)
-      : Expr(NK_ExprString, Range), Parts(std::move(Parts)) {
+  ExprString(LexerCursorRange Range, InterpolatedParts *Parts)
+      : Expr(NK_ExprString, Range), Parts(Parts) {
     assert(this->Parts && "parts must not be null");
   }
 
@@ -137,15 +136,17 @@ public:
     return Parts->literal();
   }
 
-  [[nodiscard]] ChildVector children() const override { return {Parts.get()}; }
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
+    Visit(Parts);
+  }
 };
 
 class ExprPath : public Expr {
-  std::shared_ptr<InterpolatedParts> Parts;
+  InterpolatedParts *Parts;
 
 public:
-  ExprPath(LexerCursorRange Range, std::shared_ptr<InterpolatedParts> Parts)
-      : Expr(NK_ExprPath, Range), Parts(std::move(Parts)) {
+  ExprPath(LexerCursorRange Range, InterpolatedParts *Parts)
+      : Expr(NK_ExprPath, Range), Parts(Parts) {
     assert(this->Parts && "parts must not be null");
   }
 
@@ -154,7 +155,9 @@ public:
     return *Parts;
   }
 
-  [[nodiscard]] ChildVector children() const override { return {Parts.get()}; }
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
+    Visit(Parts);
+  }
 };
 
 class ExprSPath : public Expr {
@@ -164,37 +167,37 @@ public:
   ExprSPath(LexerCursorRange Range, std::string Text)
       : Expr(NK_ExprSPath, Range), Text(std::move(Text)) {}
 
-  [[nodiscard]] ChildVector children() const override { return {}; }
+  template <class VisitFn> void forEachChild(VisitFn && /*Visit*/) const {}
 
   [[nodiscard]] const std::string &text() const { return Text; }
 };
 
 class ExprParen : public Expr {
-  const std::shared_ptr<Expr> E;
-  const std::shared_ptr<Misc> LParen;
-  const std::shared_ptr<Misc> RParen;
+  Expr *const E;
+  Misc *const LParen;
+  Misc *const RParen;
 
 public:
-  ExprParen(LexerCursorRange Range, std::shared_ptr<Expr> E,
-            std::shared_ptr<Misc> LParen, std::shared_ptr<Misc> RParen)
-      : Expr(NK_ExprParen, Range), E(std::move(E)), LParen(std::move(LParen)),
-        RParen(std::move(RParen)) {}
+  ExprParen(LexerCursorRange Range, Expr *E, Misc *LParen, Misc *RParen)
+      : Expr(NK_ExprParen, Range), E(E), LParen(LParen), RParen(RParen) {}
 
-  [[nodiscard]] const Expr *expr() const { return E.get(); }
-  [[nodiscard]] const Misc *lparen() const { return LParen.get(); }
-  [[nodiscard]] const Misc *rparen() const { return RParen.get(); }
+  [[nodiscard]] const Expr *expr() const { return E; }
+  [[nodiscard]] const Misc *lparen() const { return LParen; }
+  [[nodiscard]] const Misc *rparen() const { return RParen; }
 
-  [[nodiscard]] ChildVector children() const override {
-    return {E.get(), LParen.get(), RParen.get()};
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
+    Visit(E);
+    Visit(LParen);
+    Visit(RParen);
   }
 };
 
 class ExprVar : public Expr {
-  const std::shared_ptr<Identifier> ID;
+  Identifier *const ID;
 
 public:
-  ExprVar(LexerCursorRange Range, std::shared_ptr<Identifier> ID)
-      : Expr(NK_ExprVar, Range), ID(std::move(ID)) {
+  ExprVar(LexerCursorRange Range, Identifier *ID)
+      : Expr(NK_ExprVar, Range), ID(ID) {
     assert(this->ID && "ID must not be null");
   }
   [[nodiscard]] const Identifier &id() const {
@@ -202,7 +205,9 @@ public:
     return *ID;
   }
 
-  [[nodiscard]] ChildVector children() const override { return {ID.get()}; }
+  template <class VisitFn> void forEachChild(VisitFn &&Visit) const {
+    Visit(ID);
+  }
 };
 
 } // namespace nixf
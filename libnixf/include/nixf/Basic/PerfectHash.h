@@ -0,0 +1,131 @@
+/// \file
+/// \brief Perfect hash tables of names known at build time.
+///
+/// Keys are hashed into buckets, and each bucket has a seed that maps its keys
+/// into distinct slots ("hash and displace"). A lookup hashes the key twice,
+/// and compares it with the only key in its slot. Generators compute the seeds
+/// once, and emit keys and values in slot order.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace nixf {
+
+/// \brief Seeded FNV-1a, with a final mix so that `% N` of it is uniform.
+///
+/// \note tokens.py has a copy of this function, keep them in sync.
+constexpr std::uint32_t perfectHash(std::uint32_t Seed, std::string_view S) {
+  std::uint32_t H = 2166136261U ^ Seed;
+  for (char Ch : S) {
+    H ^= static_cast<unsigned char>(Ch);
+    H *= 16777619U;
+  }
+  H ^= H >> 16;
+  H *= 0x45d9f3bU;
+  H ^= H >> 16;
+  return H;
+}
+
+/// \brief The slot of \p Key, in a table of `Seeds.size()` slots.
+///
+/// The slot must be compared with \p Key, as unknown keys are also mapped to
+/// some slot.
+constexpr std::size_t perfectHashSlot(std::span<const std::uint32_t> Seeds,
+                                      std::string_view Key) {
+  const std::size_t N = Seeds.size();
+  if (N == 0)
+    return 0;
+  const std::uint32_t Seed = Seeds[perfectHash(0, Key) % N];
+  return perfectHash(Seed, Key) % N;
+}
+
+/// \brief Seeds of buckets, and slots of keys, see `layoutPerfectHash`.
+struct PerfectHashLayout {
+  std::vector<std::uint32_t> Seeds;
+  std::vector<std::uint32_t> Slots;
+};
+
+/// \brief Find seeds that map \p Keys to distinct slots.
+///
+/// \p Keys must be unique. Buckets with more keys are placed first, when most
+/// slots are still free.
+constexpr PerfectHashLayout
+layoutPerfectHash(std::span<const std::string_view> Keys) {
+  const std::size_t N = Keys.size();
+  PerfectHashLayout Layout{std::vector<std::uint32_t>(N),
+                           std::vector<std::uint32_t>(N)};
+  std::vector<std::vector<std::size_t>> Buckets(N);
+  for (std::size_t I = 0; I < N; ++I)
+    Buckets[perfectHash(0, Keys[I]) % N].push_back(I);
+
+  std::vector<std::size_t> Order(N);
+  for (std::size_t B = 0; B < N; ++B)
+    Order[B] = B;
+  std::sort(Order.begin(), Order.end(), [&](std::size_t L, std::size_t R) {
+    if (Buckets[L].size() != Buckets[R].size())
+      return Buckets[L].size() > Buckets[R].size();
+    return L < R;
+  });
+
+  std::vector<bool> Used(N);
+  std::vector<std::size_t> Slots;
+  for (std::size_t B : Order) {
+    const std::vector<std::size_t> &Bucket = Buckets[B];
+    if (Bucket.empty())
+      break;
+    for (std::uint32_t Seed = 1;; ++Seed) {
+      Slots.clear();
+      for (std::size_t I : Bucket) {
+        std::size_t Slot = perfectHash(Seed, Keys[I]) % N;
+        if (Used[Slot] ||
+            std::find(Slots.begin(), Slots.end(), Slot) != Slots.end())
+          break;
+        Slots.push_back(Slot);
+      }
+      if (Slots.size() != Bucket.size())
+        continue;
+      Layout.Seeds[B] = Seed;
+      for (std::size_t J = 0; J < Bucket.size(); ++J) {
+        Used[Slots[J]] = true;
+        Layout.Slots[Bucket[J]] = Slots[J];
+      }
+      break;
+    }
+  }
+  return Layout;
+}
+
+/// \brief A set of \p N names, laid out at compile time.
+template <std::size_t N> class PerfectHashSet {
+  std::array<std::uint32_t, N> Seeds{};
+  std::array<std::string_view, N> Keys{};
+
+public:
+  consteval PerfectHashSet(const std::string_view (&Names)[N]) {
+    PerfectHashLayout Layout = layoutPerfectHash(Names);
+    for (std::size_t I = 0; I < N; ++I) {
+      Seeds[I] = Layout.Seeds[I];
+      Keys[Layout.Slots[I]] = Names[I];
+    }
+  }
+
+  [[nodiscard]] constexpr bool contains(std::string_view Name) const {
+    return N != 0 && Keys[perfectHashSlot(Seeds, Name)] == Name;
+  }
+
+  [[nodiscard]] constexpr auto begin() const { return Keys.begin(); }
+  [[nodiscard]] constexpr auto end() const { return Keys.end(); }
+  [[nodiscard]] constexpr std::size_t size() const { return N; }
+};
+
+template <std::size_t N>
+PerfectHashSet(const std::string_view (&)[N]) -> PerfectHashSet<N>;
+
+} // namespace nixf
@@ -52,13 +52,13 @@ public:
 /// \brief A point in the source file.
 ///
 /// This class is used to represent a point in the source file. And it shall be
-/// constructed by Lexer, to keep Line & Column information correct.
-/// \see Lexer::consume(std::size_t)
+/// constructed from a line table, to keep Line & Column information correct.
+/// Fields are 32-bit, source files larger than 4GiB are not supported.
+/// \see LineIndex::cursor(std::size_t)
 class LexerCursor {
-  int64_t Line;
-  int64_t Column;
-  std::size_t Offset;
-  friend class Lexer;
+  uint32_t Line;
+  uint32_t Column;
+  uint32_t Offset;
   LexerCursor(int64_t Line, int64_t Column, std::size_t Offset)
       : Line(Line), Column(Column), Offset(Offset) {}
 
@@ -0,0 +1,225 @@
+/// \file
+/// \brief Traversals of the AST, without materializing children.
+///
+/// `Node::children()` builds a vector for each node. `forEachChild` switches on
+/// the kind of the node instead, and calls back for each child in place.
+///
+/// `RecursiveASTVisitor` walks the AST in pre-order with it. The walk either
+/// recurses on the thread stack, or keeps pending nodes in a vector, so that
+/// deeply nested inputs do not overflow the stack.
+
+#pragma once
+
+#include "nixf/Basic/Nodes/Attrs.h"
+#include "nixf/Basic/Nodes/Basic.h"
+#include "nixf/Basic/Nodes/Expr.h"
+#include "nixf/Basic/Nodes/Lambda.h"
+#include "nixf/Basic/Nodes/Op.h"
+#include "nixf/Basic/Nodes/Simple.h"
+
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <vector>
+
+namespace nixf {
+
+/// \brief Call \p F with \p N, casted to its concrete class.
+template <class Fn> decltype(auto) dispatch(const Node &N, Fn &&F) {
+  switch (N.kind()) {
+  case Node::NK_Interpolation:
+    return F(static_cast<const Interpolation &>(N));
+  case Node::NK_InterpolableParts:
+    return F(static_cast<const InterpolatedParts &>(N));
+  case Node::NK_Misc:
+    return F(static_cast<const Misc &>(N));
+  case Node::NK_Dot:
+    return F(static_cast<const Dot &>(N));
+  case Node::NK_Identifier:
+    return F(static_cast<const Identifier &>(N));
+  case Node::NK_AttrName:
+    return F(static_cast<const AttrName &>(N));
+  case Node::NK_AttrPath:
+    return F(static_cast<const AttrPath &>(N));
+  case Node::NK_Binding:
+    return F(static_cast<const Binding &>(N));
+  case Node::NK_Inherit:
+    return F(static_cast<const Inherit &>(N));
+  case Node::NK_Binds:
+    return F(static_cast<const Binds &>(N));
+  case Node::NK_LambdaArg:
+    return F(static_cast<const LambdaArg &>(N));
+  case Node::NK_Formals:
+    return F(static_cast<const Formals &>(N));
+  case Node::NK_Formal:
+    return F(static_cast<const Formal &>(N));
+  case Node::NK_Op:
+    return F(static_cast<const Op &>(N));
+  case Node::NK_ExprInt:
+    return F(static_cast<const ExprInt &>(N));
+  case Node::NK_ExprFloat:
+    return F(static_cast<const ExprFloat &>(N));
+  case Node::NK_ExprVar:
+    return F(static_cast<const ExprVar &>(N));
+  case Node::NK_ExprString:
+    return F(static_cast<const ExprString &>(N));
+  case Node::NK_ExprPath:
+    return F(static_cast<const ExprPath &>(N));
+  case Node::NK_ExprSPath:
+    return F(static_cast<const ExprSPath &>(N));
+  case Node::NK_ExprParen:
+    return F(static_cast<const ExprParen &>(N));
+  case Node::NK_ExprAttrs:
+    return F(static_cast<const ExprAttrs &>(N));
+  case Node::NK_ExprSelect:
+    return F(static_cast<const ExprSelect &>(N));
+  case Node::NK_ExprCall:
+    return F(static_cast<const ExprCall &>(N));
+  case Node::NK_ExprList:
+    return F(static_cast<const ExprList &>(N));
+  case Node::NK_ExprLambda:
+    return F(static_cast<const ExprLambda &>(N));
+  case Node::NK_ExprBinOp:
+    return F(static_cast<const ExprBinOp &>(N));
+  case Node::NK_ExprUnaryOp:
+    return F(static_cast<const ExprUnaryOp &>(N));
+  case Node::NK_ExprOpHasAttr:
+    return F(static_cast<const ExprOpHasAttr &>(N));
+  case Node::NK_ExprIf:
+    return F(static_cast<const ExprIf &>(N));
+  case Node::NK_ExprAssert:
+    return F(static_cast<const ExprAssert &>(N));
+  case Node::NK_ExprLet:
+    return F(static_cast<const ExprLet &>(N));
+  case Node::NK_ExprLegacyLet:
+    return F(static_cast<const ExprLegacyLet &>(N));
+  case Node::NK_ExprWith:
+    return F(static_cast<const ExprWith &>(N));
+  default:
+    assert(false && "invalid NodeKind");
+  }
+  __builtin_unreachable();
+}
+
+/// \brief Call \p Visit for each child of \p N, null ones included.
+///
+/// Children are in the same order as `Node::children()`.
+template <class Fn> void forEachChild(const Node &N, Fn &&Visit) {
+  dispatch(N, [&](const auto &Concrete) { Concrete.forEachChild(Visit); });
+}
+
+/// \brief Pre-order traversal of the AST.
+///
+/// For each node, the traversal switches on the kind once, and calls
+/// `visitNode` with the concrete node. It calls `visit` of the derived class,
+/// if there is a matching overload:
+///
+/// \code
+/// struct VarCounter : RecursiveASTVisitor<VarCounter> {
+///   int Count = 0;
+///   bool visit(const ExprVar &) { ++Count; return true; }
+/// };
+/// \endcode
+///
+/// Overloads of `visit` must be public. They return false to skip the children
+/// of the node. They may call `traverse` on some nodes themselves, e.g. the
+/// body of a lambda only. In iterative traversals, these nodes are traversed
+/// after the visitor returns, and before the children of the node.
+template <class Derived> class RecursiveASTVisitor {
+  struct PendingNode {
+    const Node *N;
+    const Node *Parent;
+  };
+
+  /// Pending nodes of the running iterative traversal, or nullptr.
+  std::vector<PendingNode> *Pending = nullptr;
+
+  /// The node being visited, and its parent.
+  const Node *Current = nullptr;
+  const Node *Parent = nullptr;
+
+  Derived &derived() { return *static_cast<Derived *>(this); }
+
+  void traverseRecursively(const Node &N) {
+    const Node *OldParent = Parent;
+    Parent = Current;
+    Current = &N;
+    dispatch(N, [this](const auto &Concrete) {
+      if (!derived().visitNode(Concrete))
+        return;
+      Concrete.forEachChild([this](const Node *Ch) {
+        if (Ch)
+          traverseRecursively(*Ch);
+      });
+    });
+    Current = Parent;
+    Parent = OldParent;
+  }
+
+public:
+  /// \brief Parent of the node being visited, or nullptr for the root.
+  ///
+  /// For nodes traversed by a visitor, this is the node it was visiting.
+  [[nodiscard]] const Node *parent() const { return Parent; }
+
+  /// \brief Visit \p N, before its children.
+  ///
+  /// \p N is of its concrete class. Derived classes may hide this with a
+  /// non-template `visitNode(const Node &)`, to visit all nodes alike.
+  ///
+  /// \returns false to skip the children.
+  template <class T> bool visitNode(const T &N) {
+    if constexpr (requires(Derived &D) {
+                    { D.visit(N) } -> std::convertible_to<bool>;
+                  })
+      return static_cast<bool>(derived().visit(N));
+    else
+      return true;
+  }
+
+  /// \brief Traverse \p N and its descendants. Null nodes are ignored.
+  ///
+  /// This recurses on the thread stack, unless called during an iterative
+  /// traversal.
+  void traverse(const Node *N) {
+    if (!N)
+      return;
+    if (Pending) {
+      Pending->emplace_back(PendingNode{N, Current});
+      return;
+    }
+    traverseRecursively(*N);
+  }
+
+  /// \brief Traverse \p Root like `traverse`, with an explicit stack.
+  ///
+  /// The depth of the AST is only limited by memory.
+  void traverseIteratively(const Node *Root) {
+    assert(!Pending && "iterative traversals must not be nested");
+    std::vector<PendingNode> Stack;
+    Pending = &Stack;
+    traverse(Root);
+    while (!Stack.empty()) {
+      Current = Stack.back().N;
+      Parent = Stack.back().Parent;
+      Stack.pop_back();
+      std::size_t Mark = Stack.size();
+      dispatch(*Current, [&](const auto &Concrete) {
+        if (!derived().visitNode(Concrete))
+          return;
+        Concrete.forEachChild([&](const Node *Ch) {
+          if (Ch)
+            Stack.emplace_back(PendingNode{Ch, &Concrete});
+        });
+      });
+      // Nodes of this step are pushed in order, and popped in reverse.
+      std::reverse(Stack.begin() + static_cast<std::ptrdiff_t>(Mark),
+                   Stack.end());
+    }
+    Pending = nullptr;
+    Current = nullptr;
+    Parent = nullptr;
+  }
+};
+
+} // namespace nixf
@@ -20,4 +20,21 @@ class Diagnostic;
 std::shared_ptr<Node> parse(std::string_view Src,
                             std::vector<Diagnostic> &Diags);
 
+/// \brief Parse a string incrementally, based on the previous parse result.
+///
+/// Top-level bindings located before the first changed byte are shared with
+/// \p OldAST, and the rest is parsed again. If the previous result cannot be
+/// reused, e.g. the edit crosses the top-level attrset, this falls back to a
+/// full parse. The result is the same as `parse(Src, Diags)` either way.
+///
+/// \param Src The string to parse.
+/// \param OldSrc The string previously parsed.
+/// \param OldAST The AST returned by parsing \p OldSrc, may be nullptr.
+/// \param OldDiags Diagnostics reported by parsing \p OldSrc.
+/// \param Diags Diagnostics will be appended to this vector.
+std::shared_ptr<Node> reparse(std::string_view Src, std::string_view OldSrc,
+                              const std::shared_ptr<Node> &OldAST,
+                              const std::vector<Diagnostic> &OldDiags,
+                              std::vector<Diagnostic> &Diags);
+
 } // namespace nixf
@@ -3,19 +3,20 @@
 ///
 /// This is used to construct upward edges. For each node, record it's direct
 /// parent. (Abstract Syntax TREE only have one parent for each node).
+///
+/// Parents are kept in a `NodeMap`, so each step upward is an array access.
 
 #pragma once
 
+#include "nixf/Basic/NodeMap.h"
 #include "nixf/Basic/Nodes/Basic.h"
 
-#include <map>
-
 namespace nixf {
 
 class ParentMapAnalysis {
-  std::map<const Node *, const Node *> ParentMap;
+  NodeMap<const Node *> Parents;
 
-  void dfs(const Node *N, const Node *Parent);
+  class Builder;
 
 public:
   void runOnAST(const Node &Root);
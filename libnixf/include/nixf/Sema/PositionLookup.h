@@ -0,0 +1,59 @@
+/// \file
+/// \brief Lookup nodes by their position.
+///
+/// `Node::descend` walks the AST from the root, calling `children()` and
+/// comparing positions of each child. This analysis flattens the AST once, so
+/// that lookups only binary-search children, by offsets, at each level.
+
+#pragma once
+
+#include "nixf/Basic/LineIndex.h"
+#include "nixf/Basic/Nodes/Basic.h"
+#include "nixf/Basic/Range.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace nixf {
+
+class PositionLookupAnalysis {
+  struct Entry {
+    const Node *N;
+    std::uint32_t LOffset;
+    std::uint32_t ROffset;
+    /// Children of this node are `Children[FirstChild, FirstChild + Size)`.
+    std::uint32_t FirstChild;
+    std::uint32_t Size : 31;
+    /// Children are ordered by both of their offsets, so they could be
+    /// binary-searched.
+    std::uint32_t Sorted : 1;
+  };
+
+  /// Nodes of the AST, `Entries[0]` is the root.
+  std::vector<Entry> Entries;
+
+  /// Indices of children in `Entries`, contiguous for each node.
+  std::vector<std::uint32_t> Children;
+
+  /// Lines of the source, to convert positions to offsets.
+  const LineIndex *Lines = nullptr;
+
+  std::uint32_t add(const Node &N);
+
+  /// \brief Key of \p Pos, comparable with keys of node offsets.
+  [[nodiscard]] std::uint64_t key(Position Pos) const;
+
+  /// \brief The first child of \p E containing keys [\p LKey, \p RKey].
+  [[nodiscard]] const Entry *child(const Entry &E, std::uint64_t LKey,
+                                   std::uint64_t RKey) const;
+
+public:
+  void runOnAST(const Node &Root);
+
+  /// \brief Descendant node that contains the given range.
+  ///
+  /// Equivalent to `Root.descend(Range)`.
+  [[nodiscard]] const Node *descend(PositionRange Range) const;
+};
+
+} // namespace nixf
@@ -1,7 +1,6 @@
 #include <cstdint>
-#include <map>
-#include <string>
-#include <vector>
+#include <span>
+#include <string_view>
 
 namespace nixf {
 
@@ -9,11 +8,13 @@ namespace nixf {
  * Info about a primitive operation, but omit the implementation.
  */
 struct PrimOpInfo {
+  std::string_view Name;
+
   /**
    * Names of the parameters of a primop, for primops that take a
    * fixed number of arguments to be substituted for these parameters.
    */
-  std::vector<std::string> Args;
+  std::span<const std::string_view> Args;
 
   /**
    * Aritiy of the primop.
@@ -26,7 +27,7 @@ struct PrimOpInfo {
   /**
    * Optional free-form documentation about the primop.
    */
-  std::string Doc;
+  std::string_view Doc;
 
   /**
    * If true, this primop is not exposed to the user.
@@ -34,7 +35,15 @@ struct PrimOpInfo {
   bool Internal;
 };
 
-extern std::map<std::string, nixf::PrimOpInfo> PrimOpsInfo;
+/// \brief All primops, generated in the slots of a perfect hash table.
+/// \see PerfectHash.h
+extern const std::span<const PrimOpInfo> PrimOpsInfo;
+
+/// \brief Seeds of buckets of the perfect hash table of `PrimOpsInfo`.
+extern const std::span<const std::uint32_t> PrimOpsSeeds;
+
+/// \brief The primop named \p Name exactly, or nullptr.
+const PrimOpInfo *findPrimOpInfo(std::string_view Name);
 
 /// \brief Result of looking up a primop by name.
 enum class PrimopLookupResult : std::uint8_t {
@@ -47,6 +56,6 @@ enum class PrimopLookupResult : std::uint8_t {
 };
 
 /// \brief Look up information about a global primop by name.
-PrimopLookupResult lookupGlobalPrimOpInfo(const std::string &Name);
+PrimopLookupResult lookupGlobalPrimOpInfo(std::string_view Name);
 
 } // namespace nixf
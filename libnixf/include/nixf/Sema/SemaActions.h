@@ -3,6 +3,7 @@
 ///
 /// Non grammatical errors (e.g. duplicating) are detected here.
 
+#include "nixf/Basic/ASTContext.h"
 #include "nixf/Basic/Diagnostic.h"
 #include "nixf/Basic/Nodes/Attrs.h"
 #include "nixf/Basic/Nodes/Basic.h"
@@ -16,10 +17,12 @@ namespace nixf {
 class Sema {
   std::string_view Src;
   std::vector<Diagnostic> &Diags;
+  ASTContext &Ctx;
 
 public:
-  Sema(std::string_view Src, std::vector<Diagnostic> &Diags)
-      : Src(Src), Diags(Diags) {}
+  /// \brief Desugared nodes are allocated in \p Ctx.
+  Sema(std::string_view Src, std::vector<Diagnostic> &Diags, ASTContext &Ctx)
+      : Src(Src), Diags(Diags), Ctx(Ctx) {}
 
   using FormalVector = Formals::FormalVector;
 
@@ -42,11 +45,11 @@ public:
   void dedupFormal(std::map<std::string, const Formal *> &Dedup,
                    const FormalVector &FV);
 
-  std::shared_ptr<Formals> onFormals(LexerCursorRange Range, FormalVector FV);
+  Formals *onFormals(LexerCursorRange Range, FormalVector FV);
 
   /// \brief Desugar inherit (expr) a, inherit a, into select, or variable.
-  static std::pair<std::shared_ptr<Expr>, Attribute::AttributeKind>
-  desugarInheritExpr(std::shared_ptr<AttrName> Name, std::shared_ptr<Expr> E);
+  std::pair<Expr *, Attribute::AttributeKind>
+  desugarInheritExpr(AttrName *Name, Expr *E);
 
   void dupAttr(std::string Name, LexerCursorRange Range, LexerCursorRange Prev);
 
@@ -71,34 +74,28 @@ public:
   void mergeAttrSets(SemaAttrs &XAttrs, const SemaAttrs &YAttrs);
 
   /// \note Name must not be null
-  void insertAttr(SemaAttrs &SA, std::shared_ptr<AttrName> Name,
-                  std::shared_ptr<Expr> E, Attribute::AttributeKind Kind);
+  void insertAttr(SemaAttrs &SA, AttrName *Name, Expr *E,
+                  Attribute::AttributeKind Kind);
 
   /// Select into \p Attr the attribute specified by \p Path, or create one if
   /// not exists, until reached the inner-most attr. Similar to `mkdir -p`.
   ///
   /// \return The selected or created attribute.
-  SemaAttrs *selectOrCreate(SemaAttrs &SA,
-                            const std::vector<std::shared_ptr<AttrName>> &Path);
+  SemaAttrs *selectOrCreate(SemaAttrs &SA, const std::vector<AttrName *> &Path);
 
   /// Insert the binding: `AttrPath = E;` into \p Attr
-  void addAttr(SemaAttrs &Attr, const AttrPath &Path, std::shared_ptr<Expr> E);
+  void addAttr(SemaAttrs &Attr, const AttrPath &Path, Expr *E);
 
-  void lowerInheritName(SemaAttrs &SA, std::shared_ptr<AttrName> Name,
-                        std::shared_ptr<Expr> E,
+  void lowerInheritName(SemaAttrs &SA, AttrName *Name, Expr *E,
                         Attribute::AttributeKind InheritKind);
 
   void lowerInherit(SemaAttrs &Attr, const Inherit &Inherit);
 
   void lowerBinds(SemaAttrs &SA, const Binds &B);
 
-  std::shared_ptr<ExprAttrs> onExprAttrs(LexerCursorRange Range,
-                                         std::shared_ptr<Binds> Binds,
-                                         std::shared_ptr<Misc> Rec);
+  ExprAttrs *onExprAttrs(LexerCursorRange Range, Binds *Binds, Misc *Rec);
 
-  std::shared_ptr<LambdaArg> onLambdaArg(LexerCursorRange Range,
-                                         std::shared_ptr<Identifier> ID,
-                                         std::shared_ptr<Formals> F);
+  LambdaArg *onLambdaArg(LexerCursorRange Range, Identifier *ID, Formals *F);
 };
 
 } // namespace nixf
@@ -0,0 +1,44 @@
+/// \file
+/// \brief Interned names of variables.
+///
+/// Analyses intern each name once, and then compare symbols as integers.
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace nixf {
+
+/// \brief An interned name, unique in its `SymbolTable`.
+enum class Symbol : std::uint32_t {};
+
+class SymbolTable {
+  /// Names by symbol. A deque does not move them, so views of them are stable.
+  std::deque<std::string> Names;
+
+  std::unordered_map<std::string_view, Symbol> Symbols;
+
+public:
+  SymbolTable() = default;
+  SymbolTable(const SymbolTable &) = delete;
+  SymbolTable &operator=(const SymbolTable &) = delete;
+
+  /// \brief The symbol of \p Name, which is created if not interned yet.
+  Symbol intern(std::string_view Name);
+
+  /// \brief The symbol of \p Name, if it was interned.
+  [[nodiscard]] std::optional<Symbol> lookup(std::string_view Name) const;
+
+  [[nodiscard]] const std::string &name(Symbol S) const {
+    return Names[static_cast<std::uint32_t>(S)];
+  }
+
+  [[nodiscard]] std::size_t size() const { return Names.size(); }
+};
+
+} // namespace nixf
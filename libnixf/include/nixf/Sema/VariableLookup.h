@@ -5,19 +5,28 @@
 /// We do variable lookup for liveness checking, and emit diagnostics
 /// like "unused with", or "undefined variable".
 /// The implementation aims to be consistent with C++ nix (NixOS/nix).
+///
+/// Names are interned in a `SymbolTable` of the analysis, so looking up a
+/// variable compares integers in each scope, instead of strings. Results are
+/// kept in `NodeMap`s, indexed by nodes.
 
 #pragma once
 
 #include "nixf/Basic/Diagnostic.h"
+#include "nixf/Basic/NodeMap.h"
 #include "nixf/Basic/Nodes/Attrs.h"
 #include "nixf/Basic/Nodes/Basic.h"
 #include "nixf/Basic/Nodes/Expr.h"
 #include "nixf/Basic/Nodes/Lambda.h"
 #include "nixf/Basic/Nodes/Simple.h"
+#include "nixf/Sema/SymbolTable.h"
 
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace nixf {
@@ -79,10 +88,47 @@ public:
   [[nodiscard]] bool isBuiltin() const { return Source == DS_Builtin; }
 };
 
+/// \brief Definitions of an environment, iterated in the order of names.
+///
+/// Definitions are also indexed by symbol, in a sorted vector of integers.
+class DefMap {
+public:
+  using value_type = std::pair<std::string, std::shared_ptr<Definition>>;
+  using const_iterator = std::vector<value_type>::const_iterator;
+
+  struct Entry {
+    Symbol Sym;
+    std::string Name;
+    std::shared_ptr<Definition> Def;
+  };
+
+private:
+  std::vector<value_type> Defs;
+
+  /// Symbols of names, with indices of definitions, sorted by symbol.
+  std::vector<std::pair<Symbol, std::uint32_t>> Index;
+
+public:
+  DefMap() = default;
+
+  /// \brief Definitions of \p Entries, whose names must be unique.
+  explicit DefMap(std::vector<Entry> Entries);
+
+  [[nodiscard]] const_iterator begin() const { return Defs.begin(); }
+  [[nodiscard]] const_iterator end() const { return Defs.end(); }
+  [[nodiscard]] std::size_t size() const { return Defs.size(); }
+  [[nodiscard]] bool empty() const { return Defs.empty(); }
+
+  [[nodiscard]] bool contains(std::string_view Name) const;
+
+  /// \brief The definition of \p S, or nullptr.
+  [[nodiscard]] const std::shared_ptr<Definition> *find(Symbol S) const;
+};
+
 /// \brief A set of variable definitions, which may inherit parent environment.
 class EnvNode {
 public:
-  using DefMap = std::map<std::string, std::shared_ptr<Definition>>;
+  using DefMap = nixf::DefMap;
 
 private:
   const std::shared_ptr<EnvNode> Parent; // Points to the parent node.
@@ -119,16 +165,22 @@ public:
   };
 
   struct LookupResult {
-    LookupResultKind Kind;
+    LookupResultKind Kind = LookupResultKind::NoSuchVar;
     std::shared_ptr<const Definition> Def;
   };
 
-  using ToDefMap = std::map<const Node *, std::shared_ptr<Definition>>;
-  using EnvMap = std::map<const Node *, std::shared_ptr<EnvNode>>;
+  using ToDefMap = NodeMap<std::shared_ptr<Definition>>;
+  using EnvMap = NodeMap<const EnvNode *>;
 
 private:
   std::vector<Diagnostic> &Diags;
 
+  /// Names of all definitions, and of builtins.
+  SymbolTable Symbols;
+
+  /// Environments created by the analysis, nodes only refer to them.
+  std::vector<std::shared_ptr<EnvNode>> EnvNodes;
+
   std::map<const Node *, std::shared_ptr<Definition>>
       WithDefs; // record with ... ; users.
 
@@ -138,6 +190,9 @@ private:
   // name lookup, for later references like code completions.
   EnvMap Envs;
 
+  std::shared_ptr<EnvNode> newEnv(std::shared_ptr<EnvNode> Parent, DefMap Defs,
+                                  const Node *Syntax);
+
   void lookupVar(const ExprVar &Var, const std::shared_ptr<EnvNode> &Env);
 
   void checkBuiltins(const ExprSelect &Sel);
@@ -165,7 +220,7 @@ private:
 
   void trivialDispatch(const Node &Root, const std::shared_ptr<EnvNode> &Env);
 
-  std::map<const ExprVar *, LookupResult> Results;
+  NodeMap<LookupResult> Results;
 
   /// \brief For variables resolved from `with` scopes, track all enclosing
   /// `with` expressions that could potentially provide the binding.
@@ -183,9 +238,7 @@ public:
 
   /// \brief Query the which name/with binds to specific varaible.
   [[nodiscard]] LookupResult query(const ExprVar &Var) const {
-    if (!Results.contains(&Var))
-      return {.Kind = LookupResultKind::NoSuchVar};
-    return Results.at(&Var);
+    return Results.lookup(Var);
   }
 
   /// \brief Get definition record for some name.
@@ -201,9 +254,8 @@ public:
   ///   2. "with" keyword is recorded.
   ///   3. Lambda arguments, record its identifier.
   [[nodiscard]] const Definition *toDef(const Node &N) const {
-    if (ToDef.contains(&N))
-      return ToDef.at(&N).get();
-    return nullptr;
+    const std::shared_ptr<Definition> *Def = ToDef.find(N);
+    return Def ? Def->get() : nullptr;
   }
 
   const EnvNode *env(const Node *N) const;
@@ -0,0 +1,86 @@
+#include "nixf/Basic/ASTContext.h"
+
+#include <algorithm>
+#include <cstdint>
+
+using namespace nixf;
+
+namespace {
+
+/// Slabs grow from 4KiB to 1MiB, so small files do not waste memory and large
+/// files need few allocations.
+constexpr std::size_t MinSlabSize = 4096;
+constexpr std::size_t MaxSlabSize = 1 << 20;
+
+/// Deleter of contexts returned by `ASTContext::make()`.
+///
+/// It remembers the context, so that it could be found from any aliasing
+/// `std::shared_ptr` sharing the ownership, by `std::get_deleter`.
+struct ContextDeleter {
+  ASTContext *Ctx;
+  void operator()(ASTContext *Ptr) const { delete Ptr; }
+};
+
+} // namespace
+
+ASTContext::~ASTContext() {
+  for (auto It = Nodes.rbegin(); It != Nodes.rend(); ++It)
+    (*It)->~Node();
+}
+
+void *ASTContext::allocate(std::size_t Size, std::size_t Align) {
+  auto Aligned = [&](std::byte *Ptr) {
+    auto Addr = reinterpret_cast<std::uintptr_t>(Ptr);
+    return Ptr + ((Align - Addr % Align) % Align);
+  };
+  std::byte *Ptr = Aligned(Cur);
+  if (!Cur || Ptr + Size > End) {
+    std::size_t SlabSize =
+        Slabs.empty() ? MinSlabSize
+                      : std::min(Slabs.back().Size * 2, MaxSlabSize);
+    SlabSize = std::max(SlabSize, Size + Align);
+    Slabs.emplace_back(
+        Slab{std::unique_ptr<std::byte[]>(new std::byte[SlabSize]), SlabSize});
+    Cur = Slabs.back().Begin.get();
+    End = Cur + SlabSize;
+    Ptr = Aligned(Cur);
+  }
+  Cur = Ptr + Size;
+  Bytes += Size;
+  return Ptr;
+}
+
+bool ASTContext::owns(const Node *N) const {
+  const auto *Ptr = reinterpret_cast<const std::byte *>(N);
+  return std::any_of(Slabs.begin(), Slabs.end(), [&](const Slab &S) {
+    return S.Begin.get() <= Ptr && Ptr < S.Begin.get() + S.Size;
+  });
+}
+
+void ASTContext::retain(std::shared_ptr<const ASTContext> Ctx) {
+  if (std::find(Deps.begin(), Deps.end(), Ctx) == Deps.end())
+    Deps.emplace_back(std::move(Ctx));
+}
+
+std::shared_ptr<ASTContext> ASTContext::make(std::string_view Src) {
+  auto *Ctx = new ASTContext(Src);
+  return {Ctx, ContextDeleter{Ctx}};
+}
+
+std::shared_ptr<Node> ASTContext::share(std::shared_ptr<ASTContext> Ctx,
+                                        Node *Root) {
+  assert(Ctx && std::get_deleter<ContextDeleter>(Ctx) &&
+         "context must be made by ASTContext::make()");
+  assert((!Root || Ctx->owns(Root) ||
+          std::any_of(Ctx->Deps.begin(), Ctx->Deps.end(),
+                      [&](const auto &Dep) { return Dep->owns(Root); })) &&
+         "root must be reachable from the context");
+  return {std::move(Ctx), Root};
+}
+
+std::shared_ptr<const ASTContext>
+ASTContext::of(const std::shared_ptr<Node> &AST) {
+  if (const auto *D = std::get_deleter<ContextDeleter>(AST))
+    return {AST, D->Ctx};
+  return nullptr;
+}
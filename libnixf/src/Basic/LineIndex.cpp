@@ -0,0 +1,30 @@
+#include "nixf/Basic/LineIndex.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+using namespace nixf;
+
+LineIndex::LineIndex(std::string_view Src) : Starts{0} {
+  assert(Src.size() <= std::numeric_limits<std::uint32_t>::max() &&
+         "source files larger than 4GiB are not supported");
+  const char *Begin = Src.data();
+  const char *End = Begin + Src.size();
+  for (const char *P = Begin; P < End;) {
+    const auto *NL = static_cast<const char *>(std::memchr(P, '\n', End - P));
+    if (!NL)
+      break;
+    Starts.emplace_back(NL + 1 - Begin);
+    P = NL + 1;
+  }
+}
+
+LexerCursor LineIndex::cursor(std::size_t Offset) const {
+  // The last line starting at or before Offset.
+  auto It = std::upper_bound(Starts.begin(), Starts.end(), Offset);
+  auto Line = static_cast<int64_t>(It - Starts.begin()) - 1;
+  return LexerCursor::unsafeCreate(
+      Line, static_cast<int64_t>(Offset - Starts[Line]), Offset);
+}
@@ -1,5 +1,8 @@
 #include "nixf/Basic/Nodes/Simple.h"
 
+#include "nixf/Basic/ASTContext.h"
+#include "nixf/Basic/RecursiveASTVisitor.h"
+
 using namespace nixf;
 
 namespace {
@@ -50,6 +53,18 @@ mergeFragments(std::vector<InterpolablePart> Fragments) {
   __builtin_unreachable();
 }
 
+LexerCursor Node::cursor(std::uint32_t Offset) const {
+  if (Ctx)
+    return Ctx->lines().cursor(Offset);
+  return LexerCursor::unsafeCreate(0, Offset, Offset);
+}
+
+Node::ChildVector Node::children() const {
+  ChildVector Children;
+  forEachChild(*this, [&](Node *Ch) { Children.emplace_back(Ch); });
+  return Children;
+}
+
 InterpolatedParts::InterpolatedParts(LexerCursorRange Range,
                                      std::vector<InterpolablePart> Fragments)
     : Node(NK_InterpolableParts, Range),
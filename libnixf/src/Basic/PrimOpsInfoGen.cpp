@@ -1,7 +1,11 @@
+#include "nixf/Basic/PerfectHash.h"
+
 #include <nix/expr/eval.hh>
 #include <nix/expr/primops.hh>
 
 #include <iostream>
+#include <string_view>
+#include <vector>
 
 int main(int argc, char **argv) {
   std::freopen(argv[1], "w", stdout);
@@ -9,35 +13,79 @@ int main(int argc, char **argv) {
   // Generate .cpp file that inject all primops into a custom vector.
   // This is used by the language server to provide documentation,
   // but omit the implementation of primops.
+  //
+  // Primops are emitted in the slots of a perfect hash table, as constant
+  // data, so looking them up needs neither a map nor static initialization.
+  const auto &PrimOps = nix::RegisterPrimOp::primOps();
+  std::vector<std::string_view> Names;
+  for (const auto &PrimOp : PrimOps)
+    Names.emplace_back(PrimOp.name);
+  nixf::PerfectHashLayout Layout = nixf::layoutPerfectHash(Names);
+  std::vector<const nix::PrimOp *> BySlot(PrimOps.size());
+  for (size_t I = 0; I < PrimOps.size(); ++I)
+    BySlot[Layout.Slots[I]] = &PrimOps[I];
+
   std::cout << "#include <nixf/Sema/PrimOpInfo.h>" << "\n\n";
-  std::cout << "std::map<std::string, nixf::PrimOpInfo> nixf::PrimOpsInfo = {"
-            << '\n';
-  for (const auto &PrimOp : nix::RegisterPrimOp::primOps()) {
-    std::cout << "  {" << "\"" << PrimOp.name << "\", {\n";
+  std::cout << "#include <array>" << "\n\n";
+  std::cout << "using namespace std::literals;" << "\n\n";
+  std::cout << "namespace {" << "\n\n";
 
-    // .args
-    std::cout << "    .Args = {";
-    for (size_t I = 0; I < PrimOp.args.size(); ++I) {
-      std::cout << "\"" << PrimOp.args[I] << "\"";
-      if (I + 1 < PrimOp.args.size()) {
+  // .args, which are referenced by spans.
+  for (size_t S = 0; S < BySlot.size(); ++S) {
+    const auto &Args = BySlot[S]->args;
+    std::cout << "constexpr std::array<std::string_view, " << Args.size()
+              << "> Args" << S << " = {";
+    for (size_t I = 0; I < Args.size(); ++I) {
+      std::cout << "\"" << Args[I] << "\"sv";
+      if (I + 1 < Args.size()) {
         std::cout << ", ";
       }
     }
-    std::cout << "},\n";
+    std::cout << "};\n";
+  }
+  std::cout << '\n';
+
+  std::cout << "constexpr std::array<std::uint32_t, " << Layout.Seeds.size()
+            << "> Seeds = {";
+  for (size_t I = 0; I < Layout.Seeds.size(); ++I) {
+    std::cout << Layout.Seeds[I];
+    if (I + 1 < Layout.Seeds.size()) {
+      std::cout << ", ";
+    }
+  }
+  std::cout << "};\n\n";
+
+  std::cout << "constexpr std::array<nixf::PrimOpInfo, " << BySlot.size()
+            << "> PrimOps = {{" << '\n';
+  for (size_t S = 0; S < BySlot.size(); ++S) {
+    const nix::PrimOp &PrimOp = *BySlot[S];
+    std::cout << "  {\n";
+
+    // .name
+    std::cout << "    .Name = \"" << PrimOp.name << "\"sv,\n";
+
+    // .args
+    std::cout << "    .Args = Args" << S << ",\n";
 
     // .arity
     std::cout << "    .Arity = " << PrimOp.arity << ",\n";
 
     // .doc
     std::cout << "    .Doc = R\"xabc(" << PrimOp.doc.value_or("")
-              << ")xabc\",\n";
+              << ")xabc\"sv,\n";
 
     // .internal
     std::cout << "    .Internal = " << (PrimOp.internal ? "true" : "false")
               << ",\n";
 
-    std::cout << "  }},\n";
+    std::cout << "  },\n";
   }
-  std::cout << "};\n";
+  std::cout << "}};\n\n";
+  std::cout << "} // namespace" << "\n\n";
+
+  std::cout << "const std::span<const nixf::PrimOpInfo> nixf::PrimOpsInfo = "
+               "PrimOps;\n";
+  std::cout << "const std::span<const std::uint32_t> nixf::PrimOpsSeeds = "
+               "Seeds;\n";
   return 0;
 }
@@ -2,36 +2,124 @@
 
 #include "nixf/Basic/Range.h"
 
+#include <array>
 #include <cassert>
-#include <cctype>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 using namespace nixf;
 using namespace tok;
 
 namespace {
 
-bool isUriSchemeChar(char Ch) {
-  // These characters are valid URI scheme char.
-  return std::isalnum(Ch) || Ch == '+' || Ch == '-' || Ch == '.';
+/// Classes of characters, as bits of `CharClasses`.
+enum CharClass : std::uint8_t {
+  /// `std::isspace` in the "C" locale.
+  CC_Space = 1 << 0,
+  CC_Digit = 1 << 1,
+  CC_Alpha = 1 << 2,
+  /// [a-zA-Z0-9_\'\-]
+  CC_Identifier = 1 << 3,
+  /// [a-zA-Z0-9\.\_\-\+]
+  CC_Path = 1 << 4,
+  /// [a-zA-Z0-9\+\-\.]
+  CC_UriScheme = 1 << 5,
+  /// [a-zA-Z0-9\%\/\?\:\@\&\=\+\$\,\-\_\.\!\~\*\']
+  CC_UriPath = 1 << 6,
+  /// Path characters, and '/'.
+  CC_PathSegment = 1 << 7,
+};
+
+constexpr std::array<std::uint8_t, 256> CharClasses = [] {
+  std::array<std::uint8_t, 256> Classes{};
+  auto Add = [&](std::string_view Chars, std::uint8_t Class) {
+    for (char Ch : Chars)
+      Classes[static_cast<unsigned char>(Ch)] |= Class;
+  };
+  constexpr std::string_view Digits = "0123456789";
+  constexpr std::string_view Alphas =
+      "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+  Add(" \t\n\v\f\r", CC_Space);
+  Add(Digits, CC_Digit | CC_Identifier | CC_Path | CC_UriScheme | CC_UriPath);
+  Add(Alphas, CC_Alpha | CC_Identifier | CC_Path | CC_UriScheme | CC_UriPath);
+  Add("_'-", CC_Identifier);
+  Add("._-+", CC_Path);
+  for (std::size_t Ch = 0; Ch < Classes.size(); ++Ch) {
+    if (Classes[Ch] & CC_Path)
+      Classes[Ch] |= CC_PathSegment;
+  }
+  Add("/", CC_PathSegment);
+  Add("+-.", CC_UriScheme);
+  Add("%/?:@&=+$,-_.!~*'", CC_UriPath);
+  return Classes;
+}();
+
+bool is(char Ch, std::uint8_t Class) {
+  return CharClasses[static_cast<unsigned char>(Ch)] & Class;
 }
 
-bool isUriPathChar(char Ch) {
-  // These characters are valid URI path char.
-  return std::isalnum(Ch) || Ch == '%' || Ch == '/' || Ch == '?' || Ch == ':' ||
-         Ch == '@' || Ch == '&' || Ch == '=' || Ch == '+' || Ch == '$' ||
-         Ch == ',' || Ch == '-' || Ch == '_' || Ch == '.' || Ch == '!' ||
-         Ch == '~' || Ch == '*' || Ch == '\'';
+bool isUriSchemeChar(char Ch) { return is(Ch, CC_UriScheme); }
+
+bool isUriPathChar(char Ch) { return is(Ch, CC_UriPath); }
+
+bool isPathChar(char Ch) { return is(Ch, CC_Path); }
+
+/// First character in [P, End) not of \p Class, or End.
+const char *skipClass(const char *P, const char *End, std::uint8_t Class) {
+  while (P != End && is(*P, Class))
+    ++P;
+  return P;
 }
 
-bool isPathChar(char Ch) {
-  // These characters are valid path char.
-  return std::isdigit(Ch) || std::isalpha(Ch) || Ch == '.' || Ch == '_' ||
-         Ch == '-' || Ch == '+';
+/// First character in [P, End) that is not whitespace, or End.
+///
+/// Indentation and blank lines are long runs of a few characters, so they are
+/// skipped a vector at a time.
+const char *skipWhitespaces(const char *P, const char *End) {
+#if defined(__SSE2__)
+  const __m128i Space = _mm_set1_epi8(' ');
+  const __m128i LF = _mm_set1_epi8('\n');
+  const __m128i Tab = _mm_set1_epi8('\t');
+  const __m128i CR = _mm_set1_epi8('\r');
+  for (; End - P >= 16; P += 16) {
+    __m128i V = _mm_loadu_si128(reinterpret_cast<const __m128i *>(P));
+    __m128i Eq = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(V, Space), _mm_cmpeq_epi8(V, LF)),
+        _mm_or_si128(_mm_cmpeq_epi8(V, Tab), _mm_cmpeq_epi8(V, CR)));
+    if (unsigned Mask = ~_mm_movemask_epi8(Eq) & 0xFFFF) {
+      P += __builtin_ctz(Mask);
+      break;
+    }
+  }
+#endif
+  // '\v' and '\f', and the tail.
+  return skipClass(P, End, CC_Space);
 }
 
-bool isIdentifierChar(char Ch) {
-  return std::isdigit(Ch) || std::isalpha(Ch) || Ch == '_' || Ch == '\'' ||
-         Ch == '-';
+/// First character in [P, End) that is \p A, \p B or \p C, or End.
+const char *findAny(const char *P, const char *End, char A, char B, char C) {
+#if defined(__SSE2__)
+  const __m128i VA = _mm_set1_epi8(A);
+  const __m128i VB = _mm_set1_epi8(B);
+  const __m128i VC = _mm_set1_epi8(C);
+  for (; End - P >= 16; P += 16) {
+    __m128i V = _mm_loadu_si128(reinterpret_cast<const __m128i *>(P));
+    __m128i Eq = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(V, VA), _mm_cmpeq_epi8(V, VB)),
+        _mm_cmpeq_epi8(V, VC));
+    if (unsigned Mask = _mm_movemask_epi8(Eq))
+      return P + __builtin_ctz(Mask);
+  }
+#endif
+  for (; P != End; ++P) {
+    if (*P == A || *P == B || *P == C)
+      return P;
+  }
+  return End;
 }
 
 } // namespace
@@ -39,26 +127,40 @@ bool isIdentifierChar(char Ch) {
 using DK = Diagnostic::DiagnosticKind;
 using NK = Note::NoteKind;
 
-std::optional<LexerCursorRange> Lexer::consumePrefix(std::string_view Prefix) {
-  LexerCursor Begin = cur();
+LexerCursor Lexer::cursor(std::size_t Offset) const {
+  // Cursors are mostly looked up in order, so try lines after the last one
+  // first, before searching all lines.
+  constexpr std::size_t MaxSteps = 8;
+  std::size_t Line = LineHint;
+  if (Line < Lines.lines() && Lines.lineStart(Line) <= Offset) {
+    std::size_t Steps = 0;
+    while (Line + 1 < Lines.lines() && Lines.lineStart(Line + 1) <= Offset &&
+           Steps++ < MaxSteps)
+      ++Line;
+    if (Steps > MaxSteps)
+      Line = Lines.cursor(Offset).line();
+  } else {
+    Line = Lines.cursor(Offset).line();
+  }
+  LineHint = Line;
+  return LexerCursor::unsafeCreate(
+      static_cast<int64_t>(Line),
+      static_cast<int64_t>(Offset - Lines.lineStart(Line)), Offset);
+}
+
+bool Lexer::consumePrefix(std::string_view Prefix) {
   if (peekPrefix(Prefix)) {
     consume(Prefix.length());
-    return LexerCursorRange{Begin, cur()};
+    return true;
   }
-  return std::nullopt;
+  return false;
 }
 
-std::optional<LexerCursorRange> Lexer::consumeManyOf(std::string_view Chars) {
-  if (eof())
-    return std::nullopt;
-  if (Chars.find(peekUnwrap()) != std::string_view::npos) {
-    auto Start = Cur;
-    while (!eof() && Chars.find(peekUnwrap()) != std::string_view::npos) {
-      consume();
-    }
-    return LexerCursorRange{Start, Cur};
-  }
-  return std::nullopt;
+bool Lexer::consumeManyDigits() {
+  const char *Begin = Src.data() + Offset;
+  const char *P = skipClass(Begin, Src.data() + Src.size(), CC_Digit);
+  consume(P - Begin);
+  return P != Begin;
 }
 
 std::optional<char> Lexer::consumeOneOf(std::string_view Chars) {
@@ -82,22 +184,15 @@ bool Lexer::consumeOne(char C) {
   return false;
 }
 
-std::optional<LexerCursorRange> Lexer::consumeManyPathChar() {
-  if (eof())
-    return std::nullopt;
-  if (auto Ch = peek(); Ch && isPathChar(*Ch)) {
-    auto Start = Cur;
-    do {
-      consume();
-      Ch = peek();
-    } while (Ch && isPathChar(*Ch));
-    return LexerCursorRange{Start, Cur};
-  }
-  return std::nullopt;
+bool Lexer::consumeManyPathChar() {
+  const char *Begin = Src.data() + Offset;
+  const char *P = skipClass(Begin, Src.data() + Src.size(), CC_Path);
+  consume(P - Begin);
+  return P != Begin;
 }
 
 bool Lexer::peekPrefix(std::string_view Prefix) {
-  if (Cur.Offset + Prefix.length() > Src.length())
+  if (Offset + Prefix.length() > Src.length())
     return false;
   if (remain().starts_with(Prefix)) {
     return true;
@@ -105,42 +200,50 @@ bool Lexer::peekPrefix(std::string_view Prefix) {
   return false;
 }
 
+void Lexer::consumePathSegments() {
+  const char *Begin = Src.data() + Offset;
+  consume(skipClass(Begin, Src.data() + Src.size(), CC_PathSegment) - Begin);
+}
+
 bool Lexer::consumeWhitespaces() {
-  if (auto Ch = peek(); Ch && !std::isspace(*Ch))
-    return false;
-  do {
-    consume();
-  } while (!eof() && std::isspace(peekUnwrap()));
-  return true;
+  const char *Begin = Src.data() + Offset;
+  const char *P = skipWhitespaces(Begin, Src.data() + Src.size());
+  consume(P - Begin);
+  return P != Begin;
 }
 
 bool Lexer::consumeComments() {
   if (eof())
     return false;
-  if (std::optional<LexerCursorRange> BeginRange = consumePrefix("/*")) {
+  const char *End = Src.data() + Src.size();
+  std::size_t Begin = Offset;
+  if (consumePrefix("/*")) {
     // Consume block comments until we meet '*/'
-    while (true) {
-      if (eof()) {
+    for (const char *P = Src.data() + Offset;; ++P) {
+      P = static_cast<const char *>(std::memchr(P, '*', End - P));
+      if (!P) {
         // There is no '*/' to terminate comments
+        Offset = Src.size();
         Diagnostic &Diag = Diags.emplace_back(DK::DK_UnterminatedBComment,
                                               LexerCursorRange{cur()});
-        Diag.note(NK::NK_BCommentBegin, *BeginRange);
+        Diag.note(NK::NK_BCommentBegin,
+                  LexerCursorRange{cursor(Begin), cursor(Begin + 2)});
         Diag.fix("insert */").edit(TextEdit::mkInsertion(cur(), "*/"));
         return true;
       }
-      if (consumePrefix("*/"))
+      if (P + 1 != End && P[1] == '/') {
         // We found the ending '*/'
-        return true;
-      consume(); // Consume a character (block comment body).
-    }
-  } else if (consumePrefix("#")) {
-    // Single line comments, consume blocks until we meet EOF or '\n' or '\r'
-    while (true) {
-      if (eof() || consumeEOL()) {
+        Offset = P + 2 - Src.data();
         return true;
       }
-      consume(); // Consume a character (single line comment body).
     }
+  } else if (consumePrefix("#")) {
+    // Single line comments, consume blocks until we meet EOF or '\n'.
+    // "\r\n" ends with '\n' as well.
+    const char *P = Src.data() + Offset;
+    const auto *LF = static_cast<const char *>(std::memchr(P, '\n', End - P));
+    Offset = LF ? LF + 1 - Src.data() : Src.size();
+    return true;
   }
   return false;
 }
@@ -191,8 +294,10 @@ void Lexer::lexNumbers() {
   // however, we accept [0-9]+\.[0-9]*([Ee][+-]?[0-9]+)?
   // and issues a warning if it has leading zeros
   // [0-9]+
-  auto Ch = consumeManyDigits();
-  assert(Ch.has_value() && "lexNumbers() must be called with a digit start");
+  std::size_t Begin = Offset;
+  [[maybe_unused]] bool Digits = consumeManyDigits();
+  assert(Digits && "lexNumbers() must be called with a digit start");
+  std::size_t DigitsEnd = Offset;
   if (peek() == '.') {
     // float
     Tok = tok_float;
@@ -201,9 +306,11 @@ void Lexer::lexNumbers() {
     consumeManyDigits();
     lexFloatExp();
     // Checking that if the float token has leading zeros.
-    std::string_view Prefix = Src.substr(Ch->lCur().Offset, 2);
-    if (Prefix.starts_with("0") && Prefix != "0.")
-      Diags.emplace_back(DK::DK_FloatLeadingZero, *Ch) << std::string(Prefix);
+    std::string_view Prefix = Src.substr(Begin, 2);
+    if (Prefix.starts_with("0") && Prefix != "0.") {
+      LexerCursorRange Range{cursor(Begin), cursor(DigitsEnd)};
+      Diags.emplace_back(DK::DK_FloatLeadingZero, Range) << std::string(Prefix);
+    }
   } else {
     Tok = tok_int;
   }
@@ -219,7 +326,7 @@ bool Lexer::consumePathStart() {
   // Path, starts with any valid path char, or a leading "~/" home path, and
   // must contain slashs Here, we look ahead characters, the must be valid path
   // char And also check if it contains a slash.
-  LexerCursor Saved = cur();
+  std::size_t Saved = Offset;
 
   // Nix accepts paths under the user's home directory, e.g. ~/foo. The '~'
   // marker is only valid as a path start when immediately followed by '/'.
@@ -231,7 +338,7 @@ bool Lexer::consumePathStart() {
       if (peekPrefix("${"))
         return true;
     }
-    Cur = Saved;
+    Offset = Saved;
     return false;
   }
 
@@ -251,7 +358,7 @@ bool Lexer::consumePathStart() {
   }
 
   // Otherwise, it is not a path, restore cursor.
-  Cur = Saved;
+  Offset = Saved;
   return false;
 }
 
@@ -260,7 +367,7 @@ bool Lexer::consumeURI() {
   // [a-zA-Z][a-zA-Z0-9\+\-\.]*\:[a-zA-Z0-9\%\/\?\:\@\&\=\+\$\,\-\_\.\!\~\*\']+
   //
 
-  LexerCursor Saved = cur();
+  std::size_t Saved = Offset;
   // URI, starts with any valid URI scheme char, and must contain a colon
   // Here, we look ahead characters, the must be valid path char
   // And also check if it contains a colon.
@@ -280,13 +387,13 @@ bool Lexer::consumeURI() {
     }
   }
 
-  Cur = Saved;
+  Offset = Saved;
   return false;
 }
 
 bool Lexer::consumeSPath() {
   //  \<{PATH_CHAR}+(\/{PATH_CHAR}+)*\>
-  LexerCursor Saved = cur();
+  std::size_t Saved = Offset;
 
   if (peek() == '<')
     consume();
@@ -315,29 +422,18 @@ bool Lexer::consumeSPath() {
     }
   }
 
-  Cur = Saved;
+  Offset = Saved;
   return false;
 }
 
 void Lexer::lexIdentifier() {
   // identifier: [a-zA-Z_][a-zA-Z0-9_\'\-]*,
   consume();
-  while (!eof() && isIdentifierChar(peekUnwrap()))
-    consume();
+  const char *Begin = Src.data() + Offset;
+  consume(skipClass(Begin, Src.data() + Src.size(), CC_Identifier) - Begin);
 }
 
-void Lexer::maybeKW() {
-  // For complex language this should be done on automaton or hashtable.
-  // But actually there are few keywords in nix language, so we just do
-  // comparison.
-#define TOK_KEYWORD(NAME)                                                      \
-  if (tokStr() == #NAME) {                                                     \
-    Tok = tok_kw_##NAME;                                                       \
-    return;                                                                    \
-  }
-#include "TokenKinds.inc"
-#undef TOK_KEYWORD
-}
+void Lexer::maybeKW() { Tok = tok::keyword(tokStr()); }
 
 Token Lexer::lexPath() {
   // Accept all characters, except ${, or "
@@ -359,23 +455,13 @@ Token Lexer::lexPath() {
   if (peekPrefix("~/")) {
     Tok = tok_path_fragment;
     consume(2);
-    while (!eof() && (isPathChar(peekUnwrap()) || peekUnwrap() == '/')) {
-      // Encountered an interpolation, stop here
-      if (peekPrefix("${"))
-        break;
-      consume();
-    }
+    consumePathSegments();
     return finishToken();
   }
 
   if (isPathChar(peekUnwrap()) || peekUnwrap() == '/') {
     Tok = tok_path_fragment;
-    while (!eof() && (isPathChar(peekUnwrap()) || peekUnwrap() == '/')) {
-      // Encountered an interpolation, stop here
-      if (peekPrefix("${"))
-        break;
-      consume();
-    }
+    consumePathSegments();
     return finishToken();
   }
   return finishToken();
@@ -410,20 +496,23 @@ Token Lexer::lexString() {
     [[fallthrough]];
   default:
     Tok = tok_string_part;
-    for (; !eof();) {
-      // '\' escape
-      if (peekUnwrap() == '\\')
-        break;
-      if (peekUnwrap() == '"')
+    const char *End = Src.data() + Src.size();
+    for (const char *P = Src.data() + Offset;;) {
+      // Stop at '\' escape, or '"'.
+      P = findAny(P, End, '\\', '"', '$');
+      Offset = P - Src.data();
+      if (P == End || *P != '$')
         break;
       // double-$, or \$, escapes ${.
       // We will handle escaping on Sema
-      if (consumePrefix("$${"))
+      if (consumePrefix("$${")) {
+        P += 3;
         continue;
+      }
       // Encountered a string interpolation, stop here
       if (peekPrefix("${"))
         break;
-      consume();
+      ++P;
     }
   }
   return finishToken();
@@ -454,17 +543,22 @@ Token Lexer::lexIndString() {
   }
 
   Tok = tok_string_part;
-  for (; !eof();) {
-    if (peekPrefix("''"))
+  const char *End = Src.data() + Src.size();
+  for (const char *P = Src.data() + Offset;;) {
+    P = findAny(P, End, '\'', '$', '$');
+    Offset = P - Src.data();
+    if (P == End || peekPrefix("''"))
       break;
     // double-$, or \$, escapes ${.
     // We will handle escaping on Sema
-    if (consumePrefix("$${"))
+    if (consumePrefix("$${")) {
+      P += 3;
       continue;
+    }
     // Encountered a string interpolation, stop here
     if (peekPrefix("${"))
       break;
-    consume();
+    ++P;
   }
   return finishToken();
 }
@@ -492,19 +586,19 @@ Token Lexer::lex() {
   }
 
   // Determine if this is a URI.
-  if (std::isalpha(*Ch)) {
+  if (is(*Ch, CC_Alpha)) {
     if (consumeURI()) {
       Tok = tok_uri;
       return finishToken();
     }
   }
 
-  if (std::isdigit(*Ch)) {
+  if (is(*Ch, CC_Digit)) {
     lexNumbers();
     return finishToken();
   }
 
-  if (std::isalpha(*Ch) || *Ch == '_') {
+  if (is(*Ch, CC_Alpha) || *Ch == '_') {
 
     // So, this is not a path/URI, it should be an identifier.
     lexIdentifier();
@@ -5,14 +5,19 @@
 /// This should be considered as implementation detail of the parser. So the
 /// header is explicitly made private. Unit tests should be placed in the
 /// lib/Parse/test directory.
+///
+/// The lexer only tracks offsets. Lines and columns of token boundaries are
+/// looked up in a `LineIndex`, near the line of the previous lookup.
 #pragma once
 
 #include "Token.h"
 
 #include "nixf/Basic/Diagnostic.h"
+#include "nixf/Basic/LineIndex.h"
 #include "nixf/Basic/Range.h"
 
 #include <cassert>
+#include <memory>
 #include <optional>
 #include <string_view>
 
@@ -22,34 +27,36 @@ class Lexer {
   const std::string_view Src;
   std::vector<Diagnostic> &Diags;
 
-  LexerCursor Cur;
+  /// Lines of the source, if not given by the parser.
+  std::unique_ptr<LineIndex> OwnedLines;
+  const LineIndex &Lines;
+
+  /// Offset of the next character.
+  std::size_t Offset = 0;
+
+  /// The line of the last cursor looked up.
+  mutable std::size_t LineHint = 0;
+
+  /// \brief Cursor of \p Offset, with line and column.
+  [[nodiscard]] LexerCursor cursor(std::size_t Offset) const;
 
   void consume(std::size_t N = 1) {
-    assert(Cur.Offset + N <= Src.length());
-    // Update Line & Column & Offset
-    for (std::size_t I = 0; I < N; ++I) {
-      if (Src[Cur.Offset + I] == '\n') {
-        ++Cur.Line;
-        Cur.Column = 0;
-      } else {
-        ++Cur.Column;
-      }
-    }
-    Cur.Offset += N;
+    assert(Offset + N <= Src.length());
+    Offset += N;
   }
 
   // token recorder
-  LexerCursor TokStartPtr;
+  std::size_t TokStart = 0;
   tok::TokenKind Tok;
   void startToken() {
     Tok = tok::tok_unknown;
-    TokStartPtr = Cur;
+    TokStart = Offset;
   }
   Token finishToken() {
     return {
         Tok,
-        {TokStartPtr, Cur},
-        Src.substr(TokStartPtr.Offset, Cur.Offset - TokStartPtr.Offset),
+        {cursor(TokStart), cursor(Offset)},
+        Src.substr(TokStart, Offset - TokStart),
     };
   }
 
@@ -62,26 +69,23 @@ class Lexer {
     return Offset >= Src.length();
   }
 
-  [[nodiscard]] bool eof() const { return eof(Cur.Offset); }
-
-  bool consumeEOL() { return consumePrefix("\r\n") || consumePrefix("\n"); }
+  [[nodiscard]] bool eof() const { return eof(Offset); }
 
   bool lexFloatExp();
 
   // Advance cursor if it starts with prefix, otherwise do nothing
-  std::optional<LexerCursorRange> consumePrefix(std::string_view Prefix);
+  bool consumePrefix(std::string_view Prefix);
 
   bool consumeOne(char C);
 
   std::optional<char> consumeOneOf(std::string_view Chars);
 
-  std::optional<LexerCursorRange> consumeManyOf(std::string_view Chars);
+  bool consumeManyDigits();
 
-  std::optional<LexerCursorRange> consumeManyDigits() {
-    return consumeManyOf("0123456789");
-  }
+  bool consumeManyPathChar();
 
-  std::optional<LexerCursorRange> consumeManyPathChar();
+  /// Consume path characters and slashes, e.g. "b//c" of "a/${x}b//c".
+  void consumePathSegments();
 
   /// Look ahead and check if we has \p Prefix
   bool peekPrefix(std::string_view Prefix);
@@ -101,16 +105,16 @@ class Lexer {
   void lexNumbers();
 
   [[nodiscard]] std::string_view tokStr() const {
-    return Src.substr(TokStartPtr.Offset, Cur.Offset - TokStartPtr.Offset);
+    return Src.substr(TokStart, Offset - TokStart);
   }
 
-  [[nodiscard]] std::string_view remain() const {
-    return Src.substr(Cur.Offset);
-  }
+  [[nodiscard]] std::string_view remain() const { return Src.substr(Offset); }
 
-  [[nodiscard]] LexerCursorRange curRange() const { return {Cur, Cur}; }
+  [[nodiscard]] LexerCursorRange curRange() const {
+    return LexerCursorRange{cur()};
+  }
 
-  [[nodiscard]] char peekUnwrap() const { return Src[Cur.Offset]; }
+  [[nodiscard]] char peekUnwrap() const { return Src[Offset]; }
 
   [[nodiscard]] std::optional<char> peek() const {
     if (eof())
@@ -120,15 +124,21 @@ class Lexer {
 
 public:
   Lexer(std::string_view Src, std::vector<Diagnostic> &Diags)
-      : Src(Src), Diags(Diags), Cur() {}
+      : Src(Src), Diags(Diags), OwnedLines(std::make_unique<LineIndex>(Src)),
+        Lines(*OwnedLines) {}
+
+  /// \brief Lex \p Src, whose lines are \p Lines.
+  Lexer(std::string_view Src, std::vector<Diagnostic> &Diags,
+        const LineIndex &Lines)
+      : Src(Src), Diags(Diags), Lines(Lines) {}
 
   /// Reset the cursor at source \p offset (zero-based indexing)
   void setCur(const LexerCursor &NewCur) {
-    assert(Src.begin() + NewCur.Offset <= Src.end());
-    Cur = NewCur;
+    assert(NewCur.offset() <= Src.length());
+    Offset = NewCur.offset();
   }
 
-  [[nodiscard]] const LexerCursor &cur() const { return Cur; }
+  [[nodiscard]] LexerCursor cur() const { return cursor(Offset); }
 
   Token lex();
   Token lexString();
@@ -3,7 +3,7 @@
 using namespace nixf;
 using namespace detail;
 
-std::shared_ptr<AttrName> Parser::parseAttrName() {
+AttrName *Parser::parseAttrName() {
   switch (Token Tok = peek(); Tok.kind()) {
   case tok_kw_or:
     Diags.emplace_back(Diagnostic::DK_OrIdentifier, Tok.range());
@@ -11,46 +11,46 @@ std::shared_ptr<AttrName> Parser::parseAttrName() {
   case tok_id: {
     consume();
     auto ID =
-        std::make_shared<Identifier>(Tok.range(), std::string(Tok.view()));
-    return std::make_shared<AttrName>(std::move(ID), Tok.range());
+        Ctx->create<Identifier>(Tok.range(), std::string(Tok.view()));
+    return Ctx->create<AttrName>(ID, Tok.range());
   }
   case tok_dquote: {
-    std::shared_ptr<ExprString> String = parseString(/*IsIndented=*/false);
-    return std::make_shared<AttrName>(std::move(String));
+    ExprString *String = parseString(/*IsIndented=*/false);
+    return Ctx->create<AttrName>(String);
   }
   case tok_dollar_curly: {
-    std::shared_ptr<Interpolation> Expr = parseInterpolation();
-    return std::make_shared<AttrName>(std::move(Expr));
+    Interpolation *Expr = parseInterpolation();
+    return Ctx->create<AttrName>(Expr);
   }
   default:
     return nullptr;
   }
 }
 
-std::shared_ptr<AttrPath> Parser::parseAttrPath() {
-  auto First = parseAttrName();
+AttrPath *Parser::parseAttrPath() {
+  auto *First = parseAttrName();
   if (!First)
     return nullptr;
   LexerCursor Begin = First->lCur();
   assert(LastToken && "LastToken should be set after valid attrname");
-  std::vector<std::shared_ptr<AttrName>> AttrNames;
-  const AttrName *PrevName = First.get();
+  std::vector<AttrName *> AttrNames;
+  const AttrName *PrevName = First;
   const AttrName *NextName = nullptr;
-  AttrNames.emplace_back(std::move(First));
-  std::vector<std::shared_ptr<Dot>> Dots;
+  AttrNames.emplace_back(First);
+  std::vector<Dot *> Dots;
   auto SyncDot = withSync(tok_dot);
   while (true) {
     if (Token Tok = peek(); Tok.kind() == tok_dot) {
       consume();
-      auto Next = parseAttrName();
-      NextName = Next.get();
+      auto *Next = parseAttrName();
+      NextName = Next;
       // Make a "dot" node.
-      auto Do = std::make_shared<Dot>(Tok.range(), PrevName, NextName);
+      auto *Do = Ctx->create<Dot>(Tok.range(), PrevName, NextName);
       // Only update "PrevName" if "Next" is not nullptr.
       // More information could be obtained by those dots.
       if (NextName)
         PrevName = NextName;
-      Dots.emplace_back(std::move(Do));
+      Dots.emplace_back(Do);
       if (!Next) {
         // extra ".", consider remove it.
         Diagnostic &D =
@@ -60,17 +60,17 @@ std::shared_ptr<AttrPath> Parser::parseAttrPath() {
             .edit(TextEdit::mkInsertion(Tok.rCur(), R"("dummy")"));
         continue;
       }
-      AttrNames.emplace_back(std::move(Next));
+      AttrNames.emplace_back(Next);
       continue;
     }
     break;
   }
-  return std::make_shared<AttrPath>(LexerCursorRange{Begin, LastToken->rCur()},
-                                    std::move(AttrNames), std::move(Dots));
+  return Ctx->create<AttrPath>(LexerCursorRange{Begin, LastToken->rCur()},
+                               std::move(AttrNames), std::move(Dots));
 }
 
-std::shared_ptr<Binding> Parser::parseBinding() {
-  auto Path = parseAttrPath();
+Binding *Parser::parseBinding() {
+  auto *Path = parseAttrPath();
   if (!Path)
     return nullptr;
   assert(LastToken && "LastToken should be set after valid attrpath");
@@ -78,12 +78,12 @@ std::shared_ptr<Binding> Parser::parseBinding() {
   auto SyncSemi = withSync(tok_semi_colon);
   ExpectResult ExpTokEq = expect(tok_eq);
   if (!ExpTokEq.ok())
-    return std::make_shared<Binding>(
-        LexerCursorRange{Path->lCur(), LastToken->rCur()}, std::move(Path),
-        nullptr, nullptr);
+    return Ctx->create<Binding>(
+        LexerCursorRange{Path->lCur(), LastToken->rCur()}, Path, nullptr,
+        nullptr);
   consume();
-  auto TokEq = std::make_shared<Misc>(ExpTokEq.tok().range());
-  auto Expr = parseExpr();
+  auto *TokEq = Ctx->create<Misc>(ExpTokEq.tok().range());
+  auto *Expr = parseExpr();
   if (!Expr)
     diagNullExpr(Diags, LastToken->rCur(), "binding");
   if (Token Tok = peek(); Tok.kind() == tok_semi_colon) {
@@ -97,12 +97,11 @@ std::shared_ptr<Binding> Parser::parseBinding() {
     D << std::string(tok::spelling(tok_semi_colon));
     D.fix("insert ;").edit(TextEdit::mkInsertion(LastToken->rCur(), ";"));
   }
-  return std::make_shared<Binding>(
-      LexerCursorRange{Path->lCur(), LastToken->rCur()}, std::move(Path),
-      std::move(Expr), std::move(TokEq));
+  return Ctx->create<Binding>(LexerCursorRange{Path->lCur(), LastToken->rCur()},
+                              Path, Expr, TokEq);
 }
 
-std::shared_ptr<Inherit> Parser::parseInherit() {
+Inherit *Parser::parseInherit() {
   Token TokInherit = peek();
   if (TokInherit.kind() != tok_kw_inherit)
     return nullptr;
@@ -115,8 +114,8 @@ std::shared_ptr<Inherit> Parser::parseInherit() {
   auto SyncDollarCurly = withSync(tok_dollar_curly);
 
   assert(LastToken && "LastToken should be set after consume()");
-  std::vector<std::shared_ptr<AttrName>> AttrNames;
-  std::shared_ptr<Expr> Expr = nullptr;
+  std::vector<AttrName *> AttrNames;
+  Expr *Expr = nullptr;
   if (Token Tok = peek(); Tok.kind() == tok_l_paren) {
     consume();
     Expr = parseExpr();
@@ -129,8 +128,8 @@ std::shared_ptr<Inherit> Parser::parseInherit() {
           << std::string(tok::spelling(tok_l_paren));
   }
   while (true) {
-    if (auto AttrName = parseAttrName()) {
-      AttrNames.emplace_back(std::move(AttrName));
+    if (auto *AttrName = parseAttrName()) {
+      AttrNames.emplace_back(AttrName);
       continue;
     }
     break;
@@ -154,15 +153,12 @@ std::shared_ptr<Inherit> Parser::parseInherit() {
       F.edit(TextEdit::mkRemoval(ER.tok().range()));
     }
   }
-  return std::make_shared<Inherit>(
+  return Ctx->create<Inherit>(
       LexerCursorRange{TokInherit.lCur(), LastToken->rCur()},
-      std::move(AttrNames), std::move(Expr));
+      std::move(AttrNames), Expr);
 }
 
-std::shared_ptr<Binds> Parser::parseBinds() {
-  // TODO: curently we don't support inherit
-  LexerCursor Begin = peek().lCur();
-  std::vector<std::shared_ptr<Node>> Bindings;
+void Parser::parseBindings(std::vector<Node *> &Bindings) {
   // attrpath
   auto SyncID = withSync(tok_id);
   auto SyncQuote = withSync(tok_dquote);
@@ -171,12 +167,12 @@ std::shared_ptr<Binds> Parser::parseBinds() {
   // inherit
   auto SyncInherit = withSync(tok_kw_inherit);
   while (true) {
-    if (auto Binding = parseBinding()) {
-      Bindings.emplace_back(std::move(Binding));
+    if (auto *Binding = parseBinding()) {
+      Bindings.emplace_back(Binding);
       continue;
     }
-    if (auto Inherit = parseInherit()) {
-      Bindings.emplace_back(std::move(Inherit));
+    if (auto *Inherit = parseInherit()) {
+      Bindings.emplace_back(Inherit);
       continue;
     }
     // If it is neither a binding, nor an inherit. Let's consume an "Unknown"
@@ -185,15 +181,22 @@ std::shared_ptr<Binds> Parser::parseBinds() {
       continue;
     break;
   }
+}
+
+Binds *Parser::parseBinds() {
+  // TODO: curently we don't support inherit
+  LexerCursor Begin = peek().lCur();
+  std::vector<Node *> Bindings;
+  parseBindings(Bindings);
   if (Bindings.empty())
     return nullptr;
   assert(LastToken && "LastToken should be set after valid binding");
-  return std::make_shared<Binds>(LexerCursorRange{Begin, LastToken->rCur()},
-                                 std::move(Bindings));
+  return Ctx->create<Binds>(LexerCursorRange{Begin, LastToken->rCur()},
+                            std::move(Bindings));
 }
 
-std::shared_ptr<ExprAttrs> Parser::parseExprAttrs() {
-  std::shared_ptr<Misc> Rec;
+ExprAttrs *Parser::parseExprAttrs() {
+  Misc *Rec = nullptr;
 
   auto Sync = withSync(tok_r_curly);
 
@@ -203,19 +206,19 @@ std::shared_ptr<ExprAttrs> Parser::parseExprAttrs() {
   LexerCursor Begin = peek().lCur(); // rec or {
   if (Token Tok = peek(); Tok.kind() == tok_kw_rec) {
     consume();
-    Rec = std::make_shared<Misc>(Tok.range());
+    Rec = Ctx->create<Misc>(Tok.range());
   }
   if (ExpectResult ER = expect(tok_l_curly); ER.ok()) {
     consume();
     Matcher = ER.tok();
   }
   assert(LastToken && "LastToken should be set after valid { or rec");
-  auto Binds = parseBinds();
+  auto *Binds = parseBinds();
   if (ExpectResult ER = expect(tok_r_curly); ER.ok())
     consume();
   else
     ER.diag().note(Note::NK_ToMachThis, Matcher.range())
         << std::string(tok::spelling(Matcher.kind()));
-  return Act.onExprAttrs(LexerCursorRange{Begin, LastToken->rCur()},
-                         std::move(Binds), std::move(Rec));
+  return Act.onExprAttrs(LexerCursorRange{Begin, LastToken->rCur()}, Binds,
+                         Rec);
 }
@@ -3,8 +3,8 @@
 using namespace nixf;
 using namespace nixf::detail;
 
-std::shared_ptr<Expr> Parser::parseExprSelect() {
-  std::shared_ptr<Expr> Expr = parseExprSimple();
+Expr *Parser::parseExprSelect() {
+  Expr *Expr = parseExprSimple();
   if (!Expr)
     return nullptr;
   assert(LastToken && "LastToken should be set after valid expr");
@@ -18,9 +18,9 @@ std::shared_ptr<Expr> Parser::parseExprSelect() {
 
   // expr_select : expr_simple '.' attrpath
   //             | expr_simple '.' attrpath 'or' expr_select
-  auto Do = std::make_shared<Dot>(Tok.range(), Expr.get(), nullptr);
+  auto *Do = Ctx->create<Dot>(Tok.range(), Expr, nullptr);
   consume(); // .
-  auto Path = parseAttrPath();
+  auto *Path = parseAttrPath();
   if (!Path) {
     // extra ".", consider remove it.
     Diagnostic &D =
@@ -33,47 +33,44 @@ std::shared_ptr<Expr> Parser::parseExprSelect() {
   Token TokOr = peek();
   if (TokOr.kind() != tok_kw_or) {
     // expr_select : expr_simple '.' attrpath
-    return std::make_shared<ExprSelect>(
-        LexerCursorRange{Begin, LastToken->rCur()}, std::move(Expr),
-        std::move(Do), std::move(Path), /*Default=*/nullptr,
-        /*DesugaredFrom=*/nullptr);
+    return Ctx->create<ExprSelect>(LexerCursorRange{Begin, LastToken->rCur()},
+                                   Expr, Do, Path, /*Default=*/nullptr,
+                                   /*DesugaredFrom=*/nullptr);
   }
 
   // expr_select : expr_simple '.' attrpath 'or' expr_select
   consume(); // `or`
-  auto Default = parseExprSelect();
+  auto *Default = parseExprSelect();
   if (!Default) {
     Diagnostic &D = diagNullExpr(Diags, LastToken->rCur(), "default");
     D.fix("remove `or` keyword").edit(TextEdit::mkRemoval(TokOr.range()));
   }
-  return std::make_shared<ExprSelect>(
-      LexerCursorRange{Begin, LastToken->rCur()}, std::move(Expr),
-      std::move(Do), std::move(Path), std::move(Default),
-      /*DesugaredFrom=*/nullptr);
+  return Ctx->create<ExprSelect>(LexerCursorRange{Begin, LastToken->rCur()},
+                                 Expr, Do, Path, Default,
+                                 /*DesugaredFrom=*/nullptr);
 }
 
-std::shared_ptr<Expr> Parser::parseExprApp(int Limit) {
-  std::shared_ptr<Expr> Fn = parseExprSelect();
+Expr *Parser::parseExprApp(int Limit) {
+  Expr *Fn = parseExprSelect();
   // If fn cannot be evaluated to lambda, exit early.
   if (!Fn || !Fn->maybeLambda())
     return Fn;
 
-  std::vector<std::shared_ptr<Expr>> Args;
+  std::vector<Expr *> Args;
   while (Limit--) {
-    std::shared_ptr<Expr> Arg = parseExprSelect();
+    Expr *Arg = parseExprSelect();
     if (!Arg)
       break;
-    Args.emplace_back(std::move(Arg));
+    Args.emplace_back(Arg);
   }
 
   if (Args.empty())
     return Fn;
-  return std::make_shared<ExprCall>(
-      LexerCursorRange{Fn->lCur(), Args.back()->rCur()}, std::move(Fn),
-      std::move(Args));
+  return Ctx->create<ExprCall>(
+      LexerCursorRange{Fn->lCur(), Args.back()->rCur()}, Fn, std::move(Args));
 }
 
-std::shared_ptr<Expr> Parser::parseExpr() {
+Expr *Parser::parseExpr() {
   // Look ahead 4 tokens.
   switch (peek().kind()) {
   case tok_id: {
@@ -143,7 +140,7 @@ std::shared_ptr<Expr> Parser::parseExpr() {
   return parseExprOp();
 }
 
-std::shared_ptr<ExprIf> Parser::parseExprIf() {
+ExprIf *Parser::parseExprIf() {
   LexerCursor LCur = lCur(); // if
   Token TokIf = peek();
   assert(TokIf.kind() == tok_kw_if && "parseExprIf should start with `if`");
@@ -153,7 +150,7 @@ std::shared_ptr<ExprIf> Parser::parseExprIf() {
   auto SyncThen = withSync(tok_kw_then);
   auto SyncElse = withSync(tok_kw_else);
 
-  auto Cond = parseExpr();
+  auto *Cond = parseExpr();
   if (!Cond) {
     Diagnostic &D = diagNullExpr(Diags, LastToken->rCur(), "condition");
     D.fix("remove `if` keyword").edit(TextEdit::mkRemoval(TokIf.range()));
@@ -161,8 +158,8 @@ std::shared_ptr<ExprIf> Parser::parseExprIf() {
         .edit(TextEdit::mkInsertion(TokIf.rCur(), "true"));
 
     if (peek().kind() != tok_kw_then)
-      return std::make_shared<ExprIf>(LexerCursorRange{LCur, LastToken->rCur()},
-                                      std::move(Cond), /*Then=*/nullptr,
+      return Ctx->create<ExprIf>(LexerCursorRange{LCur, LastToken->rCur()},
+                                      Cond, /*Then=*/nullptr,
                                       /*Else=*/nullptr);
   }
 
@@ -171,46 +168,44 @@ std::shared_ptr<ExprIf> Parser::parseExprIf() {
     Diagnostic &D = ExpKwThen.diag();
     Note &N = D.note(Note::NK_ToMachThis, TokIf.range());
     N << std::string(tok::spelling(tok_kw_if));
-    return std::make_shared<ExprIf>(LexerCursorRange{LCur, LastToken->rCur()},
-                                    std::move(Cond), /*Then=*/nullptr,
-                                    /*Else=*/nullptr);
+    return Ctx->create<ExprIf>(LexerCursorRange{LCur, LastToken->rCur()}, Cond,
+                               /*Then=*/nullptr, /*Else=*/nullptr);
   }
 
   consume(); // then
 
-  auto Then = parseExpr();
+  auto *Then = parseExpr();
   if (!Then) {
     Diagnostic &D = diagNullExpr(Diags, LastToken->rCur(), "then");
     Note &N = D.note(Note::NK_ToMachThis, TokIf.range());
     N << std::string(tok::spelling(tok_kw_if));
 
     if (peek().kind() != tok_kw_else)
-      return std::make_shared<ExprIf>(LexerCursorRange{LCur, LastToken->rCur()},
-                                      std::move(Cond), std::move(Then),
+      return Ctx->create<ExprIf>(LexerCursorRange{LCur, LastToken->rCur()},
+                                      Cond, Then,
                                       /*Else=*/nullptr);
   }
 
   ExpectResult ExpKwElse = expect(tok_kw_else);
   if (!ExpKwElse.ok())
-    return std::make_shared<ExprIf>(LexerCursorRange{LCur, LastToken->rCur()},
-                                    std::move(Cond), std::move(Then),
+    return Ctx->create<ExprIf>(LexerCursorRange{LCur, LastToken->rCur()},
+                                    Cond, Then,
                                     /*Else=*/nullptr);
 
   consume(); // else
 
-  auto Else = parseExpr();
+  auto *Else = parseExpr();
   if (!Else) {
     Diagnostic &D = diagNullExpr(Diags, LastToken->rCur(), "else");
     Note &N = D.note(Note::NK_ToMachThis, TokIf.range());
     N << std::string(tok::spelling(tok_kw_if));
   }
 
-  return std::make_shared<ExprIf>(LexerCursorRange{LCur, LastToken->rCur()},
-                                  std::move(Cond), std::move(Then),
-                                  std::move(Else));
+  return Ctx->create<ExprIf>(LexerCursorRange{LCur, LastToken->rCur()}, Cond,
+                             Then, Else);
 }
 
-std::shared_ptr<ExprAssert> Parser::parseExprAssert() {
+ExprAssert *Parser::parseExprAssert() {
   LexerCursor LCur = lCur();
   Token TokAssert = peek();
   assert(TokAssert.kind() == tok_kw_assert && "should be tok_kw_assert");
@@ -219,15 +214,15 @@ std::shared_ptr<ExprAssert> Parser::parseExprAssert() {
 
   auto SyncSemi = withSync(tok_semi_colon);
 
-  auto Cond = parseExpr();
+  auto *Cond = parseExpr();
   if (!Cond) {
     Diagnostic &D = diagNullExpr(Diags, LastToken->rCur(), "condition");
     D.fix("remove `assert` keyword")
         .edit(TextEdit::mkRemoval(TokAssert.range()));
 
     if (peek().kind() != tok_colon)
-      return std::make_shared<ExprAssert>(
-          LexerCursorRange{LCur, LastToken->rCur()}, std::move(Cond),
+      return Ctx->create<ExprAssert>(
+          LexerCursorRange{LCur, LastToken->rCur()}, Cond,
           /*Value=*/nullptr);
   }
 
@@ -237,29 +232,28 @@ std::shared_ptr<ExprAssert> Parser::parseExprAssert() {
     Diagnostic &D = ExpSemi.diag();
     Note &N = D.note(Note::NK_ToMachThis, TokAssert.range());
     N << std::string(tok::spelling(tok_kw_assert));
-    return std::make_shared<ExprAssert>(
-        LexerCursorRange{LCur, LastToken->rCur()}, std::move(Cond),
-        /*Value=*/nullptr);
+    return Ctx->create<ExprAssert>(LexerCursorRange{LCur, LastToken->rCur()},
+                                   Cond, /*Value=*/nullptr);
   }
 
   consume(); // ;
 
-  auto Value = parseExpr();
+  auto *Value = parseExpr();
 
   if (!Value)
     diagNullExpr(Diags, LastToken->rCur(), "assert value");
 
-  return std::make_shared<ExprAssert>(LexerCursorRange{LCur, LastToken->rCur()},
-                                      std::move(Cond), std::move(Value));
+  return Ctx->create<ExprAssert>(LexerCursorRange{LCur, LastToken->rCur()},
+                                 Cond, Value);
 }
 
-std::shared_ptr<ExprLet> Parser::parseExprLet() {
+ExprLet *Parser::parseExprLet() {
   LexerCursor LCur = lCur();
   Token TokLet = peek();
   assert(TokLet.kind() == tok_kw_let &&
          "first token should be tok_kw_let in parseExprLet()");
 
-  auto Let = std::make_shared<Misc>(TokLet.range());
+  auto *Let = Ctx->create<Misc>(TokLet.range());
 
   consume(); // 'let'
 
@@ -267,44 +261,42 @@ std::shared_ptr<ExprLet> Parser::parseExprLet() {
 
   assert(LastToken && "LastToken should be set after consume()");
 
-  auto Binds = parseBinds();
-  auto Attrs = Binds ? Act.onExprAttrs(Binds->range(), Binds, Let) : nullptr;
+  auto *Binds = parseBinds();
+  auto *Attrs = Binds ? Act.onExprAttrs(Binds->range(), Binds, Let) : nullptr;
 
   ExpectResult ExpKwIn = expect(tok_kw_in);
 
   if (!ExpKwIn.ok()) {
     // missing 'in'
-    return std::make_shared<ExprLet>(LexerCursorRange{LCur, LastToken->rCur()},
-                                     std::move(Let), /*KwIn=*/nullptr,
-                                     /*E=*/nullptr, std::move(Attrs));
+    return Ctx->create<ExprLet>(LexerCursorRange{LCur, LastToken->rCur()}, Let,
+                                /*KwIn=*/nullptr, /*E=*/nullptr, Attrs);
   }
 
-  auto In = std::make_shared<Misc>(ExpKwIn.tok().range());
+  auto *In = Ctx->create<Misc>(ExpKwIn.tok().range());
 
   consume(); // 'in'
 
-  auto E = parseExpr();
+  auto *E = parseExpr();
   if (!E)
     diagNullExpr(Diags, LastToken->rCur(), "let ... in");
 
-  return std::make_shared<ExprLet>(LexerCursorRange{LCur, LastToken->rCur()},
-                                   std::move(Let), std::move(In), std::move(E),
-                                   std::move(Attrs));
+  return Ctx->create<ExprLet>(LexerCursorRange{LCur, LastToken->rCur()}, Let,
+                              In, E, Attrs);
 }
 
-std::shared_ptr<ExprWith> Parser::parseExprWith() {
+ExprWith *Parser::parseExprWith() {
   LexerCursor LCur = lCur();
   Token TokWith = peek();
   assert(TokWith.kind() == tok_kw_with && "token should be tok_kw_with");
 
   consume(); // with
 
-  auto KwWith = std::make_shared<Misc>(TokWith.range());
+  auto *KwWith = Ctx->create<Misc>(TokWith.range());
   assert(LastToken && "LastToken should be set after consume()");
 
   auto SyncSemi = withSync(tok_semi_colon);
 
-  auto With = parseExpr();
+  auto *With = parseExpr();
 
   if (!With)
     diagNullExpr(Diags, LastToken->rCur(), "with expression");
@@ -313,30 +305,29 @@ std::shared_ptr<ExprWith> Parser::parseExprWith() {
   if (!ExpSemi.ok()) {
     ExpSemi.diag().note(Note::NK_ToMachThis, TokWith.range())
         << std::string(tok::spelling(tok_kw_with));
-    return std::make_shared<ExprWith>(LexerCursorRange{LCur, LastToken->rCur()},
-                                      std::move(KwWith), /*TokSemi*/ nullptr,
-                                      std::move(With), /*E=*/nullptr);
+    return Ctx->create<ExprWith>(LexerCursorRange{LCur, LastToken->rCur()},
+                                 KwWith, /*TokSemi*/ nullptr, With,
+                                 /*E=*/nullptr);
   }
 
-  auto TokSemi = std::make_shared<Misc>(ExpSemi.tok().range());
+  auto *TokSemi = Ctx->create<Misc>(ExpSemi.tok().range());
   consume(); // ;
 
-  auto E = parseExpr();
+  auto *E = parseExpr();
 
   if (!E)
     diagNullExpr(Diags, LastToken->rCur(), "with body");
 
-  return std::make_shared<ExprWith>(LexerCursorRange{LCur, LastToken->rCur()},
-                                    std::move(KwWith), std::move(TokSemi),
-                                    std::move(With), std::move(E));
+  return Ctx->create<ExprWith>(LexerCursorRange{LCur, LastToken->rCur()},
+                               KwWith, TokSemi, With, E);
 }
 
-std::shared_ptr<ExprLegacyLet> Parser::parseExprLegacyLet() {
+ExprLegacyLet *Parser::parseExprLegacyLet() {
   LexerCursor LCur = lCur();
   Token TokLet = peek();
   assert(TokLet.kind() == tok_kw_let &&
          "parseExprLegacyLet should start with `let`");
-  auto KwLet = std::make_shared<Misc>(TokLet.range());
+  auto *KwLet = Ctx->create<Misc>(TokLet.range());
   consume(); // 'let'
 
   auto Sync = withSync(tok_r_curly);
@@ -347,7 +338,7 @@ std::shared_ptr<ExprLegacyLet> Parser::parseExprLegacyLet() {
   }
   assert(LastToken && "LastToken should be set after consume()");
 
-  auto Binds = parseBinds();
+  auto *Binds = parseBinds();
 
   LexerCursorRange RCurlyRange{LastToken->rCur(), LastToken->rCur()};
   if (ExpectResult ER = expect(tok_r_curly); ER.ok()) {
@@ -360,7 +351,7 @@ std::shared_ptr<ExprLegacyLet> Parser::parseExprLegacyLet() {
 
   auto Attrs =
       Act.onExprAttrs(LexerCursorRange{TokLet.lCur(), LastToken->rCur()},
-                      std::move(Binds), KwLet);
+                      Binds, KwLet);
 
   LexerCursorRange FullRange{LCur, LastToken->rCur()};
 
@@ -393,6 +384,5 @@ std::shared_ptr<ExprLegacyLet> Parser::parseExprLegacyLet() {
   if (!HasBody)
     Diags.emplace_back(Diagnostic::DK_LetAttrsMissingBody, FullRange);
 
-  return std::make_shared<ExprLegacyLet>(FullRange, std::move(KwLet),
-                                         std::move(Attrs));
+  return Ctx->create<ExprLegacyLet>(FullRange, KwLet, Attrs);
 }
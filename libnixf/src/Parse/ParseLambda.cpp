@@ -3,51 +3,49 @@
 using namespace nixf;
 using namespace detail;
 
-std::shared_ptr<Formal> Parser::parseFormal() {
+Formal *Parser::parseFormal() {
   // formal : ,? ID
   //        | ,? ID '?' expr
   //        | ,? ...
 
   LexerCursor LCur = lCur();
-  std::shared_ptr<Misc> Comma = nullptr;
+  Misc *Comma = nullptr;
   if (Token Tok = peek(); Tok.kind() == tok_comma) {
     consume();
-    Comma = std::make_shared<Misc>(Tok.range());
+    Comma = Ctx->create<Misc>(Tok.range());
   }
   if (Token Tok = peek(); Tok.kind() == tok_id) {
     consume(); // ID
     assert(LastToken && "LastToken should be set after consume()");
     auto ID =
-        std::make_shared<Identifier>(Tok.range(), std::string(Tok.view()));
+        Ctx->create<Identifier>(Tok.range(), std::string(Tok.view()));
     if (peek().kind() != tok_question)
-      return std::make_shared<Formal>(LexerCursorRange{LCur, LastToken->rCur()},
-                                      std::move(Comma), std::move(ID), nullptr);
+      return Ctx->create<Formal>(LexerCursorRange{LCur, LastToken->rCur()},
+                                      Comma, ID, nullptr);
     consume(); // ?
-    std::shared_ptr<Expr> Default = parseExpr();
+    Expr *Default = parseExpr();
     if (!Default)
       diagNullExpr(Diags, LastToken->rCur(), "default value");
-    return std::make_shared<Formal>(LexerCursorRange{LCur, LastToken->rCur()},
-                                    std::move(Comma), std::move(ID),
-                                    std::move(Default));
+    return Ctx->create<Formal>(LexerCursorRange{LCur, LastToken->rCur()}, Comma,
+                               ID, Default);
   }
   if (Token Tok = peek(); Tok.kind() == tok_ellipsis) {
     consume(); // ...
     assert(LastToken && "LastToken should be set after consume()");
-    std::shared_ptr<Misc> Ellipsis = std::make_shared<Misc>(Tok.range());
-    return std::make_shared<Formal>(LexerCursorRange{LCur, LastToken->rCur()},
-                                    std::move(Comma), std::move(Ellipsis));
+    Misc *Ellipsis = Ctx->create<Misc>(Tok.range());
+    return Ctx->create<Formal>(LexerCursorRange{LCur, LastToken->rCur()}, Comma,
+                               Ellipsis);
   }
 
   if (Comma) {
     assert(LastToken && "LastToken should be set after consume()");
-    return std::make_shared<Formal>(LexerCursorRange{LCur, LastToken->rCur()},
-                                    std::move(Comma), /*ID=*/nullptr,
-                                    /*Default=*/nullptr);
+    return Ctx->create<Formal>(LexerCursorRange{LCur, LastToken->rCur()}, Comma,
+                               /*ID=*/nullptr, /*Default=*/nullptr);
   }
   return nullptr;
 }
 
-std::shared_ptr<Formals> Parser::parseFormals() {
+Formals *Parser::parseFormals() {
   ExpectResult ER = expect(tok_l_curly);
   if (!ER.ok())
     return nullptr;
@@ -59,13 +57,13 @@ std::shared_ptr<Formals> Parser::parseFormals() {
   auto SyncQuestion = withSync(tok_question);
   auto SyncID = withSync(tok_id);
   LexerCursor LCur = ER.tok().lCur();
-  std::vector<std::shared_ptr<Formal>> Members;
+  std::vector<Formal *> Members;
   while (true) {
     if (Token Tok = peek(); Tok.kind() == tok_r_curly)
       break;
-    std::shared_ptr<Formal> Formal = parseFormal();
+    Formal *Formal = parseFormal();
     if (Formal) {
-      Members.emplace_back(std::move(Formal));
+      Members.emplace_back(Formal);
       continue;
     }
     if (removeUnexpected())
@@ -81,19 +79,19 @@ std::shared_ptr<Formals> Parser::parseFormals() {
                        std::move(Members));
 }
 
-std::shared_ptr<LambdaArg> Parser::parseLambdaArg() {
+LambdaArg *Parser::parseLambdaArg() {
   LexerCursor LCur = lCur();
   if (Token TokID = peek(); TokID.kind() == tok_id) {
     consume(); // ID
     assert(LastToken && "LastToken should be set after consume()");
     auto ID =
-        std::make_shared<Identifier>(TokID.range(), std::string(TokID.view()));
+        Ctx->create<Identifier>(TokID.range(), std::string(TokID.view()));
     if (peek().kind() != tok_at)
       return Act.onLambdaArg(LexerCursorRange{LCur, LastToken->rCur()},
-                             std::move(ID), nullptr);
+                             ID, nullptr);
 
     consume(); // @
-    std::shared_ptr<Formals> Formals = parseFormals();
+    Formals *Formals = parseFormals();
     if (!Formals) {
       // extra "@", consider remove it.
       Diagnostic &D =
@@ -102,46 +100,46 @@ std::shared_ptr<LambdaArg> Parser::parseLambdaArg() {
       D.fix("insert dummy formals")
           .edit(TextEdit::mkInsertion(TokID.rCur(), R"({})"));
     }
-    return Act.onLambdaArg(LexerCursorRange{LCur, LastToken->rCur()},
-                           std::move(ID), std::move(Formals));
+    return Act.onLambdaArg(LexerCursorRange{LCur, LastToken->rCur()}, ID,
+                           Formals);
   }
 
-  std::shared_ptr<Formals> Formals = parseFormals();
+  Formals *Formals = parseFormals();
   if (!Formals)
     return nullptr;
   assert(LastToken && "LastToken should be set after valid formals");
   Token TokAt = peek();
   if (TokAt.kind() != tok_at)
     return Act.onLambdaArg(LexerCursorRange{LCur, LastToken->rCur()}, nullptr,
-                           std::move(Formals));
+                           Formals);
   consume(); // @
   ExpectResult ER = expect(tok_id);
   if (!ER.ok()) {
     ER.diag().note(Note::NK_ToMachThis, TokAt.range())
         << std::string(tok::spelling(tok_at));
     return Act.onLambdaArg(LexerCursorRange{LCur, LastToken->rCur()}, nullptr,
-                           std::move(Formals));
+                           Formals);
   }
   consume(); // ID
-  auto ID = std::make_shared<Identifier>(ER.tok().range(),
+  auto *ID = Ctx->create<Identifier>(ER.tok().range(),
                                          std::string(ER.tok().view()));
-  return Act.onLambdaArg(LexerCursorRange{LCur, LastToken->rCur()},
-                         std::move(ID), std::move(Formals));
+  return Act.onLambdaArg(LexerCursorRange{LCur, LastToken->rCur()}, ID,
+                         Formals);
 }
 
-std::shared_ptr<ExprLambda> Parser::parseExprLambda() {
+ExprLambda *Parser::parseExprLambda() {
   // expr_lambda : lambda_arg ':' expr
   LexerCursor LCur = lCur();
-  std::shared_ptr<LambdaArg> Arg = parseLambdaArg();
+  LambdaArg *Arg = parseLambdaArg();
   assert(LastToken && "LastToken should be set after parseLambdaArg");
   if (!Arg)
     return nullptr;
   if (ExpectResult ER = expect(tok_colon); ER.ok())
     consume();
 
-  std::shared_ptr<Expr> Body = parseExpr();
+  Expr *Body = parseExpr();
   if (!Body)
     diagNullExpr(Diags, LastToken->rCur(), "lambda body");
-  return std::make_shared<ExprLambda>(LexerCursorRange{LCur, LastToken->rCur()},
-                                      std::move(Arg), std::move(Body));
+  return Ctx->create<ExprLambda>(LexerCursorRange{LCur, LastToken->rCur()}, Arg,
+                                 Body);
 }
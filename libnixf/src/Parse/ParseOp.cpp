@@ -80,22 +80,21 @@ unsigned getUnaryBP(TokenKind Kind) {
 
 } // namespace
 
-std::shared_ptr<Expr> Parser::parseExprOpBP(unsigned LeftRBP) {
-  std::shared_ptr<Expr> Prefix;
+Expr *Parser::parseExprOpBP(unsigned LeftRBP) {
+  Expr *Prefix = nullptr;
   LexerCursor LCur = lCur();
   switch (Token Tok = peek(); Tok.kind()) {
   case tok_op_not:
   case tok_op_negate: {
     consume();
     assert(LastToken && "consume() should have set LastToken");
-    auto O = std::make_shared<Op>(Tok.range(), Tok.kind());
-    auto Expr = parseExprOpBP(getUnaryBP(Tok.kind()));
+    auto *O = Ctx->create<Op>(Tok.range(), Tok.kind());
+    auto *Expr = parseExprOpBP(getUnaryBP(Tok.kind()));
     if (!Expr)
       diagNullExpr(Diags, LastToken->rCur(),
                    "unary operator " + std::string(tok::spelling(Tok.kind())));
-    Prefix =
-        std::make_shared<ExprUnaryOp>(LexerCursorRange{LCur, LastToken->rCur()},
-                                      std::move(O), std::move(Expr));
+    Prefix = Ctx->create<ExprUnaryOp>(
+        LexerCursorRange{LCur, LastToken->rCur()}, O, Expr);
     break;
   }
   default:
@@ -127,27 +126,25 @@ std::shared_ptr<Expr> Parser::parseExprOpBP(unsigned LeftRBP) {
         }
         consume();
         assert(LastToken && "consume() should have set LastToken");
-        auto O = std::make_shared<Op>(Tok.range(), Tok.kind());
-        auto RHS = parseExprOpBP(RBP);
+        auto *O = Ctx->create<Op>(Tok.range(), Tok.kind());
+        auto *RHS = parseExprOpBP(RBP);
         if (!RHS) {
           diagNullExpr(Diags, LastToken->rCur(), "binary op RHS");
           continue;
         }
         LexerCursorRange Range{Prefix->lCur(), RHS->rCur()};
-        Prefix = std::make_shared<ExprBinOp>(Range, std::move(O),
-                                             std::move(Prefix), std::move(RHS));
+        Prefix = Ctx->create<ExprBinOp>(Range, O, Prefix, RHS);
         break;
       }
     case tok_question: {
       // expr_op '?' attrpath
       consume();
       assert(LastToken && "consume() should have set LastToken");
-      auto O = std::make_shared<Op>(Tok.range(), Tok.kind());
+      auto *O = Ctx->create<Op>(Tok.range(), Tok.kind());
 
-      std::shared_ptr<AttrPath> Path = parseAttrPath();
+      AttrPath *Path = parseAttrPath();
       LexerCursorRange Range{Prefix->lCur(), LastToken->rCur()};
-      Prefix = std::make_shared<ExprOpHasAttr>(
-          Range, std::move(O), std::move(Prefix), std::move(Path));
+      Prefix = Ctx->create<ExprOpHasAttr>(Range, O, Prefix, Path);
       break;
     }
     case tok_kw_or: {
@@ -158,18 +155,17 @@ std::shared_ptr<Expr> Parser::parseExprOpBP(unsigned LeftRBP) {
       D.fix("replace 'or' with '||'").edit(TextEdit(Tok.range(), "||"));
       consume();
       assert(LastToken && "consume() should have set LastToken");
-      auto O = std::make_shared<Op>(Tok.range(), Tok.kind());
+      auto *O = Ctx->create<Op>(Tok.range(), Tok.kind());
 
       // Try to recover by replacing 'or' with '||'
-      auto RHS = parseExprOpBP(getBP(tok_op_or).second);
+      auto *RHS = parseExprOpBP(getBP(tok_op_or).second);
       if (!RHS) {
         diagNullExpr(Diags, LastToken->rCur(), "RHS of 'or'");
         continue;
       }
 
       LexerCursorRange Range{Prefix->lCur(), RHS->rCur()};
-      Prefix = std::make_shared<ExprBinOp>(Range, std::move(O),
-                                           std::move(Prefix), std::move(RHS));
+      Prefix = Ctx->create<ExprBinOp>(Range, O, Prefix, RHS);
       break;
     }
     default:
@@ -37,20 +37,20 @@ bool mayProducedBySimple(const Expr *E) {
 
 } // namespace
 
-std::shared_ptr<ExprParen> Parser::parseExprParen() {
+ExprParen *Parser::parseExprParen() {
   Token L = peek();
-  auto LParen = std::make_shared<Misc>(L.range());
+  auto *LParen = Ctx->create<Misc>(L.range());
   assert(L.kind() == tok_l_paren);
   consume(); // (
   auto Sync = withSync(tok_r_paren);
   assert(LastToken && "LastToken should be set after consume()");
-  auto Expr = parseExpr();
+  auto *Expr = parseExpr();
   if (!Expr)
     diagNullExpr(Diags, LastToken->rCur(), "parenthesized");
   if (ExpectResult ER = expect(tok_r_paren); ER.ok()) {
     consume(); // )
-    auto RParen = std::make_shared<Misc>(ER.tok().range());
-    if (mayProducedBySimple(Expr.get())) {
+    auto *RParen = Ctx->create<Misc>(ER.tok().range());
+    if (mayProducedBySimple(Expr)) {
       Diagnostic &D =
           Diags.emplace_back(Diagnostic::DK_RedundantParen, LParen->range());
       D.tag(DiagnosticTag::Faded);
@@ -58,27 +58,24 @@ std::shared_ptr<ExprParen> Parser::parseExprParen() {
       F.edit(TextEdit::mkRemoval(LParen->range()));
       F.edit(TextEdit::mkRemoval(RParen->range()));
     }
-    return std::make_shared<ExprParen>(
-        LexerCursorRange{L.lCur(), ER.tok().rCur()}, std::move(Expr),
-        std::move(LParen), std::move(RParen));
+    return Ctx->create<ExprParen>(LexerCursorRange{L.lCur(), ER.tok().rCur()},
+                                  Expr, LParen, RParen);
   } else { // NOLINT(readability-else-after-return)
     ER.diag().note(Note::NK_ToMachThis, L.range())
         << std::string(tok::spelling(tok_l_paren));
-    if (mayProducedBySimple(Expr.get())) {
+    if (mayProducedBySimple(Expr)) {
       Diagnostic &D =
           Diags.emplace_back(Diagnostic::DK_RedundantParen, LParen->range());
       D.tag(DiagnosticTag::Faded);
       Fix &F = D.fix("remove (");
       F.edit(TextEdit::mkRemoval(LParen->range()));
     }
-    return std::make_shared<ExprParen>(
-        LexerCursorRange{L.lCur(), LastToken->rCur()}, std::move(Expr),
-        std::move(LParen),
-        /*RParen=*/nullptr);
+    return Ctx->create<ExprParen>(LexerCursorRange{L.lCur(), LastToken->rCur()},
+                                  Expr, LParen, /*RParen=*/nullptr);
   }
 }
 
-std::shared_ptr<ExprList> Parser::parseExprList() {
+ExprList *Parser::parseExprList() {
   Token Tok = peek();
   if (Tok.kind() != tok_l_bracket)
     return nullptr;
@@ -86,25 +83,25 @@ std::shared_ptr<ExprList> Parser::parseExprList() {
   auto Sync = withSync(tok_r_bracket);
   assert(LastToken && "LastToken should be set after consume()");
   LexerCursor Begin = Tok.lCur();
-  std::vector<std::shared_ptr<Expr>> Exprs;
+  std::vector<Expr *> Exprs;
   while (true) {
     if (Token Tok = peek(); Tok.kind() == tok_r_bracket)
       break;
-    std::shared_ptr<Expr> Expr = parseExprSelect();
+    Expr *Expr = parseExprSelect();
     if (!Expr)
       break;
-    Exprs.emplace_back(std::move(Expr));
+    Exprs.emplace_back(Expr);
   }
   if (ExpectResult ER = expect(tok_r_bracket); ER.ok())
     consume();
   else
     ER.diag().note(Note::NK_ToMachThis, Tok.range())
         << std::string(tok::spelling(tok_l_bracket));
-  return std::make_shared<ExprList>(LexerCursorRange{Begin, LastToken->rCur()},
-                                    std::move(Exprs));
+  return Ctx->create<ExprList>(LexerCursorRange{Begin, LastToken->rCur()},
+                               std::move(Exprs));
 }
 
-std::shared_ptr<Expr> Parser::parseExprSimple() {
+Expr *Parser::parseExprSimple() {
   Token Tok = peek();
   switch (Tok.kind()) {
   case tok_uri: {
@@ -112,11 +109,10 @@ std::shared_ptr<Expr> Parser::parseExprSimple() {
     consume();
     auto Literal = std::string(Tok.view());
     // Create the string used for this URI
-    auto Parts = std::make_shared<InterpolatedParts>(
-        Tok.range(), std::vector<InterpolablePart>{
-                         InterpolablePart{std::move(Literal)},
-                     });
-    auto Str = std::make_shared<ExprString>(Tok.range(), std::move(Parts));
+    auto *Parts = Ctx->create<InterpolatedParts>(
+        Tok.range(),
+        std::vector<InterpolablePart>{ InterpolablePart{std::move(Literal)}, });
+    auto *Str = Ctx->create<ExprString>(Tok.range(), Parts);
     // Report warning about URL deprecation.
     Diagnostic &D =
         Diags.emplace_back(Diagnostic::DK_DeprecatedURL, Tok.range());
@@ -129,8 +125,8 @@ std::shared_ptr<Expr> Parser::parseExprSimple() {
   case tok_id: {
     consume();
     auto ID =
-        std::make_shared<Identifier>(Tok.range(), std::string(Tok.view()));
-    return std::make_shared<ExprVar>(Tok.range(), std::move(ID));
+        Ctx->create<Identifier>(Tok.range(), std::string(Tok.view()));
+    return Ctx->create<ExprVar>(Tok.range(), ID);
   }
   case tok_int: {
     consume();
@@ -142,17 +138,17 @@ std::shared_ptr<Expr> Parser::parseExprSimple() {
       // emit a diagnostic saying we cannot decode integer to NixInt.
       Diags.emplace_back(Diagnostic::DK_IntTooBig, Tok.range());
     }
-    return std::make_shared<ExprInt>(Tok.range(), N);
+    return Ctx->create<ExprInt>(Tok.range(), N);
   }
   case tok_float: {
     consume();
     // libc++ doesn't support std::from_chars for floating point numbers.
     NixFloat N = std::strtof(std::string(Tok.view()).c_str(), nullptr);
-    return std::make_shared<ExprFloat>(Tok.range(), N);
+    return Ctx->create<ExprFloat>(Tok.range(), N);
   }
   case tok_spath: {
     consume();
-    return std::make_shared<ExprSPath>(
+    return Ctx->create<ExprSPath>(
         Tok.range(), std::string(Tok.view().substr(1, Tok.view().size() - 2)));
   }
   case tok_dquote: // "  - normal strings
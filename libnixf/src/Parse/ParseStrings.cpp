@@ -3,7 +3,7 @@
 using namespace nixf;
 using namespace nixf::detail;
 
-std::shared_ptr<Interpolation> Parser::parseInterpolation() {
+Interpolation *Parser::parseInterpolation() {
   Token TokDollarCurly = peek();
   assert(TokDollarCurly.kind() == tok_dollar_curly);
   consume(); // ${
@@ -11,7 +11,7 @@ std::shared_ptr<Interpolation> Parser::parseInterpolation() {
   assert(LastToken);
   /* with(PS_Expr) */ {
     auto ExprState = withState(PS_Expr);
-    auto Expr = parseExpr();
+    auto *Expr = parseExpr();
     if (!Expr)
       diagNullExpr(Diags, LastToken->rCur(), "interpolation");
     if (ExpectResult ER = expect(tok_r_curly); ER.ok()) {
@@ -20,13 +20,12 @@ std::shared_ptr<Interpolation> Parser::parseInterpolation() {
       ER.diag().note(Note::NK_ToMachThis, TokDollarCurly.range())
           << std::string(tok::spelling(tok_dollar_curly));
     }
-    return std::make_shared<Interpolation>(
-        LexerCursorRange{TokDollarCurly.lCur(), LastToken->rCur()},
-        std::move(Expr));
+    return Ctx->create<Interpolation>(
+        LexerCursorRange{TokDollarCurly.lCur(), LastToken->rCur()}, Expr);
   } // with(PS_Expr)
 }
 
-std::shared_ptr<Expr> Parser::parseExprPath() {
+Expr *Parser::parseExprPath() {
   Token Begin = peek();
   std::vector<InterpolablePart> Fragments;
   assert(Begin.kind() == tok_path_fragment);
@@ -42,27 +41,26 @@ std::shared_ptr<Expr> Parser::parseExprPath() {
       if (Next.kind() == tok_path_end)
         break;
       if (Next.kind() == tok_dollar_curly) {
-        if (auto Expr = parseInterpolation())
-          Fragments.emplace_back(std::move(Expr));
+        if (auto *Expr = parseInterpolation())
+          Fragments.emplace_back(Expr);
         continue;
       }
       assert(false && "should be path_end or ${");
     } while (true);
   }
-  auto Parts = std::make_shared<InterpolatedParts>(
+  auto *Parts = Ctx->create<InterpolatedParts>(
       LexerCursorRange{Begin.lCur(), End}, std::move(Fragments));
-  return std::make_shared<ExprPath>(LexerCursorRange{Begin.lCur(), End},
-                                    std::move(Parts));
+  return Ctx->create<ExprPath>(LexerCursorRange{Begin.lCur(), End}, Parts);
 }
 
-std::shared_ptr<InterpolatedParts> Parser::parseStringParts() {
+InterpolatedParts *Parser::parseStringParts() {
   std::vector<InterpolablePart> Parts;
   LexerCursor PartsBegin = peek().lCur();
   while (true) {
     switch (Token Tok = peek(0); Tok.kind()) {
     case tok_dollar_curly: {
-      if (auto Expr = parseInterpolation())
-        Parts.emplace_back(std::move(Expr));
+      if (auto *Expr = parseInterpolation())
+        Parts.emplace_back(Expr);
       continue;
     }
     case tok_string_part: {
@@ -101,14 +99,14 @@ std::shared_ptr<InterpolatedParts> Parser::parseStringParts() {
     }
     default:
       assert(LastToken && "LastToken should be set in `parseString`");
-      return std::make_shared<InterpolatedParts>(
+      return Ctx->create<InterpolatedParts>(
           LexerCursorRange{PartsBegin, LastToken->rCur()},
           std::move(Parts)); // TODO!
     }
   }
 }
 
-std::shared_ptr<ExprString> Parser::parseString(bool IsIndented) {
+ExprString *Parser::parseString(bool IsIndented) {
   Token Quote = peek();
   TokenKind QuoteKind = IsIndented ? tok_quote2 : tok_dquote;
   std::string QuoteSpel(tok::spelling(QuoteKind));
@@ -119,15 +117,15 @@ std::shared_ptr<ExprString> Parser::parseString(bool IsIndented) {
   assert(LastToken && "LastToken should be set after consume()");
   /* with(PS_String / PS_IndString) */ {
     auto StringState = withState(IsIndented ? PS_IndString : PS_String);
-    std::shared_ptr<InterpolatedParts> Parts = parseStringParts();
+    InterpolatedParts *Parts = parseStringParts();
     if (ExpectResult ER = expect(QuoteKind); ER.ok()) {
       consume();
-      return std::make_shared<ExprString>(
-          LexerCursorRange{Quote.lCur(), ER.tok().rCur()}, std::move(Parts));
+      return Ctx->create<ExprString>(
+          LexerCursorRange{Quote.lCur(), ER.tok().rCur()}, Parts);
     } else { // NOLINT(readability-else-after-return)
       ER.diag().note(Note::NK_ToMachThis, Quote.range()) << QuoteSpel;
-      return std::make_shared<ExprString>(
-          LexerCursorRange{Quote.lCur(), Parts->rCur()}, std::move(Parts));
+      return Ctx->create<ExprString>(
+          LexerCursorRange{Quote.lCur(), Parts->rCur()}, Parts);
     }
 
   } // with(PS_String / PS_IndString)
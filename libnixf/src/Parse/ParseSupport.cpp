@@ -37,11 +37,14 @@ Parser::SyncRAII Parser::withSync(TokenKind Kind) { return {*this, Kind}; }
 std::shared_ptr<Node> nixf::parse(std::string_view Src,
                                   std::vector<Diagnostic> &Diags) {
   Parser P(Src, Diags);
-  return P.parse();
+  Expr *AST = P.parse();
+  if (!AST)
+    return nullptr;
+  return ASTContext::share(P.context(), AST);
 }
 
-std::shared_ptr<Expr> nixf::Parser::parse() {
-  auto Expr = parseExpr();
+Expr *nixf::Parser::parse() {
+  auto *Expr = parseExpr();
   if (Token Tok = peek(); Tok.kind() != tok::tok_eof) {
     // TODO: maybe we'd like to have multiple expressions in a single file.
     // Report an error.
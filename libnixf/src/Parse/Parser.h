@@ -4,6 +4,7 @@
 
 #include "Lexer.h"
 
+#include "nixf/Basic/ASTContext.h"
 #include "nixf/Basic/Nodes/Attrs.h"
 #include "nixf/Basic/Nodes/Basic.h"
 #include "nixf/Basic/Nodes/Expr.h"
@@ -39,6 +40,7 @@ public:
 
 private:
   std::string_view Src;
+  std::shared_ptr<ASTContext> Ctx;
   Lexer Lex;
   Sema Act;
   std::vector<Diagnostic> &Diags;
@@ -147,20 +149,27 @@ private:
   LexerCursor lCur() { return peek().lCur(); }
 
   /// Pratt parser for binary/unary operators.
-  std::shared_ptr<Expr> parseExprOpBP(unsigned BP);
+  Expr *parseExprOpBP(unsigned BP);
 
 public:
+  /// \brief Nodes are allocated in \p Ctx, shared with the parser.
   Parser(std::string_view Src, std::vector<Diagnostic> &Diags)
-      : Src(Src), Lex(Src, Diags), Act(Src, Diags), Diags(Diags) {
+      : Src(Src), Ctx(ASTContext::make(Src)),
+        Lex(Src, Diags, Ctx->lines()), Act(Src, Diags, *Ctx), Diags(Diags) {
     pushState(PS_Expr);
   }
 
+  /// \brief The context owning all nodes created by this parser.
+  [[nodiscard]] const std::shared_ptr<ASTContext> &context() const {
+    return Ctx;
+  }
+
   /// \brief Parse interpolations.
   ///
   /// \code
   /// interpolation : "${" expr "}"
   /// \endcode
-  std::shared_ptr<Interpolation> parseInterpolation();
+  Interpolation *parseInterpolation();
 
   /// \brief Parse paths.
   ///
@@ -172,59 +181,65 @@ public:
   /// The first token, path_fragment is lexed in PS_Expr context, then switch in
   /// "PS_Path" context. The ending token "path_end" shall be poped with context
   /// switching.
-  std::shared_ptr<Expr> parseExprPath();
+  Expr *parseExprPath();
 
   /// \code
   /// string_part : interpolation
   ///             | STRING_PART
   ///             | STRING_ESCAPE
   /// \endcode
-  std::shared_ptr<InterpolatedParts> parseStringParts();
+  InterpolatedParts *parseStringParts();
 
   /// \code
   /// string : " string_part* "
   ///        | '' string_part* ''
   /// \endcode
-  std::shared_ptr<ExprString> parseString(bool IsIndented);
+  ExprString *parseString(bool IsIndented);
 
   /// \code
   /// '(' expr ')'
   /// \endcode
-  std::shared_ptr<ExprParen> parseExprParen();
+  ExprParen *parseExprParen();
 
   /// \code
   /// attrname : ID
   ///          | string
   ///          | interpolation
   /// \endcode
-  std::shared_ptr<AttrName> parseAttrName();
+  AttrName *parseAttrName();
 
   /// \code
   /// attrpath : attrname ('.' attrname)*
   /// \endcode
-  std::shared_ptr<AttrPath> parseAttrPath();
+  AttrPath *parseAttrPath();
 
   /// \code
   /// binding : attrpath '=' expr ';'
   /// \endcode
-  std::shared_ptr<Binding> parseBinding();
+  Binding *parseBinding();
 
   /// \code
   /// inherit :  'inherit' '(' expr ')' inherited_attrs ';'
   ///         |  'inherit' inherited_attrs ';'
   /// inherited_attrs: attrname*
   /// \endcode
-  std::shared_ptr<Inherit> parseInherit();
+  Inherit *parseInherit();
+
+  /// \brief Parse bindings and inherits, append them to \p Bindings.
+  ///
+  /// This is the loop body of `parseBinds()`, and it is also used for resuming
+  /// the parser in incremental mode.
+  void parseBindings(std::vector<Node *> &Bindings);
 
   /// \code
   /// binds : ( binding | inherit )*
   /// \endcode
-  std::shared_ptr<Binds> parseBinds();
+  Binds *parseBinds();
 
   /// attrset_expr : REC? '{' binds '}'
   ///
   /// Note: peek `tok_kw_rec` or `tok_l_curly` before calling this function.
-  std::shared_ptr<ExprAttrs> parseExprAttrs();
+  ExprAttrs *parseExprAttrs();
 
   /// \code
   /// expr_simple :  INT
@@ -241,7 +256,7 @@ public:
   ///             | attrset_expr
   ///             | list
   /// \endcode
-  std::shared_ptr<Expr> parseExprSimple();
+  Expr *parseExprSimple();
 
   /// \code
   /// expr_select : expr_simple '.' attrpath
@@ -249,7 +264,7 @@ public:
   ///             | expr_simple 'or' <-- special "apply", 'or' is argument
   ///             | expr_simple
   /// \endcode
-  std::shared_ptr<Expr> parseExprSelect();
+  Expr *parseExprSelect();
 
   /// \code
   /// expr_app : expr_app expr_select
@@ -258,24 +273,24 @@ public:
   ///
   /// Consume at most \p Limit number of `expr_select` as arguments
   /// e.g. `Fn A1 A2 A3` with Limit = 2 will be parsed as `((Fn A1 A2) A3)`
-  std::shared_ptr<Expr> parseExprApp(int Limit = INT_MAX);
+  Expr *parseExprApp(int Limit = INT_MAX);
 
   /// \code
   /// expr_list : '[' expr_select* ']'
   /// \endcode
-  std::shared_ptr<ExprList> parseExprList();
+  ExprList *parseExprList();
 
   /// \code
   /// formal : ,? ID
   ///        | ,? ID '?' expr
   ///        | ,? ...
   /// \endcode
-  std::shared_ptr<Formal> parseFormal();
+  Formal *parseFormal();
 
   /// \code
   /// formals : '{' formal* '}'
   /// \endcode
-  std::shared_ptr<Formals> parseFormals();
+  Formals *parseFormals();
 
   /// \code
   /// lambda_arg : ID
@@ -283,14 +298,14 @@ public:
   ///            | '{' formals '}'
   ///            | '{' formals '}' @ ID
   /// \endcode
-  std::shared_ptr<LambdaArg> parseLambdaArg();
+  LambdaArg *parseLambdaArg();
 
   /// \code
   /// expr_lambda : lambda_arg ':' expr
   /// \endcode
-  std::shared_ptr<ExprLambda> parseExprLambda();
+  ExprLambda *parseExprLambda();
 
-  std::shared_ptr<Expr> parseExpr();
+  Expr *parseExpr();
 
   /// \brief Parse binary/unary operators.
   /// \code
@@ -312,35 +327,49 @@ public:
   /// %nonassoc '?'
   /// %nonassoc NEGATE
   /// \endcode
-  std::shared_ptr<Expr> parseExprOp() { return parseExprOpBP(0); }
+  Expr *parseExprOp() { return parseExprOpBP(0); }
 
   /// \code
   /// expr_if : 'if' expr 'then' expr 'else' expr
   /// \endcode
-  std::shared_ptr<ExprIf> parseExprIf();
+  ExprIf *parseExprIf();
 
   /// \code
   /// expr_assert : 'assert' expr ';' expr
   /// \endcode
-  std::shared_ptr<ExprAssert> parseExprAssert();
+  ExprAssert *parseExprAssert();
 
   /// \code
   /// epxr_let : 'let' binds 'in' expr
   /// \endcode
-  std::shared_ptr<ExprLet> parseExprLet();
+  ExprLet *parseExprLet();
 
   /// \code
   /// expr_legacy_let : 'let' '{' binds '}'
   /// \endcode
-  std::shared_ptr<ExprLegacyLet> parseExprLegacyLet();
+  ExprLegacyLet *parseExprLegacyLet();
 
   /// \code
   /// expr_with :  'with' expr ';' expr
   /// \endcode
-  std::shared_ptr<ExprWith> parseExprWith();
+  ExprWith *parseExprWith();
 
   /// Top-level parsing.
-  std::shared_ptr<Expr> parse();
+  Expr *parse();
+
+  /// \brief Top-level parsing, reusing bindings from \p Old.
+  ///
+  /// \p Old is the AST of previous source, which shares the first \p Unchanged
+  /// bytes with current source. Top-level bindings located entirely in the
+  /// unchanged prefix are reused and the parser resumes right after them.
+  ///
+  /// On success, diagnostics of reused nodes are taken from \p OldDiags, and
+  /// contexts owning reused nodes are retained by `context()`.
+  ///
+  /// \returns nullptr if \p Old cannot be reused, e.g. it was not returned by
+  /// `nixf::parse`. Diagnostics reported so far should be discarded then.
+  Expr *reparse(const std::shared_ptr<Node> &Old,
+                const std::vector<Diagnostic> &OldDiags, std::size_t Unchanged);
 };
 
 } // namespace nixf
@@ -0,0 +1,258 @@
+/// \file
+/// \brief Incremental re-parsing.
+///
+/// Large nix files (package sets, generated hardware configurations) are
+/// usually a single attribute set, maybe wrapped in lambdas, with thousands of
+/// bindings. After an edit, bindings located before the first changed byte are
+/// textually unchanged, so they are reused as-is and the parser resumes right
+/// after them.
+
+#include "Parser.h"
+
+#include "nixf/Parse/Parser.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+
+using namespace nixf;
+
+namespace {
+
+/// \brief Length of the longest common prefix of \p A and \p B.
+std::size_t commonPrefix(std::string_view A, std::string_view B) {
+  auto [AI, BI] = std::mismatch(A.begin(), A.end(), B.begin(), B.end());
+  return AI - A.begin();
+}
+
+/// \brief Collect static names inserted to the enclosing attrset by \p Bind.
+///
+/// For `a.b.c = 1;`, this is "a". For `inherit a b;`, these are "a" and "b".
+void collectNames(const Node &Bind, std::vector<std::string_view> &Names) {
+  switch (Bind.kind()) {
+  case Node::NK_Binding: {
+    const auto &B = static_cast<const Binding &>(Bind);
+    const AttrName *First = B.path().names().front();
+    if (First && First->isStatic())
+      Names.emplace_back(First->staticName());
+    break;
+  }
+  case Node::NK_Inherit: {
+    for (const auto &Name : static_cast<const Inherit &>(Bind).names()) {
+      if (Name && Name->isStatic())
+        Names.emplace_back(Name->staticName());
+    }
+    break;
+  }
+  default:
+    assert(false && "Bind should be either Inherit or Binding");
+  }
+}
+
+/// \brief Check if the parser could be resumed right after \p Bind.
+///
+/// The binding must be terminated by ";", and nothing was reported there.
+/// Otherwise, diagnostics at this point cannot be distinguished from the ones
+/// reported by the resumed parser, e.g. "expected }".
+bool isResumable(const Node &Bind, std::string_view Src,
+                 const std::vector<Diagnostic> &OldDiags) {
+  LexerCursor End = Bind.rCur();
+  if (Src[End.offset() - 1] != ';')
+    return false;
+  return std::none_of(OldDiags.begin(), OldDiags.end(),
+                      [&](const Diagnostic &D) {
+                        return D.range().lCur() == End &&
+                               D.range().rCur() == End;
+                      });
+}
+
+/// \brief If \p Bind defines an attrset literal, get the (first) static name.
+///
+/// Sema merges later bindings into such attrsets in-place, e.g.
+/// \code{nix}
+/// { a = { x = 1; }; a.y = 2; }
+/// \endcode
+/// So they cannot be shared between ASTs if the name is duplicated.
+const std::string *mergeableName(const Node &Bind) {
+  if (Bind.kind() != Node::NK_Binding)
+    return nullptr;
+  const auto &B = static_cast<const Binding &>(Bind);
+  if (!B.value() || B.value()->kind() != Node::NK_ExprAttrs)
+    return nullptr;
+  const AttrName *First = B.path().names().front();
+  if (!First || !First->isStatic())
+    return nullptr;
+  return &First->staticName();
+}
+
+/// \brief Let \p Ctx retain the context owning \p N, which is either \p Old
+/// or one of the contexts retained by \p Old.
+void retainOwner(ASTContext &Ctx, const std::shared_ptr<const ASTContext> &Old,
+                 const Node *N) {
+  if (!N)
+    return;
+  if (Old->owns(N)) {
+    Ctx.retain(Old);
+    return;
+  }
+  for (const std::shared_ptr<const ASTContext> &Dep : Old->deps()) {
+    if (Dep->owns(N)) {
+      Ctx.retain(Dep);
+      return;
+    }
+  }
+  assert(false && "reused nodes must be owned by the previous context");
+}
+
+} // namespace
+
+Expr *Parser::reparse(const std::shared_ptr<Node> &Old,
+                      const std::vector<Diagnostic> &OldDiags,
+                      std::size_t Unchanged) {
+  std::shared_ptr<const ASTContext> OldCtx = ASTContext::of(Old);
+  if (!OldCtx)
+    return nullptr;
+
+  // Walk through lambdas, e.g. `{ pkgs, ... }: { }`.
+  std::vector<const ExprLambda *> Lambdas;
+  const Node *Body = Old.get();
+  while (Body && Body->kind() == Node::NK_ExprLambda) {
+    Lambdas.emplace_back(static_cast<const ExprLambda *>(Body));
+    Body = Lambdas.back()->body();
+  }
+  if (!Body || Body->kind() != Node::NK_ExprAttrs)
+    return nullptr;
+  const auto &Attrs = static_cast<const ExprAttrs &>(*Body);
+  if (Attrs.isRecursive() || !Attrs.binds())
+    return nullptr;
+
+  // Reuse bindings ending before the first changed byte.
+  const std::vector<Node *> &OldBindings =
+      Attrs.binds()->bindings();
+  std::size_t Reuse = 0;
+  while (Reuse < OldBindings.size() &&
+         OldBindings[Reuse]->rCur().offset() <= Unchanged)
+    ++Reuse;
+  while (Reuse && !isResumable(*OldBindings[Reuse - 1], Src, OldDiags))
+    --Reuse;
+  if (!Reuse)
+    return nullptr;
+  assert(Src[Attrs.lCur().offset()] == '{' && "non-rec attrs begins with {");
+
+  std::vector<Node *> Bindings(OldBindings.begin(),
+                               OldBindings.begin() + Reuse);
+
+  // Reused attrset literals must not be merged with others, neither in the
+  // previous AST nor in the new one.
+  std::map<std::string_view, std::size_t> OldNames;
+  {
+    std::vector<std::string_view> Names;
+    for (const Node *Bind : OldBindings)
+      collectNames(*Bind, Names);
+    for (std::string_view Name : Names)
+      ++OldNames[Name];
+  }
+  std::set<std::string_view> Mergeable;
+  for (const Node *Bind : Bindings) {
+    if (const std::string *Name = mergeableName(*Bind)) {
+      if (OldNames[*Name] != 1)
+        return nullptr;
+      Mergeable.emplace(*Name);
+    }
+  }
+
+  // Semantic diagnostics among reused bindings are going to be reported by
+  // the new `Sema::onExprAttrs`. Previous ones cannot be distinguished from
+  // others, so just give up in this case.
+  {
+    std::vector<Diagnostic> SemaDiags;
+    ASTContext Scratch;
+    Sema PrefixAct(Src, SemaDiags, Scratch);
+    SemaAttrs SA(/*Recursive=*/nullptr);
+    PrefixAct.lowerBinds(SA, Binds(Attrs.binds()->range(), Bindings));
+    if (!SemaDiags.empty())
+      return nullptr;
+  }
+
+  // Resume the parser, as if we are in `parseExprAttrs()`.
+  auto Sync = withSync(tok_r_curly);
+  LexerCursor LCurly = Attrs.lCur();
+  Token Matcher(tok_l_curly,
+                {LCurly, LexerCursor::unsafeCreate(LCurly.line(),
+                                                   LCurly.column() + 1,
+                                                   LCurly.offset() + 1)},
+                Src.substr(LCurly.offset(), 1));
+  LexerCursor Resume = Bindings.back()->rCur();
+  LexerCursor Semi = LexerCursor::unsafeCreate(
+      Resume.line(), Resume.column() - 1, Resume.offset() - 1);
+  Lex.setCur(Resume);
+  LastToken =
+      Token(tok_semi_colon, {Semi, Resume}, Src.substr(Semi.offset(), 1));
+
+  parseBindings(Bindings);
+
+  {
+    std::vector<std::string_view> Names;
+    for (std::size_t I = Reuse; I < Bindings.size(); ++I)
+      collectNames(*Bindings[I], Names);
+    for (std::string_view Name : Names)
+      if (Mergeable.contains(Name))
+        return nullptr;
+  }
+
+  auto *NewBinds = Ctx->create<Binds>(
+      LexerCursorRange{Attrs.binds()->lCur(), LastToken->rCur()},
+      std::move(Bindings));
+  if (ExpectResult ER = expect(tok_r_curly); ER.ok())
+    consume();
+  else
+    ER.diag().note(Note::NK_ToMachThis, Matcher.range())
+        << std::string(tok::spelling(Matcher.kind()));
+
+  Expr *Result = Act.onExprAttrs(LexerCursorRange{LCurly, LastToken->rCur()},
+                                 NewBinds, /*Rec=*/nullptr);
+
+  // Anything after the attrset changes the structure, e.g. `{ } // { }`
+  if (peek().kind() != tok_eof)
+    return nullptr;
+  for (auto It = Lambdas.rbegin(); It != Lambdas.rend(); ++It) {
+    const ExprLambda &Lambda = **It;
+    Result = Ctx->create<ExprLambda>(
+        LexerCursorRange{Lambda.lCur(), LastToken->rCur()}, Lambda.Arg, Result);
+  }
+
+  // Reused nodes are owned by the previous context, or by contexts it retains.
+  // Only retain the owners, otherwise contexts chain up across edits.
+  for (std::size_t I = 0; I < Reuse; ++I)
+    retainOwner(*Ctx, OldCtx, OldBindings[I]);
+  for (const ExprLambda *Lambda : Lambdas)
+    retainOwner(*Ctx, OldCtx, Lambda->arg());
+
+  // Diagnostics before the resuming point are still valid.
+  std::vector<Diagnostic> Kept;
+  for (const Diagnostic &D : OldDiags) {
+    if (D.range().lCur().offset() < Resume.offset() &&
+        D.range().rCur().offset() <= Resume.offset())
+      Kept.emplace_back(D);
+  }
+  Diags.insert(Diags.begin(), std::make_move_iterator(Kept.begin()),
+               std::make_move_iterator(Kept.end()));
+  return Result;
+}
+
+std::shared_ptr<Node> nixf::reparse(std::string_view Src,
+                                    std::string_view OldSrc,
+                                    const std::shared_ptr<Node> &OldAST,
+                                    const std::vector<Diagnostic> &OldDiags,
+                                    std::vector<Diagnostic> &Diags) {
+  if (OldAST) {
+    std::vector<Diagnostic> NewDiags;
+    Parser P(Src, NewDiags);
+    if (Expr *AST = P.reparse(OldAST, OldDiags, commonPrefix(Src, OldSrc))) {
+      Diags.insert(Diags.end(), std::make_move_iterator(NewDiags.begin()),
+                   std::make_move_iterator(NewDiags.end()));
+      return ASTContext::share(P.context(), AST);
+    }
+  }
+  return parse(Src, Diags);
+}
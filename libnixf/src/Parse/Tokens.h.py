@@ -13,6 +13,9 @@ def tok_id(tok: tokens.Token):
 def generate_tokens_h() -> str:
     header = """#pragma once
 
+#include "nixf/Basic/PerfectHash.h"
+
+#include <cstdint>
 #include <string_view>
 
 namespace nixf::tok {
@@ -37,11 +40,42 @@ enum TokenKind {
 }
 """
 
+    header += generate_keyword()
+
     header += "} // namespace nixf::tok"
 
     return header
 
 
+def generate_keyword() -> str:
+    names = [token.name for token in tokens.keyword_tokens]
+    seeds, slots = tokens.layout_perfect_hash(names)
+    by_slot = [""] * len(names)
+    for token, slot in zip(tokens.keyword_tokens, slots):
+        by_slot[slot] = token
+
+    code = """
+/// The keyword spelled `Name`, or tok_id if `Name` is not a keyword.
+constexpr TokenKind keyword(std::string_view Name) {
+    using namespace std::literals;
+"""
+    code += "    constexpr std::uint32_t Seeds[] = {"
+    code += ", ".join(str(seed) for seed in seeds) + "};\n"
+    code += "    constexpr std::string_view Names[] = {"
+    code += ", ".join(f'"{token.spelling}"sv' for token in by_slot) + "};\n"
+    code += "    constexpr TokenKind Kinds[] = {"
+    code += ", ".join(tok_id(token) for token in by_slot) + "};\n"
+    code += """    std::size_t Slot = perfectHashSlot(Seeds, Name);
+    return Names[Slot] == Name ? Kinds[Slot] : tok_id;
+}
+
+"""
+    for token in tokens.keyword_tokens:
+        code += f'static_assert(keyword("{token.spelling}") == {tok_id(token)});\n'
+    code += "\n"
+    return code
+
+
 if __name__ == "__main__":
     import sys
 
@@ -1,5 +1,5 @@
 from dataclasses import dataclass
-from typing import List
+from typing import Dict, List, Tuple
 
 
 @dataclass
@@ -85,3 +85,41 @@ tokens: List[Token] = [
     OpToken("not", "!"),  # unary operator
     *bin_op_tokens,
 ]
+
+
+def perfect_hash(seed: int, s: str) -> int:
+    """Mirror of nixf::perfectHash in nixf/Basic/PerfectHash.h."""
+    h = 2166136261 ^ seed
+    for ch in s.encode():
+        h ^= ch
+        h = (h * 16777619) & 0xFFFFFFFF
+    h ^= h >> 16
+    h = (h * 0x45D9F3B) & 0xFFFFFFFF
+    h ^= h >> 16
+    return h
+
+
+def layout_perfect_hash(keys: List[str]) -> Tuple[List[int], List[int]]:
+    """Seeds of buckets, and slots of keys, like nixf::layoutPerfectHash."""
+    n = len(keys)
+    buckets: Dict[int, List[int]] = {}
+    for i, key in enumerate(keys):
+        buckets.setdefault(perfect_hash(0, key) % n, []).append(i)
+
+    seeds = [0] * n
+    slots = [0] * n
+    used = [False] * n
+    for b, bucket in sorted(buckets.items(), key=lambda x: -len(x[1])):
+        seed = 1
+        while True:
+            candidates = [perfect_hash(seed, keys[i]) % n for i in bucket]
+            if len(set(candidates)) == len(candidates) and not any(
+                used[c] for c in candidates
+            ):
+                break
+            seed += 1
+        seeds[b] = seed
+        for i, c in zip(bucket, candidates):
+            used[c] = True
+            slots[i] = c
+    return seeds, slots
@@ -1,17 +1,34 @@
 #include "nixf/Sema/ParentMap.h"
 
+#include "nixf/Basic/RecursiveASTVisitor.h"
+
 using namespace nixf;
 
-void ParentMapAnalysis::dfs(const Node *N, const Node *Parent) {
-  if (!N)
-    return;
-  ParentMap.insert({N, Parent});
-  for (const Node *Ch : N->children())
-    dfs(Ch, N);
-}
+/// Records the parent of each node.
+///
+/// This recurses on the thread stack, which is faster than keeping pending
+/// nodes in a vector. The parser and variable lookup recurse deeper for each
+/// level of nesting anyway.
+class ParentMapAnalysis::Builder : public RecursiveASTVisitor<Builder> {
+  ParentMapAnalysis &PMA;
+
+public:
+  explicit Builder(ParentMapAnalysis &PMA) : PMA(PMA) {}
+
+  bool visitNode(const Node &N) {
+    // Some nodes are shared, e.g. the `let` keyword is a child of ExprLet and
+    // of its ExprAttrs. Keep the first parent, the outermost one.
+    const Node *&Parent = PMA.Parents[N];
+    if (Parent)
+      return true;
+    // Special case. Root node has itself as "parent".
+    Parent = parent() ? parent() : &N;
+    return true;
+  }
+};
 
 const Node *ParentMapAnalysis::query(const Node &N) const {
-  return ParentMap.contains(&N) ? ParentMap.at(&N) : nullptr;
+  return Parents.lookup(N);
 }
 
 const Node *ParentMapAnalysis::upExpr(const Node &N) const {
@@ -35,8 +52,7 @@ const Node *ParentMapAnalysis::upTo(const Node &N, Node::NodeKind Kind) const {
 }
 
 void ParentMapAnalysis::runOnAST(const Node &Root) {
-  // Special case. Root node has itself as "parent".
-  dfs(&Root, &Root);
+  Builder(*this).traverse(&Root);
 }
 
 bool nixf::ParentMapAnalysis::isRoot(const Node *Up, const Node &N) {
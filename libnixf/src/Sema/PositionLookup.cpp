@@ -0,0 +1,121 @@
+#include "nixf/Sema/PositionLookup.h"
+
+#include "nixf/Basic/ASTContext.h"
+#include "nixf/Basic/RecursiveASTVisitor.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace nixf;
+
+namespace {
+
+/// Keys of offsets are odd. Even keys are between two offsets, for positions
+/// beyond the end of a line.
+std::uint64_t offsetKey(std::uint64_t Offset) { return (2 * Offset) + 1; }
+
+} // namespace
+
+std::uint32_t PositionLookupAnalysis::add(const Node &N) {
+  auto Index = static_cast<std::uint32_t>(Entries.size());
+  Entries.push_back({&N, static_cast<std::uint32_t>(N.lOffset()),
+                     static_cast<std::uint32_t>(N.rOffset()), 0, 0, 1});
+
+  // Reserve the slots of children first, they are contiguous.
+  std::uint32_t Size = 0;
+  forEachChild(N, [&](const Node *Ch) { Size += Ch != nullptr; });
+
+  auto First = static_cast<std::uint32_t>(Children.size());
+  Children.resize(First + Size);
+  bool Sorted = true;
+  std::uint32_t I = 0;
+  forEachChild(N, [&](const Node *Ch) {
+    if (!Ch)
+      return;
+    std::uint32_t C = add(*Ch);
+    Children[First + I] = C;
+    if (I > 0) {
+      const Entry &Prev = Entries[Children[First + I - 1]];
+      Sorted = Sorted && Prev.LOffset <= Entries[C].LOffset &&
+               Prev.ROffset <= Entries[C].ROffset;
+    }
+    ++I;
+  });
+  Entry &E = Entries[Index];
+  E.FirstChild = First;
+  E.Size = Size;
+  E.Sorted = Sorted;
+  return Index;
+}
+
+void PositionLookupAnalysis::runOnAST(const Node &Root) {
+  Entries.clear();
+  Children.clear();
+  Lines = Root.context() ? &Root.context()->lines() : nullptr;
+  add(Root);
+}
+
+std::uint64_t PositionLookupAnalysis::key(Position Pos) const {
+  constexpr auto Max = std::numeric_limits<std::uint64_t>::max();
+  if (Pos.line() < 0)
+    return 0;
+  auto Line = static_cast<std::size_t>(Pos.line());
+  if (!Lines) {
+    // Nodes without lines are placed in line 0, at column `offset`.
+    if (Line > 0)
+      return Max;
+    return Pos.column() < 0 ? 0 : offsetKey(Pos.column());
+  }
+  if (Line >= Lines->lines())
+    return Max;
+  std::uint64_t Start = Lines->lineStart(Line);
+  if (Pos.column() < 0)
+    return offsetKey(Start) - 1;
+  auto Column = static_cast<std::uint64_t>(Pos.column());
+  if (Line + 1 < Lines->lines()) {
+    // Columns beyond the line feed are before the next line.
+    std::uint64_t LineFeed = Lines->lineStart(Line + 1) - 1;
+    if (Start + Column > LineFeed)
+      return offsetKey(LineFeed) + 1;
+  }
+  return offsetKey(Start + Column);
+}
+
+const PositionLookupAnalysis::Entry *
+PositionLookupAnalysis::child(const Entry &E, std::uint64_t LKey,
+                              std::uint64_t RKey) const {
+  auto Contains = [&](const Entry &C) {
+    return offsetKey(C.LOffset) <= LKey && RKey <= offsetKey(C.ROffset);
+  };
+  const std::uint32_t *Begin = Children.data() + E.FirstChild;
+  const std::uint32_t *End = Begin + E.Size;
+  if (!E.Sorted) {
+    for (const std::uint32_t *It = Begin; It != End; ++It) {
+      if (Contains(Entries[*It]))
+        return &Entries[*It];
+    }
+    return nullptr;
+  }
+  // Children before the first one ending at or after RKey cannot contain it.
+  // Children after it begin after LKey, if it does not contain the range.
+  const std::uint32_t *It =
+      std::partition_point(Begin, End, [&](std::uint32_t C) {
+        return offsetKey(Entries[C].ROffset) < RKey;
+      });
+  if (It != End && Contains(Entries[*It]))
+    return &Entries[*It];
+  return nullptr;
+}
+
+const Node *PositionLookupAnalysis::descend(PositionRange Range) const {
+  if (Entries.empty())
+    return nullptr;
+  std::uint64_t LKey = key(Range.begin());
+  std::uint64_t RKey = key(Range.end());
+  const Entry *E = &Entries.front();
+  if (!(offsetKey(E->LOffset) <= LKey && RKey <= offsetKey(E->ROffset)))
+    return nullptr;
+  while (const Entry *Next = child(*E, LKey, RKey))
+    E = Next;
+  return E->N;
+}
@@ -1,15 +1,25 @@
 #include "nixf/Sema/PrimOpInfo.h"
+#include "nixf/Basic/PerfectHash.h"
+
+#include <string>
 
 using namespace nixf;
 
-PrimopLookupResult nixf::lookupGlobalPrimOpInfo(const std::string &Name) {
-  if (PrimOpsInfo.contains(Name)) {
+const PrimOpInfo *nixf::findPrimOpInfo(std::string_view Name) {
+  if (PrimOpsInfo.empty())
+    return nullptr;
+  const PrimOpInfo &Info = PrimOpsInfo[perfectHashSlot(PrimOpsSeeds, Name)];
+  return Info.Name == Name ? &Info : nullptr;
+}
+
+PrimopLookupResult nixf::lookupGlobalPrimOpInfo(std::string_view Name) {
+  if (findPrimOpInfo(Name)) {
     return PrimopLookupResult::Found;
   }
 
   // Prefix the name with "__", and check again.
-  std::string PrefixedName = "__" + Name;
-  if (PrimOpsInfo.contains(PrefixedName)) {
+  std::string PrefixedName = "__" + std::string(Name);
+  if (findPrimOpInfo(PrefixedName)) {
     return PrimopLookupResult::PrefixedFound;
   }
 
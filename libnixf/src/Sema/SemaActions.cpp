@@ -64,8 +64,8 @@ void Sema::mergeAttrSets(SemaAttrs &XAttrs, const SemaAttrs &YAttrs) {
   }
 }
 
-void Sema::insertAttr(SemaAttrs &SA, std::shared_ptr<AttrName> Name,
-                      std::shared_ptr<Expr> E, Attribute::AttributeKind Kind) {
+void Sema::insertAttr(SemaAttrs &SA, AttrName *Name, Expr *E,
+                      Attribute::AttributeKind Kind) {
   // In this function we accept nullptr "E".
   //
   // e.g. { a = ; }
@@ -76,7 +76,7 @@ void Sema::insertAttr(SemaAttrs &SA, std::shared_ptr<AttrName> Name,
   assert(Name);
   if (!Name->isStatic()) {
     if (E)
-      SA.Dynamic.emplace_back(std::move(Name), std::move(E), Kind);
+      SA.Dynamic.emplace_back(Name, E, Kind);
     return;
   }
   auto &Attrs = SA.Static;
@@ -87,7 +87,7 @@ void Sema::insertAttr(SemaAttrs &SA, std::shared_ptr<AttrName> Name,
         E->kind() == Node::NK_ExprAttrs) {
       // If this is also an attrset, we want to merge them.
       auto *XAttrSet = static_cast<ExprAttrs *>(V.value());
-      auto *YAttrSet = static_cast<ExprAttrs *>(E.get());
+      auto *YAttrSet = static_cast<ExprAttrs *>(E);
       checkAttrRecursiveForMerge(*XAttrSet, *YAttrSet);
       mergeAttrSets(XAttrSet->SA, YAttrSet->SA);
       return;
@@ -97,12 +97,12 @@ void Sema::insertAttr(SemaAttrs &SA, std::shared_ptr<AttrName> Name,
   }
   if (!E)
     return;
-  Attrs.insert({StaticName, Attribute(std::move(Name), std::move(E), Kind)});
+  Attrs.insert({StaticName, Attribute(Name, E, Kind)});
 }
 
 SemaAttrs *
 Sema::selectOrCreate(SemaAttrs &SA,
-                     const std::vector<std::shared_ptr<AttrName>> &Path) {
+                     const std::vector<AttrName *> &Path) {
   assert(!Path.empty() && "AttrPath has at least 1 name");
   SemaAttrs *Inner = &SA;
   // Firstly perform a lookup to see if the attribute already exists.
@@ -131,40 +131,37 @@ Sema::selectOrCreate(SemaAttrs &SA,
         // There is no existing one, let's create a new attribute.
         // These attributes are implicitly created, and to match default ctor
         // in C++ nix implementation, they are all non-recursive.
-        auto NewNested = std::make_shared<ExprAttrs>(
+        auto *NewNested = Ctx.create<ExprAttrs>(
             Name->range(), nullptr, nullptr, SemaAttrs(/*Recursive=*/nullptr));
         Inner = &NewNested->SA;
         StaticAttrs.insert(
-            {StaticName, Attribute(Name, std::move(NewNested),
+            {StaticName, Attribute(Name, NewNested,
                                    Attribute::AttributeKind::Plain)});
       }
     } else {
       // Create a dynamic attribute.
       std::vector<Attribute> &DynamicAttrs = Inner->Dynamic;
-      auto NewNested = std::make_shared<ExprAttrs>(
-          Name->range(), nullptr, nullptr, SemaAttrs(/*Recursive=*/nullptr));
+      auto *NewNested = Ctx.create<ExprAttrs>(Name->range(), nullptr, nullptr,
+                                              SemaAttrs(/*Recursive=*/nullptr));
       Inner = &NewNested->SA;
-      DynamicAttrs.emplace_back(Name,
-                                std::shared_ptr<Expr>(std::move(NewNested)),
+      DynamicAttrs.emplace_back(Name, NewNested,
                                 Attribute::AttributeKind::Plain);
     }
   }
   return Inner;
 }
 
-void Sema::addAttr(SemaAttrs &Attr, const AttrPath &Path,
-                   std::shared_ptr<Expr> E) {
+void Sema::addAttr(SemaAttrs &Attr, const AttrPath &Path, Expr *E) {
   // Select until the inner-most attr.
   SemaAttrs *Inner = selectOrCreate(Attr, Path.names());
   if (!Inner)
     return;
 
   // Insert the attribute.
-  std::shared_ptr<AttrName> Name = Path.names().back();
+  AttrName *Name = Path.names().back();
   if (!Name)
     return;
-  insertAttr(*Inner, std::move(Name), std::move(E),
-             Attribute::AttributeKind::Plain);
+  insertAttr(*Inner, Name, E, Attribute::AttributeKind::Plain);
 }
 
 void Sema::removeFormal(Fix &F, const FormalVector::const_iterator &Rm,
@@ -185,7 +182,7 @@ void Sema::checkFormalEllipsis(const FormalVector &FV) {
   if (FV.empty())
     return;
 
-  Formal &LastF = *FV.back().get(); // Last Formal
+  Formal &LastF = *FV.back(); // Last Formal
 
   for (auto It = FV.begin(); It + 1 != FV.end(); It++) {
     Formal &CurF = **It; // Current Formal
@@ -234,7 +231,7 @@ void Sema::checkFormalEmpty(const FormalVector &FV) {
     if (It + 1 == FV.cend())
       break;
 
-    const std::shared_ptr<Formal> &FPtr = *It;
+    const Formal *FPtr = *It;
     const Formal &F = *FPtr;
     // Check if the formal is emtpy, e.g.
     // { , }
@@ -250,7 +247,7 @@ void Sema::checkFormalEmpty(const FormalVector &FV) {
 
 void Sema::dedupFormal(std::map<std::string, const Formal *> &Dedup,
                        const FormalVector &FV) {
-  for (const std::shared_ptr<Formal> &FPtr : FV) {
+  for (const Formal *FPtr : FV) {
     const Formal &F = *FPtr;
     if (!F.id())
       continue;
@@ -269,18 +266,16 @@ void Sema::dedupFormal(std::map<std::string, const Formal *> &Dedup,
   }
 }
 
-std::shared_ptr<Formals> Sema::onFormals(LexerCursorRange Range,
-                                         FormalVector FV) {
+Formals *Sema::onFormals(LexerCursorRange Range, FormalVector FV) {
   std::map<std::string, const Formal *> Dedup;
   checkFormalSep(FV);
   checkFormalEllipsis(FV);
   checkFormalEmpty(FV);
   dedupFormal(Dedup, FV);
-  return std::make_shared<Formals>(Range, std::move(FV), std::move(Dedup));
+  return Ctx.create<Formals>(Range, std::move(FV), std::move(Dedup));
 }
 
-void Sema::lowerInheritName(SemaAttrs &SA, std::shared_ptr<AttrName> Name,
-                            std::shared_ptr<Expr> E,
+void Sema::lowerInheritName(SemaAttrs &SA, AttrName *Name, Expr *E,
                             Attribute::AttributeKind InheritKind) {
   assert(InheritKind != Attribute::AttributeKind::Plain);
   if (!Name)
@@ -301,29 +296,28 @@ void Sema::lowerInheritName(SemaAttrs &SA, std::shared_ptr<AttrName> Name,
   }
   // Insert the attr.
   std::string StaticName = Name->staticName();
-  SA.Static.insert(
-      {StaticName, Attribute(std::move(Name), std::move(E), InheritKind)});
+  SA.Static.insert({StaticName, Attribute(Name, E, InheritKind)});
 }
 
 void Sema::lowerInherit(SemaAttrs &Attr, const Inherit &Inherit) {
-  for (const std::shared_ptr<AttrName> &Name : Inherit.names()) {
+  for (AttrName *Name : Inherit.names()) {
     assert(Name);
     auto [Desugar, Kind] = desugarInheritExpr(Name, Inherit.expr());
-    lowerInheritName(Attr, Name, std::move(Desugar), Kind);
+    lowerInheritName(Attr, Name, Desugar, Kind);
   }
 }
 
 void Sema::lowerBinds(SemaAttrs &SA, const Binds &B) {
-  for (const std::shared_ptr<Node> &Bind : B.bindings()) {
+  for (Node *Bind : B.bindings()) {
     assert(Bind && "Bind is not null");
     switch (Bind->kind()) {
     case Node::NK_Inherit: {
-      auto *N = static_cast<Inherit *>(Bind.get());
+      auto *N = static_cast<Inherit *>(Bind);
       lowerInherit(SA, *N);
       break;
     }
     case Node::NK_Binding: {
-      auto *B = static_cast<Binding *>(Bind.get());
+      auto *B = static_cast<Binding *>(Bind);
       addAttr(SA, B->path(), B->value());
       break;
     }
@@ -333,35 +327,30 @@ void Sema::lowerBinds(SemaAttrs &SA, const Binds &B) {
   }
 }
 
-std::pair<std::shared_ptr<Expr>, Attribute::AttributeKind>
-Sema::desugarInheritExpr(std::shared_ptr<AttrName> Name,
-                         std::shared_ptr<Expr> E) {
+std::pair<Expr *, Attribute::AttributeKind>
+Sema::desugarInheritExpr(AttrName *Name,
+                         Expr *E) {
   auto Range = Name->range();
   if (!E)
-    return {std::make_shared<ExprVar>(Range, Name->id()),
+    return {Ctx.create<ExprVar>(Range, Name->id()),
             Attribute::AttributeKind::Inherit};
 
-  auto Path = std::make_shared<AttrPath>(
-      Range, std::vector<std::shared_ptr<AttrName>>{std::move(Name)},
-      std::vector<std::shared_ptr<Dot>>{});
-  return {std::make_shared<ExprSelect>(Range, std::move(E), nullptr,
-                                       std::move(Path), nullptr, E.get()),
+  auto *Path = Ctx.create<AttrPath>(Range, std::vector<AttrName *>{Name},
+                                    std::vector<Dot *>{});
+  return {Ctx.create<ExprSelect>(Range, E, nullptr,
+                                       Path, nullptr, E),
           Attribute::AttributeKind::InheritFrom};
 }
 
-std::shared_ptr<ExprAttrs> Sema::onExprAttrs(LexerCursorRange Range,
-                                             std::shared_ptr<Binds> Binds,
-                                             std::shared_ptr<Misc> Rec) {
-  SemaAttrs ESA(Rec.get());
+ExprAttrs *Sema::onExprAttrs(LexerCursorRange Range, Binds *Binds, Misc *Rec) {
+  SemaAttrs ESA(Rec);
   if (Binds)
     lowerBinds(ESA, *Binds);
-  return std::make_shared<ExprAttrs>(Range, std::move(Binds), std::move(Rec),
-                                     std::move(ESA));
+  return Ctx.create<ExprAttrs>(Range, Binds, Rec, std::move(ESA));
 }
 
-std::shared_ptr<LambdaArg> Sema::onLambdaArg(LexerCursorRange Range,
-                                             std::shared_ptr<Identifier> ID,
-                                             std::shared_ptr<Formals> F) {
+LambdaArg *Sema::onLambdaArg(LexerCursorRange Range, Identifier *ID,
+                             Formals *F) {
   // Check that if lambda arguments duplicated to it's formal
 
   if (ID && F) {
@@ -372,7 +361,7 @@ std::shared_ptr<LambdaArg> Sema::onLambdaArg(LexerCursorRange Range,
       D.note(Note::NK_DuplicateFormal, F->dedup().at(ID->name())->range());
     }
   }
-  return std::make_shared<LambdaArg>(Range, std::move(ID), std::move(F));
+  return Ctx.create<LambdaArg>(Range, ID, F);
 }
 
 } // namespace nixf
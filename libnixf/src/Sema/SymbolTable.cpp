@@ -0,0 +1,20 @@
+#include "nixf/Sema/SymbolTable.h"
+
+using namespace nixf;
+
+Symbol SymbolTable::intern(std::string_view Name) {
+  auto It = Symbols.find(Name);
+  if (It != Symbols.end())
+    return It->second;
+  auto S = static_cast<Symbol>(Names.size());
+  const std::string &Interned = Names.emplace_back(Name);
+  Symbols.emplace(Interned, S);
+  return S;
+}
+
+std::optional<Symbol> SymbolTable::lookup(std::string_view Name) const {
+  auto It = Symbols.find(Name);
+  if (It == Symbols.end())
+    return std::nullopt;
+  return It->second;
+}
@@ -3,37 +3,41 @@
 #include "nixf/Basic/Nodes/Attrs.h"
 #include "nixf/Basic/Nodes/Expr.h"
 #include "nixf/Basic/Nodes/Lambda.h"
+#include "nixf/Basic/PerfectHash.h"
+#include "nixf/Basic/RecursiveASTVisitor.h"
 #include "nixf/Sema/PrimOpInfo.h"
 
-#include <set>
+#include <algorithm>
 
 using namespace nixf;
 
 namespace {
 
-std::set<std::string> Constants{
+constexpr PerfectHashSet Constants{{
     "true",           "false",           "null",
     "__currentTime",  "__currentSystem", "__nixVersion",
     "__storeDir",     "__langVersion",   "__importNative",
     "__traceVerbose", "__nixPath",       "derivation",
-};
+}};
 
 /// Builder a map of definitions. If there are something overlapped, maybe issue
 /// a diagnostic.
 class DefBuilder {
-  EnvNode::DefMap Def;
+  std::vector<DefMap::Entry> Def;
   std::vector<Diagnostic> &Diags;
+  SymbolTable &Symbols;
 
   std::shared_ptr<Definition> addSimple(std::string Name, const Node *Entry,
                                         Definition::DefinitionSource Source) {
-    assert(!Def.contains(Name));
     auto NewDef = std::make_shared<Definition>(Entry, Source);
-    Def.insert({std::move(Name), NewDef});
+    Symbol Sym = Symbols.intern(Name);
+    Def.push_back({Sym, std::move(Name), NewDef});
     return NewDef;
   }
 
 public:
-  DefBuilder(std::vector<Diagnostic> &Diags) : Diags(Diags) {}
+  DefBuilder(std::vector<Diagnostic> &Diags, SymbolTable &Symbols)
+      : Diags(Diags), Symbols(Symbols) {}
 
   void addBuiltin(std::string Name) {
     // Don't need to record def map for builtins.
@@ -43,8 +47,7 @@ public:
   [[nodiscard("Record ToDef Map!")]] std::shared_ptr<Definition>
   add(std::string Name, const Node *Entry, Definition::DefinitionSource Source,
       bool IsInheritFromBuiltin) {
-    auto PrimOpLookup = lookupGlobalPrimOpInfo(Name);
-    if (PrimOpLookup == PrimopLookupResult::Found && !IsInheritFromBuiltin) {
+    if (!IsInheritFromBuiltin && findPrimOpInfo(Name)) {
       // Overriding a builtin primop is discouraged.
       Diagnostic &D =
           Diags.emplace_back(Diagnostic::DK_PrimOpOverridden, Entry->range());
@@ -61,7 +64,7 @@ public:
     return addSimple(std::move(Name), Entry, Source);
   }
 
-  EnvNode::DefMap finish() { return std::move(Def); }
+  DefMap finish() { return DefMap(std::move(Def)); }
 };
 
 /// Special check for inherited from builtins attribute.
@@ -93,6 +96,39 @@ bool isBuiltinConstant(const std::string &Name) {
 
 } // namespace
 
+DefMap::DefMap(std::vector<Entry> Entries) {
+  std::sort(Entries.begin(), Entries.end(),
+            [](const Entry &L, const Entry &R) { return L.Name < R.Name; });
+  Defs.reserve(Entries.size());
+  Index.reserve(Entries.size());
+  for (Entry &E : Entries) {
+    assert((Defs.empty() || Defs.back().first != E.Name) &&
+           "names of definitions must be unique");
+    Index.emplace_back(E.Sym, static_cast<std::uint32_t>(Defs.size()));
+    Defs.emplace_back(std::move(E.Name), std::move(E.Def));
+  }
+  std::sort(Index.begin(), Index.end());
+}
+
+bool DefMap::contains(std::string_view Name) const {
+  auto It = std::lower_bound(Defs.begin(), Defs.end(), Name,
+                             [](const value_type &D, std::string_view Name) {
+                               return D.first < Name;
+                             });
+  return It != Defs.end() && It->first == Name;
+}
+
+const std::shared_ptr<Definition> *DefMap::find(Symbol S) const {
+  auto It = std::lower_bound(
+      Index.begin(), Index.end(), S,
+      [](const std::pair<Symbol, std::uint32_t> &I, Symbol S) {
+        return I.first < S;
+      });
+  if (It == Index.end() || It->first != S)
+    return nullptr;
+  return &Defs[It->second].second;
+}
+
 bool EnvNode::isLive() const {
   for (const auto &[_, D] : Defs) {
     if (!D->uses().empty())
@@ -171,12 +207,15 @@ void VariableLookupAnalysis::emitEnvLivenessWarning(
 void VariableLookupAnalysis::lookupVar(const ExprVar &Var,
                                        const std::shared_ptr<EnvNode> &Env) {
   const auto &Name = Var.id().name();
+  // Names never defined are not interned, and only looked up in `with`.
+  std::optional<Symbol> Sym = Symbols.lookup(Name);
   const auto *CurEnv = Env.get();
   std::shared_ptr<Definition> Def;
   std::vector<const EnvNode *> WithEnvs;
   for (; CurEnv; CurEnv = CurEnv->parent()) {
-    if (CurEnv->defs().contains(Name)) {
-      Def = CurEnv->defs().at(Name);
+    if (const std::shared_ptr<Definition> *D =
+            Sym ? CurEnv->defs().find(*Sym) : nullptr) {
+      Def = *D;
       break;
     }
     // Find all nested "with" expression, variables potentially come from those.
@@ -194,7 +233,7 @@ void VariableLookupAnalysis::lookupVar(const ExprVar &Var,
 
   if (Def) {
     Def->usedBy(Var);
-    Results.insert({&Var, LookupResult{LookupResultKind::Defined, Def}});
+    Results[Var] = LookupResult{LookupResultKind::Defined, Def};
   } else if (!WithEnvs.empty()) { // comes from enclosed "with" expressions.
     // Collect all `with` expressions that could provide this variable's
     // binding. This is stored for later queries (e.g., by code actions that
@@ -206,7 +245,7 @@ void VariableLookupAnalysis::lookupVar(const ExprVar &Var,
       WithScopes.push_back(static_cast<const ExprWith *>(WithEnv->syntax()));
     }
     VarWithScopes.insert({&Var, std::move(WithScopes)});
-    Results.insert({&Var, LookupResult{LookupResultKind::FromWith, Def}});
+    Results[Var] = LookupResult{LookupResultKind::FromWith, Def};
   } else {
     // Check if this is a primop.
     switch (lookupGlobalPrimOpInfo(Name)) {
@@ -218,14 +257,12 @@ void VariableLookupAnalysis::lookupVar(const ExprVar &Var,
           Diags.emplace_back(Diagnostic::DK_PrimOpNeedsPrefix, Var.range());
       D.fix("use `builtins.` prefix")
           .edit(TextEdit::mkInsertion(Var.range().lCur(), "builtins."));
-      Results.insert(
-          {&Var, LookupResult{LookupResultKind::Undefined, nullptr}});
+      Results[Var] = LookupResult{LookupResultKind::Undefined, nullptr};
       break;
     }
     case PrimopLookupResult::NotFound:
       // Otherwise, this variable is undefined.
-      Results.insert(
-          {&Var, LookupResult{LookupResultKind::Undefined, nullptr}});
+      Results[Var] = LookupResult{LookupResultKind::Undefined, nullptr};
       Diagnostic &Diag =
           Diags.emplace_back(Diagnostic::DK_UndefinedVariable, Var.range());
       Diag << Var.id().name();
@@ -241,7 +278,7 @@ void VariableLookupAnalysis::dfs(const ExprLambda &Lambda,
     return;
 
   // Create a new EnvNode, as lambdas may have formal & arg.
-  DefBuilder DBuilder(Diags);
+  DefBuilder DBuilder(Diags, Symbols);
   assert(Lambda.arg());
   const LambdaArg &Arg = *Lambda.arg();
 
@@ -249,17 +286,15 @@ void VariableLookupAnalysis::dfs(const ExprLambda &Lambda,
   // ^~~<------- add function argument.
   if (Arg.id()) {
     if (!Arg.formals()) {
-      ToDef.insert_or_assign(Arg.id(),
-                             DBuilder.add(Arg.id()->name(), Arg.id(),
-                                          Definition::DS_LambdaArg,
-                                          /*IsInheritFromBuiltin=*/false));
+      ToDef[*Arg.id()] = DBuilder.add(Arg.id()->name(), Arg.id(),
+                                      Definition::DS_LambdaArg,
+                                      /*IsInheritFromBuiltin=*/false);
       // Function arg cannot duplicate to it's formal.
       // If it this unluckily happens, we would like to skip this definition.
     } else if (!Arg.formals()->dedup().contains(Arg.id()->name())) {
-      ToDef.insert_or_assign(Arg.id(),
-                             DBuilder.add(Arg.id()->name(), Arg.id(),
-                                          Definition::DS_LambdaWithArg_Arg,
-                                          /*IsInheritFromBuiltin=*/false));
+      ToDef[*Arg.id()] = DBuilder.add(Arg.id()->name(), Arg.id(),
+                                      Definition::DS_LambdaWithArg_Arg,
+                                      /*IsInheritFromBuiltin=*/false);
     }
   }
 
@@ -279,13 +314,12 @@ void VariableLookupAnalysis::dfs(const ExprLambda &Lambda,
       Definition::DefinitionSource Source =
           Arg.id() ? Definition::DS_LambdaWithArg_Formal
                    : Definition::DS_LambdaNoArg_Formal;
-      ToDef.insert_or_assign(Formal->id(),
-                             DBuilder.add(Name, Formal->id(), Source,
-                                          /*IsInheritFromBuiltin=*/false));
+      ToDef[*Formal->id()] = DBuilder.add(Name, Formal->id(), Source,
+                                          /*IsInheritFromBuiltin=*/false);
     }
   }
 
-  auto NewEnv = std::make_shared<EnvNode>(Env, DBuilder.finish(), &Lambda);
+  auto NewEnv = newEnv(Env, DBuilder.finish(), &Lambda);
 
   if (Arg.formals()) {
     for (const auto &Formal : Arg.formals()->members()) {
@@ -316,15 +350,14 @@ std::shared_ptr<EnvNode> VariableLookupAnalysis::dfsAttrs(
     const Node *Syntax, Definition::DefinitionSource Source) {
   if (SA.isRecursive()) {
     // rec { }, or let ... in ...
-    DefBuilder DB(Diags);
+    DefBuilder DB(Diags, Symbols);
     // For each static names, create a name binding.
     for (const auto &[Name, Attr] : SA.staticAttrs()) {
-      ToDef.insert_or_assign(
-          &Attr.key(),
-          DB.add(Name, &Attr.key(), Source, checkInheritedFromBuiltin(Attr)));
+      ToDef[Attr.key()] =
+          DB.add(Name, &Attr.key(), Source, checkInheritedFromBuiltin(Attr));
     }
 
-    auto NewEnv = std::make_shared<EnvNode>(Env, DB.finish(), Syntax);
+    auto NewEnv = newEnv(Env, DB.finish(), Syntax);
 
     for (const auto &[_, Attr] : SA.staticAttrs()) {
       if (!Attr.value())
@@ -379,7 +412,7 @@ void VariableLookupAnalysis::dfs(const ExprLet &Let,
     // This is an empty let ... in ... expr, definitely anti-pattern in
     // nix language. Create a trivial env and return.
     if (!Let.attrs()) {
-      auto NewEnv = std::make_shared<EnvNode>(Env, EnvNode::DefMap{}, &Let);
+      auto NewEnv = newEnv(Env, DefMap{}, &Let);
       return NewEnv;
     }
 
@@ -405,20 +438,19 @@ void VariableLookupAnalysis::dfs(const ExprLegacyLet &LegacyLet,
 
 void VariableLookupAnalysis::trivialDispatch(
     const Node &Root, const std::shared_ptr<EnvNode> &Env) {
-  for (const Node *Ch : Root.children()) {
-    if (!Ch)
-      continue;
-    dfs(*Ch, Env);
-  }
+  forEachChild(Root, [&](const Node *Ch) {
+    if (Ch)
+      dfs(*Ch, Env);
+  });
 }
 
 void VariableLookupAnalysis::dfs(const ExprWith &With,
                                  const std::shared_ptr<EnvNode> &Env) {
-  auto NewEnv = std::make_shared<EnvNode>(Env, EnvNode::DefMap{}, &With);
+  auto NewEnv = newEnv(Env, DefMap{}, &With);
   if (!WithDefs.contains(&With)) {
     auto NewDef =
         std::make_shared<Definition>(&With.kwWith(), Definition::DS_With);
-    ToDef.insert_or_assign(&With.kwWith(), NewDef);
+    ToDef[With.kwWith()] = NewDef;
     WithDefs.insert_or_assign(&With, NewDef);
   }
 
@@ -498,7 +530,7 @@ void VariableLookupAnalysis::checkLetInheritBuiltins(const SemaAttrs &SA) {
       continue;
 
     // Check if the inherited name is a prelude builtin
-    if (lookupGlobalPrimOpInfo(Name) == PrimopLookupResult::Found) {
+    if (findPrimOpInfo(Name)) {
       Diagnostic &D = Diags.emplace_back(Diagnostic::DK_PrimOpRemovablePrefix,
                                          Attr.key().range());
       D.fix("remove unnecessary inherit")
@@ -509,7 +541,9 @@ void VariableLookupAnalysis::checkLetInheritBuiltins(const SemaAttrs &SA) {
 
 void VariableLookupAnalysis::dfs(const Node &Root,
                                  const std::shared_ptr<EnvNode> &Env) {
-  Envs.insert({&Root, Env});
+  const EnvNode *&RootEnv = Envs[Root];
+  if (!RootEnv)
+    RootEnv = Env.get();
   switch (Root.kind()) {
   case Node::NK_ExprVar: {
     const auto &Var = static_cast<const ExprVar &>(Root);
@@ -554,23 +588,23 @@ void VariableLookupAnalysis::dfs(const Node &Root,
 
 void VariableLookupAnalysis::runOnAST(const Node &Root) {
   // Create a basic env
-  DefBuilder DB(Diags);
+  DefBuilder DB(Diags, Symbols);
 
-  for (const auto &[Name, Info] : PrimOpsInfo) {
+  for (const PrimOpInfo &Info : PrimOpsInfo) {
     if (!Info.Internal) {
       // Only add non-internal primops without "__" prefix.
-      DB.addBuiltin(Name);
+      DB.addBuiltin(std::string(Info.Name));
     }
   }
 
-  for (const auto &Builtin : Constants)
-    DB.addBuiltin(Builtin);
+  for (std::string_view Builtin : Constants)
+    DB.addBuiltin(std::string(Builtin));
 
   DB.addBuiltin("builtins");
   // This is an undocumented keyword actually.
   DB.addBuiltin(std::string("__curPos"));
 
-  auto Env = std::make_shared<EnvNode>(nullptr, DB.finish(), nullptr);
+  auto Env = newEnv(nullptr, DB.finish(), nullptr);
 
   dfs(Root, Env);
 }
@@ -578,8 +612,13 @@ void VariableLookupAnalysis::runOnAST(const Node &Root) {
 VariableLookupAnalysis::VariableLookupAnalysis(std::vector<Diagnostic> &Diags)
     : Diags(Diags) {}
 
+std::shared_ptr<EnvNode>
+VariableLookupAnalysis::newEnv(std::shared_ptr<EnvNode> Parent, DefMap Defs,
+                               const Node *Syntax) {
+  return EnvNodes.emplace_back(
+      std::make_shared<EnvNode>(std::move(Parent), std::move(Defs), Syntax));
+}
+
 const EnvNode *VariableLookupAnalysis::env(const Node *N) const {
-  if (!Envs.contains(N))
-    return nullptr;
-  return Envs.at(N).get();
+  return N ? Envs.lookup(*N) : nullptr;
 }
@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+
+#include "nixf/Basic/ASTContext.h"
+#include "nixf/Basic/Diagnostic.h"
+#include "nixf/Basic/Nodes/Attrs.h"
+#include "nixf/Basic/Nodes/Simple.h"
+#include "nixf/Parse/Parser.h"
+
+namespace {
+
+using namespace std::literals;
+using namespace nixf;
+
+TEST(ASTContext, Create) {
+  ASTContext Ctx;
+  auto *Int = Ctx.create<ExprInt>(LexerCursorRange{}, 1);
+  auto *ID = Ctx.create<Identifier>(LexerCursorRange{}, "foo");
+  ASSERT_EQ(Int->value(), 1);
+  ASSERT_EQ(ID->name(), "foo");
+  ASSERT_TRUE(Ctx.owns(Int));
+  ASSERT_TRUE(Ctx.owns(ID));
+  ASSERT_EQ(Ctx.nodes(), 2);
+
+  ExprInt Outside(LexerCursorRange{}, 2);
+  ASSERT_FALSE(Ctx.owns(&Outside));
+}
+
+TEST(ASTContext, LargeFile) {
+  ASTContext Ctx;
+  for (int I = 0; I < 100000; ++I)
+    Ctx.create<ExprInt>(LexerCursorRange{}, I);
+  ASSERT_EQ(Ctx.nodes(), 100000);
+  ASSERT_GE(Ctx.bytes(), 100000 * sizeof(ExprInt));
+}
+
+TEST(ASTContext, Parse) {
+  std::vector<Diagnostic> Diags;
+  std::shared_ptr<Node> AST = parse("{ a = 1; b = [ 2 3 ]; }"sv, Diags);
+  ASSERT_TRUE(AST);
+
+  std::shared_ptr<const ASTContext> Ctx = ASTContext::of(AST);
+  ASSERT_TRUE(Ctx);
+  ASSERT_TRUE(Ctx->owns(AST.get()));
+  ASSERT_TRUE(Ctx->owns(static_cast<ExprAttrs &>(*AST).binds()));
+
+  // The context is kept alive by the AST.
+  AST.reset();
+  ASSERT_EQ(Ctx.use_count(), 1);
+}
+
+TEST(ASTContext, Lines) {
+  std::vector<Diagnostic> Diags;
+  std::shared_ptr<Node> AST = parse("{\n  a = 1;\n}"sv, Diags);
+  const Node *Binds = static_cast<ExprAttrs &>(*AST).binds();
+  ASSERT_TRUE(Binds->lCur().isAt(1, 2, 4));
+  ASSERT_TRUE(Binds->rCur().isAt(1, 8, 10));
+  ASSERT_EQ(Binds->lOffset(), 4);
+  ASSERT_EQ(Binds->rOffset(), 10);
+}
+
+TEST(ASTContext, OfUnowned) {
+  auto AST = std::make_shared<ExprInt>(LexerCursorRange{}, 1);
+  ASSERT_FALSE(ASTContext::of(AST));
+}
+
+} // namespace
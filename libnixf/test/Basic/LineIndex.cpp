@@ -0,0 +1,26 @@
+#include <gtest/gtest.h>
+
+#include "nixf/Basic/LineIndex.h"
+
+namespace {
+
+using namespace std::literals;
+using namespace nixf;
+
+TEST(LineIndex, Empty) {
+  LineIndex Lines(""sv);
+  ASSERT_EQ(Lines.lines(), 1);
+  ASSERT_TRUE(Lines.cursor(0).isAt(0, 0, 0));
+}
+
+TEST(LineIndex, Cursor) {
+  LineIndex Lines("ab\n\ncd\n"sv);
+  ASSERT_EQ(Lines.lines(), 4);
+  ASSERT_TRUE(Lines.cursor(0).isAt(0, 0, 0));
+  ASSERT_TRUE(Lines.cursor(2).isAt(0, 2, 2));
+  ASSERT_TRUE(Lines.cursor(3).isAt(1, 0, 3));
+  ASSERT_TRUE(Lines.cursor(5).isAt(2, 1, 5));
+  ASSERT_TRUE(Lines.cursor(7).isAt(3, 0, 7));
+}
+
+} // namespace
@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+
+#include "nixf/Basic/ASTContext.h"
+#include "nixf/Basic/NodeMap.h"
+#include "nixf/Basic/Nodes/Simple.h"
+
+namespace {
+
+using namespace nixf;
+
+TEST(NodeMap, Context) {
+  ASTContext Ctx;
+  auto *A = Ctx.create<ExprInt>(LexerCursorRange{}, 1);
+  auto *B = Ctx.create<ExprInt>(LexerCursorRange{}, 2);
+
+  NodeMap<int> Map;
+  ASSERT_EQ(Map.find(*A), nullptr);
+  Map[*B] = 42;
+  ASSERT_EQ(Map.lookup(*B), 42);
+  ASSERT_EQ(Map.lookup(*A), 0);
+
+  // Nodes created later are assigned as well.
+  auto *C = Ctx.create<ExprInt>(LexerCursorRange{}, 3);
+  ASSERT_EQ(Map.find(*C), nullptr);
+  Map[*C] = 43;
+  ASSERT_EQ(Map.lookup(*C), 43);
+  ASSERT_EQ(Map.lookup(*B), 42);
+}
+
+TEST(NodeMap, Contexts) {
+  ASTContext Ctx1;
+  ASTContext Ctx2;
+  auto *A = Ctx1.create<ExprInt>(LexerCursorRange{}, 1);
+  auto *B = Ctx2.create<ExprInt>(LexerCursorRange{}, 2);
+  ASSERT_EQ(A->index(), B->index());
+
+  NodeMap<int> Map;
+  Map[*A] = 1;
+  Map[*B] = 2;
+  ASSERT_EQ(Map.lookup(*A), 1);
+  ASSERT_EQ(Map.lookup(*B), 2);
+}
+
+TEST(NodeMap, Detached) {
+  ExprInt A(LexerCursorRange{}, 1);
+  ExprInt B(LexerCursorRange{}, 2);
+
+  NodeMap<const Node *> Map;
+  Map[A] = &B;
+  ASSERT_EQ(Map.lookup(A), &B);
+  ASSERT_EQ(Map.find(B), nullptr);
+
+  Map.clear();
+  ASSERT_EQ(Map.find(A), nullptr);
+}
+
+} // namespace
@@ -30,8 +30,8 @@ TEST(Node, InterpolateLiteral) {
 
 TEST(Node, InterpolateLiteralFalse) {
   std::vector<InterpolablePart> Fragments;
-  Fragments.emplace_back(
-      std::make_unique<Interpolation>(LexerCursorRange{}, nullptr));
+  Interpolation Interp(LexerCursorRange{}, nullptr);
+  Fragments.emplace_back(&Interp);
   InterpolatedParts Parts(LexerCursorRange{}, std::move(Fragments));
   ASSERT_FALSE(Parts.isLiteral());
 }
@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+
+#include "nixf/Basic/PerfectHash.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace nixf;
+
+TEST(PerfectHash, Layout) {
+  std::vector<std::string> Storage;
+  for (int I = 0; I < 1000; ++I)
+    Storage.emplace_back("name" + std::to_string(I));
+  std::vector<std::string_view> Keys(Storage.begin(), Storage.end());
+
+  PerfectHashLayout Layout = layoutPerfectHash(Keys);
+  ASSERT_EQ(Layout.Seeds.size(), Keys.size());
+  ASSERT_EQ(Layout.Slots.size(), Keys.size());
+
+  // Slots are a permutation.
+  std::set<std::uint32_t> Slots(Layout.Slots.begin(), Layout.Slots.end());
+  ASSERT_EQ(Slots.size(), Keys.size());
+  ASSERT_LT(*Slots.rbegin(), Keys.size());
+
+  for (std::size_t I = 0; I < Keys.size(); ++I)
+    ASSERT_EQ(perfectHashSlot(Layout.Seeds, Keys[I]), Layout.Slots[I]);
+}
+
+TEST(PerfectHash, Empty) {
+  PerfectHashLayout Layout = layoutPerfectHash({});
+  ASSERT_TRUE(Layout.Seeds.empty());
+  ASSERT_EQ(perfectHashSlot(Layout.Seeds, "a"), 0);
+}
+
+TEST(PerfectHash, Set) {
+  static constexpr PerfectHashSet Set{{"true", "false", "null", ""}};
+  static_assert(Set.contains("null"));
+  static_assert(!Set.contains("nul"));
+
+  ASSERT_EQ(Set.size(), 4);
+  ASSERT_TRUE(Set.contains("true"));
+  ASSERT_TRUE(Set.contains("false"));
+  ASSERT_TRUE(Set.contains(""));
+  ASSERT_FALSE(Set.contains("True"));
+  ASSERT_FALSE(Set.contains("nulll"));
+
+  std::set<std::string_view> Names(Set.begin(), Set.end());
+  ASSERT_EQ(Names, (std::set<std::string_view>{"true", "false", "null", ""}));
+}
+
+} // namespace
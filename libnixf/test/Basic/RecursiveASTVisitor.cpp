@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+
+#include "nixf/Basic/ASTContext.h"
+#include "nixf/Basic/Diagnostic.h"
+#include "nixf/Basic/RecursiveASTVisitor.h"
+#include "nixf/Parse/Parser.h"
+
+#include <map>
+
+namespace {
+
+using namespace std::literals;
+using namespace nixf;
+
+constexpr auto Src = R"(
+{ pkgs ? import <nixpkgs> { }, lib, ... }@args:
+let
+  inherit (lib) optional;
+  x = rec { a.b = 1; "c" = a.b or 2.5; ${"d"} = -x; };
+in
+with pkgs; assert x ? a; [
+  (if x.a.b == 1 then "${toString x} ${./foo}" else ./bar/${x})
+  (y: y + 1)
+  (let { body = 1; })
+]
+)"sv;
+
+void collect(const Node *N, std::vector<const Node *> &Nodes) {
+  if (!N)
+    return;
+  Nodes.emplace_back(N);
+  for (const Node *Ch : N->children())
+    collect(Ch, Nodes);
+}
+
+struct Collector : RecursiveASTVisitor<Collector> {
+  std::vector<const Node *> Nodes;
+  bool visit(const Node &N) {
+    Nodes.emplace_back(&N);
+    return true;
+  }
+};
+
+TEST(RecursiveASTVisitor, ForEachChild) {
+  std::vector<Diagnostic> Diags;
+  std::shared_ptr<Node> AST = parse(Src, Diags);
+  std::vector<const Node *> Nodes;
+  collect(AST.get(), Nodes);
+  ASSERT_GT(Nodes.size(), 100);
+
+  for (const Node *N : Nodes) {
+    Node::ChildVector Children;
+    forEachChild(*N, [&](Node *Ch) { Children.emplace_back(Ch); });
+    ASSERT_EQ(Children, N->children()) << N->name();
+  }
+}
+
+TEST(RecursiveASTVisitor, PreOrder) {
+  std::vector<Diagnostic> Diags;
+  std::shared_ptr<Node> AST = parse(Src, Diags);
+  std::vector<const Node *> Nodes;
+  collect(AST.get(), Nodes);
+
+  Collector Recursive;
+  Recursive.traverse(AST.get());
+  ASSERT_EQ(Recursive.Nodes, Nodes);
+
+  Collector Iterative;
+  Iterative.traverseIteratively(AST.get());
+  ASSERT_EQ(Iterative.Nodes, Nodes);
+}
+
+struct ParentCollector : RecursiveASTVisitor<ParentCollector> {
+  std::map<const Node *, const Node *> Parents;
+  bool visitNode(const Node &N) {
+    Parents[&N] = parent();
+    return true;
+  }
+};
+
+void collectParents(const Node *N, const Node *Parent,
+                    std::map<const Node *, const Node *> &Parents) {
+  if (!N)
+    return;
+  Parents[N] = Parent;
+  for (const Node *Ch : N->children())
+    collectParents(Ch, N, Parents);
+}
+
+TEST(RecursiveASTVisitor, Parent) {
+  std::vector<Diagnostic> Diags;
+  std::shared_ptr<Node> AST = parse(Src, Diags);
+  std::map<const Node *, const Node *> Parents;
+  collectParents(AST.get(), nullptr, Parents);
+
+  ParentCollector Recursive;
+  Recursive.traverse(AST.get());
+  ASSERT_EQ(Recursive.Parents, Parents);
+
+  ParentCollector Iterative;
+  Iterative.traverseIteratively(AST.get());
+  ASSERT_EQ(Iterative.Parents, Parents);
+}
+
+struct Overloads : RecursiveASTVisitor<Overloads> {
+  int Vars = 0;
+  int Exprs = 0;
+  int Lambdas = 0;
+  bool visit(const ExprVar &) {
+    ++Vars;
+    return true;
+  }
+  bool visit(const Expr &) {
+    ++Exprs;
+    return true;
+  }
+  bool visit(const ExprLambda &Lambda) {
+    // Only the body, skipping formals.
+    ++Lambdas;
+    traverse(Lambda.body());
+    return false;
+  }
+};
+
+TEST(RecursiveASTVisitor, Overloads) {
+  std::vector<Diagnostic> Diags;
+  std::shared_ptr<Node> AST = parse("{ a ? b }: x: [ a c (y: y) ]", Diags);
+
+  Overloads Recursive;
+  Recursive.traverse(AST.get());
+  ASSERT_EQ(Recursive.Lambdas, 3);
+  ASSERT_EQ(Recursive.Vars, 3);
+  ASSERT_EQ(Recursive.Exprs, 2); // The list, and parentheses.
+
+  Overloads Iterative;
+  Iterative.traverseIteratively(AST.get());
+  ASSERT_EQ(Iterative.Lambdas, 3);
+  ASSERT_EQ(Iterative.Vars, 3);
+  ASSERT_EQ(Iterative.Exprs, 2);
+}
+
+struct ParenCounter : RecursiveASTVisitor<ParenCounter> {
+  std::size_t Count = 0;
+  bool visit(const ExprParen &) {
+    ++Count;
+    return true;
+  }
+};
+
+TEST(RecursiveASTVisitor, Deep) {
+  // Deep enough to overflow the thread stack, if the traversal recursed.
+  constexpr std::size_t Depth = 1 << 20;
+  ASTContext Ctx;
+  Expr *E = Ctx.create<ExprInt>(LexerCursorRange{}, 1);
+  for (std::size_t I = 0; I < Depth; ++I)
+    E = Ctx.create<ExprParen>(LexerCursorRange{}, E, nullptr, nullptr);
+
+  ParenCounter Counter;
+  Counter.traverseIteratively(E);
+  ASSERT_EQ(Counter.Count, Depth);
+}
+
+} // namespace
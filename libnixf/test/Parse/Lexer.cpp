@@ -103,6 +103,36 @@ aaa
             "/* comment begins at here");
 }
 
+TEST_F(LexerTest, TriviaLong) {
+  // Longer than a vector, with comments and CRLF.
+  std::string Src = "\n" + std::string(40, ' ') + "# comment\r\n" +
+                    std::string(20, '\t') + "/* a\nb */ a\n\n   b";
+  Lexer Lexer(Src, Diags);
+  auto A = Lexer.lex();
+  ASSERT_EQ(A.kind(), tok_id);
+  ASSERT_EQ(A.view(), "a");
+  ASSERT_TRUE(A.lCur().isAt(3, 5, 82));
+  ASSERT_TRUE(A.rCur().isAt(3, 6, 83));
+  auto B = Lexer.lex();
+  ASSERT_EQ(B.view(), "b");
+  ASSERT_TRUE(B.lCur().isAt(5, 3, 88));
+
+  // Cursors are right after going back.
+  Lexer.setCur(A.lCur());
+  ASSERT_TRUE(Lexer.lex().lCur().isAt(3, 5, 82));
+  ASSERT_TRUE(Diags.empty());
+}
+
+TEST_F(LexerTest, TriviaBCommentRange) {
+  Lexer Lexer("\n  /* a\n  b", Diags);
+  auto P = Lexer.lex();
+  ASSERT_EQ(P.kind(), tok_eof);
+  ASSERT_EQ(Diags.size(), 1);
+  ASSERT_TRUE(Diags[0].range().lCur().isAt(2, 3, 11));
+  ASSERT_TRUE(Diags[0].notes()[0].range().lCur().isAt(1, 2, 3));
+  ASSERT_TRUE(Diags[0].notes()[0].range().rCur().isAt(1, 4, 5));
+}
+
 TEST_F(LexerTest, FloatLeadingZero) {
   Lexer Lexer("00.33", Diags);
   auto P = Lexer.lex();
@@ -158,6 +188,35 @@ TEST_F(LexerTest, lexString) {
   ASSERT_EQ(Tokens.size(), 13);
 }
 
+TEST_F(LexerTest, lexStringLong) {
+  // String parts longer than a vector, with dollars that are not ${.
+  Lexer Lexer(R"("a long string costs $5 or $$${x}, a longer one ${x}\n")",
+              Diags);
+  auto Tokens = collect(Lexer, &Lexer::lexString);
+  ASSERT_EQ(Tokens.size(), 6);
+  ASSERT_EQ(Tokens[0].kind(), tok_dquote);
+  ASSERT_EQ(Tokens[1].kind(), tok_string_part);
+  ASSERT_EQ(Tokens[1].view(),
+            "a long string costs $5 or $$${x}, a longer one ");
+  ASSERT_EQ(Tokens[2].kind(), tok_dollar_curly);
+  ASSERT_EQ(Tokens[3].kind(), tok_string_part);
+  ASSERT_EQ(Tokens[3].view(), "x}");
+  ASSERT_EQ(Tokens[4].kind(), tok_string_escape);
+  ASSERT_EQ(Tokens[5].kind(), tok_dquote);
+}
+
+TEST_F(LexerTest, lexIndStringLong) {
+  Lexer Lexer("echo 'single quotes' $HOME $${x}\n  and ${x}''", Diags);
+  auto Tokens = collect(Lexer, &Lexer::lexIndString);
+  ASSERT_EQ(Tokens.size(), 4);
+  ASSERT_EQ(Tokens[0].kind(), tok_string_part);
+  ASSERT_EQ(Tokens[0].view(), "echo 'single quotes' $HOME $${x}\n  and ");
+  ASSERT_EQ(Tokens[1].kind(), tok_dollar_curly);
+  ASSERT_TRUE(Tokens[1].lCur().isAt(1, 6, 39));
+  ASSERT_EQ(Tokens[2].view(), "x}");
+  ASSERT_EQ(Tokens[3].kind(), tok_quote2);
+}
+
 TEST_F(LexerTest, lexIDPath) {
   // FIXME: test  pp//a to see that we can lex this as Update(pp, a)
   Lexer Lexer(R"(id pa/t)", Diags);
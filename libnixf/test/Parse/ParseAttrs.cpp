@@ -268,7 +268,7 @@ TEST(Parser, AttrsBindingWriting) {
   ASSERT_EQ(Attrs.binds()->bindings().size(), 1);
 
   const auto &Bind =
-      *static_cast<Binding *>(Attrs.binds()->bindings()[0].get());
+      *static_cast<Binding *>(Attrs.binds()->bindings()[0]);
 
   ASSERT_EQ(Bind.kind(), Node::NK_Binding);
 
@@ -304,7 +304,7 @@ TEST(Parser, AttrsBindingWritingDot) {
   ASSERT_EQ(Attrs.binds()->bindings().size(), 1);
 
   const auto &Bind =
-      *static_cast<Binding *>(Attrs.binds()->bindings()[0].get());
+      *static_cast<Binding *>(Attrs.binds()->bindings()[0]);
 
   ASSERT_EQ(Bind.kind(), Node::NK_Binding);
   ASSERT_EQ(Bind.eq(), nullptr);
@@ -351,11 +351,11 @@ TEST(Parser, AttrsNestedInLambda) {
   ASSERT_EQ(Attrs->kind(), Node::NK_ExprAttrs);
 
   const auto &Bind =
-      static_cast<Binding *>(Attrs->binds()->bindings()[0].get());
+      static_cast<Binding *>(Attrs->binds()->bindings()[0]);
 
   ASSERT_EQ(Bind->kind(), Node::NK_Binding);
 
-  const auto &NestedAttrs = static_cast<ExprAttrs *>(Bind->value().get());
+  const auto &NestedAttrs = static_cast<ExprAttrs *>(Bind->value());
 
   ASSERT_EQ(NestedAttrs->kind(), Node::NK_ExprAttrs);
 }
@@ -383,7 +383,7 @@ TEST(Parser, AttrsNested) {
   const auto &B = static_cast<ExprAttrs *>(AST.get())->binds()->bindings();
   ASSERT_EQ(B.size(), 1);
 
-  const auto &Ba = static_cast<Binding *>(B[0].get());
+  const auto &Ba = static_cast<Binding *>(B[0]);
 
   ASSERT_EQ(Ba->kind(), Node::NK_Binding);
   ASSERT_TRUE(Ba->range().lCur().isAt(2, 2, 5));
@@ -396,11 +396,11 @@ TEST(Parser, AttrsNested) {
   ASSERT_TRUE(Ba->eq()->range().rCur().isAt(2, 5, 8));
 
   const auto &BaRHS =
-      static_cast<ExprAttrs *>(Ba->value().get())->binds()->bindings();
+      static_cast<ExprAttrs *>(Ba->value())->binds()->bindings();
   ASSERT_EQ(BaRHS.size(), 1);
   ASSERT_EQ(BaRHS[0]->kind(), Node::NK_Binding);
 
-  const auto &BaRHSb = static_cast<Binding *>(BaRHS[0].get());
+  const auto &BaRHSb = static_cast<Binding *>(BaRHS[0]);
 
   ASSERT_EQ(BaRHSb->range().lCur().line(), 3);
   ASSERT_EQ(BaRHSb->range().lCur().column(), 4);
@@ -454,13 +454,13 @@ TEST(Parser, AttrsBindingInherit) {
   ASSERT_TRUE(B[1]->range().lCur().isAt(3, 2, 14));
   ASSERT_TRUE(B[1]->range().rCur().isAt(3, 10, 22));
   ASSERT_EQ(B[1]->kind(), Node::NK_Inherit);
-  const auto &I = static_cast<Inherit *>(B[1].get());
+  const auto &I = static_cast<Inherit *>(B[1]);
   ASSERT_EQ(I->names().size(), 0);
 
   ASSERT_TRUE(B[2]->range().lCur().isAt(4, 2, 25));
   ASSERT_TRUE(B[2]->range().rCur().isAt(4, 12, 35));
   ASSERT_EQ(B[2]->kind(), Node::NK_Inherit);
-  const auto &I2 = static_cast<Inherit *>(B[2].get());
+  const auto &I2 = static_cast<Inherit *>(B[2]);
   ASSERT_EQ(I2->names().size(), 1);
   ASSERT_TRUE(I2->names()[0]->range().lCur().isAt(4, 10, 33));
   ASSERT_TRUE(I2->names()[0]->range().rCur().isAt(4, 11, 34));
@@ -471,7 +471,7 @@ TEST(Parser, AttrsBindingInherit) {
   ASSERT_TRUE(B[3]->range().lCur().isAt(5, 2, 38));
   ASSERT_TRUE(B[3]->range().rCur().isAt(5, 14, 50));
   ASSERT_EQ(B[3]->kind(), Node::NK_Inherit);
-  const auto &I3 = static_cast<Inherit *>(B[3].get());
+  const auto &I3 = static_cast<Inherit *>(B[3]);
   ASSERT_EQ(I3->names().size(), 2);
   ASSERT_TRUE(I3->names()[0]->range().lCur().isAt(5, 10, 46));
   ASSERT_TRUE(I3->names()[0]->range().rCur().isAt(5, 11, 47));
@@ -487,7 +487,7 @@ TEST(Parser, AttrsBindingInherit) {
   ASSERT_TRUE(B[4]->range().lCur().isAt(6, 2, 53));
   ASSERT_TRUE(B[4]->range().rCur().isAt(6, 16, 67));
   ASSERT_EQ(B[4]->kind(), Node::NK_Inherit);
-  const auto &I4 = static_cast<Inherit *>(B[4].get());
+  const auto &I4 = static_cast<Inherit *>(B[4]);
   ASSERT_EQ(I4->names().size(), 1);
   ASSERT_TRUE(I4->names()[0]->range().lCur().isAt(6, 14, 65));
   ASSERT_TRUE(I4->names()[0]->range().rCur().isAt(6, 15, 66));
@@ -496,7 +496,7 @@ TEST(Parser, AttrsBindingInherit) {
   ASSERT_EQ(I4->expr()->kind(), Node::NK_ExprVar);
   ASSERT_TRUE(I4->hasExpr());
 
-  const auto &I5 = static_cast<Inherit *>(B[5].get());
+  const auto &I5 = static_cast<Inherit *>(B[5]);
   ASSERT_EQ(I5->names().size(), 2);
   ASSERT_EQ(I5->names()[0]->id()->name(), "a");
   ASSERT_EQ(I5->names()[1]->id()->name(), "b");
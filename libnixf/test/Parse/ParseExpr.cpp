@@ -33,7 +33,7 @@ TEST(Parser, SelectOK) {
   ASSERT_TRUE(AST->range().lCur().isAt(0, 0, 0));
   ASSERT_TRUE(AST->range().rCur().isAt(0, 5, 5));
 
-  const auto &S = static_cast<ExprSelect *>(AST.get());
+  const auto &S = static_cast<ExprSelect *>(AST);
 
   ASSERT_EQ(S->defaultExpr(), nullptr);
   ASSERT_TRUE(S->path()->lCur().isAt(0, 2, 2));
@@ -65,7 +65,7 @@ TEST(Parser, SelectDefault) {
   ASSERT_EQ(Diags.size(), 0);
   ASSERT_EQ(AST->kind(), Node::NK_ExprSelect);
 
-  const auto &S = static_cast<ExprSelect *>(AST.get());
+  const auto &S = static_cast<ExprSelect *>(AST);
 
   ASSERT_TRUE(S->defaultExpr()->range().lCur().isAt(0, 7, 7));
   ASSERT_TRUE(S->defaultExpr()->range().rCur().isAt(0, 8, 8));
@@ -143,7 +143,7 @@ TEST(Parser, ParseExprApp) {
   ASSERT_TRUE(AST->range().lCur().isAt(0, 0, 0));
   ASSERT_TRUE(AST->range().rCur().isAt(0, 3, 3));
 
-  const auto &A = static_cast<ExprCall *>(AST.get());
+  const auto &A = static_cast<ExprCall *>(AST);
 
   ASSERT_TRUE(A->fn().range().lCur().isAt(0, 0, 0));
   ASSERT_TRUE(A->fn().range().rCur().isAt(0, 1, 1));
@@ -315,7 +315,7 @@ TEST(Parser, ExprIf) {
   ASSERT_TRUE(AST->lCur().isAt(0, 0, 0));
   ASSERT_TRUE(AST->rCur().isAt(0, 21, 21));
 
-  ExprIf &If = *static_cast<ExprIf *>(AST.get());
+  ExprIf &If = *static_cast<ExprIf *>(AST);
 
   ASSERT_EQ(If.cond()->kind(), Node::NK_ExprInt);
   ASSERT_EQ(If.then()->kind(), Node::NK_ExprVar);
@@ -336,7 +336,7 @@ TEST(Parser, ExprAssert) {
   ASSERT_TRUE(AST->lCur().isAt(0, 0, 0));
   ASSERT_TRUE(AST->rCur().isAt(0, 13, 13));
 
-  ExprAssert &Assert = *static_cast<ExprAssert *>(AST.get());
+  ExprAssert &Assert = *static_cast<ExprAssert *>(AST);
 
   ASSERT_EQ(Assert.cond()->kind(), Node::NK_ExprInt);
   ASSERT_EQ(Assert.value()->kind(), Node::NK_ExprString);
@@ -352,7 +352,7 @@ TEST(Parser, ExprLet) {
   ASSERT_TRUE(AST);
   ASSERT_EQ(AST->kind(), Node::NK_ExprLet);
 
-  const Binds &B = *static_cast<ExprLet *>(AST.get())->binds();
+  const Binds &B = *static_cast<ExprLet *>(AST)->binds();
   ASSERT_EQ(B.bindings().size(), 1);
 }
 
@@ -379,7 +379,7 @@ TEST(Parser, ExprLet_Binds) {
   ASSERT_TRUE(AST);
   ASSERT_EQ(AST->kind(), Node::NK_ExprLet);
 
-  ASSERT_FALSE(static_cast<ExprLet *>(AST.get())->binds());
+  ASSERT_FALSE(static_cast<ExprLet *>(AST)->binds());
 }
 
 TEST(Parser, ExprWith_Ok) {
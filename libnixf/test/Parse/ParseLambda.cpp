@@ -100,7 +100,7 @@ TEST(Parser, ParseFormals) {
 
   ASSERT_EQ(AST->kind(), Node::NK_Formals);
 
-  auto *F = static_cast<Formals *>(AST.get());
+  auto *F = static_cast<Formals *>(AST);
   ASSERT_EQ(F->members().size(), 3);
   ASSERT_TRUE(F->range().rCur().isAt(0, 11, 11));
 }
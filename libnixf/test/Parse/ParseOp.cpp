@@ -20,7 +20,7 @@ TEST(Parser, ExprOp) {
   ASSERT_TRUE(AST);
   ASSERT_EQ(AST->kind(), Node::NK_ExprBinOp);
 
-  auto &BinOp = *static_cast<ExprBinOp *>(AST.get());
+  auto &BinOp = *static_cast<ExprBinOp *>(AST);
 
   ASSERT_TRUE(BinOp.lhs());
   ASSERT_TRUE(BinOp.rhs());
@@ -38,7 +38,7 @@ TEST(Parser, UnaryOp) {
   ASSERT_TRUE(AST);
 
   ASSERT_EQ(AST->kind(), Node::NK_ExprUnaryOp);
-  auto &UnaryOp = *static_cast<ExprUnaryOp *>(AST.get());
+  auto &UnaryOp = *static_cast<ExprUnaryOp *>(AST);
 
   ASSERT_EQ(UnaryOp.expr()->kind(), Node::NK_ExprSelect);
 }
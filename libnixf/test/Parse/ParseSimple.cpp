@@ -562,7 +562,7 @@ TEST(Parser, ParseExprList) {
   ASSERT_TRUE(AST->range().lCur().isAt(0, 0, 0));
   ASSERT_TRUE(AST->range().rCur().isAt(0, 7, 7));
 
-  const auto &L = static_cast<ExprList *>(AST.get());
+  const auto &L = static_cast<ExprList *>(AST);
 
   ASSERT_EQ(L->elements().size(), 3);
   ASSERT_TRUE(L->elements()[0]->range().lCur().isAt(0, 1, 1));
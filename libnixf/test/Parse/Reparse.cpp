@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+
+#include "nixf/Basic/Diagnostic.h"
+#include "nixf/Basic/Nodes/Attrs.h"
+#include "nixf/Basic/Nodes/Lambda.h"
+#include "nixf/Parse/Parser.h"
+
+#include <sstream>
+
+namespace {
+
+using namespace nixf;
+using namespace std::string_view_literals;
+
+/// Serialize node kinds & ranges, to compare with full parsing.
+void dump(const Node *N, std::ostream &OS) {
+  if (!N) {
+    OS << "null ";
+    return;
+  }
+  OS << N->name() << "@" << N->lCur().offset() << ":" << N->lCur().line()
+     << ":" << N->lCur().column() << "-" << N->rCur().offset() << " ";
+  for (const Node *Ch : N->children())
+    dump(Ch, OS);
+}
+
+std::string dump(const Node *N) {
+  std::ostringstream OS;
+  dump(N, OS);
+  return OS.str();
+}
+
+std::string dump(const std::vector<Diagnostic> &Diags) {
+  std::ostringstream OS;
+  for (const Diagnostic &D : Diags)
+    OS << D.format() << "@" << D.range().lCur().offset() << "-"
+       << D.range().rCur().offset() << " ";
+  return OS.str();
+}
+
+struct ReparseResult {
+  std::shared_ptr<Node> Old;
+  std::shared_ptr<Node> New;
+};
+
+/// Parse \p OldSrc, then reparse \p NewSrc based on it, and check that the
+/// result is the same as parsing \p NewSrc from scratch.
+ReparseResult check(std::string_view OldSrc, std::string_view NewSrc) {
+  std::vector<Diagnostic> OldDiags;
+  std::shared_ptr<Node> Old = parse(OldSrc, OldDiags);
+
+  std::vector<Diagnostic> Diags;
+  std::shared_ptr<Node> New = reparse(NewSrc, OldSrc, Old, OldDiags, Diags);
+
+  std::vector<Diagnostic> FullDiags;
+  std::shared_ptr<Node> Full = parse(NewSrc, FullDiags);
+
+  EXPECT_EQ(dump(New.get()), dump(Full.get()));
+  EXPECT_EQ(dump(Diags), dump(FullDiags));
+  return {std::move(Old), std::move(New)};
+}
+
+const Binds &bindsOf(const Node &N) {
+  const Node *Body = &N;
+  while (Body->kind() == Node::NK_ExprLambda)
+    Body = static_cast<const ExprLambda *>(Body)->body();
+  assert(Body->kind() == Node::NK_ExprAttrs);
+  return *static_cast<const ExprAttrs *>(Body)->binds();
+}
+
+TEST(Reparse, ReuseLeadingBindings) {
+  auto [Old, New] = check(R"({
+  a = 1;
+  b = { x = 1; };
+  c = 3;
+})"sv,
+                          R"({
+  a = 1;
+  b = { x = 1; };
+  c = 3 + ;
+  d = 4;
+})"sv);
+  const auto &OldBinds = bindsOf(*Old).bindings();
+  const auto &NewBinds = bindsOf(*New).bindings();
+  ASSERT_EQ(NewBinds.size(), 4);
+  ASSERT_EQ(NewBinds[0], OldBinds[0]);
+  ASSERT_EQ(NewBinds[1], OldBinds[1]);
+  ASSERT_NE(NewBinds[2], OldBinds[2]);
+}
+
+TEST(Reparse, ReuseInLambdaBody) {
+  auto [Old, New] = check(R"({ pkgs, ... }: {
+  a = pkgs.a;
+  b = pkgs.b;
+})"sv,
+                          R"({ pkgs, ... }: {
+  a = pkgs.a;
+  b = pkgs.b
+})"sv);
+  ASSERT_EQ(New->kind(), Node::NK_ExprLambda);
+  const auto &OldLambda = static_cast<const ExprLambda &>(*Old);
+  const auto &NewLambda = static_cast<const ExprLambda &>(*New);
+  ASSERT_EQ(NewLambda.arg(), OldLambda.arg());
+  ASSERT_EQ(bindsOf(*New).bindings()[0], bindsOf(*Old).bindings()[0]);
+}
+
+TEST(Reparse, KeepDiagnostics) {
+  auto [Old, New] = check(R"({
+  a = ;
+  b = { x = 1; x = 2; };
+  c = 1;
+})"sv,
+                          R"({
+  a = ;
+  b = { x = 1; x = 2; };
+  c = 1;
+  c = 2;
+})"sv);
+  ASSERT_EQ(bindsOf(*New).bindings()[1], bindsOf(*Old).bindings()[1]);
+}
+
+TEST(Reparse, Fallback) {
+  // The edit is located in the first binding.
+  check("{ a = 1; b = 2; }", "{ a = 12; b = 2; }");
+  // Not an attrset.
+  check("let a = 1; in a", "let a = 1; in a + 1");
+  // Recursive attrsets.
+  check("rec { a = 1; b = a; }", "rec { a = 1; b = a + 1; }");
+  // Something follows the attrset.
+  check("{ a = 1; b = 2; }", "{ a = 1; b = 2; } // { }");
+  check("{ a = 1; b = 2; }", "{ a = 1; } b");
+  // Reused attrset literal is going to be merged.
+  check("{ a = { x = 1; }; b = 2; }", "{ a = { x = 1; }; a.y = 2; }");
+  // Reused attrset literal was merged previously.
+  check("{ a = { x = 1; }; a.y = 2; }", "{ a = { x = 1; }; }");
+  // Duplicated names among reused bindings.
+  check("{ a = 1; a = 2; b = 3; }", "{ a = 1; a = 2; b = 4; }");
+  // Missing ";" after the last reusable binding.
+  check("{ a = 1; b = with x; }", "{ a = 1; b = with x; c }");
+  // No previous AST.
+  std::vector<Diagnostic> Diags;
+  ASSERT_TRUE(reparse("{ }", "", nullptr, {}, Diags));
+}
+
+} // namespace
@@ -1,6 +1,9 @@
 #include <gtest/gtest.h>
 
 #include "nixf/Basic/Diagnostic.h"
+#include "nixf/Basic/Nodes/Attrs.h"
+#include "nixf/Basic/Nodes/Expr.h"
+#include "nixf/Basic/Nodes/Simple.h"
 #include "nixf/Parse/Parser.h"
 #include "nixf/Sema/ParentMap.h"
 
@@ -26,4 +29,67 @@ TEST_F(ParentMapTest, Basic) {
   ASSERT_EQ(Var->kind(), Node::NK_ExprVar);
 }
 
+TEST_F(ParentMapTest, Reparse) {
+  // Nodes of the first binding are reused, and live in the old context.
+  std::string_view OldSrc = "{ a = x; b = 1; }";
+  std::string_view NewSrc = "{ a = x; b = 12; }";
+  std::shared_ptr<Node> Old = nixf::parse(OldSrc, Diags);
+  std::vector<Diagnostic> NewDiags;
+  std::shared_ptr<Node> New = nixf::reparse(NewSrc, OldSrc, Old, Diags,
+                                            NewDiags);
+  PMA.runOnAST(*New);
+
+  const auto &Binds = *static_cast<const ExprAttrs &>(*New).binds();
+  const Node *Reused = Binds.bindings()[0];
+  const Node *Fresh = Binds.bindings()[1];
+  ASSERT_NE(Reused->context(), Fresh->context());
+  ASSERT_EQ(PMA.query(*Reused), &Binds);
+  ASSERT_EQ(PMA.query(*Fresh), &Binds);
+
+  const Node *X = New->descend({{0, 6}, {0, 7}});
+  ASSERT_EQ(X->kind(), Node::NK_Identifier);
+  ASSERT_EQ(PMA.upTo(*X, Node::NK_ExprAttrs), New.get());
+  ASSERT_TRUE(PMA.isRoot(*New));
+}
+
+TEST_F(ParentMapTest, KeywordLet) {
+  // The keyword is shared with the inner ExprAttrs, it belongs to the `let`.
+  auto AST = nixf::parse(R"(let a = 1; in a)", Diags);
+  PMA.runOnAST(*AST);
+
+  const auto &Let = static_cast<const ExprLet &>(*AST);
+  ASSERT_EQ(PMA.query(Let.let()), &Let);
+  ASSERT_EQ(PMA.query(*Let.attrs()), &Let);
+  ASSERT_EQ(PMA.upExpr(Let.let()), &Let);
+}
+
+TEST_F(ParentMapTest, KeywordLegacyLet) {
+  auto AST = nixf::parse(R"(let { body = 1; })", Diags);
+  PMA.runOnAST(*AST);
+
+  const auto &Let = static_cast<const ExprLegacyLet &>(*AST);
+  ASSERT_EQ(PMA.query(Let.let()), &Let);
+  ASSERT_EQ(PMA.query(*Let.attrs()), &Let);
+}
+
+TEST_F(ParentMapTest, KeywordRec) {
+  auto AST = nixf::parse(R"(rec { a = 1; })", Diags);
+  PMA.runOnAST(*AST);
+
+  const auto &Attrs = static_cast<const ExprAttrs &>(*AST);
+  ASSERT_NE(Attrs.rec(), nullptr);
+  ASSERT_EQ(PMA.query(*Attrs.rec()), &Attrs);
+  ASSERT_EQ(PMA.upExpr(*Attrs.rec()), &Attrs);
+}
+
+TEST_F(ParentMapTest, Detached) {
+  // Nodes created outside of any context.
+  Identifier ID(LexerCursorRange{}, "a");
+  ExprVar Var(LexerCursorRange{}, &ID);
+  PMA.runOnAST(Var);
+  ASSERT_EQ(PMA.query(ID), &Var);
+  ASSERT_EQ(PMA.upExpr(ID), &Var);
+  ASSERT_TRUE(PMA.isRoot(Var));
+}
+
 } // namespace
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+
+#include "nixf/Basic/Diagnostic.h"
+#include "nixf/Basic/Nodes/Simple.h"
+#include "nixf/Parse/Parser.h"
+#include "nixf/Sema/PositionLookup.h"
+
+#include <algorithm>
+
+using namespace nixf;
+
+namespace {
+
+/// Check that lookups agree with `Node::descend`, for every position in the
+/// source, including those beyond the end of lines, and every range.
+void checkAllPositions(const Node &AST, std::string_view Src) {
+  PositionLookupAnalysis PLA;
+  PLA.runOnAST(AST);
+
+  int64_t Lines = std::count(Src.begin(), Src.end(), '\n') + 1;
+  auto MaxColumn = static_cast<int64_t>(Src.size()) + 2;
+  for (int64_t L = -1; L <= Lines; ++L) {
+    for (int64_t C = -1; C <= MaxColumn; ++C) {
+      PositionRange Range(Position(L, C));
+      ASSERT_EQ(PLA.descend(Range), AST.descend(Range)) << L << ":" << C;
+    }
+  }
+
+  LineIndex Index(Src);
+  for (std::size_t B = 0; B <= Src.size(); ++B) {
+    for (std::size_t E = B; E <= Src.size(); ++E) {
+      PositionRange Range(Index.cursor(B).position(),
+                          Index.cursor(E).position());
+      ASSERT_EQ(PLA.descend(Range), AST.descend(Range)) << B << "-" << E;
+    }
+  }
+}
+
+TEST(PositionLookup, Basic) {
+  std::vector<Diagnostic> Diags;
+  auto AST = parse("{ a = 1; b = a + 2; }", Diags);
+  PositionLookupAnalysis PLA;
+  PLA.runOnAST(*AST);
+
+  const Node *N = PLA.descend({{0, 2}, {0, 2}});
+  ASSERT_EQ(N->kind(), Node::NK_Identifier);
+  ASSERT_EQ(PLA.descend({{0, 2}, {0, 7}})->kind(), Node::NK_Binding);
+  ASSERT_EQ(PLA.descend({{0, 0}, {0, 21}}), AST.get());
+  ASSERT_EQ(PLA.descend({{0, 0}, {0, 22}}), nullptr);
+}
+
+TEST(PositionLookup, SameAsDescend) {
+  const char *Sources[] = {
+      "{ a = 1; b = a + 2; }",
+      "let\n  x = 1;\n  y = { z = x; };\nin\n  x + y.z",
+      "{ pkgs, lib ? pkgs.lib, ... }@args:\n"
+      "with lib;\n"
+      "assert true;\n"
+      "[ 1 2.0 \"s${toString 3}\" ''\n  i\n'' ./p/${x} (a: a) ]",
+      "a.b.c or (d // { e = !f; }) -1 - -2",
+      "{ inherit (x) a b; inherit c; \"d\" = 1; ${e} = 2; }",
+      "rec { a = if b then c else d; }",
+      // Errors.
+      "{ a = ; b",
+      "let in",
+      "",
+  };
+  for (const char *Src : Sources) {
+    std::vector<Diagnostic> Diags;
+    auto AST = parse(Src, Diags);
+    if (AST)
+      checkAllPositions(*AST, Src);
+  }
+}
+
+TEST(PositionLookup, Reparse) {
+  std::string_view OldSrc = "{\n  a = x;\n  b = 1;\n}";
+  std::string_view NewSrc = "{\n  a = x;\n  b = 12;\n}";
+  std::vector<Diagnostic> Diags;
+  std::vector<Diagnostic> NewDiags;
+  auto Old = parse(OldSrc, Diags);
+  auto New = reparse(NewSrc, OldSrc, Old, Diags, NewDiags);
+  checkAllPositions(*New, NewSrc);
+}
+
+TEST(PositionLookup, Detached) {
+  // Nodes created outside of any context.
+  Identifier ID(LexerCursorRange{LexerCursor::unsafeCreate(0, 1, 1),
+                                 LexerCursor::unsafeCreate(0, 2, 2)},
+                "a");
+  ExprVar Var(LexerCursorRange{LexerCursor::unsafeCreate(0, 0, 0),
+                               LexerCursor::unsafeCreate(0, 3, 3)},
+              &ID);
+  checkAllPositions(Var, "(a)");
+}
+
+} // namespace
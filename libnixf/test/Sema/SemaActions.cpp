@@ -1,5 +1,4 @@
 #include <gtest/gtest.h>
-#include <memory>
 
 #include "nixf/Basic/Nodes/Attrs.h"
 #include "nixf/Basic/Range.h"
@@ -14,26 +13,26 @@ using namespace std::literals;
 class SemaActionTest : public ::testing::Test {
 protected:
   std::vector<Diagnostic> Diags;
+  /// Nodes only store offsets, the line of offset N is N.
+  ASTContext Ctx{"\n\n\n"sv};
   Sema L;
 
-public:
-  SemaActionTest() : L("", Diags) {}
-};
+  AttrName *getDynamicName(LexerCursorRange Range = {}) {
+    return Ctx.create<AttrName>(Ctx.create<Interpolation>(Range, nullptr));
+  }
 
-std::shared_ptr<AttrName> getDynamicName(LexerCursorRange Range = {}) {
-  return std::make_shared<AttrName>(
-      std::make_shared<Interpolation>(Range, nullptr));
-}
+  AttrName *getStaticName(std::string Name, LexerCursorRange Range = {}) {
+    return Ctx.create<AttrName>(Ctx.create<Identifier>(Range, std::move(Name)),
+                                Range);
+  }
 
-std::shared_ptr<AttrName> getStaticName(std::string Name,
-                                        LexerCursorRange Range = {}) {
-  return std::make_shared<AttrName>(
-      std::make_shared<Identifier>(Range, std::move(Name)), Range);
-}
+public:
+  SemaActionTest() : L("", Diags, Ctx) {}
+};
 
 TEST_F(SemaActionTest, selectOrCreate) {
   SemaAttrs Attr(nullptr);
-  std::vector<std::shared_ptr<AttrName>> Path;
+  std::vector<AttrName *> Path;
   Path.emplace_back(getStaticName("a"));
   Path.emplace_back(getStaticName("b"));
   Path.emplace_back(getStaticName("c"));
@@ -85,8 +84,8 @@ TEST_F(SemaActionTest, selectOrCreate) {
 
 TEST_F(SemaActionTest, selectOrCreateDynamic) {
   SemaAttrs Attr(nullptr);
-  std::vector<std::shared_ptr<AttrName>> Path;
-  auto FirstName = getDynamicName();
+  std::vector<AttrName *> Path;
+  auto *FirstName = getDynamicName();
   Path.emplace_back(FirstName);
   Path.emplace_back(getDynamicName());
 
@@ -102,20 +101,19 @@ TEST_F(SemaActionTest, selectOrCreateDynamic) {
 }
 
 TEST_F(SemaActionTest, insertAttrDup) {
-  auto Name = getStaticName("a");
+  auto *Name = getStaticName("a");
   // Check we can detect duplicated attr.
   std::map<std::string, Attribute> Attrs;
 
   Attrs.insert(
       {"a", Attribute(
                 /*Key=*/Name,
-                /*Value=*/std::make_shared<ExprInt>(LexerCursorRange{}, 1),
+                /*Value=*/Ctx.create<ExprInt>(LexerCursorRange{}, 1),
                 Attribute::AttributeKind::Plain)});
 
   SemaAttrs A(std::move(Attrs), {}, nullptr);
-  std::shared_ptr<ExprInt> E(new ExprInt{{}, 1});
-  L.insertAttr(A, std::move(Name), std::move(E),
-               Attribute::AttributeKind::Plain); // Duplicated
+  auto *E = Ctx.create<ExprInt>(LexerCursorRange{}, 1);
+  L.insertAttr(A, Name, E, Attribute::AttributeKind::Plain); // Duplicated
 
   ASSERT_EQ(A.staticAttrs().size(), 1);
   ASSERT_EQ(Diags.size(), 1);
@@ -123,29 +121,27 @@ TEST_F(SemaActionTest, insertAttrDup) {
 
 TEST_F(SemaActionTest, insertAttrOK) {
   SemaAttrs SA(nullptr);
-  auto Name = getStaticName("a");
+  auto *Name = getStaticName("a");
   // Check we can detect duplicated attr.
-  std::shared_ptr<ExprInt> E(new ExprInt{{}, 1});
-  L.insertAttr(SA, std::move(Name), std::move(E),
-               Attribute::AttributeKind::Plain); // Duplicated
+  auto *E = Ctx.create<ExprInt>(LexerCursorRange{}, 1);
+  L.insertAttr(SA, Name, E, Attribute::AttributeKind::Plain); // Duplicated
   ASSERT_EQ(SA.staticAttrs().size(), 1);
   ASSERT_EQ(Diags.size(), 0);
 }
 
 TEST_F(SemaActionTest, insertAttrNullptr) {
   SemaAttrs SA(nullptr);
-  auto Name = getStaticName("a");
-  std::shared_ptr<ExprInt> E(new ExprInt{{}, 1});
-  L.insertAttr(SA, std::move(Name), std::move(E),
-               Attribute::AttributeKind::Plain); // Duplicated
+  auto *Name = getStaticName("a");
+  auto *E = Ctx.create<ExprInt>(LexerCursorRange{}, 1);
+  L.insertAttr(SA, Name, E, Attribute::AttributeKind::Plain); // Duplicated
   ASSERT_EQ(SA.staticAttrs().size(), 1);
   ASSERT_EQ(Diags.size(), 0);
 }
 
 TEST_F(SemaActionTest, insertAttrNullptr2) {
   SemaAttrs SA(nullptr);
-  auto Name = getDynamicName();
-  L.insertAttr(SA, std::move(Name), nullptr, Attribute::AttributeKind::Plain);
+  auto *Name = getDynamicName();
+  L.insertAttr(SA, Name, nullptr, Attribute::AttributeKind::Plain);
   ASSERT_EQ(SA.staticAttrs().size(), 0);
   ASSERT_EQ(SA.dynamicAttrs().size(), 0);
   ASSERT_EQ(Diags.size(), 0);
@@ -153,17 +149,15 @@ TEST_F(SemaActionTest, insertAttrNullptr2) {
 
 TEST_F(SemaActionTest, inheritName) {
   SemaAttrs Attr(nullptr);
-  auto Name = getStaticName("a");
+  auto *Name = getStaticName("a");
 
-  L.lowerInheritName(Attr, std::move(Name), nullptr,
-                     Attribute::AttributeKind::Inherit);
+  L.lowerInheritName(Attr, Name, nullptr, Attribute::AttributeKind::Inherit);
   ASSERT_EQ(Attr.staticAttrs().size(), 1);
   ASSERT_EQ(Diags.size(), 0);
 }
 
 TEST_F(SemaActionTest, inheritNameNullptr) {
   SemaAttrs Attr(nullptr);
-  auto Name = getStaticName("a");
 
   L.lowerInheritName(Attr, nullptr, nullptr, Attribute::AttributeKind::Inherit);
   ASSERT_EQ(Attr.staticAttrs().size(), 0);
@@ -172,8 +166,8 @@ TEST_F(SemaActionTest, inheritNameNullptr) {
 
 TEST_F(SemaActionTest, inheritNameDynamic) {
   SemaAttrs Attr(nullptr);
-  auto Name = getDynamicName(
-      {LexerCursor::unsafeCreate(0, 0, 1), LexerCursor::unsafeCreate(0, 1, 2)});
+  auto *Name = getDynamicName(
+      {LexerCursor::unsafeCreate(1, 0, 1), LexerCursor::unsafeCreate(2, 0, 2)});
 
   L.lowerInheritName(Attr, Name, nullptr, Attribute::AttributeKind::Inherit);
   ASSERT_EQ(Attr.staticAttrs().size(), 0);
@@ -182,7 +176,7 @@ TEST_F(SemaActionTest, inheritNameDynamic) {
 
   const Diagnostic &D = Diags.front();
   ASSERT_EQ(D.kind(), Diagnostic::DK_DynamicInherit);
-  ASSERT_TRUE(D.range().lCur().isAt(0, 0, 1));
+  ASSERT_TRUE(D.range().lCur().isAt(1, 0, 1));
   ASSERT_EQ(D.fixes().size(), 1);
   ASSERT_EQ(D.fixes().front().edits().size(), 1);
   ASSERT_TRUE(D.fixes().front().edits().front().isRemoval());
@@ -192,13 +186,13 @@ TEST_F(SemaActionTest, inheritNameDynamic) {
 }
 
 TEST_F(SemaActionTest, inheritNameDuplicated) {
-  auto Name = getStaticName("a");
+  auto *Name = getStaticName("a");
   std::map<std::string, Attribute> Attrs;
 
   Attrs.insert(
       {"a", Attribute(
                 /*Key=*/Name,
-                /*Value=*/std::make_shared<ExprInt>(LexerCursorRange{}, 1),
+                /*Value=*/Ctx.create<ExprInt>(LexerCursorRange{}, 1),
                 Attribute::AttributeKind::Plain)});
 
   SemaAttrs SA(std::move(Attrs), {}, nullptr);
@@ -208,13 +202,13 @@ TEST_F(SemaActionTest, inheritNameDuplicated) {
 }
 
 TEST_F(SemaActionTest, mergeAttrSets) {
-  std::shared_ptr<AttrName> XName =
-      getStaticName("a", {LexerCursor::unsafeCreate(1, 1, 1),
-                          LexerCursor::unsafeCreate(1, 1, 1)});
+  AttrName *XName =
+      getStaticName("a", {LexerCursor::unsafeCreate(1, 0, 1),
+                          LexerCursor::unsafeCreate(1, 0, 1)});
 
-  std::shared_ptr<AttrName> YName =
-      getStaticName("a", {LexerCursor::unsafeCreate(2, 2, 2),
-                          LexerCursor::unsafeCreate(1, 1, 1)});
+  AttrName *YName =
+      getStaticName("a", {LexerCursor::unsafeCreate(2, 0, 2),
+                          LexerCursor::unsafeCreate(2, 0, 2)});
 
   std::map<std::string, Attribute> XAttrs;
   std::map<std::string, Attribute> YAttrs;
@@ -222,13 +216,13 @@ TEST_F(SemaActionTest, mergeAttrSets) {
   XAttrs.insert(
       {"a", Attribute(
                 /*Key=*/XName,
-                /*Value=*/std::make_shared<ExprInt>(LexerCursorRange{}, 1),
+                /*Value=*/Ctx.create<ExprInt>(LexerCursorRange{}, 1),
                 Attribute::AttributeKind::Plain)});
 
   YAttrs.insert(
       {"a", Attribute(
                 /*Key=*/YName,
-                /*Value=*/std::make_shared<ExprInt>(LexerCursorRange{}, 1),
+                /*Value=*/Ctx.create<ExprInt>(LexerCursorRange{}, 1),
                 Attribute::AttributeKind::Plain)});
 
   SemaAttrs XA(XAttrs, {}, nullptr);
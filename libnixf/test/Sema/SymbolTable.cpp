@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+
+#include "nixf/Sema/SymbolTable.h"
+
+#include <string>
+
+namespace {
+
+using namespace nixf;
+
+TEST(SymbolTable, Intern) {
+  SymbolTable Symbols;
+  Symbol A = Symbols.intern("a");
+  Symbol B = Symbols.intern("b");
+  ASSERT_NE(A, B);
+  ASSERT_EQ(Symbols.intern(std::string("a")), A);
+  ASSERT_EQ(Symbols.name(A), "a");
+  ASSERT_EQ(Symbols.name(B), "b");
+  ASSERT_EQ(Symbols.size(), 2);
+}
+
+TEST(SymbolTable, Lookup) {
+  SymbolTable Symbols;
+  ASSERT_FALSE(Symbols.lookup("a"));
+  Symbol A = Symbols.intern("a");
+  ASSERT_EQ(Symbols.lookup("a"), A);
+  // Lookups do not intern names.
+  ASSERT_FALSE(Symbols.lookup("b"));
+  ASSERT_EQ(Symbols.size(), 1);
+}
+
+TEST(SymbolTable, Stable) {
+  // Names stay in place while the table grows.
+  SymbolTable Symbols;
+  Symbol A = Symbols.intern("a");
+  const std::string *Name = &Symbols.name(A);
+  for (int I = 0; I < 10000; ++I)
+    Symbols.intern("name" + std::to_string(I));
+  ASSERT_EQ(&Symbols.name(A), Name);
+  ASSERT_EQ(Symbols.lookup("a"), A);
+  ASSERT_EQ(Symbols.lookup("name9999"), Symbols.intern("name9999"));
+}
+
+} // namespace
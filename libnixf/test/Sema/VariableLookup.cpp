@@ -265,6 +265,28 @@ TEST_F(VLATest, Env) {
   ASSERT_TRUE(Env->defs().contains("y"));
 }
 
+TEST_F(VLATest, EnvOrder) {
+  // Definitions are iterated by name, not by symbol.
+  std::shared_ptr<Node> AST =
+      parse("let c = 1; a = 2; b = a + c; in a: b", Diags);
+  VariableLookupAnalysis VLA(Diags);
+  VLA.runOnAST(*AST);
+
+  const auto &Lambda = *static_cast<ExprLet &>(*AST).expr();
+  const EnvNode *Env = VLA.env(static_cast<const ExprLambda &>(Lambda).body());
+  ASSERT_TRUE(Env);
+  ASSERT_EQ(Env->defs().size(), 1);
+  ASSERT_FALSE(Env->defs().contains("b"));
+
+  const EnvNode *LetEnv = Env->parent();
+  ASSERT_TRUE(LetEnv);
+  std::vector<std::string> Names;
+  for (const auto &[Name, _] : LetEnv->defs())
+    Names.emplace_back(Name);
+  ASSERT_EQ(Names, (std::vector<std::string>{"a", "b", "c"}));
+  ASSERT_FALSE(LetEnv->defs().contains("d"));
+}
+
 TEST_F(VLATest, FormalDef) {
   std::shared_ptr<Node> AST = parse("{ a ? 1, b ? a}: b", Diags);
   VariableLookupAnalysis VLA(Diags);
@@ -679,10 +701,10 @@ TEST_F(VLATest, GetWithScopes_IndirectNested_Let) {
   ASSERT_TRUE(Binds);
   const auto &Bindings = Binds->bindings();
   ASSERT_EQ(Bindings.size(), 1);
-  const auto *BindingNode = static_cast<const Binding *>(Bindings[0].get());
+  const auto *BindingNode = static_cast<const Binding *>(Bindings[0]);
   ASSERT_TRUE(BindingNode);
   const auto *InnerWith =
-      static_cast<const ExprWith *>(BindingNode->value().get());
+      static_cast<const ExprWith *>(BindingNode->value());
   ASSERT_TRUE(InnerWith);
   ASSERT_EQ(InnerWith->kind(), Node::NK_ExprWith);
 
@@ -715,10 +737,10 @@ TEST_F(VLATest, GetWithScopes_IndirectNested_AttrSet) {
   const auto &Bindings = Binds->bindings();
   ASSERT_EQ(Bindings.size(), 1);
 
-  const auto *BindingNode = static_cast<const Binding *>(Bindings[0].get());
+  const auto *BindingNode = static_cast<const Binding *>(Bindings[0]);
   ASSERT_TRUE(BindingNode);
   const auto *InnerWith =
-      static_cast<const ExprWith *>(BindingNode->value().get());
+      static_cast<const ExprWith *>(BindingNode->value());
   ASSERT_TRUE(InnerWith);
 
   const auto *Var = static_cast<const ExprVar *>(InnerWith->expr());
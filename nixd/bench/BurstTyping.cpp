@@ -0,0 +1,196 @@
+/// \file
+/// \brief Benchmark end-to-end latency of requests after a burst of typing.
+///
+/// The server runs in-process, connected by a pipe (input) and an in-memory
+/// stream (output). Each iteration replays a burst of "textDocument/didChange"
+/// notifications, one per keystroke, followed by a
+/// "textDocument/documentSymbol" request, and waits for its reply.
+
+#include <benchmark/benchmark.h>
+
+#include "lspserver/Connection.h"
+#include "nixd/Controller/Controller.h"
+
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+namespace {
+
+using namespace nixd;
+using namespace lspserver;
+
+std::string makePackageSet(int Packages) {
+  std::string Src = "{ pkgs, lib, callPackage, ... }:\n{\n";
+  for (int I = 0; I < Packages; ++I) {
+    std::string Name = "pkg" + std::to_string(I);
+    Src += "  " + Name + " = callPackage ({ mkDerivation, fetchurl }:\n";
+    Src += "    mkDerivation {\n";
+    Src += "      pname = \"" + Name + "\";\n";
+    Src += "      version = \"1.0." + std::to_string(I) + "\";\n";
+    Src += "      src = fetchurl { url = \"https://example.org/" + Name +
+           ".tar.gz\"; };\n";
+    Src += "      meta.description = \"Package " + Name + "\";\n";
+    Src += "    }) { };\n";
+  }
+  Src += "}\n";
+  return Src;
+}
+
+/// Collects replies sent by the server.
+class ReplySink : public llvm::raw_ostream {
+  std::string Buffer;
+  std::mutex Lock;
+  std::condition_variable Replied;
+  std::set<int64_t> IDs; // GUARDED_BY(Lock)
+
+  void write_impl(const char *Ptr, size_t Size) override {
+    Buffer.append(Ptr, Size);
+    // Split "Content-Length: N\r\n\r\n{...}" messages.
+    for (;;) {
+      std::size_t Header = Buffer.find("\r\n\r\n");
+      if (Header == std::string::npos)
+        return;
+      std::size_t Length = std::stoul(Buffer.substr(16, Header - 16));
+      if (Buffer.size() < Header + 4 + Length)
+        return;
+      auto Message = llvm::json::parse(Buffer.substr(Header + 4, Length));
+      Buffer.erase(0, Header + 4 + Length);
+      if (!Message) {
+        llvm::consumeError(Message.takeError());
+        continue;
+      }
+      if (const llvm::json::Object *Obj = Message->getAsObject()) {
+        if (std::optional<int64_t> ID = Obj->getInteger("id");
+            ID && !Obj->get("method")) {
+          std::lock_guard G(Lock);
+          IDs.emplace(*ID);
+          Replied.notify_all();
+        }
+      }
+    }
+  }
+
+  uint64_t current_pos() const override { return 0; }
+
+public:
+  ReplySink() { SetUnbuffered(); }
+
+  void wait(int64_t ID) {
+    std::unique_lock L(Lock);
+    Replied.wait(L, [&]() { return IDs.contains(ID); });
+  }
+};
+
+class Session {
+  int Pipe[2];
+  ReplySink Sink;
+  std::unique_ptr<Controller> Server;
+  std::thread Loop;
+
+public:
+  Session() {
+    [[maybe_unused]] int Err = pipe(Pipe);
+    assert(!Err);
+    Server = std::make_unique<Controller>(
+        std::make_unique<InboundPort>(Pipe[0]),
+        std::make_unique<OutboundPort>(Sink));
+    Loop = std::thread([this]() { Server->run(); });
+  }
+
+  ~Session() {
+    send(llvm::json::Object{{"jsonrpc", "2.0"}, {"method", "exit"}});
+    Loop.join();
+    Server.reset();
+    close(Pipe[0]);
+    close(Pipe[1]);
+  }
+
+  void send(llvm::json::Value Message) {
+    std::string Str;
+    llvm::raw_string_ostream OS(Str);
+    OS << Message;
+    std::string Framed =
+        "Content-Length: " + std::to_string(Str.size()) + "\r\n\r\n" + Str;
+    for (std::size_t Written = 0; Written < Framed.size();) {
+      ssize_t N = write(Pipe[1], Framed.data() + Written,
+                        Framed.size() - Written);
+      if (N < 0)
+        continue;
+      Written += N;
+    }
+  }
+
+  void notify(llvm::StringRef Method, llvm::json::Value Params) {
+    send(llvm::json::Object{
+        {"jsonrpc", "2.0"}, {"method", Method}, {"params", std::move(Params)}});
+  }
+
+  void call(int64_t ID, llvm::StringRef Method, llvm::json::Value Params) {
+    send(llvm::json::Object{{"jsonrpc", "2.0"},
+                            {"id", ID},
+                            {"method", Method},
+                            {"params", std::move(Params)}});
+    Sink.wait(ID);
+  }
+};
+
+constexpr llvm::StringLiteral URI = "file:///bench/packages.nix";
+
+void BM_BurstTyping(benchmark::State &State) {
+  const int Packages = static_cast<int>(State.range(0));
+  const int Burst = static_cast<int>(State.range(1));
+  Session S;
+  S.notify("textDocument/didOpen",
+           llvm::json::Object{
+               {"textDocument", llvm::json::Object{
+                                    {"uri", URI},
+                                    {"languageId", "nix"},
+                                    {"version", 0},
+                                    {"text", makePackageSet(Packages)},
+                                }}});
+
+  // Type in the middle of the file, right after "pkgN =".
+  const int Line = 2 + 7 * (Packages / 2);
+  const int Character =
+      static_cast<int>(2 + 3 + std::to_string(Packages / 2).size() + 2);
+  int64_t Version = 0;
+  for (auto _ : State) {
+    for (int I = 0; I < Burst; ++I) {
+      auto Pos = [&]() {
+        return llvm::json::Object{{"line", Line}, {"character", Character}};
+      };
+      S.notify("textDocument/didChange",
+               llvm::json::Object{
+                   {"textDocument",
+                    llvm::json::Object{{"uri", URI}, {"version", ++Version}}},
+                   {"contentChanges",
+                    llvm::json::Array{llvm::json::Object{
+                        {"range", llvm::json::Object{{"start", Pos()},
+                                                     {"end", Pos()}}},
+                        {"text", " "},
+                    }}},
+               });
+    }
+    S.call(Version, "textDocument/documentSymbol",
+           llvm::json::Object{
+               {"textDocument", llvm::json::Object{{"uri", URI}}}});
+  }
+  State.SetItemsProcessed(State.iterations() * Burst);
+}
+
+BENCHMARK(BM_BurstTyping)
+    ->ArgsProduct({{1000, 5000}, {1, 10, 50}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,88 @@
+/// \file
+/// \brief Benchmark ranking of large completion candidate sets.
+///
+/// Names are synthetic, but similar to the nixpkgs top-level. "BM_SortAll"
+/// scores every candidate and sorts all matches before truncating the list,
+/// "BM_TopK" keeps the best items in a bounded heap (CompletionRanker).
+
+#include <benchmark/benchmark.h>
+
+#include "nixd/Controller/CompletionRanker.h"
+#include "nixd/Support/FuzzyMatch.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace nixd;
+using namespace lspserver;
+
+constexpr std::size_t Limit = 30;
+
+std::vector<std::string> makeNames(int Num) {
+  const char *Stems[] = {"python", "haskell", "perl",  "node", "lib",
+                         "gnome",  "kde",     "xorg",  "font", "rust",
+                         "go",     "ocaml",   "linux", "vim",  "emacs"};
+  const char *Suffixes[] = {"", "Packages", "-utils", "_full", "Plugins",
+                            "-bin"};
+  std::mt19937 Gen(42);
+  std::vector<std::string> Names;
+  Names.reserve(Num);
+  for (int I = 0; I < Num; ++I) {
+    std::string Name = Stems[Gen() % std::size(Stems)];
+    Name += Suffixes[Gen() % std::size(Suffixes)];
+    Name += std::to_string(I);
+    Names.emplace_back(std::move(Name));
+  }
+  std::shuffle(Names.begin(), Names.end(), Gen);
+  return Names;
+}
+
+const char *Patterns[] = {"p", "py", "haskellP", "xorg1", "gnmPl"};
+
+void BM_SortAll(benchmark::State &State) {
+  std::vector<std::string> Names = makeNames(State.range(0));
+  std::size_t I = 0;
+  for (auto _ : State) {
+    std::string_view Pattern = Patterns[I++ % std::size(Patterns)];
+    std::vector<std::pair<int, CompletionItem>> Matched;
+    for (const std::string &Name : Names) {
+      if (std::optional<int> Score = fuzzyMatch(Pattern, Name))
+        Matched.emplace_back(*Score, CompletionItem{.label = Name});
+    }
+    std::stable_sort(Matched.begin(), Matched.end(),
+                     [](const auto &L, const auto &R) {
+                       return L.first > R.first;
+                     });
+    if (Matched.size() > Limit)
+      Matched.resize(Limit);
+    benchmark::DoNotOptimize(Matched);
+  }
+  State.SetItemsProcessed(State.iterations() * Names.size());
+}
+
+void BM_TopK(benchmark::State &State) {
+  std::vector<std::string> Names = makeNames(State.range(0));
+  std::size_t I = 0;
+  for (auto _ : State) {
+    std::string_view Pattern = Patterns[I++ % std::size(Patterns)];
+    CompletionRanker Ranker(Limit);
+    for (const std::string &Name : Names)
+      Ranker.add(Pattern, CompletionItem{.label = Name});
+    auto Items = Ranker.take();
+    benchmark::DoNotOptimize(Items);
+  }
+  State.SetItemsProcessed(State.iterations() * Names.size());
+}
+
+BENCHMARK(BM_SortAll)->Arg(1000)->Arg(10000)->Arg(100000)->Unit(
+    benchmark::kMicrosecond);
+BENCHMARK(BM_TopK)->Arg(1000)->Arg(10000)->Arg(100000)->Unit(
+    benchmark::kMicrosecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,103 @@
+/// \file
+/// \brief Benchmark converting diagnostics of a large file to LSP ranges.
+///
+/// This is what "textDocument/publishDiagnostics" spends its time on. The
+/// file has one unused "let" binding per line, each reported by the variable
+/// lookup analysis, and some lines have non-ASCII comments. "BM_Scan"
+/// converts offsets by scanning the text from its beginning, "BM_LineTable"
+/// looks up lines in a lspserver::LineTable, built on each iteration.
+
+#include <benchmark/benchmark.h>
+
+#include "lspserver/SourceCode.h"
+
+#include <nixf/Basic/Diagnostic.h>
+#include <nixf/Parse/Parser.h>
+#include <nixf/Sema/VariableLookup.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace lspserver;
+
+std::string makeUnusedBindings(int Bindings) {
+  std::string Src = "let\n";
+  for (int I = 0; I < Bindings; ++I) {
+    Src += "  x" + std::to_string(I) + " = " + std::to_string(I) + ";";
+    if (I % 8 == 0)
+      Src += " # ünused";
+    Src += "\n";
+  }
+  Src += "in\n{ }\n";
+  return Src;
+}
+
+struct Document {
+  std::string Src;
+  std::vector<nixf::Diagnostic> Diagnostics;
+
+  explicit Document(int Bindings) : Src(makeUnusedBindings(Bindings)) {
+    std::shared_ptr<nixf::Node> AST = nixf::parse(Src, Diagnostics);
+    nixf::VariableLookupAnalysis VLA(Diagnostics);
+    VLA.runOnAST(*AST);
+  }
+};
+
+template <class Convert>
+void convertAll(const std::vector<nixf::Diagnostic> &Diagnostics,
+                const Convert &C, std::vector<Range> &Ranges) {
+  Ranges.clear();
+  for (const nixf::Diagnostic &D : Diagnostics) {
+    Ranges.emplace_back(Range{C(D.range().lCur()), C(D.range().rCur())});
+    for (const nixf::Note &N : D.notes())
+      Ranges.emplace_back(Range{C(N.range().lCur()), C(N.range().rCur())});
+  }
+}
+
+void BM_Scan(benchmark::State &State) {
+  Document Doc(static_cast<int>(State.range(0)));
+  std::vector<Range> Ranges;
+  for (auto _ : State) {
+    convertAll(
+        Doc.Diagnostics,
+        [&](const nixf::LexerCursor &P) {
+          return offsetToPosition(Doc.Src, P.offset());
+        },
+        Ranges);
+    benchmark::DoNotOptimize(Ranges.data());
+  }
+  State.SetItemsProcessed(State.iterations() * Doc.Diagnostics.size());
+}
+
+void BM_LineTable(benchmark::State &State) {
+  Document Doc(static_cast<int>(State.range(0)));
+  std::vector<Range> Ranges;
+  for (auto _ : State) {
+    LineTable Lines(Doc.Src);
+    convertAll(
+        Doc.Diagnostics,
+        [&](const nixf::LexerCursor &P) {
+          return Lines.offsetToPosition(P.offset());
+        },
+        Ranges);
+    benchmark::DoNotOptimize(Ranges.data());
+  }
+  State.SetItemsProcessed(State.iterations() * Doc.Diagnostics.size());
+}
+
+BENCHMARK(BM_Scan)
+    ->Arg(1000)
+    ->Arg(5000)
+    ->Arg(10000)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LineTable)
+    ->Arg(1000)
+    ->Arg(5000)
+    ->Arg(10000)
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,179 @@
+/// \file
+/// \brief Benchmark receiving a large document, from JSON text to the draft.
+///
+/// "DOM" parses the whole message by llvm::json::parse(), and the params by
+/// fromJSON(), copying the text on each step. "Lazy" scans the envelope, and
+/// decodes the text straight into the params, which are moved into the draft.
+
+#include <benchmark/benchmark.h>
+
+#include "lspserver/Connection.h"
+#include "lspserver/DraftStore.h"
+#include "lspserver/LSPBinder.h"
+#include "lspserver/Logger.h"
+#include "lspserver/Protocol.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <optional>
+#include <string>
+
+#include <unistd.h>
+
+namespace {
+
+std::atomic<std::size_t> Allocations;
+std::atomic<std::size_t> AllocatedBytes;
+
+} // namespace
+
+void *operator new(std::size_t Size) {
+  Allocations.fetch_add(1, std::memory_order_relaxed);
+  AllocatedBytes.fetch_add(Size, std::memory_order_relaxed);
+  if (void *Ptr = std::malloc(Size ? Size : 1))
+    return Ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *Ptr) noexcept { std::free(Ptr); }
+
+void operator delete(void *Ptr, std::size_t) noexcept { std::free(Ptr); }
+
+namespace {
+
+using namespace lspserver;
+
+/// Messages are logged, but not formatted, as with verbose logging off.
+class NullLogger : public Logger {
+  void log(Level, const char *, const llvm::formatv_object_base &) override {}
+};
+
+/// A didOpen notification, for a document of roughly \p Size bytes.
+std::string makeDidOpen(std::size_t Size) {
+  std::string Text = "{\n";
+  for (int I = 0; Text.size() < Size; ++I) {
+    Text += "  pkg" + std::to_string(I) + " = callPackage ./pkg" +
+            std::to_string(I) + " { description = \"the \\\"pkg\\\"\"; };\n";
+  }
+  Text += "}\n";
+  std::string Message;
+  llvm::raw_string_ostream OS(Message);
+  OS << llvm::json::Object{
+      {"jsonrpc", "2.0"},
+      {"method", "textDocument/didOpen"},
+      {"params",
+       llvm::json::Object{
+           {"textDocument",
+            llvm::json::Object{
+                {"uri", "file:///default.nix"},
+                {"languageId", "nix"},
+                {"version", 1},
+                {"text", std::move(Text)},
+            }},
+       }},
+  };
+  return Message;
+}
+
+/// Stores opened documents, as the controller does.
+class Server : public MessageHandler {
+  HandlerRegistry Registry;
+  DraftStore Store;
+  bool Lazy;
+
+  void onOpenByRef(const DidOpenTextDocumentParams &Params) {
+    Store.addDraft(Params.textDocument.uri.file(), "1",
+                   Rope(Params.textDocument.text));
+  }
+
+  void onOpen(DidOpenTextDocumentParams &&Params) {
+    Store.addDraft(Params.textDocument.uri.file(), "1",
+                   Rope(std::move(Params.textDocument.text)));
+  }
+
+public:
+  explicit Server(bool Lazy) : Lazy(Lazy) {
+    if (Lazy)
+      Registry.addNotification("textDocument/didOpen", this, &Server::onOpen);
+    else
+      Registry.addNotification("textDocument/didOpen", this,
+                               &Server::onOpenByRef);
+  }
+
+  bool onNotify(llvm::StringRef Method, llvm::json::Value Params) override {
+    Registry.NotificationHandlers[Method](std::move(Params));
+    return true;
+  }
+
+  std::optional<bool> onRawNotify(llvm::StringRef Method,
+                                  llvm::StringRef Params) override {
+    if (!Lazy)
+      return std::nullopt;
+    Registry.RawNotificationHandlers[Method](Params);
+    return true;
+  }
+
+  bool onCall(llvm::StringRef, llvm::json::Value, llvm::json::Value) override {
+    return true;
+  }
+
+  bool onReply(llvm::json::Value,
+               llvm::Expected<llvm::json::Value> R) override {
+    llvm::consumeError(R.takeError());
+    return true;
+  }
+
+  std::size_t size() const {
+    return Store.getDraft("/default.nix")->Contents.size();
+  }
+};
+
+void run(benchmark::State &State, bool Lazy) {
+  NullLogger Log;
+  LoggingSession Session(Log);
+  const std::string Message = makeDidOpen(State.range(0));
+  InboundPort In(STDIN_FILENO);
+  Server S(Lazy);
+  std::size_t Allocs = Allocations.load();
+  std::size_t Bytes = AllocatedBytes.load();
+  for (auto _ : State) {
+    if (Lazy) {
+      In.dispatchRaw(Message, S);
+    } else {
+      // This is how messages were dispatched, by a copy of the parsed one.
+      llvm::Expected<llvm::json::Value> V = llvm::json::parse(Message);
+      if (!V) {
+        llvm::consumeError(V.takeError());
+        State.SkipWithError("failed to parse the message");
+        break;
+      }
+      In.dispatch(*V, S);
+    }
+  }
+  benchmark::DoNotOptimize(S.size());
+  State.SetBytesProcessed(State.iterations() * Message.size());
+  State.counters["allocs"] =
+      benchmark::Counter(static_cast<double>(Allocations.load() - Allocs),
+                         benchmark::Counter::kAvgIterations);
+  State.counters["alloc_bytes"] =
+      benchmark::Counter(static_cast<double>(AllocatedBytes.load() - Bytes),
+                         benchmark::Counter::kAvgIterations);
+}
+
+void BM_DidOpenDOM(benchmark::State &State) { run(State, /*Lazy=*/false); }
+
+void BM_DidOpenLazy(benchmark::State &State) { run(State, /*Lazy=*/true); }
+
+BENCHMARK(BM_DidOpenDOM)
+    ->Arg(1 << 20)
+    ->Arg(8 << 20)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_DidOpenLazy)
+    ->Arg(1 << 20)
+    ->Arg(8 << 20)
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
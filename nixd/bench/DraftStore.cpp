@@ -0,0 +1,124 @@
+/// \file
+/// \brief Benchmark a typing session on a large document in the DraftStore.
+///
+/// Each keystroke is an incremental "textDocument/didChange", applied to the
+/// stored draft as the controller does. The baseline copies the whole text
+/// into a std::string per keystroke, edits it, and stores another copy.
+
+#include <benchmark/benchmark.h>
+
+#include "lspserver/DraftStore.h"
+#include "lspserver/SourceCode.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace lspserver;
+
+/// About 1 MB of Nix code.
+std::string makeDocument() {
+  std::string Src = "{ pkgs, lib, callPackage, ... }:\n{\n";
+  for (int I = 0; Src.size() < (1 << 20); ++I) {
+    std::string Name = "pkg" + std::to_string(I);
+    Src += "  " + Name + " = callPackage ({ mkDerivation, fetchurl }:\n";
+    Src += "    mkDerivation {\n";
+    Src += "      pname = \"" + Name + "\";\n";
+    Src += "      version = \"1.0." + std::to_string(I) + "\";\n";
+    Src += "    }) { };\n";
+  }
+  Src += "}\n";
+  return Src;
+}
+
+/// Type a new attribute in the middle of the document, character by
+/// character, with a few backspaces.
+std::vector<TextDocumentContentChangeEvent> makeSession(int Line) {
+  const std::string Typed = "  hello = \"world\";\n  foo = bar.baz;\n";
+  std::vector<TextDocumentContentChangeEvent> Changes;
+  Position At{Line, 0};
+  for (char Ch : Typed) {
+    TextDocumentContentChangeEvent C;
+    C.range = Range{At, At};
+    C.rangeLength = 0;
+    C.text = std::string(1, Ch);
+    Changes.emplace_back(C);
+    if (Ch == '\n') {
+      At = Position{At.line + 1, 0};
+      continue;
+    }
+    At.character++;
+    if (Ch == '=') {
+      // Typo, and backspace.
+      C.range = Range{At, At};
+      C.text = "x";
+      Changes.emplace_back(C);
+      C.range = Range{At, Position{At.line, At.character + 1}};
+      C.rangeLength = 1;
+      C.text = "";
+      Changes.emplace_back(C);
+    }
+  }
+  return Changes;
+}
+
+void BM_TypingString(benchmark::State &State) {
+  const std::string Doc = makeDocument();
+  const auto Session = makeSession(10000);
+  for (auto _ : State) {
+    auto Draft = std::make_shared<const std::string>(Doc);
+    for (const auto &Change : Session) {
+      std::string NewCode(*Draft);
+      if (auto Err = applyChange(NewCode, Change)) {
+        State.SkipWithError("cannot apply change");
+        llvm::consumeError(std::move(Err));
+        return;
+      }
+      Draft = std::make_shared<const std::string>(NewCode);
+    }
+    benchmark::DoNotOptimize(Draft);
+  }
+  State.SetItemsProcessed(State.iterations() * Session.size());
+}
+
+void BM_TypingRope(benchmark::State &State) {
+  const std::string Doc = makeDocument();
+  const auto Session = makeSession(10000);
+  const std::string File = "/default.nix";
+  for (auto _ : State) {
+    DraftStore Store;
+    Store.addDraft(File, "", Rope(Doc));
+    for (const auto &Change : Session) {
+      Rope NewCode = Store.getDraft(File)->Contents;
+      if (auto Err = applyChange(NewCode, Change)) {
+        State.SkipWithError("cannot apply change");
+        llvm::consumeError(std::move(Err));
+        return;
+      }
+      Store.addDraft(File, "", std::move(NewCode));
+    }
+    benchmark::DoNotOptimize(Store.getDraft(File)->Contents.str());
+  }
+  State.SetItemsProcessed(State.iterations() * Session.size());
+}
+
+/// The text is flattened when it is analyzed, i.e. once per burst.
+void BM_Flatten(benchmark::State &State) {
+  Rope Doc = Rope(makeDocument()).replace(0, 0, "# edited\n");
+  for (auto _ : State) {
+    // A new snapshot, with nothing flattened yet.
+    Rope Copy = Doc.replace(0, 0, "");
+    benchmark::DoNotOptimize(Copy.str());
+  }
+  State.SetBytesProcessed(State.iterations() * Doc.size());
+}
+
+BENCHMARK(BM_TypingString)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TypingRope)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Flatten)->Unit(benchmark::kMicrosecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
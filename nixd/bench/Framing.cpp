@@ -0,0 +1,81 @@
+/// \file
+/// \brief Benchmark throughput of reading framed messages from a pipe.
+///
+/// This is how nixd talks to its workers, and how clients talk to nixd. A
+/// writer thread sends "Content-Length" framed JSON messages, and the
+/// InboundPort reads and parses them.
+
+#include <benchmark/benchmark.h>
+
+#include "lspserver/Connection.h"
+
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+namespace {
+
+using namespace lspserver;
+
+/// A message with a string payload, so that it has roughly \p Size bytes.
+std::string makeMessage(std::size_t Size) {
+  std::string Body = R"({"jsonrpc":"2.0","method":"bench","params":")";
+  Body += std::string(Size, 'x');
+  Body += "\"}";
+  return "Content-Length: " + std::to_string(Body.size()) + "\r\n\r\n" + Body;
+}
+
+void writeAll(int FD, const std::string &Data) {
+  for (std::size_t Written = 0; Written < Data.size();) {
+    ssize_t N = write(FD, Data.data() + Written, Data.size() - Written);
+    if (N < 0)
+      continue;
+    Written += N;
+  }
+}
+
+void BM_ReadMessages(benchmark::State &State) {
+  const std::size_t Size = State.range(0);
+  const int Count = static_cast<int>(State.range(1));
+  const std::string Message = makeMessage(Size);
+  std::string All;
+  for (int I = 0; I < Count; ++I)
+    All += Message;
+
+  for (auto _ : State) {
+    int Pipe[2];
+    if (pipe(Pipe) != 0) {
+      State.SkipWithError("pipe() failed");
+      return;
+    }
+    std::thread Writer([&]() { writeAll(Pipe[1], All); });
+    InboundPort In(Pipe[0]);
+    std::string Buffer;
+    for (int I = 0; I < Count; ++I) {
+      auto Value = In.readMessage(Buffer);
+      if (!Value) {
+        llvm::consumeError(Value.takeError());
+        State.SkipWithError("failed to read the message");
+        break;
+      }
+      benchmark::DoNotOptimize(*Value);
+    }
+    Writer.join();
+    close(Pipe[0]);
+    close(Pipe[1]);
+  }
+  State.SetBytesProcessed(State.iterations() * All.size());
+  State.SetItemsProcessed(State.iterations() * Count);
+}
+
+BENCHMARK(BM_ReadMessages)
+    ->Args({64, 10000})
+    ->Args({4096, 1000})
+    ->Args({1 << 20, 10})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,103 @@
+/// \file
+/// \brief Benchmark attribute name completion on a large attribute set.
+///
+/// Names are synthetic, but similar to the nixpkgs top-level (~100k entries).
+/// "BM_SortAndScan" is the previous approach: sort all names for each query,
+/// then scan them linearly.
+
+#include <benchmark/benchmark.h>
+
+#include "nixd/Eval/NameIndex.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace nixd;
+
+constexpr std::size_t Limit = 31;
+
+std::vector<std::string> makeNames(int Num) {
+  const char *Stems[] = {"python", "haskell", "perl",  "node", "lib",
+                         "gnome",  "kde",     "xorg",  "font", "rust",
+                         "go",     "ocaml",   "linux", "vim",  "emacs"};
+  const char *Suffixes[] = {"", "Packages", "-utils", "_full", "Plugins",
+                            "-bin"};
+  std::mt19937 Gen(42);
+  std::vector<std::string> Names;
+  Names.reserve(Num);
+  for (int I = 0; I < Num; ++I) {
+    std::string Name = Stems[Gen() % std::size(Stems)];
+    Name += Suffixes[Gen() % std::size(Suffixes)];
+    Name += std::to_string(I);
+    Names.emplace_back(std::move(Name));
+  }
+  // Names are not sorted in attribute sets.
+  std::shuffle(Names.begin(), Names.end(), Gen);
+  return Names;
+}
+
+const char *Patterns[] = {"py", "haskellP", "xorg1", "lbu", "gnmPl"};
+
+void BM_SortAndScan(benchmark::State &State) {
+  std::vector<std::string> Names = makeNames(State.range(0));
+  std::size_t I = 0;
+  for (auto _ : State) {
+    std::string_view Prefix = Patterns[I++ % std::size(Patterns)];
+    std::vector<const std::string *> Sorted;
+    Sorted.reserve(Names.size());
+    for (const std::string &Name : Names)
+      Sorted.emplace_back(&Name);
+    std::sort(Sorted.begin(), Sorted.end(),
+              [](const std::string *L, const std::string *R) {
+                return *L < *R;
+              });
+    std::vector<std::string_view> Result;
+    for (const std::string *Name : Sorted) {
+      if (Name->starts_with(Prefix)) {
+        Result.emplace_back(*Name);
+        if (Result.size() >= Limit)
+          break;
+      }
+    }
+    benchmark::DoNotOptimize(Result);
+  }
+}
+
+void BM_Build(benchmark::State &State) {
+  std::vector<std::string> Names = makeNames(State.range(0));
+  for (auto _ : State) {
+    NameIndex Index(Names);
+    benchmark::DoNotOptimize(Index);
+  }
+}
+
+void BM_Prefix(benchmark::State &State) {
+  NameIndex Index(makeNames(State.range(0)));
+  std::size_t I = 0;
+  for (auto _ : State) {
+    auto Result = Index.prefix(Patterns[I++ % std::size(Patterns)], Limit);
+    benchmark::DoNotOptimize(Result);
+  }
+}
+
+void BM_Complete(benchmark::State &State) {
+  NameIndex Index(makeNames(State.range(0)));
+  std::size_t I = 0;
+  for (auto _ : State) {
+    auto Result = Index.complete(Patterns[I++ % std::size(Patterns)], Limit);
+    benchmark::DoNotOptimize(Result);
+  }
+}
+
+BENCHMARK(BM_SortAndScan)->Arg(100000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Build)->Arg(100000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Prefix)->Arg(100000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Complete)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
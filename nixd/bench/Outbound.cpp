@@ -0,0 +1,89 @@
+/// \file
+/// \brief Benchmark many threads sending messages through one OutboundPort.
+///
+/// Workers of the thread pool reply, report progress and publish diagnostics
+/// concurrently. A reader thread drains the pipe, as the client does.
+
+#include <benchmark/benchmark.h>
+
+#include "lspserver/Connection.h"
+#include "lspserver/Logger.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+using namespace lspserver;
+
+/// Messages are logged, but not formatted, as with verbose logging off.
+class NullLogger : public Logger {
+  void log(Level, const char *, const llvm::formatv_object_base &) override {}
+};
+
+void BM_Notify(benchmark::State &State) {
+  const int Threads = static_cast<int>(State.range(0));
+  const int Count = 2000;
+  NullLogger Log;
+  LoggingSession Session(Log);
+
+  int Pipe[2];
+  if (pipe(Pipe) != 0) {
+    State.SkipWithError("pipe() failed");
+    return;
+  }
+  std::thread Reader([&]() {
+    char Buf[1 << 16];
+    while (read(Pipe[0], Buf, sizeof(Buf)) > 0)
+      ;
+  });
+
+  OutboundPort::Metrics M;
+  {
+    OutboundPort Out(Pipe[1], /*Pretty=*/false);
+    for (auto _ : State) {
+      std::vector<std::thread> Producers;
+      for (int T = 0; T < Threads; ++T) {
+        Producers.emplace_back([&, T]() {
+          for (int I = 0; I < Count; ++I) {
+            Out.notify("$/progress", llvm::json::Object{
+                                         {"token", T},
+                                         {"value", llvm::json::Object{
+                                                       {"kind", "report"},
+                                                       {"percentage", I},
+                                                   }},
+                                     });
+          }
+        });
+      }
+      for (std::thread &P : Producers)
+        P.join();
+      Out.flush();
+    }
+    M = Out.metrics();
+  }
+  close(Pipe[1]);
+  Reader.join();
+  close(Pipe[0]);
+
+  State.SetItemsProcessed(State.iterations() * Threads * Count);
+  State.counters["msgs/write"] =
+      static_cast<double>(M.Messages) / static_cast<double>(M.Writes);
+  State.counters["latency_us"] =
+      static_cast<double>(M.TotalLatency.count()) / 1e3 /
+      static_cast<double>(M.Messages);
+}
+
+BENCHMARK(BM_Notify)
+    ->Arg(1)
+    ->Arg(4)
+    ->Arg(16)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,69 @@
+/// \file
+/// \brief Benchmark converting columns between bytes and LSP encodings.
+///
+/// Lines are 4KiB long, with a non-ASCII character every "Arg" bytes (0 means
+/// pure ASCII). "BM_Length" measures the line in the encoding, as done for
+/// positions sent to the client, and "BM_ToOffset" finds the byte offset of
+/// its last column, as done for positions received from the client.
+
+#include <benchmark/benchmark.h>
+
+#include "lspserver/SourceCode.h"
+
+#include <string>
+
+namespace {
+
+using namespace lspserver;
+
+constexpr std::size_t LineSize = 4096;
+
+std::string makeLine(std::size_t Every) {
+  std::string Line;
+  while (Line.size() < LineSize) {
+    if (Every && Line.size() % Every == 0)
+      Line += "é";
+    else
+      Line += 'a' + Line.size() % 26;
+  }
+  return Line;
+}
+
+void BM_Length(benchmark::State &State, OffsetEncoding Enc) {
+  const std::string Line = makeLine(State.range(0));
+  setLSPEncoding(Enc);
+  for (auto _ : State)
+    benchmark::DoNotOptimize(lspLength(Line));
+  setLSPEncoding(OffsetEncoding::UTF16);
+  State.SetBytesProcessed(State.iterations() * Line.size());
+}
+
+void BM_ToOffset(benchmark::State &State, OffsetEncoding Enc) {
+  const std::string Line = makeLine(State.range(0));
+  setLSPEncoding(Enc);
+  Position End{0, static_cast<int>(lspLength(Line))};
+  for (auto _ : State) {
+    auto Offset = positionToOffset(Line, End);
+    benchmark::DoNotOptimize(*Offset);
+  }
+  setLSPEncoding(OffsetEncoding::UTF16);
+  State.SetBytesProcessed(State.iterations() * Line.size());
+}
+
+BENCHMARK_CAPTURE(BM_Length, UTF8, OffsetEncoding::UTF8)->Arg(0)->Arg(64);
+BENCHMARK_CAPTURE(BM_Length, UTF16, OffsetEncoding::UTF16)
+    ->Arg(0)
+    ->Arg(256)
+    ->Arg(64)
+    ->Arg(8);
+BENCHMARK_CAPTURE(BM_Length, UTF32, OffsetEncoding::UTF32)->Arg(0)->Arg(64);
+BENCHMARK_CAPTURE(BM_ToOffset, UTF8, OffsetEncoding::UTF8)->Arg(0)->Arg(64);
+BENCHMARK_CAPTURE(BM_ToOffset, UTF16, OffsetEncoding::UTF16)
+    ->Arg(0)
+    ->Arg(256)
+    ->Arg(64)
+    ->Arg(8);
+
+} // namespace
+
+BENCHMARK_MAIN();
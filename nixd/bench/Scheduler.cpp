@@ -0,0 +1,111 @@
+/// \file
+/// \brief Benchmark latency of completion, under load of background tasks.
+///
+/// Background tasks wait (as inlay hints wait for the nixpkgs worker), and
+/// are posted so that many of them are always queued. Meanwhile completion
+/// tasks are posted one at a time, and the time until each one finishes is
+/// measured. "FIFO" is boost::asio::thread_pool, which nixd used before, and
+/// "Priority" is the Scheduler.
+
+#include <benchmark/benchmark.h>
+
+#include "nixd/Support/Scheduler.h"
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace nixd;
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t Workers = 4;
+constexpr int Completions = 100;
+constexpr std::size_t QueuedBackground = 32;
+constexpr std::chrono::milliseconds BackgroundWait{20};
+constexpr std::chrono::microseconds CompletionWork{200};
+
+void spin(std::chrono::microseconds Duration) {
+  Clock::time_point End = Clock::now() + Duration;
+  while (Clock::now() < End)
+    ;
+}
+
+/// Post background tasks by \p PostBackground, and completions by
+/// \p PostCompletion, and report percentiles of completion latency.
+template <class BackgroundFn, class CompletionFn>
+void run(benchmark::State &State, BackgroundFn PostBackground,
+         CompletionFn PostCompletion) {
+  std::vector<double> Latencies;
+  for (auto _ : State) {
+    std::atomic<std::size_t> Queued = 0;
+    std::atomic<bool> Done = false;
+    std::thread Loader([&]() {
+      while (!Done) {
+        while (Queued < QueuedBackground) {
+          ++Queued;
+          PostBackground([&]() {
+            std::this_thread::sleep_for(BackgroundWait);
+            --Queued;
+          });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    });
+    // Let the background queue fill up.
+    std::this_thread::sleep_for(BackgroundWait);
+    for (int I = 0; I < Completions; ++I) {
+      std::promise<void> Finished;
+      Clock::time_point Posted = Clock::now();
+      PostCompletion([&]() {
+        spin(CompletionWork);
+        Finished.set_value();
+      });
+      Finished.get_future().wait();
+      Latencies.emplace_back(
+          std::chrono::duration<double, std::milli>(Clock::now() - Posted)
+              .count());
+    }
+    Done = true;
+    Loader.join();
+  }
+  std::sort(Latencies.begin(), Latencies.end());
+  auto Percentile = [&](double P) {
+    return Latencies[static_cast<std::size_t>(P * (Latencies.size() - 1))];
+  };
+  State.counters["p50_ms"] = Percentile(0.50);
+  State.counters["p99_ms"] = Percentile(0.99);
+}
+
+void BM_CompletionFIFO(benchmark::State &State) {
+  boost::asio::thread_pool Pool(Workers);
+  auto Post = [&](auto Task) { boost::asio::post(Pool, std::move(Task)); };
+  run(State, Post, Post);
+  Pool.join();
+}
+
+void BM_CompletionPriority(benchmark::State &State) {
+  Scheduler Sched(Workers);
+  run(
+      State,
+      [&](auto Task) {
+        Sched.post(Scheduler::Priority::Background, std::move(Task));
+      },
+      [&](auto Task) {
+        Sched.post(Scheduler::Priority::Interactive, std::move(Task));
+      });
+}
+
+BENCHMARK(BM_CompletionFIFO)->Iterations(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CompletionPriority)->Iterations(1)->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,126 @@
+/// \file
+/// \brief Benchmark sending large payloads through the OutboundPort.
+///
+/// "DOM" builds a llvm::json::Value by toJSON(), as the port did for every
+/// message, and "Stream" writes the struct into the output buffer directly.
+/// Both produce the same bytes.
+
+#include <benchmark/benchmark.h>
+
+#include "lspserver/Connection.h"
+#include "lspserver/JSONWriter.h"
+#include "lspserver/Logger.h"
+#include "lspserver/Protocol.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+namespace {
+
+std::atomic<std::size_t> Allocations;
+
+} // namespace
+
+void *operator new(std::size_t Size) {
+  Allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *Ptr = std::malloc(Size ? Size : 1))
+    return Ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *Ptr) noexcept { std::free(Ptr); }
+
+void operator delete(void *Ptr, std::size_t) noexcept { std::free(Ptr); }
+
+namespace {
+
+using namespace lspserver;
+
+PublishDiagnosticsParams makeDiagnostics(int Count) {
+  PublishDiagnosticsParams P;
+  P.uri = URIForFile::canonicalize("/default.nix", "/default.nix");
+  P.version = 42;
+  for (int I = 0; I < Count; ++I) {
+    Diagnostic D;
+    D.range = Range{{I, 2}, {I, 14}};
+    D.severity = 2;
+    D.code = "sema-unused-def-let";
+    D.source = "nixf";
+    D.message = "definition `pkg" + std::to_string(I) + "` is not used";
+    D.tags = {DiagnosticTag::Unnecessary};
+    P.diagnostics.emplace_back(std::move(D));
+  }
+  return P;
+}
+
+SemanticTokens makeTokens(int Count) {
+  SemanticTokens T;
+  T.resultId = "1";
+  for (int I = 0; I < Count; ++I) {
+    T.tokens.emplace_back(SemanticToken{static_cast<unsigned>(I % 3),
+                                        static_cast<unsigned>(I % 17), 4,
+                                        static_cast<unsigned>(I % 11), 0});
+  }
+  return T;
+}
+
+/// Messages are logged, but not formatted, as with verbose logging off.
+class NullLogger : public Logger {
+  void log(Level, const char *, const llvm::formatv_object_base &) override {}
+};
+
+void report(benchmark::State &State, std::size_t Allocs) {
+  State.counters["allocs"] = benchmark::Counter(
+      static_cast<double>(Allocs), benchmark::Counter::kAvgIterations);
+}
+
+template <class T>
+void runDOM(benchmark::State &State, const T &Params) {
+  NullLogger Log;
+  LoggingSession Session(Log);
+  llvm::raw_null_ostream Null;
+  OutboundPort Out(Null);
+  std::size_t Before = Allocations.load();
+  for (auto _ : State)
+    Out.notify("bench", toJSON(Params));
+  report(State, Allocations.load() - Before);
+}
+
+template <class T>
+void runStream(benchmark::State &State, const T &Params) {
+  NullLogger Log;
+  LoggingSession Session(Log);
+  llvm::raw_null_ostream Null;
+  OutboundPort Out(Null);
+  std::size_t Before = Allocations.load();
+  for (auto _ : State)
+    Out.notify("bench", [&](llvm::json::OStream &J) { writeJSON(J, Params); });
+  report(State, Allocations.load() - Before);
+}
+
+void BM_DiagnosticsDOM(benchmark::State &State) {
+  runDOM(State, makeDiagnostics(static_cast<int>(State.range(0))));
+}
+
+void BM_DiagnosticsStream(benchmark::State &State) {
+  runStream(State, makeDiagnostics(static_cast<int>(State.range(0))));
+}
+
+void BM_SemanticTokensDOM(benchmark::State &State) {
+  runDOM(State, makeTokens(static_cast<int>(State.range(0))));
+}
+
+void BM_SemanticTokensStream(benchmark::State &State) {
+  runStream(State, makeTokens(static_cast<int>(State.range(0))));
+}
+
+BENCHMARK(BM_DiagnosticsDOM)->Arg(5000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_DiagnosticsStream)->Arg(5000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SemanticTokensDOM)->Arg(50000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SemanticTokensStream)->Arg(50000)->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
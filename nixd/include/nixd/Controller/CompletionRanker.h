@@ -0,0 +1,65 @@
+/// \file
+/// \brief Rank completion candidates, keeping the best ones only.
+
+#pragma once
+
+#include "lspserver/Protocol.h"
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace nixd {
+
+/// \brief Collects completion items, scored in a single pass.
+///
+/// Each candidate is scored by fuzzily matching its name against the pattern,
+/// plus a provider-specific bonus (e.g. scope proximity). Only the best
+/// \p Limit items are kept, in a bounded heap, so that large candidate sets
+/// cost O(N log Limit) and never abort the whole request.
+class CompletionRanker {
+  struct Scored {
+    int Score;
+    std::size_t Seq;
+    lspserver::CompletionItem Item;
+  };
+
+  std::size_t Limit;
+  std::size_t Seq = 0;
+  bool Dropped = false;
+
+  /// Heap of kept items. The worst one is on the top.
+  std::vector<Scored> Heap;
+
+  /// Better items are "less" than others. Ties are broken by insertion order.
+  static bool better(const Scored &L, const Scored &R) {
+    if (L.Score != R.Score)
+      return L.Score > R.Score;
+    return L.Seq < R.Seq;
+  }
+
+public:
+  explicit CompletionRanker(std::size_t Limit) : Limit(Limit) {}
+
+  /// \brief Add \p Item if its name fuzzily matches \p Pattern.
+  ///
+  /// The name is "filterText" if it is set, otherwise "label". It should
+  /// start with the first character of \p Pattern, ignoring case.
+  ///
+  /// \returns false if the item does not match.
+  bool add(std::string_view Pattern, lspserver::CompletionItem Item,
+           int Bonus = 0);
+
+  /// \brief Whether or not some matched items were dropped.
+  ///
+  /// The list should be marked "incomplete" then, and recomputed.
+  [[nodiscard]] bool dropped() const { return Dropped; }
+
+  /// \brief Kept items, the best first.
+  ///
+  /// "sortText" is set to the rank, and "filterText" to the name, so clients
+  /// preserve the server-side order.
+  std::vector<lspserver::CompletionItem> take();
+};
+
+} // namespace nixd
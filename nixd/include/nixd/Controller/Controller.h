@@ -8,23 +8,24 @@
 #include "lspserver/LSPServer.h"
 #include "lspserver/Protocol.h"
 #include "nixd/Eval/AttrSetClient.h"
+#include "nixd/Support/Scheduler.h"
 #include "nixf/Basic/Diagnostic.h"
 
-#include <boost/asio/thread_pool.hpp>
-
+#include <condition_variable>
+#include <cstdint>
 #include <set>
 
 namespace nixd {
 
 class Controller : public lspserver::LSPServer {
 public:
-  using OptionMapTy = std::map<std::string, std::unique_ptr<AttrSetClientProc>>;
+  using OptionMapTy = std::map<std::string, std::unique_ptr<AttrSetClientPool>>;
 
 private:
   std::unique_ptr<OwnedEvalClient> Eval;
 
-  // Use this worker for evaluating nixpkgs.
-  std::unique_ptr<AttrSetClientProc> NixpkgsEval;
+  // Use these workers for evaluating nixpkgs.
+  std::unique_ptr<AttrSetClientPool> NixpkgsEval;
 
   std::mutex OptionsLock;
   // Map of option providers.
@@ -33,14 +34,17 @@ private:
   //      "home-manager" -> home-manager worker
   OptionMapTy Options; // GUARDED_BY(OptionsLock)
 
-  AttrSetClientProc &nixpkgsEval() {
+  AttrSetClientPool &nixpkgsEval() {
     assert(NixpkgsEval);
     return *NixpkgsEval;
   }
 
-  AttrSetClient *nixpkgsClient() { return nixpkgsEval().client(); }
+  std::shared_ptr<AttrSetClient> nixpkgsClient() {
+    return nixpkgsEval().client();
+  }
 
-  void evalExprWithProgress(AttrSetClient &Client, const EvalExprParams &Params,
+  void evalExprWithProgress(AttrSetClientPool &Workers,
+                            const EvalExprParams &Params,
                             std::string_view Description);
 
   lspserver::DraftStore Store;
@@ -113,18 +117,58 @@ private:
       EndWorkDoneProgress(Params);
   }
 
-  mutable std::mutex TUsLock;
-  llvm::StringMap<std::shared_ptr<NixTU>> TUs;
+  std::mutex TUsLock;
+  llvm::StringMap<std::shared_ptr<NixTU>> TUs; // GUARDED_BY(TUsLock)
 
-  std::shared_ptr<const NixTU> getTU(std::string_view File) const {
-    using lspserver::error;
-    std::lock_guard G(TUsLock);
-    if (!TUs.count(File)) [[unlikely]] {
-      lspserver::elog("cannot get translation unit: {0}", File);
-      return nullptr;
-    }
-    return TUs.lookup(File);
-  }
+  /// \brief Scheduling state of analyzing a document.
+  ///
+  /// Each version of the document gets a new "generation". Only the latest
+  /// generation is worth analyzing, older ones are dropped.
+  struct AnalysisState {
+    /// Generation of the latest document version.
+    std::uint64_t Latest = 0;
+
+    /// The latest generation someone started to analyze.
+    std::uint64_t Started = 0;
+
+    /// Generation of the unit stored in "TUs".
+    std::uint64_t Finished = 0;
+
+    /// Contents of the latest document version, flattened only if it is
+    /// analyzed.
+    lspserver::Rope Src;
+
+    /// LSP version of the latest document version.
+    std::optional<int64_t> Version;
+  };
+
+  /// Generation counter, shared by all documents so that re-opened documents
+  /// never reuse a generation.
+  std::uint64_t LastGeneration = 0; // GUARDED_BY(TUsLock)
+
+  llvm::StringMap<AnalysisState> Analyses; // GUARDED_BY(TUsLock)
+
+  /// Notified while "TUs" or "Analyses" changed.
+  std::condition_variable TUsChanged;
+
+  /// Serializes publishing diagnostics, which waits while the client reads
+  /// slowly. Taken before "TUsLock", and never while holding it.
+  std::mutex PublishLock;
+
+  /// \brief Analyze the document, if \p Generation is still the latest one.
+  void analyzeDocument(const std::string &File, std::uint64_t Generation);
+
+  /// \brief Parse & analyze \p Src, then publish the result if nothing newer
+  /// was scheduled in the meantime.
+  void runAnalysis(const std::string &File, std::uint64_t Generation,
+                   std::shared_ptr<const std::string> Src,
+                   std::optional<int64_t> Version);
+
+  /// \brief Get the translation unit of the latest document version.
+  ///
+  /// If the latest version is not analyzed yet, wait for it (or analyze it in
+  /// the calling thread), so that requests never observe outdated units.
+  std::shared_ptr<const NixTU> getTU(std::string_view File);
 
   static std::shared_ptr<nixf::Node> getAST(const NixTU &TU) {
     using lspserver::error;
@@ -135,21 +179,32 @@ private:
     return TU.ast();
   }
 
-  std::shared_ptr<const nixf::Node> getAST(std::string_view File) const {
+  std::shared_ptr<const nixf::Node> getAST(std::string_view File) {
     auto TU = getTU(File);
     return TU ? getAST(*TU) : nullptr;
   }
 
-#if BOOST_VERSION < 108800
-  // Default constructor is broken in Boost 1.87, fixed in 1.88:
-  // https://github.com/boostorg/asio/commit/30b5974ed34bfa321d268b3135ffaffcb261461a
-  boost::asio::thread_pool Pool{
-      static_cast<size_t>(boost::asio::detail::default_thread_pool_size())};
-#else
-  boost::asio::thread_pool Pool{};
-#endif
+  /// Runs request handlers, and analysis of documents.
+  Scheduler Sched;
+
+  using Priority = Scheduler::Priority;
 
-  /// Action right after a document is added (including updates).
+  /// \brief Run \p Action in a worker, before actions of lower priority.
+  void schedule(Priority P, Scheduler::Task Action) {
+    Sched.post(P, std::move(Action));
+  }
+
+  /// \brief Run \p Action in a worker, superseding the last action scheduled
+  /// with the same \p Key. For requests whose results are only shown for the
+  /// newest one, e.g. hover.
+  void schedule(Priority P, llvm::StringRef Key,
+                lspserver::CancellationToken Token, Scheduler::Task Action) {
+    Sched.post(P, Key, std::move(Token), std::move(Action));
+  }
+
+  /// \brief Action right after a document is added (including updates).
+  ///
+  /// The document is analyzed asynchronously in "Sched".
   void actOnDocumentAdd(lspserver::PathRef File,
                         std::optional<int64_t> Version);
 
@@ -165,10 +220,10 @@ private:
   void onShutdown(const lspserver::NoParams &,
                   lspserver::Callback<std::nullptr_t> Reply);
 
-  void onDocumentDidOpen(const lspserver::DidOpenTextDocumentParams &Params);
+  /// The text of the document is moved into the draft.
+  void onDocumentDidOpen(lspserver::DidOpenTextDocumentParams &&Params);
 
-  void
-  onDocumentDidChange(const lspserver::DidChangeTextDocumentParams &Params);
+  void onDocumentDidChange(lspserver::DidChangeTextDocumentParams &&Params);
 
   void onDocumentDidClose(const lspserver::DidCloseTextDocumentParams &Params);
 
@@ -231,7 +286,8 @@ private:
   /// Determine whether or not this diagnostic is suppressed.
   bool isSuppressed(nixf::Diagnostic::DiagnosticKind Kind);
   void publishDiagnostics(lspserver::PathRef File,
-                          std::optional<int64_t> Version, std::string_view Src,
+                          std::optional<int64_t> Version,
+                          const lspserver::LineTable &Lines,
                           const std::vector<nixf::Diagnostic> &Diagnostics);
 
   void onRename(const lspserver::RenameParams &Params,
@@ -254,7 +310,7 @@ public:
   Controller(std::unique_ptr<lspserver::InboundPort> In,
              std::unique_ptr<lspserver::OutboundPort> Out);
 
-  ~Controller() override { Pool.join(); }
+  ~Controller() override { Sched.join(); }
 
   bool isReadyToEval() { return Eval && Eval->ready(); }
 };
@@ -5,9 +5,13 @@
 #include "nixf/Basic/Diagnostic.h"
 #include "nixf/Basic/Nodes/Basic.h"
 #include "nixf/Sema/ParentMap.h"
+#include "nixf/Sema/PositionLookup.h"
 #include "nixf/Sema/VariableLookup.h"
 
+#include "lspserver/SourceCode.h"
+
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <vector>
 
@@ -18,15 +22,23 @@ namespace nixd {
 /// TU stands for "Translation Unit".
 class NixTU {
   std::vector<nixf::Diagnostic> Diagnostics;
+  std::vector<nixf::Diagnostic> ParseDiagnostics;
   std::shared_ptr<nixf::Node> AST;
   std::optional<util::OwnedRegion> ASTByteCode;
   std::unique_ptr<nixf::VariableLookupAnalysis> VLA;
   std::unique_ptr<nixf::ParentMapAnalysis> PMA;
   std::shared_ptr<const std::string> Src;
 
+  mutable std::once_flag LinesOnce;
+  mutable std::unique_ptr<lspserver::LineTable> Lines;
+
+  mutable std::once_flag LookupOnce;
+  mutable std::unique_ptr<nixf::PositionLookupAnalysis> Lookup;
+
 public:
   NixTU() = default;
   NixTU(std::vector<nixf::Diagnostic> Diagnostics,
+        std::vector<nixf::Diagnostic> ParseDiagnostics,
         std::shared_ptr<nixf::Node> AST,
         std::optional<util::OwnedRegion> ASTByteCode,
         std::unique_ptr<nixf::VariableLookupAnalysis> VLA,
@@ -36,6 +48,11 @@ public:
     return Diagnostics;
   }
 
+  /// \brief Diagnostics reported by the parser, used for incremental parsing.
+  [[nodiscard]] const std::vector<nixf::Diagnostic> &parseDiagnostics() const {
+    return ParseDiagnostics;
+  }
+
   [[nodiscard]] const std::shared_ptr<nixf::Node> &ast() const { return AST; }
 
   [[nodiscard]] const nixf::ParentMapAnalysis *parentMap() const {
@@ -47,6 +64,16 @@ public:
   }
 
   [[nodiscard]] std::string_view src() const { return *Src; }
+
+  /// \brief Line offsets of the source, built on first use.
+  ///
+  /// Use it for converting offsets and positions of this document.
+  [[nodiscard]] const lspserver::LineTable &lines() const;
+
+  /// \brief Node under the given range, same as `ast()->descend(Range)`.
+  ///
+  /// Looked up in an index of the AST, built on first use.
+  [[nodiscard]] const nixf::Node *descend(nixf::PositionRange Range) const;
 };
 
 } // namespace nixd
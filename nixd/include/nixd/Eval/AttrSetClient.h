@@ -5,7 +5,12 @@
 
 #include <lspserver/LSPServer.h>
 
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <optional>
 #include <thread>
+#include <vector>
 
 namespace nixd {
 
@@ -19,6 +24,11 @@ class AttrSetClient : public lspserver::LSPServer {
                              lspserver::Callback<AttrPathInfoResponse> Reply)>
       AttrPathInfo;
 
+  llvm::unique_function<void(
+      const AttrPathInfoBatchParams &Params,
+      lspserver::Callback<AttrPathInfoBatchResponse> Reply)>
+      AttrPathInfoBatch;
+
   llvm::unique_function<void(
       const AttrPathCompleteParams &Params,
       lspserver::Callback<AttrPathCompleteResponse> Reply)>
@@ -50,6 +60,11 @@ public:
     AttrPathInfo(Params, std::move(Reply));
   }
 
+  void attrpathInfoBatch(const AttrPathInfoBatchParams &Params,
+                         lspserver::Callback<AttrPathInfoBatchResponse> Reply) {
+    AttrPathInfoBatch(Params, std::move(Reply));
+  }
+
   void attrpathComplete(const AttrPathCompleteParams &Params,
                         lspserver::Callback<AttrPathCompleteResponse> Reply) {
     AttrPathComplete(Params, std::move(Reply));
@@ -75,20 +90,104 @@ public:
 class AttrSetClientProc {
   StreamProc Proc;
   AttrSetClient Client;
+
+  /// The worker closed its output, i.e. it exited or crashed.
+  std::atomic<bool> Exited = false;
+
   std::thread Input;
 
 public:
   /// \brief Check if the process is still alive
   /// \returns nullptr if it has been dead.
   AttrSetClient *client();
-  ~AttrSetClientProc() {
-    Client.exit();
-    Client.closeInbound();
-    Input.join();
-  }
+  ~AttrSetClientProc();
 
   /// \see StreamProc::StreamProc
   AttrSetClientProc(const std::function<int()> &Action);
+
+  [[nodiscard]] pid_t pid() const { return Proc.proc().PID; }
+
+  /// \brief Reap the dead process, and fail calls waiting for its replies.
+  void bury();
+};
+
+/// \brief A few worker processes, evaluating the same attrset.
+///
+/// Each nixd-attrset-eval process serves requests one at a time, so a slow
+/// query (e.g. a deep submodule) blocks everything queued after it. Requests
+/// are routed to the least loaded worker instead, and the base expression is
+/// evaluated by all of them.
+///
+/// Workers are supervised. Dead ones (e.g. killed on memory pressure) are
+/// restarted with exponential backoff, and the last evaluated expression is
+/// replayed. If all of them are dead, one is restarted at once rather than
+/// after its backoff. Requests routed to a worker still warming up are queued
+/// by the worker, behind the replayed evaluation.
+class AttrSetClientPool {
+  using Clock = std::chrono::steady_clock;
+
+  struct Worker {
+    std::shared_ptr<AttrSetClientProc> Proc;
+
+    Clock::time_point StartedAt;
+
+    /// Do not restart before this.
+    Clock::time_point RetryAt;
+
+    std::chrono::milliseconds Backoff{0};
+
+    /// Set once the replayed expression is evaluated.
+    std::shared_ptr<std::atomic<bool>> Warm;
+  };
+
+  std::function<int()> Action;
+
+  std::mutex Lock;
+
+  std::vector<Worker> Workers; // GUARDED_BY(Lock)
+
+  /// The last expression evaluated, replayed on restarted workers.
+  std::optional<EvalExprParams> LastExpr; // GUARDED_BY(Lock)
+
+  /// Rotates among equally loaded workers.
+  std::size_t Next = 0; // GUARDED_BY(Lock)
+
+  /// \brief Launch the worker, and replay the last expression on it.
+  void launch(Worker &W); // REQUIRES(Lock)
+
+  /// \brief Retire dead workers, and restart them once backoff expired.
+  /// \returns Processes just found dead. They are destroyed once the caller,
+  /// and everyone still holding their clients, drop them.
+  std::vector<std::shared_ptr<AttrSetClientProc>> supervise(); // REQUIRES(Lock)
+
+  std::vector<std::optional<std::size_t>> queueDepthsLocked(); // REQUIRES(Lock)
+
+public:
+  /// \brief Launch \p Size workers, each running \p Action.
+  /// \see StreamProc::StreamProc
+  AttrSetClientPool(std::size_t Size, std::function<int()> Action);
+
+  /// \brief Pick the alive worker with the fewest pending requests,
+  /// preferring warm ones.
+  ///
+  /// The client keeps its process alive, even if it dies and is replaced
+  /// meanwhile. Do not keep it in reply callbacks, which run on the input
+  /// thread of the process.
+  /// \returns nullptr if no worker could be started.
+  std::shared_ptr<AttrSetClient> client();
+
+  /// \brief Evaluate the expression on every alive worker.
+  ///
+  /// \p Reply is invoked once all of them finished, with the first error if
+  /// any. The expression is remembered, and replayed on restarted workers.
+  void evalExpr(const EvalExprParams &Params,
+                lspserver::Callback<EvalExprResponse> Reply);
+
+  /// \brief Number of pending requests of each worker, i.e. queue depth.
+  /// Dead workers are reported as std::nullopt.
+  std::vector<std::optional<std::size_t>> queueDepths();
+
+  [[nodiscard]] std::size_t size() const { return Workers.size(); }
 };
 
 } // namespace nixd
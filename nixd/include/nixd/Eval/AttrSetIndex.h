@@ -0,0 +1,100 @@
+/// \file
+/// \brief Persistent, memory-mapped index of evaluated attribute sets.
+///
+/// Evaluating package details in nixpkgs is slow, but the result only depends
+/// on nixpkgs source code, which lives in the (immutable) nix store. The index
+/// records attribute names and package descriptions of some scopes, and is
+/// stored in a file keyed by these store paths. Thus it is built only once,
+/// and shared by all workers on the machine.
+
+#pragma once
+
+#include "nixd/Protocol/AttrSet.h"
+#include "nixd/Support/AutoCloseFD.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nixd {
+
+/// \brief Collects attributes, and writes them into an index file.
+class AttrSetIndexBuilder {
+  struct Entry {
+    std::string Key;
+    bool IsScope;
+    std::optional<AttrPathInfoResponse> Info;
+  };
+
+  std::vector<Entry> Entries;
+
+public:
+  /// \brief Mark \p Scope as indexed. All of its attributes should be added.
+  void addScope(const Selector &Scope);
+
+  /// \brief Add attribute \p Name in \p Scope.
+  ///
+  /// \p Info is available for packages only. Others will be evaluated on
+  /// demand while serving requests.
+  void addAttr(const Selector &Scope, std::string_view Name,
+               std::optional<AttrPathInfoResponse> Info);
+
+  /// \brief Write the index into \p Path, atomically.
+  ///
+  /// \returns false if something goes wrong.
+  bool write(const std::string &Path);
+
+  /// \brief Wait for the lock of building the index at \p Path.
+  ///
+  /// Each eval worker, of each nixd instance, may find the index missing and
+  /// start a builder. Builders take the lock first, and those coming late
+  /// find the index written already. It is released once the builder exits,
+  /// even if it crashed.
+  ///
+  /// \returns std::nullopt if the lock file cannot be opened.
+  static std::optional<util::AutoCloseFD> lock(const std::string &Path);
+};
+
+/// \brief Read-only view of an index file.
+class AttrSetIndex {
+  boost::interprocess::file_mapping File;
+  boost::interprocess::mapped_region Region;
+
+  AttrSetIndex(boost::interprocess::file_mapping File,
+               boost::interprocess::mapped_region Region)
+      : File(std::move(File)), Region(std::move(Region)) {}
+
+  [[nodiscard]] const char *data() const {
+    return static_cast<const char *>(Region.get_address());
+  }
+
+  /// \brief Index of the first record not less than \p Key.
+  [[nodiscard]] std::size_t lowerBound(std::string_view Key) const;
+
+  [[nodiscard]] std::size_t size() const;
+
+  [[nodiscard]] std::string_view key(std::size_t I) const;
+
+public:
+  /// \brief Map the index file at \p Path.
+  ///
+  /// \returns nullptr if the file does not exist, or it is not valid.
+  static std::unique_ptr<AttrSetIndex> open(const std::string &Path);
+
+  /// \brief Whether or not all attributes in \p Scope are indexed.
+  [[nodiscard]] bool hasScope(const Selector &Scope) const;
+
+  /// \brief All attribute names in \p Scope, sorted.
+  [[nodiscard]] std::vector<std::string> names(const Selector &Scope) const;
+
+  /// \brief Indexed information of \p AttrPath, if it is a known package.
+  [[nodiscard]] std::optional<AttrPathInfoResponse>
+  info(const Selector &AttrPath) const;
+};
+
+} // namespace nixd
@@ -17,12 +17,18 @@
 
 #pragma once
 
+#include "nixd/Eval/AttrSetIndex.h"
+#include "nixd/Eval/NameIndex.h"
 #include "nixd/Protocol/AttrSet.h"
 
 #include "lspserver/LSPServer.h"
 
+#include <llvm/ADT/STLFunctionalExtras.h>
+#include <llvm/Support/Program.h>
+
 #include <nix/expr/eval.hh>
 
+#include <map>
 #include <memory>
 
 namespace nixd {
@@ -40,10 +46,56 @@ class AttrSetProvider : public lspserver::LSPServer {
     return *State;
   }
 
+  /// \brief The expression evaluated as "Nixpkgs".
+  std::string Expr;
+
+  /// \brief Persistent index of "Nixpkgs", if available.
+  std::unique_ptr<AttrSetIndex> Index;
+
+  /// \brief Whether or not the index for "Expr" is looked up.
+  ///
+  /// This is deferred until the first query, so that workers answering other
+  /// kinds of requests (e.g. options) never build the index.
+  bool IndexPrepared = false;
+
+  /// \brief Path of the index file, empty if "Nixpkgs" cannot be indexed.
+  std::string IndexPath;
+
+  /// \brief Background process building the index file.
+  std::optional<llvm::sys::ProcessInfo> IndexBuilder;
+
+  /// \brief Load the index for "Expr", or start building it in background.
+  void prepareIndex();
+
+  /// \brief Get the index, loading it if the builder has finished.
+  AttrSetIndex *index();
+
+  /// \brief Sorted names of attribute sets, built on first completion.
+  ///
+  /// Keyed by the kind and the path of the scope, whose names never change
+  /// once evaluated. Addresses of attributes are not stable: option scopes are
+  /// built again for each query, and garbage collected.
+  std::map<std::string, NameIndex> NameIndices;
+
+  /// \brief Get the name index cached as \p Key, listing the names by
+  /// \p Names on first use.
+  const NameIndex &
+  nameIndex(const std::string &Key,
+            llvm::function_ref<std::vector<std::string>()> Names);
+
+  /// \brief Describe the value selected by \p AttrPath.
+  llvm::Expected<AttrPathInfoResponse> attrpathInfo(const Selector &AttrPath);
+
 public:
   AttrSetProvider(std::unique_ptr<lspserver::InboundPort> In,
                   std::unique_ptr<lspserver::OutboundPort> Out);
 
+  /// \brief Evaluate \p Expr, and write its index into \p Path.
+  ///
+  /// This is the entry of index builder processes.
+  /// \returns the exit code.
+  static int buildIndex(const std::string &Expr, const std::string &Path);
+
   /// \brief Eval an expression, use it for furthur requests.
   void onEvalExpr(const EvalExprParams &Name,
                   lspserver::Callback<EvalExprResponse> Reply);
@@ -52,6 +104,11 @@ public:
   void onAttrPathInfo(const AttrPathInfoParams &AttrPath,
                       lspserver::Callback<AttrPathInfoResponse> Reply);
 
+  /// \brief Query information of many attrpaths at once.
+  void
+  onAttrPathInfoBatch(const AttrPathInfoBatchParams &AttrPaths,
+                      lspserver::Callback<AttrPathInfoBatchResponse> Reply);
+
   /// \brief Complete attrpath entries.
   void onAttrPathComplete(const AttrPathCompleteParams &Params,
                           lspserver::Callback<AttrPathCompleteResponse> Reply);
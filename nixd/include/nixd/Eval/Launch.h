@@ -5,11 +5,11 @@
 namespace nixd {
 
 void startAttrSetEval(const std::string &Name,
-                      std::unique_ptr<AttrSetClientProc> &Worker);
+                      std::unique_ptr<AttrSetClientPool> &Worker);
 
-void startNixpkgs(std::unique_ptr<AttrSetClientProc> &NixpkgsEval);
+void startNixpkgs(std::unique_ptr<AttrSetClientPool> &NixpkgsEval);
 
 void startOption(const std::string &Name,
-                 std::unique_ptr<AttrSetClientProc> &Worker);
+                 std::unique_ptr<AttrSetClientPool> &Worker);
 
 } // namespace nixd
@@ -0,0 +1,45 @@
+/// \file
+/// \brief Sorted index of attribute names, for completion.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nixd {
+
+/// \brief Attribute names of a scope, sorted for prefix searching.
+///
+/// Building the index sorts names once, so that each query is a binary search
+/// (prefix) or a single pass (fuzzy), rather than sorting all names again.
+class NameIndex {
+  std::vector<std::string> Names;
+
+public:
+  explicit NameIndex(std::vector<std::string> Names);
+
+  [[nodiscard]] std::size_t size() const { return Names.size(); }
+
+  /// \brief Names starting with \p Prefix, in lexicographic order.
+  ///
+  /// At most \p Limit names are returned.
+  [[nodiscard]] std::vector<std::string_view>
+  prefix(std::string_view Prefix, std::size_t Limit) const;
+
+  /// \brief Names fuzzily matching \p Pattern, the best match first.
+  ///
+  /// \see fuzzyMatch
+  [[nodiscard]] std::vector<std::string_view>
+  fuzzy(std::string_view Pattern, std::size_t Limit) const;
+
+  /// \brief Names for completing \p Pattern.
+  ///
+  /// Prefix matches come first, in lexicographic order, followed by other
+  /// fuzzy matches ranked by their scores.
+  [[nodiscard]] std::vector<std::string_view>
+  complete(std::string_view Pattern, std::size_t Limit) const;
+};
+
+} // namespace nixd
@@ -29,6 +29,8 @@ namespace rpcMethod {
 
 constexpr inline std::string_view EvalExpr = "attrset/evalExpr";
 constexpr inline std::string_view AttrPathInfo = "attrset/attrpathInfo";
+constexpr inline std::string_view AttrPathInfoBatch =
+    "attrset/attrpathInfoBatch";
 constexpr inline std::string_view AttrPathComplete = "attrset/attrpathComplete";
 constexpr inline std::string_view OptionInfo = "attrset/optionInfo";
 constexpr inline std::string_view OptionComplete = "attrset/optionComplete";
@@ -104,6 +106,15 @@ llvm::json::Value toJSON(const AttrPathInfoResponse &Params);
 bool fromJSON(const llvm::json::Value &Params, AttrPathInfoResponse &R,
               llvm::json::Path P);
 
+/// \brief Query many attrpaths in a single round-trip.
+using AttrPathInfoBatchParams = std::vector<Selector>;
+
+/// \brief Responses in the same order as requested selectors.
+///
+/// Selectors that cannot be evaluated get "null".
+using AttrPathInfoBatchResponse =
+    std::vector<std::optional<AttrPathInfoResponse>>;
+
 struct AttrPathCompleteParams {
   Selector Scope;
   /// \brief Search for packages prefixed with this "prefix"
@@ -0,0 +1,21 @@
+/// \file
+/// \brief Fuzzy (subsequence) matching of identifiers, for code completion.
+
+#pragma once
+
+#include <optional>
+#include <string_view>
+
+namespace nixd {
+
+/// \brief Score how well \p Pattern matches \p Word.
+///
+/// Characters of \p Pattern should appear in \p Word in order, ignoring case.
+/// Matches at the beginning of words (e.g. "ps" for "pythonPackages" or
+/// "python-support") and consecutive matches are preferred.
+///
+/// \returns std::nullopt if it does not match, otherwise the score. Greater
+/// score means better match.
+std::optional<int> fuzzyMatch(std::string_view Pattern, std::string_view Word);
+
+} // namespace nixd
@@ -0,0 +1,111 @@
+/// \file
+/// \brief Run tasks in worker threads, by priority.
+///
+/// Each worker has its own queues, one per priority. Tasks posted from a
+/// worker go to its queues, others are spread over all workers. A worker takes
+/// the most urgent task it finds, from its own queues first, then stealing from
+/// others'. Background tasks may occupy at most half of the workers, so that
+/// some are always left for requests the user waits for.
+
+#pragma once
+
+#include "lspserver/Cancellation.h"
+
+#include <llvm/ADT/FunctionExtras.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nixd {
+
+class Scheduler {
+public:
+  enum class Priority {
+    /// The user is waiting for it, e.g. completion, hover.
+    Interactive,
+    /// Results shown soon, e.g. diagnostics, semantic tokens.
+    Normal,
+    /// Nice to have, e.g. inlay hints, configuration updates.
+    Background,
+  };
+
+  static constexpr std::size_t NumPriorities = 3;
+
+  using Task = llvm::unique_function<void()>;
+
+  /// \brief Twice the hardware concurrency, as boost::asio::thread_pool does.
+  /// Tasks often wait for worker processes, rather than computing.
+  static std::size_t defaultWorkers();
+
+  explicit Scheduler(std::size_t Workers = defaultWorkers());
+
+  ~Scheduler() { join(); }
+
+  Scheduler(const Scheduler &) = delete;
+  Scheduler &operator=(const Scheduler &) = delete;
+
+  /// \brief Run \p T in a worker.
+  void post(Priority P, Task T);
+
+  /// \brief Run \p T in a worker, superseding the last task posted with the
+  /// same \p Key, i.e. cancelling its token.
+  ///
+  /// A superseded task is still run. It should check \p Token, and give up
+  /// early, e.g. reply with lspserver::cancelledError(Token).
+  void post(Priority P, llvm::StringRef Key, lspserver::CancellationToken Token,
+            Task T);
+
+  /// \brief Run remaining tasks, and stop the workers.
+  void join();
+
+  [[nodiscard]] std::size_t workers() const { return Workers.size(); }
+
+private:
+  struct Worker {
+    std::mutex Lock;
+    std::deque<Task> Queues[NumPriorities]; // GUARDED_BY(Lock)
+    std::thread Thread;
+  };
+
+  std::vector<std::unique_ptr<Worker>> Workers;
+
+  /// Tasks queued, by priority.
+  std::atomic<std::size_t> Pending[NumPriorities] = {};
+
+  /// Background tasks running, and the limit of them.
+  std::atomic<std::size_t> RunningBackground = 0;
+  std::size_t MaxBackground;
+
+  /// Worker to post the next task from outside of workers.
+  std::atomic<std::size_t> NextWorker = 0;
+
+  std::mutex SleepLock;
+  std::condition_variable Wakeup;
+  bool Stopping = false; // GUARDED_BY(SleepLock)
+
+  std::mutex LatestLock;
+  /// Token of the last task posted with each key, until it finishes.
+  /// GUARDED_BY(LatestLock)
+  llvm::StringMap<lspserver::CancellationToken> Latest;
+
+  /// Whether a worker may take a task now.
+  bool runnable() const;
+
+  /// Wake a worker, after the counters changed.
+  void wakeOne();
+
+  /// Take the most urgent task, for worker \p Self.
+  bool take(std::size_t Self, Task &T, Priority &P);
+
+  void run(std::size_t Self);
+};
+
+} // namespace nixd
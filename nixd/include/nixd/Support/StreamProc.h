@@ -2,7 +2,6 @@
 
 #include "nixd/Support/PipedProc.h"
 
-#include <llvm/Support/raw_ostream.h>
 #include <lspserver/Connection.h>
 
 namespace nixd {
@@ -10,7 +9,6 @@ namespace nixd {
 struct StreamProc {
 private:
   std::unique_ptr<util::PipedProc> Proc;
-  std::unique_ptr<llvm::raw_fd_ostream> Stream;
 
 public:
   /// \brief Launch a streamed process with \p Action.
@@ -19,11 +17,6 @@ public:
   /// value.
   StreamProc(const std::function<int()> &Action);
 
-  [[nodiscard]] llvm::raw_fd_ostream &stream() const {
-    assert(Stream);
-    return *Stream;
-  }
-
   [[nodiscard]] util::PipedProc &proc() const {
     assert(Proc);
     return *Proc;
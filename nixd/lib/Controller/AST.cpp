@@ -34,11 +34,11 @@ void getSelectAttrPath(const nixf::AttrName &N,
   const auto &APath = static_cast<const nixf::AttrPath &>(*Up);
   // Iterate on attr names
   Path.reserve(APath.names().size());
-  for (const auto &Name : APath.names()) {
+  for (const nixf::AttrName *Name : APath.names()) {
     if (!Name->isStatic())
       throw AttrPathHasDynamicError();
     Path.emplace_back(Name->staticName());
-    if (Name.get() == &N)
+    if (Name == &N)
       break;
   }
 }
@@ -70,13 +70,13 @@ void getValueAttrPath(const nixf::Node &N, const nixf::ParentMapAnalysis &PM,
   // Find out how "N" gets nested.
   const auto &UpAttrs = static_cast<const nixf::ExprAttrs &>(*Up);
   assert(UpAttrs.binds() && "empty binds cannot nest anything!");
-  for (const std::shared_ptr<nixf::Node> &Attr : UpAttrs.binds()->bindings()) {
+  for (const nixf::Node *Attr : UpAttrs.binds()->bindings()) {
     assert(Attr);
     if (Attr->kind() == Node::NK_Inherit) // Cannot deal with inherits
       continue;
     assert(Attr->kind() == Node::NK_Binding);
     const auto &Binding = static_cast<const nixf::Binding &>(*Attr);
-    if (Binding.value().get() == &N) {
+    if (Binding.value() == &N) {
       getSelectAttrPath(*Binding.path().names().back(), PM, Path);
       return;
     }
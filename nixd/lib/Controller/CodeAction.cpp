@@ -20,7 +20,6 @@
 
 #include "nixd/Controller/Controller.h"
 
-#include <boost/asio/post.hpp>
 #include <llvm/Support/JSON.h>
 
 namespace nixd {
@@ -36,6 +35,7 @@ void Controller::onCodeAction(const lspserver::CodeActionParams &Params,
   auto Action = [Reply = std::move(Reply), File, Range, this]() mutable {
     return Reply([&]() -> llvm::Expected<CheckTy> {
       const auto TU = CheckDefault(getTU(File));
+      const LineTable &Lines = TU->lines();
 
       const auto &Diagnostics = TU->diagnostics();
       auto Actions = std::vector<CodeAction>();
@@ -43,7 +43,7 @@ void Controller::onCodeAction(const lspserver::CodeActionParams &Params,
       std::string FileURI = URIForFile::canonicalize(File, File).uri();
 
       for (const nixf::Diagnostic &D : Diagnostics) {
-        auto DRange = toLSPRange(TU->src(), D.range());
+        auto DRange = toLSPRange(Lines, D.range());
         if (!Range.overlap(DRange))
           continue;
 
@@ -63,7 +63,7 @@ void Controller::onCodeAction(const lspserver::CodeActionParams &Params,
           Edits.reserve(F.edits().size());
           for (const nixf::TextEdit &TE : F.edits()) {
             Edits.emplace_back(TextEdit{
-                .range = toLSPRange(TU->src(), TE.oldRange()),
+                .range = toLSPRange(Lines, TE.oldRange()),
                 .newText = std::string(TE.newText()),
             });
           }
@@ -83,44 +83,42 @@ void Controller::onCodeAction(const lspserver::CodeActionParams &Params,
       // Add refactoring code actions based on cursor position
       if (TU->ast() && TU->parentMap()) {
         nixf::PositionRange NixfRange = toNixfRange(Range);
-        if (const nixf::Node *N = TU->ast()->descend(NixfRange)) {
-          addAttrNameActions(*N, *TU->parentMap(), FileURI, TU->src(), Actions);
-          addConvertToInheritAction(*N, *TU->parentMap(), FileURI, TU->src(),
+        if (const nixf::Node *N = TU->descend(NixfRange)) {
+          addAttrNameActions(*N, *TU->parentMap(), FileURI, Lines, Actions);
+          addConvertToInheritAction(*N, *TU->parentMap(), FileURI, Lines,
                                     Actions);
-          addFlattenAttrsAction(*N, *TU->parentMap(), FileURI, TU->src(),
-                                Actions);
-          addPackAttrsAction(*N, *TU->parentMap(), FileURI, TU->src(), Actions);
-          addInheritToBindingAction(*N, *TU->parentMap(), FileURI, TU->src(),
+          addFlattenAttrsAction(*N, *TU->parentMap(), FileURI, Lines, Actions);
+          addPackAttrsAction(*N, *TU->parentMap(), FileURI, Lines, Actions);
+          addInheritToBindingAction(*N, *TU->parentMap(), FileURI, Lines,
                                     Actions);
           addNoogleDocAction(*N, *TU->parentMap(), Actions);
-          addRewriteStringAction(*N, *TU->parentMap(), FileURI, TU->src(),
-                                 Actions);
+          addRewriteStringAction(*N, *TU->parentMap(), FileURI, Lines, Actions);
 
           // Extract to file requires variable lookup analysis
           if (TU->variableLookup()) {
             addExtractToFileAction(*N, *TU->parentMap(), *TU->variableLookup(),
-                                   FileURI, TU->src(), Actions);
+                                   FileURI, Lines, Actions);
           }
           // Add with-to-let action (requires VLA for variable tracking)
           if (TU->variableLookup()) {
             addWithToLetAction(*N, *TU->parentMap(), *TU->variableLookup(),
-                               FileURI, TU->src(), Actions);
+                               FileURI, Lines, Actions);
           }
           // Add undefined variable to formals action (requires VLA)
           if (TU->variableLookup()) {
             addToFormalsAction(*N, *TU->parentMap(), *TU->variableLookup(),
-                               FileURI, TU->src(), Actions);
+                               FileURI, Lines, Actions);
           }
         }
       }
 
       // Selection-based actions (work on arbitrary text, not AST nodes)
-      addJsonToNixAction(TU->src(), Range, FileURI, Actions);
+      addJsonToNixAction(Lines, Range, FileURI, Actions);
 
       return Actions;
     }());
   };
-  boost::asio::post(Pool, std::move(Action));
+  schedule(Priority::Normal, std::move(Action));
 }
 
 void Controller::onCodeActionResolve(const lspserver::CodeAction &Params,
@@ -152,7 +150,7 @@ void Controller::onCodeActionResolve(const lspserver::CodeAction &Params,
     // the work is done via showDocument)
     Reply(Params);
   };
-  boost::asio::post(Pool, std::move(Action));
+  schedule(Priority::Normal, std::move(Action));
 }
 
 } // namespace nixd
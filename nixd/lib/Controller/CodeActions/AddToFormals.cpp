@@ -19,7 +19,8 @@ namespace nixd {
 
 void addToFormalsAction(const nixf::Node &N, const nixf::ParentMapAnalysis &PM,
                         const nixf::VariableLookupAnalysis &VLA,
-                        const std::string &FileURI, llvm::StringRef Src,
+                        const std::string &FileURI,
+                        const lspserver::LineTable &Lines,
                         std::vector<lspserver::CodeAction> &Actions) {
   // Find ExprVar node (cursor might be on Identifier child)
   const nixf::Node *VarNode = PM.upTo(N, nixf::Node::NK_ExprVar);
@@ -70,19 +71,19 @@ void addToFormalsAction(const nixf::Node &N, const nixf::ParentMapAnalysis &PM,
     size_t InsertOffset = BraceOffset + 1;
     auto InsertCursor = nixf::LexerCursor::unsafeCreate(
         Formals.lCur().line(), Formals.lCur().column() + 1, InsertOffset);
-    auto InsertPos = toLSPPosition(Src, InsertCursor);
+    auto InsertPos = toLSPPosition(Lines, InsertCursor);
     InsertRange = lspserver::Range{InsertPos, InsertPos};
     NewText = " " + quoteNixAttrKey(VarName) + " ";
   } else {
     // Check if the last member is an ellipsis
-    const nixf::Formal *LastMember = Members.back().get();
+    const nixf::Formal *LastMember = Members.back();
     bool HasEllipsis = LastMember && LastMember->isEllipsis();
 
     if (HasEllipsis) {
       if (Members.size() == 1) {
         // Case 3: Ellipsis only `{ ... }:`
         // Insert `varName, ` before the ellipsis
-        auto InsertPos = toLSPPosition(Src, LastMember->lCur());
+        auto InsertPos = toLSPPosition(Lines, LastMember->lCur());
         InsertRange = lspserver::Range{InsertPos, InsertPos};
         NewText = quoteNixAttrKey(VarName) + ", ";
       } else {
@@ -92,7 +93,7 @@ void addToFormalsAction(const nixf::Node &N, const nixf::ParentMapAnalysis &PM,
         const nixf::Formal *LastNonEllipsis = nullptr;
         for (auto It = Members.rbegin(); It != Members.rend(); ++It) {
           if ((*It) && !(*It)->isEllipsis()) {
-            LastNonEllipsis = (*It).get();
+            LastNonEllipsis = *It;
             break;
           }
         }
@@ -100,14 +101,14 @@ void addToFormalsAction(const nixf::Node &N, const nixf::ParentMapAnalysis &PM,
         if (!LastNonEllipsis)
           return;
 
-        auto InsertPos = toLSPPosition(Src, LastNonEllipsis->rCur());
+        auto InsertPos = toLSPPosition(Lines, LastNonEllipsis->rCur());
         InsertRange = lspserver::Range{InsertPos, InsertPos};
         NewText = ", " + quoteNixAttrKey(VarName);
       }
     } else {
       // Case 2: Normal `{ a }:` without ellipsis
       // Insert `, varName` after the last formal
-      auto InsertPos = toLSPPosition(Src, LastMember->rCur());
+      auto InsertPos = toLSPPosition(Lines, LastMember->rCur());
       InsertRange = lspserver::Range{InsertPos, InsertPos};
       NewText = ", " + quoteNixAttrKey(VarName);
     }
@@ -11,7 +11,8 @@
 namespace nixd {
 
 void addAttrNameActions(const nixf::Node &N, const nixf::ParentMapAnalysis &PM,
-                        const std::string &FileURI, llvm::StringRef Src,
+                        const std::string &FileURI,
+                        const lspserver::LineTable &Lines,
                         std::vector<lspserver::CodeAction> &Actions) {
   // Find if we're inside an AttrName
   const nixf::Node *AttrNameNode = PM.upTo(N, nixf::Node::NK_AttrName);
@@ -25,7 +26,7 @@ void addAttrNameActions(const nixf::Node &N, const nixf::ParentMapAnalysis &PM,
     const std::string &Name = AN.id()->name();
     Actions.emplace_back(createSingleEditAction(
         "Quote attribute name", lspserver::CodeAction::REFACTOR_REWRITE_KIND,
-        FileURI, toLSPRange(Src, AN.range()), "\"" + Name + "\""));
+        FileURI, toLSPRange(Lines, AN.range()), "\"" + Name + "\""));
   } else if (AN.kind() == nixf::AttrName::ANK_String && AN.isStatic()) {
     // Offer to unquote if valid identifier: "foo" -> foo
     const std::string &Name = AN.staticName();
@@ -33,7 +34,7 @@ void addAttrNameActions(const nixf::Node &N, const nixf::ParentMapAnalysis &PM,
       Actions.emplace_back(
           createSingleEditAction("Unquote attribute name",
                                  lspserver::CodeAction::REFACTOR_REWRITE_KIND,
-                                 FileURI, toLSPRange(Src, AN.range()), Name));
+                                 FileURI, toLSPRange(Lines, AN.range()), Name));
     }
   }
 }
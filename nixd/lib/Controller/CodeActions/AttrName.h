@@ -7,11 +7,10 @@
 #pragma once
 
 #include <lspserver/Protocol.h>
+#include <lspserver/SourceCode.h>
 
 #include <nixf/Sema/ParentMap.h>
 
-#include <llvm/ADT/StringRef.h>
-
 #include <string>
 #include <vector>
 
@@ -23,7 +22,8 @@ namespace nixd {
 
 /// \brief Add refactoring code actions for attribute names (quote/unquote).
 void addAttrNameActions(const nixf::Node &N, const nixf::ParentMapAnalysis &PM,
-                        const std::string &FileURI, llvm::StringRef Src,
+                        const std::string &FileURI,
+                        const lspserver::LineTable &Lines,
                         std::vector<lspserver::CodeAction> &Actions);
 
 } // namespace nixd
@@ -14,8 +14,10 @@ namespace nixd {
 
 void addConvertToInheritAction(const nixf::Node &N,
                                const nixf::ParentMapAnalysis &PM,
-                               const std::string &FileURI, llvm::StringRef Src,
+                               const std::string &FileURI,
+                               const lspserver::LineTable &Lines,
                                std::vector<lspserver::CodeAction> &Actions) {
+  llvm::StringRef Src = Lines.code();
   // Find if we're inside a Binding node
   const nixf::Node *BindingNode = PM.upTo(N, nixf::Node::NK_Binding);
   if (!BindingNode)
@@ -48,7 +50,7 @@ void addConvertToInheritAction(const nixf::Node &N,
       std::string NewText = "inherit " + quoteNixAttrKey(AttrName) + ";";
       Actions.emplace_back(createSingleEditAction(
           "Convert to `inherit`", lspserver::CodeAction::REFACTOR_REWRITE_KIND,
-          FileURI, toLSPRange(Src, Bind.range()), std::move(NewText)));
+          FileURI, toLSPRange(Lines, Bind.range()), std::move(NewText)));
     }
     return;
   }
@@ -100,7 +102,7 @@ void addConvertToInheritAction(const nixf::Node &N,
     Actions.emplace_back(createSingleEditAction(
         "Convert to `inherit (" + SourceText + ")`",
         lspserver::CodeAction::REFACTOR_REWRITE_KIND, FileURI,
-        toLSPRange(Src, Bind.range()), std::move(NewText)));
+        toLSPRange(Lines, Bind.range()), std::move(NewText)));
   }
 }
 
@@ -8,11 +8,10 @@
 #pragma once
 
 #include <lspserver/Protocol.h>
+#include <lspserver/SourceCode.h>
 
 #include <nixf/Sema/ParentMap.h>
 
-#include <llvm/ADT/StringRef.h>
-
 #include <string>
 #include <vector>
 
@@ -36,7 +35,8 @@ namespace nixd {
 /// - The select expression has a default value
 void addConvertToInheritAction(const nixf::Node &N,
                                const nixf::ParentMapAnalysis &PM,
-                               const std::string &FileURI, llvm::StringRef Src,
+                               const std::string &FileURI,
+                               const lspserver::LineTable &Lines,
                                std::vector<lspserver::CodeAction> &Actions);
 
 } // namespace nixd
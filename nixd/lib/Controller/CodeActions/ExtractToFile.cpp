@@ -10,6 +10,7 @@
 #include <nixf/Basic/Nodes/Expr.h>
 #include <nixf/Basic/Nodes/Lambda.h>
 #include <nixf/Basic/Nodes/Simple.h>
+#include <nixf/Basic/RecursiveASTVisitor.h>
 
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Support/Path.h>
@@ -32,48 +33,13 @@ struct FreeVariableResult {
 /// A free variable is one that is used (ExprVar) but defined outside the
 /// expression being extracted. We traverse the subtree and collect variable
 /// names that resolve to definitions outside our scope.
-class FreeVariableCollector {
+class FreeVariableCollector
+    : public nixf::RecursiveASTVisitor<FreeVariableCollector> {
   const nixf::VariableLookupAnalysis &VLA;
   const nixf::Node &Root;
   std::set<std::string> FreeVars;
   bool HasWithVars = false;
 
-  void collect(const nixf::Node &N) {
-    // If this is a variable reference, check if it's free
-    if (N.kind() == nixf::Node::NK_ExprVar) {
-      const auto &Var = static_cast<const nixf::ExprVar &>(N);
-      auto Result = VLA.query(Var);
-
-      // Variable is free if:
-      // - It's defined (not undefined/error)
-      // - Its definition is outside our extraction root
-      // - It's not a builtin
-      if (Result.Kind ==
-              nixf::VariableLookupAnalysis::LookupResultKind::Defined &&
-          Result.Def && !Result.Def->isBuiltin()) {
-        const nixf::Node *DefSyntax = Result.Def->syntax();
-        if (DefSyntax && !isInsideNode(DefSyntax, Root)) {
-          // This variable is defined outside our subtree - it's free
-          FreeVars.insert(std::string(Var.id().name()));
-        }
-      }
-      // Variables from 'with' are implicitly free since they depend on scope
-      // Note: These may not work correctly after extraction since the 'with'
-      // context is lost. We track this to warn the user.
-      else if (Result.Kind ==
-               nixf::VariableLookupAnalysis::LookupResultKind::FromWith) {
-        FreeVars.insert(std::string(Var.id().name()));
-        HasWithVars = true;
-      }
-    }
-
-    // Recursively collect from children
-    for (const auto &Child : N.children()) {
-      if (Child)
-        collect(*Child);
-    }
-  }
-
   /// \brief Check if a node is inside (or equal to) the root node.
   static bool isInsideNode(const nixf::Node *N, const nixf::Node &Root) {
     if (!N)
@@ -90,10 +56,38 @@ public:
                         const nixf::Node &Root)
       : VLA(VLA), Root(Root) {}
 
+  /// \brief If this is a variable reference, check if it's free.
+  bool visit(const nixf::ExprVar &Var) {
+    auto Result = VLA.query(Var);
+
+    // Variable is free if:
+    // - It's defined (not undefined/error)
+    // - Its definition is outside our extraction root
+    // - It's not a builtin
+    if (Result.Kind ==
+            nixf::VariableLookupAnalysis::LookupResultKind::Defined &&
+        Result.Def && !Result.Def->isBuiltin()) {
+      const nixf::Node *DefSyntax = Result.Def->syntax();
+      if (DefSyntax && !isInsideNode(DefSyntax, Root)) {
+        // This variable is defined outside our subtree - it's free
+        FreeVars.insert(std::string(Var.id().name()));
+      }
+    }
+    // Variables from 'with' are implicitly free since they depend on scope
+    // Note: These may not work correctly after extraction since the 'with'
+    // context is lost. We track this to warn the user.
+    else if (Result.Kind ==
+             nixf::VariableLookupAnalysis::LookupResultKind::FromWith) {
+      FreeVars.insert(std::string(Var.id().name()));
+      HasWithVars = true;
+    }
+    return true;
+  }
+
   FreeVariableResult collect() {
     FreeVars.clear();
     HasWithVars = false;
-    collect(Root);
+    traverseIteratively(&Root);
     return {FreeVars, HasWithVars};
   }
 };
@@ -307,9 +301,9 @@ const nixf::Node *findExtractableExpr(const nixf::Node &N,
       const nixf::Node *GrandParent = PM.query(*Parent);
       if (GrandParent && GrandParent->kind() == nixf::Node::NK_Binding) {
         const auto &Binding = static_cast<const nixf::Binding &>(*GrandParent);
-        const auto &Value = Binding.value();
+        const nixf::Expr *Value = Binding.value();
         if (Value && isExtractable(*Value))
-          return Value.get();
+          return Value;
       }
     }
   }
@@ -322,8 +316,10 @@ const nixf::Node *findExtractableExpr(const nixf::Node &N,
 void addExtractToFileAction(const nixf::Node &N,
                             const nixf::ParentMapAnalysis &PM,
                             const nixf::VariableLookupAnalysis &VLA,
-                            const std::string &FileURI, llvm::StringRef Src,
+                            const std::string &FileURI,
+                            const lspserver::LineTable &Lines,
                             std::vector<lspserver::CodeAction> &Actions) {
+  llvm::StringRef Src = Lines.code();
   // Find an extractable expression at or above the cursor
   const nixf::Node *ExprNode = findExtractableExpr(N, PM);
   if (!ExprNode)
@@ -389,7 +385,7 @@ void addExtractToFileAction(const nixf::Node &N,
   SourceEdit.textDocument.uri =
       lspserver::URIForFile::canonicalize(SourceFilePath, SourceFilePath);
   SourceEdit.edits.push_back(lspserver::TextEdit{
-      .range = toLSPRange(Src, ExprNode->range()),
+      .range = toLSPRange(Lines, ExprNode->range()),
       .newText = ImportStmt,
   });
 
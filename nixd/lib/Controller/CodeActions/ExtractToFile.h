@@ -8,12 +8,11 @@
 #pragma once
 
 #include <lspserver/Protocol.h>
+#include <lspserver/SourceCode.h>
 
 #include <nixf/Sema/ParentMap.h>
 #include <nixf/Sema/VariableLookup.h>
 
-#include <llvm/ADT/StringRef.h>
-
 #include <string>
 #include <vector>
 
@@ -38,7 +37,8 @@ namespace nixd {
 void addExtractToFileAction(const nixf::Node &N,
                             const nixf::ParentMapAnalysis &PM,
                             const nixf::VariableLookupAnalysis &VLA,
-                            const std::string &FileURI, llvm::StringRef Src,
+                            const std::string &FileURI,
+                            const lspserver::LineTable &Lines,
                             std::vector<lspserver::CodeAction> &Actions);
 
 } // namespace nixd
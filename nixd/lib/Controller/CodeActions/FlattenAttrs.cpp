@@ -43,8 +43,10 @@ const nixf::Binds *getFlattenableBinds(const nixf::ExprAttrs &Attrs) {
 
 void addFlattenAttrsAction(const nixf::Node &N,
                            const nixf::ParentMapAnalysis &PM,
-                           const std::string &FileURI, llvm::StringRef Src,
+                           const std::string &FileURI,
+                           const lspserver::LineTable &Lines,
                            std::vector<lspserver::CodeAction> &Actions) {
+  llvm::StringRef Src = Lines.code();
   // Find if we're inside a Binding
   const nixf::Node *BindingNode = PM.upTo(N, nixf::Node::NK_Binding);
   if (!BindingNode)
@@ -104,7 +106,7 @@ void addFlattenAttrsAction(const nixf::Node &N,
   Actions.emplace_back(createSingleEditAction(
       "Flatten nested attribute set",
       lspserver::CodeAction::REFACTOR_REWRITE_KIND, FileURI,
-      toLSPRange(Src, Bind.range()), std::move(NewText)));
+      toLSPRange(Lines, Bind.range()), std::move(NewText)));
 }
 
 } // namespace nixd
@@ -14,8 +14,10 @@ namespace nixd {
 
 void addInheritToBindingAction(const nixf::Node &N,
                                const nixf::ParentMapAnalysis &PM,
-                               const std::string &FileURI, llvm::StringRef Src,
+                               const std::string &FileURI,
+                               const lspserver::LineTable &Lines,
                                std::vector<lspserver::CodeAction> &Actions) {
+  llvm::StringRef Src = Lines.code();
   // Find if we're inside an Inherit node
   const nixf::Node *InheritNode = PM.upTo(N, nixf::Node::NK_Inherit);
   if (!InheritNode)
@@ -60,7 +62,7 @@ void addInheritToBindingAction(const nixf::Node &N,
   Actions.emplace_back(createSingleEditAction(
       "Convert to explicit binding",
       lspserver::CodeAction::REFACTOR_REWRITE_KIND, FileURI,
-      toLSPRange(Src, Inherit.range()), NewText.str()));
+      toLSPRange(Lines, Inherit.range()), NewText.str()));
 }
 
 } // namespace nixd
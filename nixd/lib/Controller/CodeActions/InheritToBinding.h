@@ -8,11 +8,10 @@
 #pragma once
 
 #include <lspserver/Protocol.h>
+#include <lspserver/SourceCode.h>
 
 #include <nixf/Sema/ParentMap.h>
 
-#include <llvm/ADT/StringRef.h>
-
 #include <string>
 #include <vector>
 
@@ -31,7 +30,8 @@ namespace nixd {
 /// The action is only offered when the inherit has exactly one name.
 void addInheritToBindingAction(const nixf::Node &N,
                                const nixf::ParentMapAnalysis &PM,
-                               const std::string &FileURI, llvm::StringRef Src,
+                               const std::string &FileURI,
+                               const lspserver::LineTable &Lines,
                                std::vector<lspserver::CodeAction> &Actions);
 
 } // namespace nixd
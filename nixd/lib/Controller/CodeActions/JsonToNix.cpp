@@ -94,14 +94,14 @@ std::string jsonToNix(const llvm::json::Value &V, size_t Indent = 0,
 
 } // namespace
 
-void addJsonToNixAction(llvm::StringRef Src, const lspserver::Range &Range,
+void addJsonToNixAction(const lspserver::LineTable &Lines,
+                        const lspserver::Range &Range,
                         const std::string &FileURI,
                         std::vector<lspserver::CodeAction> &Actions) {
+  llvm::StringRef Src = Lines.code();
   // Convert LSP positions to byte offsets
-  llvm::Expected<size_t> StartOffset =
-      lspserver::positionToOffset(Src, Range.start);
-  llvm::Expected<size_t> EndOffset =
-      lspserver::positionToOffset(Src, Range.end);
+  llvm::Expected<size_t> StartOffset = Lines.positionToOffset(Range.start);
+  llvm::Expected<size_t> EndOffset = Lines.positionToOffset(Range.end);
 
   if (!StartOffset || !EndOffset) {
     if (!StartOffset)
@@ -7,8 +7,7 @@
 #pragma once
 
 #include <lspserver/Protocol.h>
-
-#include <llvm/ADT/StringRef.h>
+#include <lspserver/SourceCode.h>
 
 #include <string>
 #include <vector>
@@ -19,7 +18,8 @@ namespace nixd {
 ///
 /// This is a selection-based action that works on arbitrary text, not AST
 /// nodes. It parses the selected text as JSON and converts it to Nix syntax.
-void addJsonToNixAction(llvm::StringRef Src, const lspserver::Range &Range,
+void addJsonToNixAction(const lspserver::LineTable &Lines,
+                        const lspserver::Range &Range,
                         const std::string &FileURI,
                         std::vector<lspserver::CodeAction> &Actions);
 
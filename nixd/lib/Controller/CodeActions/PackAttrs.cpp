@@ -185,8 +185,10 @@ findSiblingBindingsRange(const nixf::Binding &Bind, const nixf::Binds &Binds,
 } // namespace
 
 void addPackAttrsAction(const nixf::Node &N, const nixf::ParentMapAnalysis &PM,
-                        const std::string &FileURI, llvm::StringRef Src,
+                        const std::string &FileURI,
+                        const lspserver::LineTable &Lines,
                         std::vector<lspserver::CodeAction> &Actions) {
+  llvm::StringRef Src = Lines.code();
   // Find if we're inside a Binding
   const nixf::Node *BindingNode = PM.upTo(N, nixf::Node::NK_Binding);
   if (!BindingNode)
@@ -264,7 +266,7 @@ void addPackAttrsAction(const nixf::Node &N, const nixf::ParentMapAnalysis &PM,
     Actions.emplace_back(createSingleEditAction(
         "Pack dotted path to nested set",
         lspserver::CodeAction::REFACTOR_REWRITE_KIND, FileURI,
-        toLSPRange(Src, Bind.range()), std::move(NewText)));
+        toLSPRange(Lines, Bind.range()), std::move(NewText)));
   } else {
     // Multiple siblings share the prefix - offer Pack One and bulk pack actions
     const nixf::SemaAttrs &SA = ParentAttrs.sema();
@@ -291,7 +293,7 @@ void addPackAttrsAction(const nixf::Node &N, const nixf::ParentMapAnalysis &PM,
       Actions.emplace_back(createSingleEditAction(
           "Pack dotted path to nested set",
           lspserver::CodeAction::REFACTOR_REWRITE_KIND, FileURI,
-          toLSPRange(Src, Bind.range()), std::move(PackOneText)));
+          toLSPRange(Lines, Bind.range()), std::move(PackOneText)));
     }
 
     // Action 2: Shallow Pack All - pack all siblings but only one level deep
@@ -304,7 +306,7 @@ void addPackAttrsAction(const nixf::Node &N, const nixf::ParentMapAnalysis &PM,
     Actions.emplace_back(createSingleEditAction(
         "Pack all '" + FirstSeg + "' bindings to nested set",
         lspserver::CodeAction::REFACTOR_REWRITE_KIND, FileURI,
-        toLSPRange(Src, *BulkRange), std::move(ShallowText)));
+        toLSPRange(Lines, *BulkRange), std::move(ShallowText)));
 
     // Action 3: Recursive Pack All - fully nest all sibling bindings
     std::string RecursiveText;
@@ -316,7 +318,7 @@ void addPackAttrsAction(const nixf::Node &N, const nixf::ParentMapAnalysis &PM,
     Actions.emplace_back(createSingleEditAction(
         "Recursively pack all '" + FirstSeg + "' bindings to nested set",
         lspserver::CodeAction::REFACTOR_REWRITE_KIND, FileURI,
-        toLSPRange(Src, *BulkRange), std::move(RecursiveText)));
+        toLSPRange(Lines, *BulkRange), std::move(RecursiveText)));
   }
 }
 
@@ -8,11 +8,10 @@
 #pragma once
 
 #include <lspserver/Protocol.h>
+#include <lspserver/SourceCode.h>
 
 #include <nixf/Sema/ParentMap.h>
 
-#include <llvm/ADT/StringRef.h>
-
 #include <string>
 #include <vector>
 
@@ -30,7 +29,8 @@ namespace nixd {
 /// - Shallow Pack All: pack all siblings sharing the same first segment
 /// - Recursive Pack All: fully nest all siblings
 void addPackAttrsAction(const nixf::Node &N, const nixf::ParentMapAnalysis &PM,
-                        const std::string &FileURI, llvm::StringRef Src,
+                        const std::string &FileURI,
+                        const lspserver::LineTable &Lines,
                         std::vector<lspserver::CodeAction> &Actions);
 
 } // namespace nixd
@@ -105,8 +105,10 @@ std::string buildIndentedString(const nixf::InterpolatedParts &Parts,
 
 void addRewriteStringAction(const nixf::Node &N,
                             const nixf::ParentMapAnalysis &PM,
-                            const std::string &FileURI, llvm::StringRef Src,
+                            const std::string &FileURI,
+                            const lspserver::LineTable &Lines,
                             std::vector<lspserver::CodeAction> &Actions) {
+  llvm::StringRef Src = Lines.code();
   // Find if we're inside an ExprString
   const nixf::Node *StringNode = PM.upTo(N, nixf::Node::NK_ExprString);
   if (!StringNode)
@@ -138,7 +140,7 @@ void addRewriteStringAction(const nixf::Node &N,
 
   Actions.emplace_back(createSingleEditAction(
       Title, lspserver::CodeAction::REFACTOR_REWRITE_KIND, FileURI,
-      toLSPRange(Src, Str.range()), std::move(NewText)));
+      toLSPRange(Lines, Str.range()), std::move(NewText)));
 }
 
 } // namespace nixd
@@ -6,11 +6,10 @@
 #pragma once
 
 #include <lspserver/Protocol.h>
+#include <lspserver/SourceCode.h>
 
 #include <nixf/Sema/ParentMap.h>
 
-#include <llvm/ADT/StringRef.h>
-
 #include <string>
 #include <vector>
 
@@ -27,7 +26,8 @@ namespace nixd {
 /// strings (''...''), properly handling escape sequence differences.
 void addRewriteStringAction(const nixf::Node &N,
                             const nixf::ParentMapAnalysis &PM,
-                            const std::string &FileURI, llvm::StringRef Src,
+                            const std::string &FileURI,
+                            const lspserver::LineTable &Lines,
                             std::vector<lspserver::CodeAction> &Actions);
 
 } // namespace nixd
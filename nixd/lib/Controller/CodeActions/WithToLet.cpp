@@ -132,8 +132,10 @@ std::string generateLetInherit(const nixf::ExprWith &With,
 
 void addWithToLetAction(const nixf::Node &N, const nixf::ParentMapAnalysis &PM,
                         const nixf::VariableLookupAnalysis &VLA,
-                        const std::string &FileURI, llvm::StringRef Src,
+                        const std::string &FileURI,
+                        const lspserver::LineTable &Lines,
                         std::vector<lspserver::CodeAction> &Actions) {
+  llvm::StringRef Src = Lines.code();
   // Find enclosing ExprWith node
   const nixf::Node *WithNode = PM.upTo(N, nixf::Node::NK_ExprWith);
   if (!WithNode)
@@ -171,7 +173,7 @@ void addWithToLetAction(const nixf::Node &N, const nixf::ParentMapAnalysis &PM,
   Actions.emplace_back(createSingleEditAction(
       "Convert `with` to `let/inherit`",
       lspserver::CodeAction::REFACTOR_REWRITE_KIND, FileURI,
-      toLSPRange(Src, With.range()), std::move(NewText)));
+      toLSPRange(Lines, With.range()), std::move(NewText)));
 }
 
 } // namespace nixd
@@ -4,20 +4,20 @@
 /// https://microsoft.github.io/language-server-protocol/specifications/lsp/3.17/specification/#textDocument_completion
 
 #include "AST.h"
-#include "CheckReturn.h"
 #include "Convert.h"
+#include "Join.h"
 
+#include "lspserver/Cancellation.h"
 #include "lspserver/Protocol.h"
 
+#include "nixd/Controller/CompletionRanker.h"
 #include "nixd/Controller/Controller.h"
 #include "nixd/Protocol/AttrSet.h"
 
 #include <nixf/Sema/VariableLookup.h>
 
-#include <boost/asio/post.hpp>
-
+#include <algorithm>
 #include <exception>
-#include <semaphore>
 #include <set>
 #include <utility>
 
@@ -29,23 +29,61 @@ namespace {
 
 /// Set max completion size to this value, we don't want to send large lists
 /// because of slow IO.
-/// Items exceed this size should be marked "incomplete" and recomputed.
+/// If more items matched, only the best ones are kept, and the list is marked
+/// "incomplete" to be recomputed.
 constexpr int MaxCompletionSize = 30;
 
+/// Bonus of definitions in the innermost scope. Outer scopes get less.
+constexpr int ScopeBonus = 8;
+constexpr int ScopeBonusStep = 2;
+
 CompletionItemKind OptionKind = CompletionItemKind::Constructor;
 CompletionItemKind OptionAttrKind = CompletionItemKind::Class;
 
-struct ExceedSizeError : std::exception {
-  [[nodiscard]] const char *what() const noexcept override {
-    return "Size exceeded";
+/// Completion items of one provider, to be ranked against "Pattern".
+struct Candidates {
+  std::string Pattern;
+  std::vector<std::pair<CompletionItem, int>> Items; // With the bonus.
+
+  void add(CompletionItem Item, int Bonus = 0) {
+    Items.emplace_back(std::move(Item), Bonus);
   }
 };
 
-void addItem(std::vector<CompletionItem> &Items, CompletionItem Item) {
-  if (Items.size() >= MaxCompletionSize) {
-    throw ExceedSizeError();
+/// Workers reply in any order, so candidates are kept per provider, and
+/// ranked once all replies arrived. Ties are broken in the order providers
+/// were asked, as if the requests were synchronous.
+using CandidatesJoin = std::shared_ptr<Join<std::vector<Candidates>>>;
+
+/// Reserve a slot for candidates of a provider.
+std::size_t addSlot(const CandidatesJoin &J) {
+  return J->update([](std::vector<Candidates> &Slots) {
+    Slots.emplace_back();
+    return Slots.size() - 1;
+  });
+}
+
+/// Fill the reserved slot, and mark the part finished.
+void fillSlot(const CandidatesJoin &J, std::size_t Slot, Candidates C) {
+  J->update(
+      [&](std::vector<Candidates> &Slots) { Slots[Slot] = std::move(C); });
+  J->done();
+}
+
+/// \brief Estimate how commonly a package is used, by its name.
+///
+/// There is no usage statistics, but canonical packages tend to have short
+/// names, while variants are suffixed (e.g. "-unwrapped", "_latest").
+int packageBonus(std::string_view Name) {
+  int Bonus = -static_cast<int>(std::min<std::size_t>(Name.size(), 40) / 8);
+  for (std::string_view Suffix : {"-unwrapped", "-bin", "_latest", "_git",
+                                  "-full", "Full", "Minimal"}) {
+    if (Name.ends_with(Suffix)) {
+      Bonus -= 2;
+      break;
+    }
   }
-  Items.emplace_back(std::move(Item));
+  return Bonus;
 }
 
 bool hasConcreteChild(const Node &N) {
@@ -73,22 +111,25 @@ class VLACompletionProvider {
   }
 
   /// Collect definition on some env, and also it's ancestors.
-  void collectDef(std::vector<CompletionItem> &Items, const EnvNode *Env,
-                  const std::string &Prefix) {
-    if (!Env)
-      return;
-    collectDef(Items, Env->parent(), Prefix);
-    for (const auto &[Name, Def] : Env->defs()) {
-      if (Name.starts_with(
-              "__")) // These names are nix internal implementation, skip.
-        continue;
-      assert(Def);
-      if (Name.starts_with(Prefix)) {
-        addItem(Items, CompletionItem{
-                           .label = Name,
-                           .kind = getCompletionItemKind(*Def),
-                       });
+  /// Definitions in inner scopes are ranked higher, and shadow outer ones.
+  void collectDef(Candidates &C, const EnvNode *Env) {
+    std::set<std::string_view> Seen;
+    for (int Bonus = ScopeBonus; Env; Env = Env->parent()) {
+      for (const auto &[Name, Def] : Env->defs()) {
+        if (Name.starts_with(
+                "__")) // These names are nix internal implementation, skip.
+          continue;
+        assert(Def);
+        if (!Seen.emplace(Name).second)
+          continue;
+        C.add(
+            CompletionItem{
+                .label = Name,
+                .kind = getCompletionItemKind(*Def),
+            },
+            Bonus);
       }
+      Bonus = std::max(0, Bonus - ScopeBonusStep);
     }
   }
 
@@ -96,10 +137,13 @@ public:
   VLACompletionProvider(const VariableLookupAnalysis &VLA) : VLA(VLA) {}
 
   /// Perform code completion right after this node.
-  void complete(const nixf::ExprVar &Desc, std::vector<CompletionItem> &Items,
+  void complete(const nixf::ExprVar &Desc, const CandidatesJoin &J,
                 const ParentMapAnalysis &PM) {
-    std::string Prefix = Desc.id().name();
-    collectDef(Items, upEnv(Desc, VLA, PM), Prefix);
+    Candidates C{.Pattern = Desc.id().name()};
+    collectDef(C, upEnv(Desc, VLA, PM));
+    J->update([&](std::vector<Candidates> &Slots) {
+      Slots.emplace_back(std::move(C));
+    });
   }
 };
 
@@ -107,9 +151,8 @@ public:
 /// We simply select nixpkgs in separate process, thus this value does not need
 /// to be cached. (It is already cached in separate process.)
 ///
-/// Currently, this procedure is explicitly blocked (synchronized). Because
-/// query nixpkgs value is relatively fast. In the future there might be nixd
-/// index, for performance.
+/// Replies are handled by continuations, so no thread is blocked while the
+/// worker is evaluating.
 class NixpkgsCompletionProvider {
 
   AttrSetClient &NixpkgsClient;
@@ -119,58 +162,58 @@ public:
       : NixpkgsClient(NixpkgsClient) {}
 
   void resolvePackage(std::vector<std::string> Scope, std::string Name,
-                      CompletionItem &Item) {
-    std::binary_semaphore Ready(0);
-    AttrPathInfoResponse Desc;
-    auto OnReply = [&Ready, &Desc](llvm::Expected<AttrPathInfoResponse> Resp) {
-      if (Resp)
-        Desc = *Resp;
-      Ready.release();
+                      CompletionItem Item, Callback<CompletionItem> Reply) {
+    auto OnReply = [Item = std::move(Item), Reply = std::move(Reply)](
+                       llvm::Expected<AttrPathInfoResponse> Resp) mutable {
+      if (!Resp) {
+        llvm::consumeError(Resp.takeError());
+        Resp = AttrPathInfoResponse{};
+      }
+      // Format "detail" and document.
+      const PackageDescription &PD = Resp->PackageDesc;
+      Item.documentation = MarkupContent{
+          .kind = MarkupKind::Markdown,
+          .value = PD.Description.value_or("") + "\n\n" +
+                   PD.LongDescription.value_or(""),
+      };
+      Item.detail = PD.Version.value_or("?");
+      Reply(std::move(Item));
     };
     Scope.emplace_back(std::move(Name));
     NixpkgsClient.attrpathInfo(Scope, std::move(OnReply));
-    Ready.acquire();
-    // Format "detail" and document.
-    const PackageDescription &PD = Desc.PackageDesc;
-    Item.documentation = MarkupContent{
-        .kind = MarkupKind::Markdown,
-        .value = PD.Description.value_or("") + "\n\n" +
-                 PD.LongDescription.value_or(""),
-    };
-    Item.detail = PD.Version.value_or("?");
   }
 
   /// \brief Ask nixpkgs provider, give us a list of names. (thunks)
   void completePackages(const lspserver::Range EditRange,
                         const AttrPathCompleteParams &Params,
-                        std::vector<CompletionItem> &Items) {
-    std::binary_semaphore Ready(0);
-    std::vector<std::string> Names;
-    auto OnReply = [&Ready,
-                    &Names](llvm::Expected<AttrPathCompleteResponse> Resp) {
+                        const CandidatesJoin &J) {
+    std::size_t Slot = addSlot(J);
+    auto OnReply = [J, Slot, EditRange, Params](
+                       llvm::Expected<AttrPathCompleteResponse> Resp) {
+      Candidates C{.Pattern = Params.Prefix};
       if (!Resp) {
         lspserver::elog("nixpkgs evaluator reported: {0}", Resp.takeError());
-        Ready.release();
-        return;
+        return fillSlot(J, Slot, std::move(C));
+      }
+      // Now we have "Names", use these to fill "Items".
+      // The provider may reply fuzzy matches, not only names with the prefix.
+      std::string Data = llvm::formatv("{0}", toJSON(Params));
+      for (const auto &Name : *Resp) {
+        C.add(
+            CompletionItem{
+                .label = Name,
+                .kind = CompletionItemKind::Field,
+                .textEdit =
+                    lspserver::TextEdit{.range = EditRange, .newText = Name},
+                .data = Data,
+            },
+            packageBonus(Name));
       }
-      Names = *Resp; // Copy response to waiting thread.
-      Ready.release();
+      fillSlot(J, Slot, std::move(C));
     };
     // Send request.
+    J->add();
     NixpkgsClient.attrpathComplete(Params, std::move(OnReply));
-    Ready.acquire();
-    // Now we have "Names", use these to fill "Items".
-    for (const auto &Name : Names) {
-      if (Name.starts_with(Params.Prefix)) {
-        addItem(Items, CompletionItem{
-                           .label = Name,
-                           .kind = CompletionItemKind::Field,
-                           .textEdit = lspserver::TextEdit{.range = EditRange,
-                                                           .newText = Name},
-                           .data = llvm::formatv("{0}", toJSON(Params)),
-                       });
-      }
-    }
   }
 };
 
@@ -221,43 +264,44 @@ public:
 
   void completeOptions(const lspserver::Range EditRange,
                        std::vector<std::string> Scope, std::string Prefix,
-                       std::vector<CompletionItem> &Items) {
-    std::binary_semaphore Ready(0);
-    OptionCompleteResponse Names;
-    auto OnReply = [&Ready,
-                    &Names](llvm::Expected<OptionCompleteResponse> Resp) {
-      if (!Resp) {
+                       const CandidatesJoin &J) {
+    AttrPathCompleteParams Params{std::move(Scope), std::move(Prefix)};
+    std::size_t Slot = addSlot(J);
+    auto OnReply = [Self = *this, J, Slot, EditRange,
+                    Params](llvm::Expected<OptionCompleteResponse> Resp) {
+      Candidates C{.Pattern = Params.Prefix};
+      if (!Resp)
         lspserver::elog("option worker reported: {0}", Resp.takeError());
-        Ready.release();
-        return;
-      }
-      Names = *Resp; // Copy response to waiting thread.
-      Ready.release();
+      else
+        Self.addOptions(EditRange, Params.Prefix.empty(), *Resp, C);
+      fillSlot(J, Slot, std::move(C));
     };
     // Send request.
-    AttrPathCompleteParams Params{std::move(Scope), std::move(Prefix)};
+    J->add();
     OptionClient.optionComplete(Params, std::move(OnReply));
-    Ready.acquire();
+  }
+
+  void addOptions(const lspserver::Range EditRange, bool EmptyPrefix,
+                  const OptionCompleteResponse &Names, Candidates &C) const {
     // Now we have "Names", use these to fill "Items".
     //
-    // When Params.Prefix is empty, the cursor is inside an empty hole and
+    // When the prefix is empty, the cursor is inside an empty hole and
     // EditRange does not point at a real prefix to replace, so we omit the
     // textEdit and let the editor fall back to insertText/label.
-    bool HasPrefix = !Params.Prefix.empty();
     auto MkTextEdit =
         [&](llvm::StringRef NewText) -> std::optional<lspserver::TextEdit> {
-      if (!HasPrefix)
+      if (EmptyPrefix)
         return std::nullopt;
       return lspserver::TextEdit{.range = EditRange, .newText = NewText.str()};
     };
     for (const nixd::OptionField &Field : Names) {
       if (!Field.Description) {
-        addItem(Items, CompletionItem{
-                           .label = Field.Name,
-                           .kind = OptionAttrKind,
-                           .detail = ModuleOrigin,
-                           .textEdit = MkTextEdit(Field.Name),
-                       });
+        C.add(CompletionItem{
+            .label = Field.Name,
+            .kind = OptionAttrKind,
+            .detail = ModuleOrigin,
+            .textEdit = MkTextEdit(Field.Name),
+        });
         continue;
       }
 
@@ -290,11 +334,11 @@ public:
           Desc.Default.has_value() && Desc.Default != Desc.Example;
       bool HasBoth = HasExample && HasDefault;
 
-      auto emit = [&](const std::string &Value, llvm::StringRef Source,
-                      llvm::StringRef SortPrefix) {
+      auto emit = [&](const std::string &Value, llvm::StringRef Source) {
         // When both variants exist, append the source so users can tell
         // them apart. `filterText` is always the plain option name so
-        // typing the name matches both items.
+        // typing the name matches both items. They have the same score, so
+        // the "example" one, added first, is ranked before "default".
         std::string Label =
             HasBoth ? llvm::formatv("{0} ({1})", Field.Name, Source).str()
                     : Field.Name;
@@ -303,21 +347,20 @@ public:
             .kind = OptionKind,
             .detail = TypeDetail,
             .documentation = Doc,
-            .sortText = (SortPrefix + Field.Name).str(),
             .filterText = Field.Name,
         };
         fillInsertText(Item, Field.Name, Value);
         Item.textEdit = MkTextEdit(Item.insertText);
-        addItem(Items, std::move(Item));
+        C.add(std::move(Item));
       };
 
       bool Emitted = false;
       if (HasExample) {
-        emit(*Desc.Example, "example", "0");
+        emit(*Desc.Example, "example");
         Emitted = true;
       }
       if (HasDefault) {
-        emit(*Desc.Default, "default", "1");
+        emit(*Desc.Default, "default");
         Emitted = true;
       }
       if (!Emitted) {
@@ -331,7 +374,7 @@ public:
         };
         fillInsertText(Item, Field.Name, "");
         Item.textEdit = MkTextEdit(Item.insertText);
-        addItem(Items, std::move(Item));
+        C.add(std::move(Item));
       }
     }
   }
@@ -341,22 +384,22 @@ void completeAttrName(const lspserver::Range EditRange,
                       const std::vector<std::string> &Scope,
                       const std::string &Prefix,
                       Controller::OptionMapTy &Options, bool CompletionSnippets,
-                      std::vector<CompletionItem> &List) {
+                      const CandidatesJoin &J) {
   for (const auto &[Name, Provider] : Options) {
-    AttrSetClient *Client = Options.at(Name)->client();
+    std::shared_ptr<AttrSetClient> Client = Options.at(Name)->client();
     if (!Client) [[unlikely]] {
       elog("skipped client {0} as it is dead", Name);
       continue;
     }
     OptionCompletionProvider OCP(*Client, Name, CompletionSnippets);
-    OCP.completeOptions(EditRange, Scope, Prefix, List);
+    OCP.completeOptions(EditRange, Scope, Prefix, J);
   }
 }
 
 void completeAttrPath(const lspserver::Range EditRange, const Node &N,
                       const ParentMapAnalysis &PM, std::mutex &OptionsLock,
                       Controller::OptionMapTy &Options, bool Snippets,
-                      std::vector<lspserver::CompletionItem> &Items) {
+                      const CandidatesJoin &J) {
   std::vector<std::string> Scope;
   using PathResult = FindAttrPathResult;
   auto R = findAttrPathForOptions(N, PM, Scope);
@@ -366,7 +409,7 @@ void completeAttrPath(const lspserver::Range EditRange, const Node &N,
     Scope.pop_back();
     {
       std::lock_guard _(OptionsLock);
-      completeAttrName(EditRange, Scope, Prefix, Options, Snippets, Items);
+      completeAttrName(EditRange, Scope, Prefix, Options, Snippets, J);
     }
   }
 }
@@ -391,11 +434,14 @@ AttrPathCompleteParams mkParams(nixd::Selector Sel, bool IsComplete) {
 void completeVarName(const lspserver::Range EditRange,
                      const VariableLookupAnalysis &VLA,
                      const ParentMapAnalysis &PM, const nixf::ExprVar &N,
-                     AttrSetClient &Client, std::vector<CompletionItem> &List) {
+                     AttrSetClient *Client, const CandidatesJoin &J) {
 #define DBGPREFIX "completion/var"
 
   VLACompletionProvider VLAP(VLA);
-  VLAP.complete(N, List, PM);
+  VLAP.complete(N, J, PM);
+
+  if (!Client)
+    return log(DBG "skipped, nixpkgs worker is not available");
 
   // Try to complete the name by known idioms.
   try {
@@ -406,12 +452,10 @@ void completeVarName(const lspserver::Range EditRange,
       return;
 
     // Invoke nixpkgs provider to get the completion list.
-    NixpkgsCompletionProvider NCP(Client);
+    NixpkgsCompletionProvider NCP(*Client);
     // Variable names are always incomplete.
-    NCP.completePackages(EditRange, mkParams(Sel, /*IsComplete=*/false), List);
-  } catch (ExceedSizeError &) {
-    // Let "onCompletion" catch this exception to set "inComplete" field.
-    throw;
+    NCP.completePackages(EditRange, mkParams(Sel, /*IsComplete=*/false),
+                         J);
   } catch (std::exception &E) {
     return log(DBG "skipped, reason: {0}", E.what());
   }
@@ -429,7 +473,7 @@ void completeSelect(const lspserver::Range EditRange,
                     const nixf::ExprSelect &Select, AttrSetClient &Client,
                     const nixf::VariableLookupAnalysis &VLA,
                     const nixf::ParentMapAnalysis &PM, bool IsComplete,
-                    std::vector<CompletionItem> &List) {
+                    const CandidatesJoin &J) {
 #define DBGPREFIX "completion/select"
   // The base expr for selecting.
   const nixf::Expr &BaseExpr = Select.expr();
@@ -448,10 +492,7 @@ void completeSelect(const lspserver::Range EditRange,
   try {
     Selector Sel =
         idioms::mkSelector(Select, idioms::mkVarSelector(Var, VLA, PM));
-    NCP.completePackages(EditRange, mkParams(Sel, IsComplete), List);
-  } catch (ExceedSizeError &) {
-    // Let "onCompletion" catch this exception to set "inComplete" field.
-    throw;
+    NCP.completePackages(EditRange, mkParams(Sel, IsComplete), J);
   } catch (std::exception &E) {
     return log(DBG "skipped, reason: {0}", E.what());
   }
@@ -463,71 +504,92 @@ void completeSelect(const lspserver::Range EditRange,
 
 void Controller::onCompletion(const CompletionParams &Params,
                               Callback<CompletionList> Reply) {
-  using CheckTy = CompletionList;
+  CancellationToken Token = CancellationToken::current();
   auto Action = [Reply = std::move(Reply), URI = Params.textDocument.uri,
-                 Pos = toNixfPosition(Params.position), this]() mutable {
-    const auto File = URI.file().str();
-    return Reply([&]() -> llvm::Expected<CompletionList> {
-      const auto TU = CheckDefault(getTU(File));
-      const auto AST = CheckDefault(getAST(*TU));
-
-      const auto *Desc = AST->descend({Pos, Pos});
-      CheckDefault(Desc && canCompleteAt(*Desc));
-
-      const auto &N = *Desc;
-      const auto &PM = *TU->parentMap();
-      const auto &UpExpr = *CheckDefault(PM.upExpr(N));
+                 Pos = toNixfPosition(Params.position), Token,
+                 this]() mutable {
+    if (Token.isCancelled())
+      return Reply(cancelledError(Token));
+    WithCancellation _(Token);
+
+    // Rank all candidates once the workers replied.
+    auto Finish = Join<std::vector<Candidates>>::create(
+        {}, [Reply = std::move(Reply),
+             Token](std::vector<Candidates> Slots) mutable {
+          if (Token.isCancelled())
+            return Reply(cancelledError(Token));
+          CompletionRanker Ranker(MaxCompletionSize);
+          for (Candidates &C : Slots) {
+            for (auto &[Item, Bonus] : C.Items)
+              Ranker.add(C.Pattern, std::move(Item), Bonus);
+          }
+          CompletionList List;
+          List.isIncomplete = Ranker.dropped();
+          List.items = Ranker.take();
+          Reply(std::move(List));
+        });
 
-      lspserver::Range EditRange = toLSPRange(TU->src(), N.range());
-      if (N.kind() == Node::NK_Dot) {
-        // If the node is a dot, insert after the dot
-        EditRange.start = EditRange.end;
-      }
+    const auto File = URI.file().str();
+    // Keep the TU alive, nodes are referenced while issuing requests.
+    const auto TU = getTU(File);
+    const auto AST = TU ? getAST(*TU) : nullptr;
+    const Node *Desc = AST ? TU->descend({Pos, Pos}) : nullptr;
+    const Node *UpExpr = nullptr;
+    if (Desc && canCompleteAt(*Desc))
+      UpExpr = TU->parentMap()->upExpr(*Desc);
+    if (!UpExpr)
+      return Finish->done();
+
+    const auto &N = *Desc;
+    const auto &PM = *TU->parentMap();
+
+    lspserver::Range EditRange = toLSPRange(TU->lines(), N.range());
+    if (N.kind() == Node::NK_Dot) {
+      // If the node is a dot, insert after the dot
+      EditRange.start = EditRange.end;
+    }
 
-      return [&]() {
-        CompletionList List;
-        const VariableLookupAnalysis &VLA = *TU->variableLookup();
-        try {
-          switch (UpExpr.kind()) {
-          // In these cases, assume the cursor have "variable" scoping.
-          case Node::NK_ExprVar: {
-            completeVarName(EditRange, VLA, PM,
-                            static_cast<const nixf::ExprVar &>(UpExpr),
-                            *nixpkgsClient(), List.items);
-            return List;
-          }
-          // A "select" expression. e.g.
-          // foo.a|
-          // foo.|
-          // foo.a.bar|
-          case Node::NK_ExprSelect: {
-            const auto &Select = static_cast<const nixf::ExprSelect &>(UpExpr);
-            completeSelect(EditRange, Select, *nixpkgsClient(), VLA, PM,
-                           N.kind() == Node::NK_Dot, List.items);
-            return List;
-          }
-          case Node::NK_ExprAttrs: {
-            completeAttrPath(EditRange, N, PM, OptionsLock, Options,
-                             ClientCaps.CompletionSnippets, List.items);
-            return List;
-          }
-          default:
-            return List;
-          }
-        } catch (ExceedSizeError &Err) {
-          List.isIncomplete = true;
-          return List;
-        }
-      }();
-    }());
+    const VariableLookupAnalysis &VLA = *TU->variableLookup();
+    std::shared_ptr<AttrSetClient> Nixpkgs = nixpkgsClient();
+    switch (UpExpr->kind()) {
+    // In these cases, assume the cursor have "variable" scoping.
+    case Node::NK_ExprVar: {
+      completeVarName(EditRange, VLA, PM,
+                      static_cast<const nixf::ExprVar &>(*UpExpr),
+                      Nixpkgs.get(), Finish);
+      break;
+    }
+    // A "select" expression. e.g.
+    // foo.a|
+    // foo.|
+    // foo.a.bar|
+    case Node::NK_ExprSelect: {
+      const auto &Select = static_cast<const nixf::ExprSelect &>(*UpExpr);
+      if (Nixpkgs)
+        completeSelect(EditRange, Select, *Nixpkgs, VLA, PM,
+                       N.kind() == Node::NK_Dot, Finish);
+      break;
+    }
+    case Node::NK_ExprAttrs: {
+      completeAttrPath(EditRange, N, PM, OptionsLock, Options,
+                       ClientCaps.CompletionSnippets, Finish);
+      break;
+    }
+    default:
+      break;
+    }
+    Finish->done();
   };
-  boost::asio::post(Pool, std::move(Action));
+  // Clients only show results of the newest request, stop the previous one.
+  schedule(Priority::Interactive, "textDocument/completion", Token,
+           std::move(Action));
 }
 
 void Controller::onCompletionItemResolve(const CompletionItem &Params,
                                          Callback<CompletionItem> Reply) {
 
-  auto Action = [Params, Reply = std::move(Reply), this]() mutable {
+  auto Action = [Params, Reply = std::move(Reply),
+                 Token = CancellationToken::current(), this]() mutable {
     if (Params.data.empty()) {
       Reply(Params);
       return;
@@ -543,12 +605,16 @@ void Controller::onCompletionItemResolve(const CompletionItem &Params,
     llvm::json::Path::Root Root;
     fromJSON(*EV, Req, Root);
 
-    // FIXME: handle null nixpkgsClient()
-    NixpkgsCompletionProvider NCP(*nixpkgsClient());
-    CompletionItem Resp = Params;
-    NCP.resolvePackage(Req.Scope, Params.label, Resp);
+    std::shared_ptr<AttrSetClient> Client = nixpkgsClient();
+    if (!Client) {
+      // The worker is restarting, resolve it without details.
+      Reply(Params);
+      return;
+    }
 
-    Reply(std::move(Resp));
+    WithCancellation _(Token);
+    NixpkgsCompletionProvider NCP(*Client);
+    NCP.resolvePackage(Req.Scope, Params.label, Params, std::move(Reply));
   };
-  boost::asio::post(Pool, std::move(Action));
+  schedule(Priority::Interactive, std::move(Action));
 }
@@ -0,0 +1,67 @@
+#include "nixd/Controller/CompletionRanker.h"
+#include "nixd/Support/FuzzyMatch.h"
+
+#include <algorithm>
+#include <cctype>
+#include <string>
+
+using namespace nixd;
+using namespace lspserver;
+
+namespace {
+
+char lower(char C) {
+  return static_cast<char>(std::tolower(static_cast<unsigned char>(C)));
+}
+
+} // namespace
+
+bool CompletionRanker::add(std::string_view Pattern, CompletionItem Item,
+                           int Bonus) {
+  std::string_view Name = Item.filterText.empty()
+                              ? std::string_view(Item.label)
+                              : std::string_view(Item.filterText);
+  // Users type names from the beginning. Anchor the first character, so that
+  // the list is not flooded by names merely containing it.
+  if (!Pattern.empty() &&
+      (Name.empty() || lower(Pattern.front()) != lower(Name.front())))
+    return false;
+  std::optional<int> Score = fuzzyMatch(Pattern, Name);
+  if (!Score)
+    return false;
+  Scored S{*Score + Bonus, Seq++, std::move(Item)};
+  if (Limit == 0) {
+    Dropped = true;
+    return true;
+  }
+  if (Heap.size() < Limit) {
+    Heap.emplace_back(std::move(S));
+    std::push_heap(Heap.begin(), Heap.end(), better);
+    return true;
+  }
+  Dropped = true;
+  // Replace the worst item, if this one is better.
+  if (better(S, Heap.front())) {
+    std::pop_heap(Heap.begin(), Heap.end(), better);
+    Heap.back() = std::move(S);
+    std::push_heap(Heap.begin(), Heap.end(), better);
+  }
+  return true;
+}
+
+std::vector<CompletionItem> CompletionRanker::take() {
+  std::sort_heap(Heap.begin(), Heap.end(), better);
+  std::vector<CompletionItem> Items;
+  Items.reserve(Heap.size());
+  for (Scored &S : Heap) {
+    CompletionItem &Item = Items.emplace_back(std::move(S.Item));
+    if (Item.filterText.empty())
+      Item.filterText = Item.label;
+    // Zero-padded, so that lexicographic order is the rank order.
+    std::string Rank = std::to_string(Items.size() - 1);
+    Item.sortText = std::string(Rank.size() < 4 ? 4 - Rank.size() : 0, '0');
+    Item.sortText += Rank;
+  }
+  Heap.clear();
+  return Items;
+}
@@ -1,8 +1,6 @@
 #include "nixd/Controller/Controller.h"
 #include "nixd/Eval/Launch.h"
 
-#include <boost/asio/post.hpp>
-
 using namespace nixd;
 using namespace lspserver;
 using llvm::json::ObjectMapper;
@@ -59,10 +57,7 @@ void Controller::updateConfig(Configuration NewConfig) {
 
   if (!Config.nixpkgs.expr.empty()) {
     /// Evaluate nixpkgs and options, using user-provided config.
-    if (nixpkgsClient()) {
-      evalExprWithProgress(*nixpkgsClient(), Config.nixpkgs.expr,
-                           "nixpkgs entries");
-    }
+    evalExprWithProgress(nixpkgsEval(), Config.nixpkgs.expr, "nixpkgs entries");
   }
   if (!Config.options.empty()) {
     std::lock_guard _(OptionsLock);
@@ -74,7 +69,7 @@ void Controller::updateConfig(Configuration NewConfig) {
         startOption(Name, Client);
       }
       assert(Client);
-      evalExprWithProgress(*Client->client(), Opt.expr, Name);
+      evalExprWithProgress(*Client, Opt.expr, Name);
     }
   }
 
@@ -82,9 +77,16 @@ void Controller::updateConfig(Configuration NewConfig) {
   updateSuppressed(Config.diagnostic.suppress);
 
   // After all, notify all AST modules the diagnostic set has been updated.
-  std::lock_guard TUsGuard(TUsLock);
-  for (const auto &[File, TU] : TUs) {
-    publishDiagnostics(File, std::nullopt, TU->src(), TU->diagnostics());
+  // Units are collected under "TUsLock", and published without it.
+  std::lock_guard PublishGuard(PublishLock);
+  std::vector<std::pair<std::string, std::shared_ptr<const NixTU>>> Units;
+  {
+    std::lock_guard TUsGuard(TUsLock);
+    for (const auto &[File, TU] : TUs)
+      Units.emplace_back(File.str(), TU);
+  }
+  for (const auto &[File, TU] : Units) {
+    publishDiagnostics(File, std::nullopt, TU->lines(), TU->diagnostics());
   }
 }
 
@@ -103,7 +105,7 @@ void Controller::fetchConfig() {
     }
     const Value &FirstConfig = Resp->getAsArray()->front();
 
-    // Run this job in the thread pool. Don't block input thread.
+    // Run this job in a worker. Don't block input thread.
     auto ConfigAction = [this, FirstConfig]() mutable {
       // Parse the config
       Configuration NewConfig;
@@ -117,7 +119,7 @@ void Controller::fetchConfig() {
       updateConfig(std::move(NewConfig));
     };
 
-    boost::asio::post(Pool, std::move(ConfigAction));
+    schedule(Priority::Background, std::move(ConfigAction));
   };
   workspaceConfiguration({.items = {ConfigurationItem{.section = "nixd"}}},
                          std::move(Action));
@@ -24,9 +24,9 @@ int nixd::getLSPSeverity(nixf::Diagnostic::DiagnosticKind Kind) {
   __builtin_unreachable();
 }
 
-lspserver::Position nixd::toLSPPosition(llvm::StringRef Code,
+lspserver::Position nixd::toLSPPosition(const lspserver::LineTable &Lines,
                                         const nixf::LexerCursor &P) {
-  return lspserver::offsetToPosition(Code, P.offset());
+  return Lines.offsetToPosition(P.offset());
 }
 
 nixf::Position nixd::toNixfPosition(const lspserver::Position &P) {
@@ -37,10 +37,10 @@ nixf::PositionRange nixd::toNixfRange(const lspserver::Range &P) {
   return {toNixfPosition(P.start), toNixfPosition(P.end)};
 }
 
-lspserver::Range nixd::toLSPRange(llvm::StringRef Code,
+lspserver::Range nixd::toLSPRange(const lspserver::LineTable &Lines,
                                   const nixf::LexerCursorRange &R) {
-  return lspserver::Range{toLSPPosition(Code, R.lCur()),
-                          toLSPPosition(Code, R.rCur())};
+  return lspserver::Range{toLSPPosition(Lines, R.lCur()),
+                          toLSPPosition(Lines, R.rCur())};
 }
 
 llvm::SmallVector<lspserver::DiagnosticTag, 1>
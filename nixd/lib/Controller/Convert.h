@@ -7,17 +7,18 @@
 #include "nixf/Basic/Range.h"
 
 #include "lspserver/Protocol.h"
+#include "lspserver/SourceCode.h"
 
 namespace nixd {
 
-lspserver::Position toLSPPosition(llvm::StringRef Code,
+lspserver::Position toLSPPosition(const lspserver::LineTable &Lines,
                                   const nixf::LexerCursor &P);
 
 nixf::Position toNixfPosition(const lspserver::Position &P);
 
 nixf::PositionRange toNixfRange(const lspserver::Range &P);
 
-lspserver::Range toLSPRange(llvm::StringRef Code,
+lspserver::Range toLSPRange(const lspserver::LineTable &Lines,
                             const nixf::LexerCursorRange &R);
 
 int getLSPSeverity(nixf::Diagnostic::DiagnosticKind Kind);
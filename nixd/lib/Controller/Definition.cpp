@@ -5,17 +5,16 @@
 
 #include "Definition.h"
 #include "AST.h"
-#include "CheckReturn.h"
 #include "Convert.h"
+#include "Join.h"
 #include "PathResolve.h"
 
 #include "nixd/Controller/Controller.h"
 #include "nixd/Protocol/AttrSet.h"
 
+#include "lspserver/Cancellation.h"
 #include "lspserver/Protocol.h"
 
-#include <boost/asio/post.hpp>
-
 #include <llvm/Support/Error.h>
 #include <llvm/Support/JSON.h>
 
@@ -27,7 +26,6 @@
 #include <nixf/Sema/VariableLookup.h>
 
 #include <exception>
-#include <semaphore>
 
 using namespace nixd;
 using namespace nixd::idioms;
@@ -38,6 +36,7 @@ using namespace llvm;
 using LookupResult = VariableLookupAnalysis::LookupResult;
 using ResultKind = VariableLookupAnalysis::LookupResultKind;
 using Locations = std::vector<Location>;
+using LocationsCallback = llvm::unique_function<void(Locations)>;
 
 namespace {
 
@@ -116,35 +115,17 @@ const Definition &findVarDefinition(const ExprVar &Var,
 }
 
 /// \brief Convert nixf::Definition to lspserver::Location
-Location convertToLocation(llvm::StringRef Src, const Definition &Def,
+Location convertToLocation(const LineTable &Lines, const Definition &Def,
                            URIForFile URI) {
   if (!Def.syntax())
     throw NoLocationForBuiltinVariable();
   assert(Def.syntax());
   return Location{
       .uri = std::move(URI),
-      .range = toLSPRange(Src, Def.syntax()->range()),
+      .range = toLSPRange(Lines, Def.syntax()->range()),
   };
 }
 
-struct NoLocationsFoundInNixpkgsException : std::exception {
-  [[nodiscard]] const char *what() const noexcept override {
-    return "no locations found in nixpkgs";
-  }
-};
-
-class WorkerReportedException : std::exception {
-  llvm::Error E;
-
-public:
-  WorkerReportedException(llvm::Error E) : E(std::move(E)) {};
-
-  llvm::Error takeError() { return std::move(E); }
-  [[nodiscard]] const char *what() const noexcept override {
-    return "worker reported some error";
-  }
-};
-
 /// \brief Resolve definition by invoking nixpkgs provider.
 ///
 /// Useful for users inspecting nixpkgs packages. For example, someone clicks
@@ -176,31 +157,27 @@ public:
   NixpkgsDefinitionProvider(AttrSetClient &NixpkgsClient)
       : NixpkgsClient(NixpkgsClient) {}
 
-  Locations resolveSelector(const nixd::Selector &Sel) {
-    std::binary_semaphore Ready(0);
-    Expected<AttrPathInfoResponse> Desc = error("not replied");
-    auto OnReply = [&Ready, &Desc](llvm::Expected<AttrPathInfoResponse> Resp) {
-      if (Resp)
-        Desc = *Resp;
-      else
-        Desc = Resp.takeError();
-      Ready.release();
-    };
-    NixpkgsClient.attrpathInfo(Sel, std::move(OnReply));
-    Ready.acquire();
-
-    if (!Desc)
-      throw WorkerReportedException(Desc.takeError());
+  void resolveSelector(const nixd::Selector &Sel, LocationsCallback Then) {
+    auto OnReply = [Then = std::move(Then)](
+                       llvm::Expected<AttrPathInfoResponse> Desc) mutable {
+      if (!Desc) {
+        elog("definition/idiom/worker: {0}", Desc.takeError());
+        return Then({});
+      }
 
-    // Prioritize package location if it exists.
-    if (const std::optional<std::string> &Position = Desc->PackageDesc.Position)
-      return Locations{parseLocation(*Position)};
+      // Prioritize package location if it exists.
+      if (const std::optional<std::string> &Position =
+              Desc->PackageDesc.Position)
+        return Then(Locations{parseLocation(*Position)});
 
-    // Use the location in "ValueMeta".
-    if (const auto &Loc = Desc->Meta.Location)
-      return Locations{*Loc};
+      // Use the location in "ValueMeta".
+      if (const auto &Loc = Desc->Meta.Location)
+        return Then(Locations{*Loc});
 
-    throw NoLocationsFoundInNixpkgsException();
+      elog("definition/idiom: no locations found in nixpkgs");
+      Then({});
+    };
+    NixpkgsClient.attrpathInfo(Sel, std::move(OnReply));
   }
 };
 
@@ -211,26 +188,17 @@ class OptionsDefinitionProvider {
 public:
   OptionsDefinitionProvider(AttrSetClient &Client) : Client(Client) {}
   void resolveLocations(const std::vector<std::string> &Params,
-                        Locations &Locs) {
-    std::binary_semaphore Ready(0);
-    Expected<OptionInfoResponse> Info = error("not replied");
-    OptionCompleteResponse Names;
-    auto OnReply = [&Ready, &Info](llvm::Expected<OptionInfoResponse> Resp) {
-      Info = std::move(Resp);
-      Ready.release();
+                        LocationsCallback Then) {
+    auto OnReply = [Then = std::move(Then)](
+                       llvm::Expected<OptionInfoResponse> Info) mutable {
+      if (!Info) {
+        elog("getting locations: {0}", Info.takeError());
+        return Then({});
+      }
+      Then(std::move(Info->Declarations));
     };
     // Send request.
-
     Client.optionInfo(Params, std::move(OnReply));
-    Ready.acquire();
-
-    if (!Info) {
-      elog("getting locations: {0}", Info.takeError());
-      return;
-    }
-
-    for (const auto &Decl : Info->Declarations)
-      Locs.emplace_back(Decl);
   }
 };
 
@@ -255,60 +223,72 @@ std::optional<Location> definePath(const ExprPath &Path,
 
 /// \brief Get the locations of some attribute path.
 ///
-/// Usually this function will return a list of option declarations via RPC
-Locations defineAttrPath(const Node &N, const ParentMapAnalysis &PM,
-                         std::mutex &OptionsLock,
-                         Controller::OptionMapTy &Options) {
+/// Usually this function will return a list of option declarations via RPC.
+/// All option workers are asked at once, locations are ordered as workers.
+void defineAttrPath(const Node &N, const ParentMapAnalysis &PM,
+                    std::mutex &OptionsLock, Controller::OptionMapTy &Options,
+                    LocationsCallback Then) {
   using PathResult = FindAttrPathResult;
   std::vector<std::string> Scope;
   auto R = findAttrPathForOptions(N, PM, Scope);
-  Locations Locs;
-  if (R == PathResult::OK) {
-    std::lock_guard _(OptionsLock);
-    // For each option worker, try to get it's decl position.
-    for (const auto &[_, Client] : Options) {
-      if (AttrSetClient *C = Client->client()) {
-        OptionsDefinitionProvider ODP(*C);
-        ODP.resolveLocations(Scope, Locs);
-      }
+  if (R != PathResult::OK)
+    return Then({});
+
+  std::lock_guard _(OptionsLock);
+  auto J = Join<std::vector<Locations>>::create(
+      std::vector<Locations>(Options.size()),
+      [Then = std::move(Then)](std::vector<Locations> Slots) mutable {
+        Locations Locs;
+        for (Locations &L : Slots)
+          std::move(L.begin(), L.end(), std::back_inserter(Locs));
+        Then(std::move(Locs));
+      });
+  // For each option worker, try to get it's decl position.
+  std::size_t Slot = 0;
+  for (const auto &[_, Client] : Options) {
+    if (std::shared_ptr<AttrSetClient> C = Client->client()) {
+      J->add();
+      OptionsDefinitionProvider ODP(*C);
+      ODP.resolveLocations(Scope, [J, Slot](Locations Locs) {
+        J->update([&](std::vector<Locations> &Slots) {
+          Slots[Slot] = std::move(Locs);
+        });
+        J->done();
+      });
     }
+    ++Slot;
   }
-  return Locs;
+  J->done();
 }
 
 /// \brief Get nixpkgs definition from a selector.
-Locations defineNixpkgsSelector(const Selector &Sel,
-                                AttrSetClient &NixpkgsClient) {
-  try {
-    // Ask nixpkgs provider information about this selector.
-    NixpkgsDefinitionProvider NDP(NixpkgsClient);
-    return NDP.resolveSelector(Sel);
-  } catch (NoLocationsFoundInNixpkgsException &E) {
-    elog("definition/idiom: {0}", E.what());
-  } catch (WorkerReportedException &E) {
-    elog("definition/idiom/worker: {0}", E.takeError());
-  }
-  return {};
+void defineNixpkgsSelector(const Selector &Sel, AttrSetClient &NixpkgsClient,
+                           LocationsCallback Then) {
+  // Ask nixpkgs provider information about this selector.
+  NixpkgsDefinitionProvider NDP(NixpkgsClient);
+  NDP.resolveSelector(Sel, std::move(Then));
 }
 
 /// \brief Get definiton of select expressions.
-Locations defineSelect(const ExprSelect &Sel, const VariableLookupAnalysis &VLA,
-                       const ParentMapAnalysis &PM,
-                       AttrSetClient &NixpkgsClient) {
+void defineSelect(const ExprSelect &Sel, const VariableLookupAnalysis &VLA,
+                  const ParentMapAnalysis &PM, AttrSetClient &NixpkgsClient,
+                  LocationsCallback Then) {
   // Currently we can only deal with idioms.
   // Maybe more data-flow analysis will be added though.
+  Selector S;
   try {
-    return defineNixpkgsSelector(mkSelector(Sel, VLA, PM), NixpkgsClient);
+    S = mkSelector(Sel, VLA, PM);
   } catch (IdiomSelectorException &E) {
     elog("defintion/idiom/selector: {0}", E.what());
+    return Then({});
   }
-  return {};
+  defineNixpkgsSelector(S, NixpkgsClient, std::move(Then));
 }
 
 Locations defineVarStatic(const ExprVar &Var, const VariableLookupAnalysis &VLA,
-                          const URIForFile &URI, llvm::StringRef Src) {
+                          const URIForFile &URI, const LineTable &Lines) {
   const Definition &Def = findVarDefinition(Var, VLA);
-  return {convertToLocation(Src, Def, URI)};
+  return {convertToLocation(Lines, Def, URI)};
 }
 
 template <class T>
@@ -317,27 +297,34 @@ std::vector<T> mergeVec(std::vector<T> A, const std::vector<T> &B) {
   return A;
 }
 
-llvm::Expected<Locations>
-defineVar(const ExprVar &Var, const VariableLookupAnalysis &VLA,
-          const ParentMapAnalysis &PM, AttrSetClient &NixpkgsClient,
-          const URIForFile &URI, llvm::StringRef Src) {
+void defineVar(const ExprVar &Var, const VariableLookupAnalysis &VLA,
+               const ParentMapAnalysis &PM, AttrSetClient *NixpkgsClient,
+               const URIForFile &URI, const LineTable &Lines,
+               LocationsCallback Then) {
+  Locations StaticLocs;
   try {
-    Locations StaticLocs = defineVarStatic(Var, VLA, URI, Src);
-
-    // Nixpkgs locations.
-    try {
-      Selector Sel = mkVarSelector(Var, VLA, PM);
-      Locations NixpkgsLocs = defineNixpkgsSelector(Sel, NixpkgsClient);
-      return mergeVec(std::move(StaticLocs), NixpkgsLocs);
-    } catch (std::exception &E) {
-      elog("definition/idiom/selector: {0}", E.what());
-      return StaticLocs;
-    }
+    StaticLocs = defineVarStatic(Var, VLA, URI, Lines);
   } catch (std::exception &E) {
     elog("definition/static: {0}", E.what());
-    return Locations{};
+    return Then({});
+  }
+
+  // Nixpkgs locations.
+  if (!NixpkgsClient)
+    return Then(std::move(StaticLocs));
+  Selector Sel;
+  try {
+    Sel = mkVarSelector(Var, VLA, PM);
+  } catch (std::exception &E) {
+    elog("definition/idiom/selector: {0}", E.what());
+    return Then(std::move(StaticLocs));
   }
-  return error("unreachable code! Please submit an issue");
+  defineNixpkgsSelector(
+      Sel, *NixpkgsClient,
+      [StaticLocs = std::move(StaticLocs),
+       Then = std::move(Then)](Locations NixpkgsLocs) mutable {
+        Then(mergeVec(std::move(StaticLocs), NixpkgsLocs));
+      });
 }
 
 /// \brief Squash a vector into smaller json variant.
@@ -354,13 +341,6 @@ template <class T> llvm::json::Value squash(std::vector<T> List) {
   return std::move(List);
 }
 
-template <class T>
-llvm::Expected<llvm::json::Value> squash(llvm::Expected<std::vector<T>> List) {
-  if (!List)
-    return List.takeError();
-  return squash(std::move(*List));
-}
-
 } // namespace
 
 const Definition &nixd::findDefinition(const Node &N,
@@ -378,44 +358,61 @@ const Definition &nixd::findDefinition(const Node &N,
 
 void Controller::onDefinition(const TextDocumentPositionParams &Params,
                               Callback<llvm::json::Value> Reply) {
-  using CheckTy = Locations;
   auto Action = [Reply = std::move(Reply), URI = Params.textDocument.uri,
-                 Pos = toNixfPosition(Params.position), this]() mutable {
+                 Pos = toNixfPosition(Params.position),
+                 Token = CancellationToken::current(), this]() mutable {
+    if (Token.isCancelled())
+      return Reply(cancelledError(Token));
+    WithCancellation _(Token);
+
     const auto File = URI.file().str();
-    return Reply(squash([&]() -> llvm::Expected<Locations> {
-      const auto TU = CheckDefault(getTU(File));
-      const auto AST = CheckDefault(getAST(*TU));
-      const auto &VLA = *TU->variableLookup();
-      const auto &PM = *TU->parentMap();
-      const auto &N = *CheckDefault(AST->descend({Pos, Pos}));
-      const auto &UpExpr = *CheckDefault(PM.upExpr(N));
-
-      // Special case for inherited names.
-      if (const ExprVar *Var = findInheritVar(N, PM, VLA))
-        return defineVar(*Var, VLA, PM, *nixpkgsClient(), URI, TU->src());
-
-      switch (UpExpr.kind()) {
-      case Node::NK_ExprVar: {
-        const auto &Var = static_cast<const ExprVar &>(UpExpr);
-        return defineVar(Var, VLA, PM, *nixpkgsClient(), URI, TU->src());
-      }
-      case Node::NK_ExprSelect: {
-        const auto &Sel = static_cast<const ExprSelect &>(UpExpr);
-        return defineSelect(Sel, VLA, PM, *nixpkgsClient());
-      }
-      case Node::NK_ExprAttrs:
-        return defineAttrPath(N, PM, OptionsLock, Options);
-      case Node::NK_ExprPath: {
-        const auto &Path = static_cast<const ExprPath &>(UpExpr);
-        if (auto Loc = definePath(Path, File))
-          return Locations{*Loc};
-        return Locations{};
-      }
-      default:
-        break;
-      }
-      return error("unknown node type for definition");
-    }()));
+    const auto TU = getTU(File);
+    const auto AST = TU ? getAST(*TU) : nullptr;
+    const Node *Desc = AST ? TU->descend({Pos, Pos}) : nullptr;
+    const Node *UpExpr = Desc ? TU->parentMap()->upExpr(*Desc) : nullptr;
+    if (!UpExpr)
+      return Reply(squash(Locations{}));
+
+    const auto &VLA = *TU->variableLookup();
+    const auto &PM = *TU->parentMap();
+    const auto &N = *Desc;
+
+    std::shared_ptr<AttrSetClient> Nixpkgs = nixpkgsClient();
+    auto ReplyLocations = [&]() -> LocationsCallback {
+      return [Reply = std::move(Reply)](Locations Locs) mutable {
+        Reply(squash(std::move(Locs)));
+      };
+    };
+
+    // Special case for inherited names.
+    if (const ExprVar *Var = findInheritVar(N, PM, VLA))
+      return defineVar(*Var, VLA, PM, Nixpkgs.get(), URI, TU->lines(),
+                       ReplyLocations());
+
+    switch (UpExpr->kind()) {
+    case Node::NK_ExprVar: {
+      const auto &Var = static_cast<const ExprVar &>(*UpExpr);
+      return defineVar(Var, VLA, PM, Nixpkgs.get(), URI, TU->lines(),
+                       ReplyLocations());
+    }
+    case Node::NK_ExprSelect: {
+      const auto &Sel = static_cast<const ExprSelect &>(*UpExpr);
+      if (!Nixpkgs)
+        return Reply(squash(Locations{}));
+      return defineSelect(Sel, VLA, PM, *Nixpkgs, ReplyLocations());
+    }
+    case Node::NK_ExprAttrs:
+      return defineAttrPath(N, PM, OptionsLock, Options, ReplyLocations());
+    case Node::NK_ExprPath: {
+      const auto &Path = static_cast<const ExprPath &>(*UpExpr);
+      if (auto Loc = definePath(Path, File))
+        return Reply(squash(Locations{*Loc}));
+      return Reply(squash(Locations{}));
+    }
+    default:
+      break;
+    }
+    Reply(error("unknown node type for definition"));
   };
-  boost::asio::post(Pool, std::move(Action));
+  schedule(Priority::Interactive, std::move(Action));
 }
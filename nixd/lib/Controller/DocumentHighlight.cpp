@@ -9,7 +9,7 @@
 
 #include "nixd/Controller/Controller.h"
 
-#include <boost/asio/post.hpp>
+#include <lspserver/Cancellation.h>
 #include <lspserver/Protocol.h>
 #include <nixf/Sema/ParentMap.h>
 #include <nixf/Sema/VariableLookup.h>
@@ -27,7 +27,7 @@ std::vector<DocumentHighlight> highlight(const nixf::Node &Desc,
                                          const ParentMapAnalysis &PMA,
                                          const VariableLookupAnalysis &VLA,
                                          const URIForFile &URI,
-                                         llvm::StringRef Src) {
+                                         const LineTable &Lines) {
   // Find "definition"
   auto Def = findDefinition(Desc, PMA, VLA);
 
@@ -36,14 +36,14 @@ std::vector<DocumentHighlight> highlight(const nixf::Node &Desc,
   for (const auto *Use : Def.uses()) {
     assert(Use);
     Highlights.emplace_back(DocumentHighlight{
-        .range = toLSPRange(Src, Use->range()),
+        .range = toLSPRange(Lines, Use->range()),
         .kind = DocumentHighlightKind::Read,
     });
   }
   if (Def.syntax()) {
     const Node &Syntax = *Def.syntax();
     Highlights.emplace_back(DocumentHighlight{
-        .range = toLSPRange(Src, Syntax.range()),
+        .range = toLSPRange(Lines, Syntax.range()),
         .kind = DocumentHighlightKind::Write,
     });
   }
@@ -58,22 +58,29 @@ void Controller::onDocumentHighlight(
     Callback<std::vector<DocumentHighlight>> Reply) {
   using CheckTy = std::vector<DocumentHighlight>;
   auto Action = [Reply = std::move(Reply), URI = Params.textDocument.uri,
-                 Pos = toNixfPosition(Params.position), this]() mutable {
+                 Pos = toNixfPosition(Params.position),
+                 Token = CancellationToken::current(), this]() mutable {
+    if (Token.isCancelled())
+      return Reply(cancelledError(Token));
     std::string File(URI.file());
     return Reply([&]() -> llvm::Expected<CheckTy> {
       const auto TU = CheckDefault(getTU(File));
       const auto AST = CheckDefault(getAST(*TU));
 
-      const auto &Desc = *CheckDefault(AST->descend({Pos, Pos}));
+      const auto &Desc = *CheckDefault(TU->descend({Pos, Pos}));
       try {
         const auto &PM = *TU->parentMap();
         const auto &VLA = *TU->variableLookup();
-        return highlight(Desc, PM, VLA, URI, TU->src());
+        return highlight(Desc, PM, VLA, URI, TU->lines());
       } catch (std::exception &E) {
         elog("textDocument/documentHighlight failed: {0}", E.what());
         return CheckTy{};
       }
     }());
   };
-  boost::asio::post(Pool, std::move(Action));
+  // Highlights follow the cursor.
+  schedule(Priority::Interactive,
+           ("textDocument/documentHighlight:" + Params.textDocument.uri.file())
+               .str(),
+           CancellationToken::current(), std::move(Action));
 }
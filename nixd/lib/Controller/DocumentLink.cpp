@@ -21,7 +21,7 @@
 
 #include "nixd/Controller/Controller.h"
 
-#include <boost/asio/post.hpp>
+#include <nixf/Basic/RecursiveASTVisitor.h>
 
 using namespace nixd;
 using namespace lspserver;
@@ -29,34 +29,31 @@ using namespace nixf;
 
 namespace {
 
-void dfs(const Node *N, const std::string &BasePath,
-         std::vector<DocumentLink> &Links, llvm::StringRef Src) {
-  if (!N)
-    return;
+class DocumentLinkCollector
+    : public RecursiveASTVisitor<DocumentLinkCollector> {
+  const std::string &BasePath;
+  std::vector<DocumentLink> &Links;
+  const LineTable &Lines;
 
-  switch (N->kind()) {
-  case Node::NK_ExprPath: {
+public:
+  DocumentLinkCollector(const std::string &BasePath,
+                        std::vector<DocumentLink> &Links,
+                        const LineTable &Lines)
+      : BasePath(BasePath), Links(Links), Lines(Lines) {}
+
+  bool visit(const ExprPath &Path) {
     // Resolve the path.
-    const auto &Path = static_cast<const ExprPath &>(*N);
     if (Path.parts().isLiteral()) {
       // Provide literal path linking.
       if (auto Link = resolveExprPath(BasePath, Path.parts().literal())) {
         Links.emplace_back(
-            DocumentLink{.range = toLSPRange(Src, N->range()),
+            DocumentLink{.range = toLSPRange(Lines, Path.range()),
                          .target = URIForFile::canonicalize(*Link, *Link)});
       }
     }
-    return;
-  }
-  default:
-    break;
+    return false;
   }
-
-  // Traverse on all children
-  for (const Node *Ch : N->children()) {
-    dfs(Ch, BasePath, Links, Src);
-  }
-}
+};
 
 } // namespace
 
@@ -72,9 +69,10 @@ void Controller::onDocumentLink(
 
       // Traverse the AST, provide the links
       std::vector<DocumentLink> Links;
-      dfs(AST.get(), File, Links, TU->src());
+      DocumentLinkCollector(File, Links, TU->lines())
+          .traverseIteratively(AST.get());
       return Links;
     }());
   };
-  boost::asio::post(Pool, std::move(Action));
+  schedule(Priority::Normal, std::move(Action));
 }
@@ -8,11 +8,11 @@
 
 #include "nixd/Controller/Controller.h"
 
-#include <boost/asio/post.hpp>
 #include <llvm/ADT/StringRef.h>
 #include <lspserver/Protocol.h>
 #include <nixf/Basic/Nodes/Attrs.h>
 #include <nixf/Basic/Nodes/Lambda.h>
+#include <nixf/Basic/RecursiveASTVisitor.h>
 #include <nixf/Sema/VariableLookup.h>
 
 #include <string>
@@ -29,24 +29,24 @@ std::string getLambdaName(const ExprLambda &Lambda) {
   return Lambda.arg()->id()->name();
 }
 
-lspserver::Range getLambdaSelectionRage(llvm::StringRef Src,
+lspserver::Range getLambdaSelectionRage(const LineTable &Lines,
                                         const ExprLambda &Lambda) {
   if (!Lambda.arg()) {
-    return toLSPRange(Src, Lambda.range());
+    return toLSPRange(Lines, Lambda.range());
   }
 
   if (!Lambda.arg()->id()) {
     assert(Lambda.arg()->formals());
-    return toLSPRange(Src, Lambda.arg()->formals()->range());
+    return toLSPRange(Lines, Lambda.arg()->formals()->range());
   }
-  return toLSPRange(Src, Lambda.arg()->id()->range());
+  return toLSPRange(Lines, Lambda.arg()->id()->range());
 }
 
-lspserver::Range getAttrRange(llvm::StringRef Src, const Attribute &Attr) {
-  auto LCur = toLSPPosition(Src, Attr.key().lCur());
+lspserver::Range getAttrRange(const LineTable &Lines, const Attribute &Attr) {
+  auto LCur = toLSPPosition(Lines, Attr.key().lCur());
   if (Attr.value())
-    return {LCur, toLSPPosition(Src, Attr.value()->rCur())};
-  return {LCur, toLSPPosition(Src, Attr.key().rCur())};
+    return {LCur, toLSPPosition(Lines, Attr.value()->rCur())};
+  return {LCur, toLSPPosition(Lines, Attr.key().rCur())};
 }
 
 /// Make variable's entry rich.
@@ -81,7 +81,7 @@ void richVar(const ExprVar &Var, DocumentSymbol &Sym,
 
 /// Collect document symbol on AST.
 void collect(const Node *AST, std::vector<DocumentSymbol> &Symbols,
-             const VariableLookupAnalysis &VLA, llvm::StringRef Src) {
+             const VariableLookupAnalysis &VLA, const LineTable &Lines) {
   if (!AST)
     return;
   switch (AST->kind()) {
@@ -93,8 +93,8 @@ void collect(const Node *AST, std::vector<DocumentSymbol> &Symbols,
         .detail = "string",
         .kind = SymbolKind::String,
         .deprecated = false,
-        .range = toLSPRange(Src, Str.range()),
-        .selectionRange = toLSPRange(Src, Str.range()),
+        .range = toLSPRange(Lines, Str.range()),
+        .selectionRange = toLSPRange(Lines, Str.range()),
         .children = {},
     };
     Symbols.emplace_back(std::move(Sym));
@@ -107,8 +107,8 @@ void collect(const Node *AST, std::vector<DocumentSymbol> &Symbols,
         .detail = "integer",
         .kind = SymbolKind::Number,
         .deprecated = false,
-        .range = toLSPRange(Src, Int.range()),
-        .selectionRange = toLSPRange(Src, Int.range()),
+        .range = toLSPRange(Lines, Int.range()),
+        .selectionRange = toLSPRange(Lines, Int.range()),
         .children = {},
     };
     Symbols.emplace_back(std::move(Sym));
@@ -121,8 +121,8 @@ void collect(const Node *AST, std::vector<DocumentSymbol> &Symbols,
         .detail = "float",
         .kind = SymbolKind::Number,
         .deprecated = false,
-        .range = toLSPRange(Src, Float.range()),
-        .selectionRange = toLSPRange(Src, Float.range()),
+        .range = toLSPRange(Lines, Float.range()),
+        .selectionRange = toLSPRange(Lines, Float.range()),
         .children = {},
     };
     Symbols.emplace_back(std::move(Sym));
@@ -135,8 +135,8 @@ void collect(const Node *AST, std::vector<DocumentSymbol> &Symbols,
         .detail = "attribute name",
         .kind = SymbolKind::Property,
         .deprecated = false,
-        .range = toLSPRange(Src, AN.range()),
-        .selectionRange = toLSPRange(Src, AN.range()),
+        .range = toLSPRange(Lines, AN.range()),
+        .selectionRange = toLSPRange(Lines, AN.range()),
         .children = {},
     };
     Symbols.emplace_back(std::move(Sym));
@@ -149,8 +149,8 @@ void collect(const Node *AST, std::vector<DocumentSymbol> &Symbols,
         .detail = "identifier",
         .kind = SymbolKind::Variable,
         .deprecated = false,
-        .range = toLSPRange(Src, Var.range()),
-        .selectionRange = toLSPRange(Src, Var.range()),
+        .range = toLSPRange(Lines, Var.range()),
+        .selectionRange = toLSPRange(Lines, Var.range()),
         .children = {},
     };
     richVar(Var, Sym, VLA);
@@ -160,14 +160,14 @@ void collect(const Node *AST, std::vector<DocumentSymbol> &Symbols,
   case Node::NK_ExprLambda: {
     std::vector<DocumentSymbol> Children;
     const auto &Lambda = static_cast<const ExprLambda &>(*AST);
-    collect(Lambda.body(), Children, VLA, Src);
+    collect(Lambda.body(), Children, VLA, Lines);
     DocumentSymbol Sym{
         .name = getLambdaName(Lambda),
         .detail = "lambda",
         .kind = SymbolKind::Function,
         .deprecated = false,
-        .range = toLSPRange(Src, Lambda.range()),
-        .selectionRange = getLambdaSelectionRage(Src, Lambda),
+        .range = toLSPRange(Lines, Lambda.range()),
+        .selectionRange = getLambdaSelectionRage(Lines, Lambda),
         .children = std::move(Children),
     };
     Symbols.emplace_back(std::move(Sym));
@@ -176,16 +176,16 @@ void collect(const Node *AST, std::vector<DocumentSymbol> &Symbols,
   case Node::NK_ExprList: {
     std::vector<DocumentSymbol> Children;
     const auto &List = static_cast<const ExprList &>(*AST);
-    for (const Node *Ch : AST->children())
-      collect(Ch, Children, VLA, Src);
+    forEachChild(*AST,
+                 [&](const Node *Ch) { collect(Ch, Children, VLA, Lines); });
 
     DocumentSymbol Sym{
         .name = "{anonymous}",
         .detail = "list",
         .kind = SymbolKind::Array,
         .deprecated = false,
-        .range = toLSPRange(Src, List.range()),
-        .selectionRange = toLSPRange(Src, List.range()),
+        .range = toLSPRange(Lines, List.range()),
+        .selectionRange = toLSPRange(Lines, List.range()),
         .children = std::move(Children),
     };
     Symbols.emplace_back(std::move(Sym));
@@ -197,28 +197,28 @@ void collect(const Node *AST, std::vector<DocumentSymbol> &Symbols,
       if (!Attr.value())
         continue;
       std::vector<DocumentSymbol> Children;
-      collect(Attr.value(), Children, VLA, Src);
+      collect(Attr.value(), Children, VLA, Lines);
       DocumentSymbol Sym{
           .name = Name,
           .detail = "attribute",
           .kind = SymbolKind::Field,
           .deprecated = false,
-          .range = getAttrRange(Src, Attr),
-          .selectionRange = toLSPRange(Src, Attr.key().range()),
+          .range = getAttrRange(Lines, Attr),
+          .selectionRange = toLSPRange(Lines, Attr.key().range()),
           .children = std::move(Children),
       };
       Symbols.emplace_back(std::move(Sym));
     }
     for (const nixf::Attribute &Attr : SA.dynamicAttrs()) {
       std::vector<DocumentSymbol> Children;
-      collect(Attr.value(), Children, VLA, Src);
+      collect(Attr.value(), Children, VLA, Lines);
       DocumentSymbol Sym{
           .name = "${dynamic attribute}",
           .detail = "attribute",
           .kind = SymbolKind::Field,
           .deprecated = false,
-          .range = getAttrRange(Src, Attr),
-          .selectionRange = toLSPRange(Src, Attr.key().range()),
+          .range = getAttrRange(Lines, Attr),
+          .selectionRange = toLSPRange(Lines, Attr.key().range()),
           .children = std::move(Children),
       };
       Symbols.emplace_back(std::move(Sym));
@@ -227,8 +227,8 @@ void collect(const Node *AST, std::vector<DocumentSymbol> &Symbols,
   }
   default:
     // Trivial dispatch. Treat these symbol as same as this level.
-    for (const Node *Ch : AST->children())
-      collect(Ch, Symbols, VLA, Src);
+    forEachChild(*AST,
+                 [&](const Node *Ch) { collect(Ch, Symbols, VLA, Lines); });
     break;
   }
 }
@@ -244,9 +244,9 @@ void Controller::onDocumentSymbol(const DocumentSymbolParams &Params,
       const auto TU = CheckDefault(getTU(URI.file().str()));
       const auto AST = CheckDefault(getAST(*TU));
       auto Symbols = std::vector<DocumentSymbol>();
-      collect(AST.get(), Symbols, *TU->variableLookup(), TU->src());
+      collect(AST.get(), Symbols, *TU->variableLookup(), TU->lines());
       return Symbols;
     }());
   };
-  boost::asio::post(Pool, std::move(Action));
+  schedule(Priority::Normal, std::move(Action));
 }
@@ -9,7 +9,6 @@
 
 #include "nixd/Controller/Controller.h"
 
-#include <boost/asio/post.hpp>
 #include <lspserver/Protocol.h>
 #include <nixf/Sema/ParentMap.h>
 #include <nixf/Sema/VariableLookup.h>
@@ -25,7 +24,7 @@ std::vector<Location> findReferences(const nixf::Node &Desc,
                                      const ParentMapAnalysis &PMA,
                                      const VariableLookupAnalysis &VLA,
                                      const URIForFile &URI,
-                                     llvm::StringRef Src) {
+                                     const LineTable &Lines) {
 
   // Two steps.
   //   1. Find some "definition" for this node.
@@ -39,7 +38,7 @@ std::vector<Location> findReferences(const nixf::Node &Desc,
     assert(Use);
     Locations.emplace_back(Location{
         .uri = URI,
-        .range = toLSPRange(Src, Use->range()),
+        .range = toLSPRange(Lines, Use->range()),
     });
   }
   return Locations;
@@ -56,15 +55,15 @@ void Controller::onReferences(const TextDocumentPositionParams &Params,
     return Reply([&]() -> llvm::Expected<CheckTy> {
       const auto TU = CheckDefault(getTU(File));
       const auto AST = CheckDefault(getAST(*TU));
-      const auto &Desc = CheckDefault(AST->descend({Pos, Pos}));
+      const auto &Desc = CheckDefault(TU->descend({Pos, Pos}));
       const auto &PM = *TU->parentMap();
       const auto &VLA = *TU->variableLookup();
       try {
-        return findReferences(*Desc, PM, VLA, URI, TU->src());
+        return findReferences(*Desc, PM, VLA, URI, TU->lines());
       } catch (std::exception &E) {
         return error("references: {0}", E.what());
       }
     }());
   };
-  boost::asio::post(Pool, std::move(Action));
+  schedule(Priority::Normal, std::move(Action));
 }
@@ -8,13 +8,13 @@
 
 #include "nixd/Controller/Controller.h"
 
-#include <boost/asio/post.hpp>
 #include <lspserver/Logger.h>
 #include <lspserver/Protocol.h>
 #include <nixf/Basic/Nodes/Attrs.h>
 #include <nixf/Basic/Nodes/Expr.h>
 #include <nixf/Basic/Nodes/Lambda.h>
 #include <nixf/Basic/Nodes/Simple.h>
+#include <nixf/Basic/RecursiveASTVisitor.h>
 
 using namespace nixd;
 using namespace lspserver;
@@ -22,9 +22,6 @@ using namespace nixf;
 
 namespace {
 
-/// Maximum recursion depth to prevent stack overflow on deeply nested ASTs.
-constexpr size_t MaxRecursionDepth = 256;
-
 /// Check if the range spans multiple lines (2+ lines required for folding).
 bool isMultiLine(const lspserver::Range &R) {
   return R.start.line < R.end.line;
@@ -43,85 +40,64 @@ FoldingRange toFoldingRange(const lspserver::Range &R) {
 
 /// Add a folding range if the node spans multiple lines.
 void addFoldingRange(const Node &N, std::vector<FoldingRange> &Ranges,
-                     llvm::StringRef Src) {
-  auto R = toLSPRange(Src, N.range());
+                     const LineTable &Lines) {
+  auto R = toLSPRange(Lines, N.range());
   if (isMultiLine(R))
     Ranges.emplace_back(toFoldingRange(R));
 }
 
-/// Collect folding ranges from AST nodes recursively.
-/// \param AST The AST node to process
-/// \param Ranges Output vector to collect folding ranges
-/// \param Src Source text for position conversion
-/// \param Depth Current recursion depth (for stack overflow protection)
-void collectFoldingRanges(const Node *AST, std::vector<FoldingRange> &Ranges,
-                          llvm::StringRef Src, size_t Depth = 0) {
-  if (!AST || Depth >= MaxRecursionDepth)
-    return;
-
-  switch (AST->kind()) {
-  case Node::NK_ExprAttrs: {
-    addFoldingRange(*AST, Ranges, Src);
-    const auto &Attrs = static_cast<const ExprAttrs &>(*AST);
-    if (Attrs.binds()) {
-      for (const Node *Ch : Attrs.binds()->children())
-        collectFoldingRanges(Ch, Ranges, Src, Depth + 1);
-    }
-    break;
+/// Collect folding ranges from AST nodes.
+///
+/// Pending nodes are kept in a vector, so deeply nested ASTs do not overflow
+/// the stack.
+class FoldingRangeCollector
+    : public RecursiveASTVisitor<FoldingRangeCollector> {
+  std::vector<FoldingRange> &Ranges;
+  const LineTable &Lines;
+
+public:
+  FoldingRangeCollector(std::vector<FoldingRange> &Ranges,
+                        const LineTable &Lines)
+      : Ranges(Ranges), Lines(Lines) {}
+
+  bool visit(const ExprAttrs &Attrs) {
+    addFoldingRange(Attrs, Ranges, Lines);
+    return true;
   }
-  case Node::NK_ExprList: {
-    addFoldingRange(*AST, Ranges, Src);
-    for (const Node *Ch : AST->children())
-      collectFoldingRanges(Ch, Ranges, Src, Depth + 1);
-    break;
+
+  bool visit(const ExprList &List) {
+    addFoldingRange(List, Ranges, Lines);
+    return true;
   }
-  case Node::NK_ExprLambda: {
-    addFoldingRange(*AST, Ranges, Src);
-    const auto &Lambda = static_cast<const ExprLambda &>(*AST);
-    if (const auto *Body = Lambda.body())
-      collectFoldingRanges(Body, Ranges, Src, Depth + 1);
-    break;
+
+  bool visit(const ExprLambda &Lambda) {
+    addFoldingRange(Lambda, Ranges, Lines);
+    // Formals are not folded.
+    traverse(Lambda.body());
+    return false;
   }
-  case Node::NK_ExprLet: {
-    addFoldingRange(*AST, Ranges, Src);
-    const auto &Let = static_cast<const ExprLet &>(*AST);
-    if (const auto *Attrs = Let.attrs())
-      collectFoldingRanges(Attrs, Ranges, Src, Depth + 1);
-    if (const auto *E = Let.expr())
-      collectFoldingRanges(E, Ranges, Src, Depth + 1);
-    break;
+
+  bool visit(const ExprLet &Let) {
+    addFoldingRange(Let, Ranges, Lines);
+    return true;
   }
-  case Node::NK_ExprWith: {
-    addFoldingRange(*AST, Ranges, Src);
-    const auto &With = static_cast<const ExprWith &>(*AST);
-    if (const auto *W = With.with())
-      collectFoldingRanges(W, Ranges, Src, Depth + 1);
-    if (const auto *E = With.expr())
-      collectFoldingRanges(E, Ranges, Src, Depth + 1);
-    break;
+
+  bool visit(const ExprWith &With) {
+    addFoldingRange(With, Ranges, Lines);
+    return true;
   }
-  case Node::NK_ExprIf: {
-    addFoldingRange(*AST, Ranges, Src);
-    const auto &If = static_cast<const ExprIf &>(*AST);
-    if (const auto *Cond = If.cond())
-      collectFoldingRanges(Cond, Ranges, Src, Depth + 1);
-    if (const auto *Then = If.then())
-      collectFoldingRanges(Then, Ranges, Src, Depth + 1);
-    if (const auto *Else = If.elseExpr())
-      collectFoldingRanges(Else, Ranges, Src, Depth + 1);
-    break;
+
+  bool visit(const ExprIf &If) {
+    addFoldingRange(If, Ranges, Lines);
+    return true;
   }
-  case Node::NK_ExprString:
+
+  bool visit(const ExprString &Str) {
     // Multiline strings are foldable regions
-    addFoldingRange(*AST, Ranges, Src);
-    break;
-  default:
-    // Other node types may contain foldable children, recurse into them
-    for (const Node *Ch : AST->children())
-      collectFoldingRanges(Ch, Ranges, Src, Depth + 1);
-    break;
+    addFoldingRange(Str, Ranges, Lines);
+    return false;
   }
-}
+};
 
 } // namespace
 
@@ -142,7 +118,8 @@ void Controller::onFoldingRange(const FoldingRangeParams &Params,
       const auto AST = CheckDefault(getAST(*TU));
       try {
         auto Ranges = std::vector<FoldingRange>();
-        collectFoldingRanges(AST.get(), Ranges, TU->src());
+        FoldingRangeCollector(Ranges, TU->lines())
+            .traverseIteratively(AST.get());
         return Ranges;
       } catch (std::exception &E) {
         elog("textDocument/foldingRange failed: {0}", E.what());
@@ -150,5 +127,5 @@ void Controller::onFoldingRange(const FoldingRangeParams &Params,
       }
     }());
   };
-  boost::asio::post(Pool, std::move(Action));
+  schedule(Priority::Normal, std::move(Action));
 }
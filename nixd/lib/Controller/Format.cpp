@@ -9,7 +9,6 @@
 #include "nixd/Controller/Controller.h"
 #include "nixd/Support/ForkPiped.h"
 
-#include <boost/asio/post.hpp>
 #include <sys/wait.h>
 
 using namespace nixd;
@@ -19,7 +18,9 @@ void Controller::onFormat(const DocumentFormattingParams &Params,
                           Callback<std::vector<TextEdit>> Reply) {
   auto Action = [this, Params, Reply = std::move(Reply)]() mutable {
     lspserver::PathRef File = Params.textDocument.uri.file();
-    const std::string &Code = *Store.getDraft(File)->Contents;
+    std::shared_ptr<const std::string> Draft =
+        Store.getDraft(File)->Contents.str();
+    const std::string &Code = *Draft;
     // Invokes another process and then read it's stdout.
     std::vector<std::string> FormatCommand;
     {
@@ -98,5 +99,5 @@ void Controller::onFormat(const DocumentFormattingParams &Params,
     Reply(std::vector{E});
   };
 
-  boost::asio::post(Pool, std::move(Action));
+  schedule(Priority::Normal, std::move(Action));
 }
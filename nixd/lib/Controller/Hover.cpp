@@ -4,17 +4,16 @@
 /// https://microsoft.github.io/language-server-protocol/specifications/lsp/3.17/specification/#textDocument_hover
 
 #include "AST.h"
-#include "CheckReturn.h"
 #include "Convert.h"
+#include "Join.h"
+
+#include "lspserver/Cancellation.h"
 
 #include "nixd/Controller/Controller.h"
 #include "nixd/Protocol/AttrSet.h"
 
-#include <boost/asio/post.hpp>
-
 #include <llvm/Support/Error.h>
 
-#include <semaphore>
 #include <sstream>
 
 using namespace nixd;
@@ -29,22 +28,19 @@ class OptionsHoverProvider {
 
 public:
   OptionsHoverProvider(AttrSetClient &Client) : Client(Client) {}
-  std::optional<OptionDescription>
-  resolveHover(const std::vector<std::string> &Scope) {
-    std::binary_semaphore Ready(0);
-    std::optional<OptionDescription> Desc;
-    auto OnReply = [&Ready, &Desc](llvm::Expected<OptionInfoResponse> Resp) {
-      if (Resp)
-        Desc = *Resp;
-      else
+  void resolveHover(
+      const std::vector<std::string> &Scope,
+      llvm::unique_function<void(std::optional<OptionDescription>)> Then) {
+    auto OnReply = [Then = std::move(Then)](
+                       llvm::Expected<OptionInfoResponse> Resp) mutable {
+      if (!Resp) {
         elog("options hover: {0}", Resp.takeError());
-      Ready.release();
+        return Then(std::nullopt);
+      }
+      Then(std::move(*Resp));
     };
 
     Client.optionInfo(Scope, std::move(OnReply));
-    Ready.acquire();
-
-    return Desc;
   }
 };
 
@@ -122,164 +118,188 @@ public:
   NixpkgsHoverProvider(AttrSetClient &NixpkgsClient)
       : NixpkgsClient(NixpkgsClient) {}
 
-  std::optional<std::string> resolveSelector(const nixd::Selector &Sel) {
-    std::binary_semaphore Ready(0);
-    std::optional<AttrPathInfoResponse> Info;
-    auto OnReply = [&Ready, &Info](llvm::Expected<AttrPathInfoResponse> Resp) {
-      if (Resp)
-        Info = *Resp;
-      else
+  void resolveSelector(
+      const nixd::Selector &Sel,
+      llvm::unique_function<void(std::optional<std::string>)> Then) {
+    auto OnReply = [Then = std::move(Then)](
+                       llvm::Expected<AttrPathInfoResponse> Resp) mutable {
+      if (!Resp) {
         elog("nixpkgs provider: {0}", Resp.takeError());
-      Ready.release();
-    };
-    NixpkgsClient.attrpathInfo(Sel, std::move(OnReply));
-    Ready.acquire();
-
-    if (!Info)
-      return std::nullopt;
+        return Then(std::nullopt);
+      }
 
-    auto Md = mkMarkdown(*Info);
-    if (Md.empty())
-      return std::nullopt;
+      auto Md = mkMarkdown(*Resp);
+      if (Md.empty())
+        return Then(std::nullopt);
 
-    return Md;
+      Then(std::move(Md));
+    };
+    NixpkgsClient.attrpathInfo(Sel, std::move(OnReply));
   }
 };
 
 /// \brief Get nixpkgs hover info from a selector.
-std::optional<Hover> hoverNixpkgsSelector(const Selector &Sel,
-                                          const nixf::Node &N,
-                                          const VariableLookupAnalysis &VLA,
-                                          const ParentMapAnalysis &PM,
-                                          AttrSetClient &NixpkgsClient,
-                                          llvm::StringRef Src) {
-  try {
-    // Ask nixpkgs provider information about this selector.
-    NixpkgsHoverProvider NHP(NixpkgsClient);
-    if (std::optional<std::string> Doc = NHP.resolveSelector(Sel)) {
-      return Hover{
-          .contents =
-              MarkupContent{
-                  .kind = MarkupKind::Markdown,
-                  .value = std::move(*Doc),
-              },
-          .range = toLSPRange(Src, N.range()),
-      };
-    }
-  } catch (std::exception &E) {
-    elog("hover/idiom: {0}", E.what());
-  }
-  return std::nullopt;
+void hoverNixpkgsSelector(const Selector &Sel, lspserver::Range Range,
+                          AttrSetClient &NixpkgsClient,
+                          Callback<std::optional<Hover>> Reply) {
+  // Ask nixpkgs provider information about this selector.
+  NixpkgsHoverProvider NHP(NixpkgsClient);
+  NHP.resolveSelector(Sel, [Range, Reply = std::move(Reply)](
+                               std::optional<std::string> Doc) mutable {
+    if (!Doc)
+      return Reply(std::nullopt);
+    Reply(Hover{
+        .contents =
+            MarkupContent{
+                .kind = MarkupKind::Markdown,
+                .value = std::move(*Doc),
+            },
+        .range = Range,
+    });
+  });
 }
 
 /// \brief Get hover info for ExprVar.
-std::optional<Hover> hoverVar(const ExprVar &Var,
-                              const VariableLookupAnalysis &VLA,
-                              const ParentMapAnalysis &PM,
-                              AttrSetClient &NixpkgsClient,
-                              llvm::StringRef Src) {
+void hoverVar(const ExprVar &Var, const VariableLookupAnalysis &VLA,
+              const ParentMapAnalysis &PM, AttrSetClient &NixpkgsClient,
+              const LineTable &Lines, Callback<std::optional<Hover>> Reply) {
+  Selector Sel;
   try {
-    Selector Sel = idioms::mkVarSelector(Var, VLA, PM);
-    return hoverNixpkgsSelector(Sel, Var, VLA, PM, NixpkgsClient, Src);
+    Sel = idioms::mkVarSelector(Var, VLA, PM);
   } catch (std::exception &E) {
     elog("hover/idiom/selector: {0}", E.what());
+    return Reply(std::nullopt);
   }
-  return std::nullopt;
+  hoverNixpkgsSelector(Sel, toLSPRange(Lines, Var.range()), NixpkgsClient,
+                       std::move(Reply));
 }
 
 /// \brief Get hover info for ExprSelect.
-std::optional<Hover> hoverSelect(const ExprSelect &Sel,
-                                 const VariableLookupAnalysis &VLA,
-                                 const ParentMapAnalysis &PM,
-                                 AttrSetClient &NixpkgsClient,
-                                 llvm::StringRef Src) {
+void hoverSelect(const ExprSelect &Sel, const VariableLookupAnalysis &VLA,
+                 const ParentMapAnalysis &PM, AttrSetClient &NixpkgsClient,
+                 const LineTable &Lines, Callback<std::optional<Hover>> Reply) {
+  Selector S;
   try {
-    Selector S = idioms::mkSelector(Sel, VLA, PM);
-    return hoverNixpkgsSelector(S, Sel, VLA, PM, NixpkgsClient, Src);
+    S = idioms::mkSelector(Sel, VLA, PM);
   } catch (std::exception &E) {
     elog("hover/idiom/selector: {0}", E.what());
+    return Reply(std::nullopt);
+  }
+  hoverNixpkgsSelector(S, toLSPRange(Lines, Sel.range()), NixpkgsClient,
+                       std::move(Reply));
+}
+
+/// \brief Make hover contents from option description.
+std::string mkOptionMarkdown(const OptionDescription &Desc) {
+  std::string Docs;
+  if (Desc.Type) {
+    std::string TypeName = Desc.Type->Name.value_or("");
+    std::string TypeDesc = Desc.Type->Description.value_or("");
+    Docs += llvm::formatv("{0} ({1})", TypeName, TypeDesc);
+  } else {
+    Docs += "? (missing type)";
+  }
+  if (Desc.Description) {
+    Docs += "\n\n" + Desc.Description.value_or("");
+  }
+  return Docs;
+}
+
+/// \brief Get hover info for options, asking all option workers at once.
+///
+/// Replies are ordered as workers in \p Options, and the first described one
+/// wins.
+void hoverOption(const std::vector<std::string> &Scope,
+                 lspserver::Range Range, Controller::OptionMapTy &Options,
+                 Callback<std::optional<Hover>> Reply) {
+  using Descriptions = std::vector<std::optional<OptionDescription>>;
+  auto J = Join<Descriptions>::create(
+      Descriptions(Options.size()),
+      [Range, Reply = std::move(Reply)](Descriptions Descs) mutable {
+        for (const std::optional<OptionDescription> &Desc : Descs) {
+          if (!Desc)
+            continue;
+          return Reply(Hover{
+              .contents =
+                  MarkupContent{
+                      .kind = MarkupKind::Markdown,
+                      .value = mkOptionMarkdown(*Desc),
+                  },
+              .range = Range,
+          });
+        }
+        Reply(std::nullopt);
+      });
+  std::size_t Slot = 0;
+  for (const auto &[_, Client] : Options) {
+    if (std::shared_ptr<AttrSetClient> C = Client->client()) {
+      J->add();
+      OptionsHoverProvider OHP(*C);
+      OHP.resolveHover(Scope, [J, Slot](std::optional<OptionDescription> D) {
+        J->update([&](Descriptions &Descs) { Descs[Slot] = std::move(D); });
+        J->done();
+      });
+    }
+    ++Slot;
   }
-  return std::nullopt;
+  J->done();
 }
 
 } // namespace
 
 void Controller::onHover(const TextDocumentPositionParams &Params,
                          Callback<std::optional<Hover>> Reply) {
-  using CheckTy = std::optional<Hover>;
   auto Action = [Reply = std::move(Reply),
                  File = std::string(Params.textDocument.uri.file()),
-                 RawPos = Params.position, this]() mutable {
-    return Reply([&]() -> llvm::Expected<CheckTy> {
-      const auto TU = CheckDefault(getTU(File));
-      const auto AST = CheckDefault(getAST(*TU));
-      const auto Pos = nixf::Position{RawPos.line, RawPos.character};
-      const auto &N = *CheckDefault(AST->descend({Pos, Pos}));
-
-      const auto Name = std::string(N.name());
-      const auto &VLA = *TU->variableLookup();
-      const auto &PM = *TU->parentMap();
-
-      const auto &UpExpr = *CheckDefault(PM.upExpr(N));
-
-      // Try to get hover info from nixpkgs.
-      if (auto *Client = nixpkgsClient(); Client) {
-        switch (UpExpr.kind()) {
-        case Node::NK_ExprVar: {
-          const auto &Var = static_cast<const ExprVar &>(UpExpr);
-          if (auto H = hoverVar(Var, VLA, PM, *Client, TU->src()))
-            return *H;
-          break;
-        }
-        case Node::NK_ExprSelect: {
-          const auto &Sel = static_cast<const ExprSelect &>(UpExpr);
-          if (auto H = hoverSelect(Sel, VLA, PM, *Client, TU->src()))
-            return *H;
-          break;
-        }
-        case Node::NK_ExprAttrs: {
-          // Try to get hover info from options.
-          auto Scope = std::vector<std::string>();
-          const auto R = findAttrPathForOptions(N, PM, Scope);
-          if (R == FindAttrPathResult::OK) {
-            std::lock_guard _(OptionsLock);
-            for (const auto &[_, Client] : Options) {
-              if (AttrSetClient *C = Client->client()) {
-                OptionsHoverProvider OHP(*C);
-                std::optional<OptionDescription> Desc = OHP.resolveHover(Scope);
-                std::string Docs;
-                if (Desc) {
-                  if (Desc->Type) {
-                    std::string TypeName = Desc->Type->Name.value_or("");
-                    std::string TypeDesc = Desc->Type->Description.value_or("");
-                    Docs += llvm::formatv("{0} ({1})", TypeName, TypeDesc);
-                  } else {
-                    Docs += "? (missing type)";
-                  }
-                  if (Desc->Description) {
-                    Docs += "\n\n" + Desc->Description.value_or("");
-                  }
-                  return Hover{
-                      .contents =
-                          MarkupContent{
-                              .kind = MarkupKind::Markdown,
-                              .value = std::move(Docs),
-                          },
-                      .range = toLSPRange(TU->src(), N.range()),
-                  };
-                }
-              }
-            }
-          }
-          break;
-        }
-        default:
-          break;
+                 RawPos = Params.position, Token = CancellationToken::current(),
+                 this]() mutable {
+    if (Token.isCancelled())
+      return Reply(cancelledError(Token));
+    WithCancellation _(Token);
+
+    const auto TU = getTU(File);
+    const auto AST = TU ? getAST(*TU) : nullptr;
+    const auto Pos = nixf::Position{RawPos.line, RawPos.character};
+    const Node *Desc = AST ? TU->descend({Pos, Pos}) : nullptr;
+    const Node *UpExpr = Desc ? TU->parentMap()->upExpr(*Desc) : nullptr;
+    if (!UpExpr)
+      return Reply(std::nullopt);
+
+    const auto &N = *Desc;
+    const auto &VLA = *TU->variableLookup();
+    const auto &PM = *TU->parentMap();
+
+    // Try to get hover info from nixpkgs.
+    if (auto Client = nixpkgsClient(); Client) {
+      switch (UpExpr->kind()) {
+      case Node::NK_ExprVar: {
+        const auto &Var = static_cast<const ExprVar &>(*UpExpr);
+        return hoverVar(Var, VLA, PM, *Client, TU->lines(), std::move(Reply));
+      }
+      case Node::NK_ExprSelect: {
+        const auto &Sel = static_cast<const ExprSelect &>(*UpExpr);
+        return hoverSelect(Sel, VLA, PM, *Client, TU->lines(),
+                           std::move(Reply));
+      }
+      case Node::NK_ExprAttrs: {
+        // Try to get hover info from options.
+        auto Scope = std::vector<std::string>();
+        const auto R = findAttrPathForOptions(N, PM, Scope);
+        if (R == FindAttrPathResult::OK) {
+          std::lock_guard _(OptionsLock);
+          return hoverOption(Scope, toLSPRange(TU->lines(), N.range()), Options,
+                             std::move(Reply));
         }
+        break;
+      }
+      default:
+        break;
       }
+    }
 
-      return std::nullopt;
-    }());
+    Reply(std::nullopt);
   };
-  boost::asio::post(Pool, std::move(Action));
+  schedule(Priority::Interactive,
+           ("textDocument/hover:" + Params.textDocument.uri.file()).str(),
+           CancellationToken::current(), std::move(Action));
 }
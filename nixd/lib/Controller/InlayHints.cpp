@@ -14,19 +14,19 @@
 ///
 
 #include "AST.h"
-#include "CheckReturn.h"
 #include "Convert.h"
 
+#include "lspserver/Cancellation.h"
+
 #include "nixd/CommandLine/Options.h"
 #include "nixd/Controller/Controller.h"
 
-#include <boost/asio/post.hpp>
+#include <nixf/Basic/RecursiveASTVisitor.h>
 
+#include <llvm/ADT/StringMap.h>
 #include <llvm/ADT/StringRef.h>
 #include <llvm/Support/CommandLine.h>
 
-#include <semaphore>
-
 using namespace nixd;
 using namespace nixf;
 using namespace lspserver;
@@ -38,7 +38,8 @@ opt<bool> EnableInlayHints{"inlay-hints", desc("Enable/Disable inlay-hints"),
                            init(true), cat(NixdCategory)};
 
 /// Ask nixpkgs provider to compute package information, to get inlay-hints.
-class NixpkgsInlayHintsProvider {
+class NixpkgsInlayHintsProvider
+    : public RecursiveASTVisitor<NixpkgsInlayHintsProvider> {
   AttrSetClient &NixpkgsProvider;
   const VariableLookupAnalysis &VLA;
   const ParentMapAnalysis &PMA;
@@ -46,67 +47,97 @@ class NixpkgsInlayHintsProvider {
   /// Only positions contained in this range should be computed && added;
   std::optional<nixf::PositionRange> Range;
 
-  std::vector<InlayHint> &Hints;
-
   bool rangeOK(const nixf::PositionRange &R) {
     if (!Range)
       return true; // Always OK if there is no limitation.
     return Range->contains(R);
   }
 
-  llvm::StringRef Src;
+  const LineTable &Lines;
+
+  /// Package names, queried in a single batch.
+  std::vector<std::string> Names;
+
+  /// Index into "Names".
+  llvm::StringMap<std::size_t> Packages;
+
+  /// Package variables, located in the source before asking the worker, so
+  /// that nodes are not referenced once the reply arrives.
+  struct PackageVar {
+    lspserver::Position Pos;
+    lspserver::Range Range;
+    std::size_t Index; // into "Names"
+  };
+  std::vector<PackageVar> Vars;
 
 public:
   NixpkgsInlayHintsProvider(AttrSetClient &NixpkgsProvider,
                             const VariableLookupAnalysis &VLA,
                             const ParentMapAnalysis &PMA,
                             std::optional<lspserver::Range> Range,
-                            std::vector<InlayHint> &Hints, llvm::StringRef Src)
-      : NixpkgsProvider(NixpkgsProvider), VLA(VLA), PMA(PMA), Hints(Hints),
-        Src(Src) {
+                            const LineTable &Lines)
+      : NixpkgsProvider(NixpkgsProvider), VLA(VLA), PMA(PMA), Lines(Lines) {
     if (Range)
       this->Range = toNixfRange(*Range);
   }
 
-  void dfs(const Node *N) {
-    if (!N)
-      return;
-    if (N->kind() == Node::NK_ExprVar) {
-      if (havePackageScope(*N, VLA, PMA)) {
-        if (!rangeOK(N->positionRange()))
-          return;
-        // Ask nixpkgs eval to provide it's information.
-        // This is relatively slow. Maybe better query a set of packages in the
-        // future?
-        std::binary_semaphore Ready(0);
-        const std::string &Name = static_cast<const ExprVar &>(*N).id().name();
-        AttrPathInfoResponse R;
-        auto OnReply = [&Ready, &R](llvm::Expected<AttrPathInfoResponse> Resp) {
-          if (!Resp) {
-            Ready.release();
-            return;
-          }
-          R = *Resp;
-          Ready.release();
-        };
-        NixpkgsProvider.attrpathInfo({Name}, std::move(OnReply));
-        Ready.acquire();
-
-        if (const std::optional<std::string> &Version = R.PackageDesc.Version) {
+  /// \brief Collect package variables within the range.
+  ///
+  /// FIXME: process other node kinds. e.g. ExprSelect.
+  bool visit(const ExprVar &Var) {
+    if (!havePackageScope(Var, VLA, PMA))
+      return true;
+    if (!rangeOK(Var.positionRange()))
+      return false;
+    const std::string &Name = Var.id().name();
+    auto [It, Inserted] = Packages.try_emplace(Name, Names.size());
+    if (Inserted)
+      Names.emplace_back(Name);
+    Vars.emplace_back(PackageVar{
+        .Pos = toLSPPosition(Lines, Var.rCur()),
+        .Range = toLSPRange(Lines, Var.range()),
+        .Index = It->second,
+    });
+    return true;
+  }
+
+  /// \brief Ask nixpkgs eval for all collected packages, in one request.
+  ///
+  /// \p Reply is invoked once the worker replied.
+  void query(Callback<std::vector<InlayHint>> Reply) {
+    if (Names.empty())
+      return Reply(std::vector<InlayHint>{});
+    AttrPathInfoBatchParams Params;
+    Params.reserve(Names.size());
+    for (const std::string &Name : Names)
+      Params.emplace_back(Selector{Name});
+
+    auto OnReply = [Vars = std::move(Vars), Reply = std::move(Reply)](
+                       llvm::Expected<AttrPathInfoBatchResponse> Resp) mutable {
+      std::vector<InlayHint> Hints;
+      if (!Resp) {
+        elog("inlay hints: {0}", Resp.takeError());
+        return Reply(std::move(Hints));
+      }
+      const AttrPathInfoBatchResponse &R = *Resp;
+      for (const PackageVar &V : Vars) {
+        if (V.Index >= R.size() || !R[V.Index])
+          continue;
+        if (const std::optional<std::string> &Version =
+                R[V.Index]->PackageDesc.Version) {
           // Construct inlay hints.
           InlayHint H{
-              .position = toLSPPosition(Src, N->rCur()),
+              .position = V.Pos,
               .label = ": " + *Version,
               .kind = InlayHintKind::Designator,
-              .range = toLSPRange(Src, N->range()),
+              .range = V.Range,
           };
           Hints.emplace_back(std::move(H));
         }
       }
-    }
-    // FIXME: process other node kinds. e.g. ExprSelect.
-    for (const Node *Ch : N->children())
-      dfs(Ch);
+      Reply(std::move(Hints));
+    };
+    NixpkgsProvider.attrpathInfoBatch(Params, std::move(OnReply));
   }
 };
 
@@ -115,26 +146,30 @@ public:
 void Controller::onInlayHint(const InlayHintsParams &Params,
                              Callback<std::vector<InlayHint>> Reply) {
 
-  using CheckTy = std::vector<InlayHint>;
-
   // If not enabled, exit early.
   if (!EnableInlayHints)
     return Reply(std::vector<InlayHint>{});
 
   auto Action = [Reply = std::move(Reply), URI = Params.textDocument.uri,
-                 Range = Params.range, this]() mutable {
+                 Range = Params.range, Token = CancellationToken::current(),
+                 this]() mutable {
+    if (Token.isCancelled())
+      return Reply(cancelledError(Token));
     const auto File = URI.file();
-    return Reply([&]() -> llvm::Expected<CheckTy> {
-      const auto TU = CheckDefault(getTU(File));
-      const auto AST = CheckDefault(getAST(*TU));
-      // Perform inlay hints computation on the range.
-      std::vector<InlayHint> Response;
-      NixpkgsInlayHintsProvider NP(*nixpkgsClient(), *TU->variableLookup(),
-                                   *TU->parentMap(), Range, Response,
-                                   TU->src());
-      NP.dfs(AST.get());
-      return Response;
-    }());
+    const auto TU = getTU(File);
+    const auto AST = TU ? getAST(*TU) : nullptr;
+    std::shared_ptr<AttrSetClient> Client = nixpkgsClient();
+    if (!AST || !Client)
+      return Reply(std::vector<InlayHint>{});
+    // Perform inlay hints computation on the range.
+    WithCancellation _(Token);
+    NixpkgsInlayHintsProvider NP(*Client, *TU->variableLookup(),
+                                 *TU->parentMap(), Range, TU->lines());
+    NP.traverseIteratively(AST.get());
+    NP.query(std::move(Reply));
   };
-  boost::asio::post(Pool, std::move(Action));
+  // Hints are asked for the visible range, which changes while scrolling.
+  schedule(Priority::Background,
+           ("textDocument/inlayHint:" + Params.textDocument.uri.file()).str(),
+           CancellationToken::current(), std::move(Action));
 }
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <llvm/ADT/FunctionExtras.h>
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+namespace nixd {
+
+/// \brief Accumulate replies of asynchronous calls, and continue with the
+/// result once all of them arrived.
+///
+/// Nothing blocks while waiting. The continuation runs on the thread
+/// finishing the last part, usually the one receiving the last reply.
+///
+///   auto J = Join<T>::create(Init, Continuation);
+///   J->add();
+///   Client.call(Params, [J](auto Resp) {
+///     J->update([&](T &V) { ... });
+///     J->done();
+///   });
+///   J->done(); // The issuer itself is a part as well.
+template <class T> class Join {
+  std::mutex Lock;
+  T Value;                                // GUARDED_BY(Lock)
+  std::size_t Pending = 1;                // GUARDED_BY(Lock)
+  llvm::unique_function<void(T)> Then;
+
+  Join(T Init, llvm::unique_function<void(T)> Then)
+      : Value(std::move(Init)), Then(std::move(Then)) {}
+
+public:
+  static std::shared_ptr<Join> create(T Init,
+                                      llvm::unique_function<void(T)> Then) {
+    return std::shared_ptr<Join>(new Join(std::move(Init), std::move(Then)));
+  }
+
+  /// \brief Register one more part to wait for.
+  void add() {
+    std::lock_guard _(Lock);
+    ++Pending;
+  }
+
+  /// \brief Access the accumulated value.
+  template <class Fn> decltype(auto) update(Fn &&F) {
+    std::lock_guard _(Lock);
+    return F(Value);
+  }
+
+  /// \brief Mark one part as finished.
+  void done() {
+    {
+      std::lock_guard _(Lock);
+      if (--Pending != 0)
+        return;
+    }
+    Then(std::move(Value));
+  }
+};
+
+} // namespace nixd
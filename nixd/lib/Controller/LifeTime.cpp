@@ -12,7 +12,9 @@
 #include "nixd/Support/Exception.h"
 
 #include "lspserver/Protocol.h"
+#include "lspserver/SourceCode.h"
 
+#include <llvm/ADT/STLExtras.h>
 #include <llvm/Support/CommandLine.h>
 
 using namespace nixd;
@@ -55,9 +57,20 @@ std::string getDefaultNixOSOptionsExpr() {
   return DefaultNixOSOptionsExpr;
 }
 
+/// Pick the encoding of positions, from those supported by the client.
+///
+/// UTF-8 is preferred, columns are byte offsets then. Otherwise stick to the
+/// UTF-16 default, which all clients support.
+OffsetEncoding
+negotiateEncoding(const std::vector<OffsetEncoding> &Supported) {
+  if (llvm::is_contained(Supported, OffsetEncoding::UTF8))
+    return OffsetEncoding::UTF8;
+  return OffsetEncoding::UTF16;
+}
+
 } // namespace
 
-void Controller::evalExprWithProgress(AttrSetClient &Client,
+void Controller::evalExprWithProgress(AttrSetClientPool &Workers,
                                       const EvalExprParams &Params,
                                       std::string_view Description) {
   auto Token = rand();
@@ -80,7 +93,7 @@ void Controller::evalExprWithProgress(AttrSetClient &Client,
                              .cancellable = false,
                              .percentage = false,
                          }});
-  Client.evalExpr(Params, std::move(Action));
+  Workers.evalExpr(Params, std::move(Action));
 }
 
 void Controller::
@@ -124,6 +137,21 @@ void Controller::
         }}},
   };
 
+  // Documents are not opened before "initialize", so positions converted later
+  // are all in the negotiated encoding. It is replied in the field the client
+  // asked by, i.e. "positionEncoding" of LSP 3.17, or clangd's extension
+  // "offsetEncoding", which is in the result rather than the capabilities.
+  const ClientCapabilities &Caps = Params.capabilities;
+  std::optional<OffsetEncoding> OffsetEncodingReply;
+  if (Caps.PositionEncodings) {
+    OffsetEncoding Encoding = negotiateEncoding(*Caps.PositionEncodings);
+    setLSPEncoding(Encoding);
+    ServerCaps["positionEncoding"] = Encoding;
+  } else if (Caps.offsetEncoding) {
+    OffsetEncodingReply = negotiateEncoding(*Caps.offsetEncoding);
+    setLSPEncoding(*OffsetEncodingReply);
+  }
+
   if (EnableSemanticTokens) {
     ServerCaps["semanticTokensProvider"] = Object{
         {
@@ -166,6 +194,8 @@ void Controller::
        }},
       {"capabilities", std::move(ServerCaps)},
   }};
+  if (OffsetEncodingReply)
+    Result["offsetEncoding"] = *OffsetEncodingReply;
 
   Reply(std::move(Result));
 
@@ -174,19 +204,16 @@ void Controller::
   // Start default workers.
   startNixpkgs(NixpkgsEval);
 
-  if (nixpkgsClient()) {
-    evalExprWithProgress(*nixpkgsClient(), getDefaultNixpkgsExpr(),
-                         "nixpkgs entries");
-  }
+  evalExprWithProgress(nixpkgsEval(), getDefaultNixpkgsExpr(),
+                       "nixpkgs entries");
 
   // Launch nixos worker also.
   {
     std::lock_guard _(OptionsLock);
     startOption("nixos", Options["nixos"]);
 
-    if (AttrSetClient *Client = Options["nixos"]->client())
-      evalExprWithProgress(*Client, getDefaultNixOSOptionsExpr(),
-                           "nixos options");
+    evalExprWithProgress(*Options["nixos"], getDefaultNixOSOptionsExpr(),
+                         "nixos options");
   }
   try {
     Config = parseCLIConfig();
@@ -3,11 +3,13 @@
 using namespace nixd;
 
 NixTU::NixTU(std::vector<nixf::Diagnostic> Diagnostics,
+             std::vector<nixf::Diagnostic> ParseDiagnostics,
              std::shared_ptr<nixf::Node> AST,
              std::optional<util::OwnedRegion> ASTByteCode,
              std::unique_ptr<nixf::VariableLookupAnalysis> VLA,
              std::shared_ptr<const std::string> Src)
-    : Diagnostics(std::move(Diagnostics)), AST(std::move(AST)),
+    : Diagnostics(std::move(Diagnostics)),
+      ParseDiagnostics(std::move(ParseDiagnostics)), AST(std::move(AST)),
       ASTByteCode(std::move(ASTByteCode)), VLA(std::move(VLA)),
       Src(std::move(Src)) {
   assert(this->Src && "Source code should not be null");
@@ -16,3 +18,20 @@ NixTU::NixTU(std::vector<nixf::Diagnostic> Diagnostics,
     PMA->runOnAST(*this->AST);
   }
 }
+
+const lspserver::LineTable &NixTU::lines() const {
+  std::call_once(LinesOnce, [this]() {
+    Lines = std::make_unique<lspserver::LineTable>(*Src);
+  });
+  return *Lines;
+}
+
+const nixf::Node *NixTU::descend(nixf::PositionRange Range) const {
+  if (!AST)
+    return nullptr;
+  std::call_once(LookupOnce, [this]() {
+    Lookup = std::make_unique<nixf::PositionLookupAnalysis>();
+    Lookup->runOnAST(*AST);
+  });
+  return Lookup->descend(Range);
+}
@@ -10,8 +10,6 @@
 #include "lspserver/Protocol.h"
 #include "nixd/Controller/Controller.h"
 
-#include <boost/asio/post.hpp>
-
 #include <exception>
 
 using namespace lspserver;
@@ -38,7 +36,7 @@ struct RenameBuiltinException : RenameException {
 WorkspaceEdit rename(const nixf::Node &Desc, const std::string &NewText,
                      const ParentMapAnalysis &PMA,
                      const VariableLookupAnalysis &VLA, const URIForFile &URI,
-                     llvm::StringRef Src) {
+                     const LineTable &Lines) {
   using lspserver::TextEdit;
   // Find "definition"
   auto Def = findDefinition(Desc, PMA, VLA);
@@ -53,13 +51,13 @@ WorkspaceEdit rename(const nixf::Node &Desc, const std::string &NewText,
 
   for (const auto *Use : Def.uses()) {
     Edits.emplace_back(TextEdit{
-        .range = toLSPRange(Src, Use->range()),
+        .range = toLSPRange(Lines, Use->range()),
         .newText = NewText,
     });
   }
 
   Edits.emplace_back(TextEdit{
-      .range = toLSPRange(Src, Def.syntax()->range()),
+      .range = toLSPRange(Lines, Def.syntax()->range()),
       .newText = NewText,
   });
   WorkspaceEdit WE;
@@ -80,19 +78,19 @@ void Controller::onRename(const RenameParams &Params,
       const auto TU = CheckDefault(getTU(File));
       const auto AST = CheckDefault(getAST(*TU));
       const auto &Desc = *CheckReturn(
-          AST->descend({Pos, Pos}),
+          TU->descend({Pos, Pos}),
           error("cannot find corresponding node on given position"));
 
       const auto &PM = *TU->parentMap();
       const auto &VLA = *TU->variableLookup();
       try {
-        return rename(Desc, NewText, PM, VLA, URI, TU->src());
+        return rename(Desc, NewText, PM, VLA, URI, TU->lines());
       } catch (std::exception &E) {
         return error(E.what());
       }
     }());
   };
-  boost::asio::post(Pool, std::move(Action));
+  schedule(Priority::Normal, std::move(Action));
 }
 
 void Controller::onPrepareRename(
@@ -106,17 +104,17 @@ void Controller::onPrepareRename(
       const auto TU = CheckDefault(getTU(File));
       const auto AST = CheckDefault(getAST(*TU));
 
-      const auto &Desc = *CheckDefault(AST->descend({Pos, Pos}));
+      const auto &Desc = *CheckDefault(TU->descend({Pos, Pos}));
 
       const auto &PM = *TU->parentMap();
       const auto &VLA = *TU->variableLookup();
       try {
-        WorkspaceEdit WE = rename(Desc, "", PM, VLA, URI, TU->src());
-        return toLSPRange(TU->src(), Desc.range());
+        WorkspaceEdit WE = rename(Desc, "", PM, VLA, URI, TU->lines());
+        return toLSPRange(TU->lines(), Desc.range());
       } catch (std::exception &E) {
         return error(E.what());
       }
     }());
   };
-  boost::asio::post(Pool, std::move(Action));
+  schedule(Priority::Interactive, std::move(Action));
 }
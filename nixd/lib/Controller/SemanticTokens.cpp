@@ -12,12 +12,12 @@
 #include <nixf/Basic/Nodes/Expr.h>
 #include <nixf/Basic/Nodes/Lambda.h>
 #include <nixf/Basic/Range.h>
+#include <nixf/Basic/RecursiveASTVisitor.h>
 #include <nixf/Sema/VariableLookup.h>
 
+#include <lspserver/Cancellation.h>
 #include <lspserver/Protocol.h>
 
-#include <boost/asio/post.hpp>
-
 using namespace nixd;
 using namespace lspserver;
 using namespace nixf;
@@ -56,7 +56,7 @@ struct RawSemanticToken {
   unsigned TokenModifiers;
 };
 
-class SemanticTokenBuilder {
+class SemanticTokenBuilder : public RecursiveASTVisitor<SemanticTokenBuilder> {
 
   const VariableLookupAnalysis &VLA;
 
@@ -64,14 +64,15 @@ class SemanticTokenBuilder {
 
   std::vector<RawSemanticToken> Raw;
 
-  llvm::StringRef Src;
+  const LineTable &Lines;
 
 public:
-  SemanticTokenBuilder(const VariableLookupAnalysis &VLA, llvm::StringRef Src)
-      : VLA(VLA), Src(Src) {}
+  SemanticTokenBuilder(const VariableLookupAnalysis &VLA,
+                       const LineTable &Lines)
+      : VLA(VLA), Lines(Lines) {}
   void addImpl(nixf::LexerCursor Pos, unsigned Length, unsigned TokenType,
                unsigned TokenModifiers) {
-    auto P = toLSPPosition(Src, Pos);
+    auto P = toLSPPosition(Lines, Pos);
     Raw.emplace_back(RawSemanticToken{P, Length, TokenType, TokenModifiers});
   }
 
@@ -86,18 +87,20 @@ public:
     return N.range().lCur().line() != N.range().rCur().line();
   }
 
-  static unsigned len(const Node &N) {
-    return N.range().rCur().offset() - N.range().lCur().offset();
+  /// Length of a single-line node, in units of the position encoding.
+  [[nodiscard]] unsigned len(const Node &N) const {
+    return toLSPPosition(Lines, N.rCur()).character -
+           toLSPPosition(Lines, N.lCur()).character;
   }
 
-  void dfs(const ExprString &Str) {
+  bool visit(const ExprString &Str) {
     unsigned Modifers = 0;
-    if (!Str.isLiteral())
-      return;
-    add(Str, ST_String, Modifers);
+    if (Str.isLiteral())
+      add(Str, ST_String, Modifers);
+    return false;
   }
 
-  void dfs(const ExprVar &Var) {
+  void addVar(const ExprVar &Var) {
     if (Var.id().name() == "true" || Var.id().name() == "false") {
       add(Var, ST_Bool, SM_Builtin);
       return;
@@ -126,12 +129,17 @@ public:
     add(Var, ST_Defined, SM_Deprecated);
   }
 
-  void dfs(const ExprSelect &Select) {
-    dfs(&Select.expr());
-    dfs(Select.defaultExpr());
+  bool visit(const ExprVar &Var) {
+    addVar(Var);
+    return false;
+  }
+
+  bool visit(const ExprSelect &Select) {
+    traverse(&Select.expr());
+    traverse(Select.defaultExpr());
     if (!Select.path())
-      return;
-    for (const std::shared_ptr<nixf::AttrName> &Name : Select.path()->names()) {
+      return false;
+    for (const nixf::AttrName *Name : Select.path()->names()) {
       if (!Name)
         continue;
       const AttrName &AN = *Name;
@@ -141,9 +149,11 @@ public:
         }
       }
     }
+    return false;
   }
 
-  void dfs(const SemaAttrs &SA) {
+  bool visit(const ExprAttrs &Attrs) {
+    const SemaAttrs &SA = Attrs.sema();
     for (const auto &[Name, Attr] : SA.staticAttrs()) {
       if (!Attr.value())
         continue;
@@ -153,14 +163,15 @@ public:
       if (Attr.fromInherit())
         continue;
       add(Attr.key(), ST_AttrName, 0);
-      dfs(Attr.value());
+      traverse(Attr.value());
     }
     for (const auto &Attr : SA.dynamicAttrs()) {
-      dfs(Attr.value());
+      traverse(Attr.value());
     }
+    return false;
   }
 
-  void dfs(const LambdaArg &Arg) {
+  void addArg(const LambdaArg &Arg) {
     if (Arg.id())
       add(*Arg.id(), ST_LambdaArg, 0);
     // Color deduplicated formals.
@@ -172,49 +183,14 @@ public:
       }
   }
 
-  void dfs(const ExprLambda &Lambda) {
+  bool visit(const ExprLambda &Lambda) {
     if (Lambda.arg()) {
-      dfs(*Lambda.arg());
+      addArg(*Lambda.arg());
     }
-    dfs(Lambda.body());
+    traverse(Lambda.body());
+    return false;
   }
 
-  void dfs(const Node *AST) {
-    if (!AST)
-      return;
-    switch (AST->kind()) {
-    case Node::NK_ExprLambda: {
-      const auto &Lambda = static_cast<const ExprLambda &>(*AST);
-      dfs(Lambda);
-      break;
-    }
-    case Node::NK_ExprString: {
-      const auto &Str = static_cast<const ExprString &>(*AST);
-      dfs(Str);
-      break;
-    }
-    case Node::NK_ExprVar: {
-      const auto &Var = static_cast<const ExprVar &>(*AST);
-      dfs(Var);
-      break;
-    }
-    case Node::NK_ExprSelect: {
-      const auto &Select = static_cast<const ExprSelect &>(*AST);
-      dfs(Select);
-      break;
-    }
-    case Node::NK_ExprAttrs: {
-      const SemaAttrs &SA = static_cast<const ExprAttrs &>(*AST).sema();
-      dfs(SA);
-      break;
-    }
-    default:
-      for (const Node *Ch : AST->children()) {
-        dfs(Ch);
-      }
-    }
-  };
-
   std::vector<SemanticToken> finish() {
     std::vector<SemanticToken> Tokens;
     std::sort(Raw.begin(), Raw.end());
@@ -238,15 +214,20 @@ void Controller::onSemanticTokens(const SemanticTokensParams &Params,
                                   Callback<SemanticTokens> Reply) {
   using CheckTy = SemanticTokens;
   auto Action = [Reply = std::move(Reply), URI = Params.textDocument.uri,
-                 this]() mutable {
+                 Token = CancellationToken::current(), this]() mutable {
+    if (Token.isCancelled())
+      return Reply(cancelledError(Token));
     const auto File = URI.file();
     return Reply([&]() -> llvm::Expected<CheckTy> {
       const auto TU = CheckDefault(getTU(File));
       const auto AST = CheckDefault(getAST(*TU));
-      SemanticTokenBuilder Builder(*TU->variableLookup(), TU->src());
-      Builder.dfs(AST.get());
+      SemanticTokenBuilder Builder(*TU->variableLookup(), TU->lines());
+      Builder.traverseIteratively(AST.get());
       return SemanticTokens{.tokens = Builder.finish()};
     }());
   };
-  boost::asio::post(Pool, std::move(Action));
+  schedule(Priority::Normal,
+           ("textDocument/semanticTokens:" + Params.textDocument.uri.file())
+               .str(),
+           CancellationToken::current(), std::move(Action));
 }
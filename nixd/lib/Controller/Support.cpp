@@ -4,8 +4,6 @@
 #include <nixf/Parse/Parser.h>
 #include <nixf/Sema/VariableLookup.h>
 
-#include <boost/asio/post.hpp>
-
 #include <mutex>
 
 using namespace lspserver;
@@ -13,48 +11,135 @@ using namespace nixd;
 
 void Controller::removeDocument(lspserver::PathRef File) {
   Store.removeDraft(File);
+  std::lock_guard P(PublishLock);
   {
     std::lock_guard _(TUsLock);
     TUs.erase(File);
+    Analyses.erase(File);
   }
-  publishDiagnostics(File, std::nullopt, "", {});
+  TUsChanged.notify_all();
+  publishDiagnostics(File, std::nullopt, LineTable(""), {});
 }
 
 void Controller::actOnDocumentAdd(PathRef File,
                                   std::optional<int64_t> Version) {
-  auto Action = [this, File = std::string(File), Version]() {
-    auto Draft = Store.getDraft(File);
-    std::shared_ptr<const std::string> Src = Draft->Contents;
-    assert(Draft && "Added document is not in the store?");
-
-    std::vector<nixf::Diagnostic> Diagnostics;
-    std::shared_ptr<nixf::Node> AST =
-        nixf::parse(*Draft->Contents, Diagnostics);
-
-    if (!AST) {
-      std::lock_guard G(TUsLock);
-      publishDiagnostics(File, Version, *Src, Diagnostics);
-      TUs.insert_or_assign(File,
-                           std::make_shared<NixTU>(std::move(Diagnostics),
-                                                   std::move(AST), std::nullopt,
-                                                   /*VLA=*/nullptr, Src));
+  auto Draft = Store.getDraft(File);
+  assert(Draft && "Added document is not in the store?");
+
+  std::uint64_t Generation;
+  {
+    std::lock_guard G(TUsLock);
+    Generation = ++LastGeneration;
+    AnalysisState &State = Analyses[File];
+    State.Latest = Generation;
+    State.Src = Draft->Contents;
+    State.Version = Version;
+  }
+  // Waiting requests may pick up the new generation.
+  TUsChanged.notify_all();
+
+  schedule(Priority::Normal, [this, File = std::string(File), Generation]() {
+    analyzeDocument(File, Generation);
+  });
+}
+
+void Controller::analyzeDocument(const std::string &File,
+                                 std::uint64_t Generation) {
+  lspserver::Rope Src;
+  std::optional<int64_t> Version;
+  {
+    std::lock_guard G(TUsLock);
+    auto It = Analyses.find(File);
+    // The document was closed, changed again, or someone else is working on
+    // it. In either case there is nothing to do.
+    if (It == Analyses.end() || It->second.Latest != Generation ||
+        It->second.Started >= Generation)
       return;
-    }
+    It->second.Started = Generation;
+    Src = It->second.Src;
+    Version = It->second.Version;
+  }
+  runAnalysis(File, Generation, Src.str(), Version);
+}
 
-    auto VLA = std::make_unique<nixf::VariableLookupAnalysis>(Diagnostics);
+void Controller::runAnalysis(const std::string &File, std::uint64_t Generation,
+                             std::shared_ptr<const std::string> Src,
+                             std::optional<int64_t> Version) {
+  // Reuse the previous AST of this file, if any.
+  std::shared_ptr<const NixTU> Prev;
+  {
+    std::lock_guard G(TUsLock);
+    Prev = TUs.lookup(File);
+  }
+
+  std::vector<nixf::Diagnostic> Diagnostics;
+  std::shared_ptr<nixf::Node> AST =
+      Prev ? nixf::reparse(*Src, Prev->src(), Prev->ast(),
+                           Prev->parseDiagnostics(), Diagnostics)
+           : nixf::parse(*Src, Diagnostics);
+  std::vector<nixf::Diagnostic> ParseDiagnostics = Diagnostics;
+
+  std::unique_ptr<nixf::VariableLookupAnalysis> VLA;
+  if (AST) {
+    VLA = std::make_unique<nixf::VariableLookupAnalysis>(Diagnostics);
     VLA->runOnAST(*AST);
+  }
 
-    publishDiagnostics(File, Version, *Src, Diagnostics);
+  std::shared_ptr<const NixTU> Finished;
+  {
+    std::lock_guard G(TUsLock);
+    auto It = Analyses.find(File);
+    // Drop the result if the document was closed, or changed in the meantime.
+    if (It != Analyses.end() && It->second.Latest == Generation) {
+      auto TU = std::make_shared<NixTU>(
+          std::move(Diagnostics), std::move(ParseDiagnostics), std::move(AST),
+          std::nullopt, std::move(VLA), Src);
+      Finished = TU;
+      TUs.insert_or_assign(File, std::move(TU));
+      It->second.Finished = Generation;
+    }
+  }
+  TUsChanged.notify_all();
+  if (!Finished)
+    return;
 
-    {
-      std::lock_guard G(TUsLock);
-      TUs.insert_or_assign(
-          File, std::make_shared<NixTU>(std::move(Diagnostics), std::move(AST),
-                                        std::nullopt, std::move(VLA), Src));
+  // Publishing may wait for the client, so it is done without "TUsLock".
+  std::lock_guard P(PublishLock);
+  {
+    // A newer unit may have been stored, and published, in the meantime.
+    std::lock_guard G(TUsLock);
+    auto It = Analyses.find(File);
+    if (It == Analyses.end() || It->second.Finished != Generation)
       return;
+  }
+  publishDiagnostics(File, Version, Finished->lines(), Finished->diagnostics());
+}
+
+std::shared_ptr<const NixTU> Controller::getTU(std::string_view File) {
+  std::unique_lock L(TUsLock);
+  for (;;) {
+    auto It = Analyses.find(File);
+    if (It == Analyses.end() || It->second.Finished == It->second.Latest)
+      break;
+    AnalysisState &State = It->second;
+    if (State.Started < State.Latest) {
+      // Nobody is working on the latest version, do it here rather than
+      // waiting for the pool, which might be fully occupied by requests.
+      std::uint64_t Generation = State.Started = State.Latest;
+      lspserver::Rope Src = State.Src;
+      std::optional<int64_t> Version = State.Version;
+      L.unlock();
+      runAnalysis(std::string(File), Generation, Src.str(), Version);
+      L.lock();
+      continue;
     }
-  };
-  Action();
+    TUsChanged.wait(L);
+  }
+  if (!TUs.count(File)) [[unlikely]] {
+    lspserver::elog("cannot get translation unit: {0}", File);
+    return nullptr;
+  }
+  return TUs.lookup(File);
 }
 
 void Controller::createWorkDoneProgress(
@@ -11,25 +11,25 @@ using namespace llvm::json;
 using namespace lspserver;
 
 void Controller::onDocumentDidOpen(
-    const lspserver::DidOpenTextDocumentParams &Params) {
+    lspserver::DidOpenTextDocumentParams &&Params) {
   PathRef File = Params.textDocument.uri.file();
-  const std::string &Contents = Params.textDocument.text;
   std::optional<int64_t> Version = Params.textDocument.version;
-  Store.addDraft(File, DraftStore::encodeVersion(Version), Contents);
+  Store.addDraft(File, DraftStore::encodeVersion(Version),
+                 Rope(std::move(Params.textDocument.text)));
   actOnDocumentAdd(File, Version);
 }
 
-void Controller::onDocumentDidChange(
-    const DidChangeTextDocumentParams &Params) {
+void Controller::onDocumentDidChange(DidChangeTextDocumentParams &&Params) {
   PathRef File = Params.textDocument.uri.file();
   auto Code = Store.getDraft(File);
   if (!Code) {
     log("Trying to incrementally change non-added document: {0}", File);
     return;
   }
-  std::string NewCode(*Code->Contents);
-  for (const auto &Change : Params.contentChanges) {
-    if (auto Err = applyChange(NewCode, Change)) {
+  // Edits share the unchanged text with the stored draft.
+  Rope NewCode = Code->Contents;
+  for (auto &Change : Params.contentChanges) {
+    if (auto Err = applyChange(NewCode, std::move(Change))) {
       // If this fails, we are most likely going to be not in sync anymore
       // with the client.  It is better to remove the draft and let further
       // operations fail rather than giving wrong results.
@@ -39,7 +39,7 @@ void Controller::onDocumentDidChange(
     }
   }
   std::optional<int64_t> Version = Params.textDocument.version;
-  Store.addDraft(File, DraftStore::encodeVersion(Version), NewCode);
+  Store.addDraft(File, DraftStore::encodeVersion(Version), std::move(NewCode));
   actOnDocumentAdd(File, Version);
 }
 
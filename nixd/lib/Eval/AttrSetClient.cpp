@@ -2,7 +2,11 @@
 
 #include "nixd/Eval/AttrSetClient.h"
 
+#include <algorithm>
+#include <mutex>
+
 #include <signal.h> // NOLINT(modernize-deprecated-headers)
+#include <sys/wait.h>
 
 using namespace nixd;
 using namespace lspserver;
@@ -13,6 +17,9 @@ AttrSetClient::AttrSetClient(std::unique_ptr<lspserver::InboundPort> In,
   EvalExpr = mkOutMethod<EvalExprParams, EvalExprResponse>(rpcMethod::EvalExpr);
   AttrPathInfo = mkOutMethod<AttrPathInfoParams, AttrPathInfoResponse>(
       rpcMethod::AttrPathInfo);
+  AttrPathInfoBatch =
+      mkOutMethod<AttrPathInfoBatchParams, AttrPathInfoBatchResponse>(
+          rpcMethod::AttrPathInfoBatch);
   AttrPathComplete =
       mkOutMethod<AttrPathCompleteParams, AttrPathCompleteResponse>(
           rpcMethod::AttrPathComplete);
@@ -30,11 +37,208 @@ const char *AttrSetClient::getExe() {
 }
 
 AttrSetClientProc::AttrSetClientProc(const std::function<int()> &Action)
-    : Proc(Action), Client(Proc.mkIn(), Proc.mkOut()),
-      Input([this]() { Client.run(); }) {}
+    : Proc(Action), Client(Proc.mkIn(), Proc.mkOut()), Input([this]() {
+        Client.run();
+        Exited = true;
+      }) {}
+
+AttrSetClientProc::~AttrSetClientProc() {
+  Client.exit();
+  Client.closeInbound();
+  Input.join();
+}
 
 AttrSetClient *AttrSetClientProc::client() {
-  if (!kill(Proc.proc().PID, 0))
+  // Dead workers are not reaped until bury(), so kill() alone cannot tell.
+  if (!Exited && !kill(Proc.proc().PID, 0))
     return &Client;
   return nullptr;
 }
+
+void AttrSetClientProc::bury() {
+  // The worker may have closed its output, but not exited yet.
+  kill(pid(), SIGKILL);
+  waitpid(pid(), nullptr, 0);
+  Client.abandonPendingCalls();
+}
+
+namespace {
+
+constexpr std::chrono::milliseconds InitialBackoff{500};
+constexpr std::chrono::milliseconds MaxBackoff{60'000};
+
+/// Workers survived for this long are considered healthy, and backoff is
+/// reset on their next death.
+constexpr std::chrono::minutes StableAfter{5};
+
+std::string formatDepths(const std::vector<std::optional<std::size_t>> &Ds) {
+  std::string Ret;
+  for (const std::optional<std::size_t> &D : Ds) {
+    if (!Ret.empty())
+      Ret += ", ";
+    Ret += D ? std::to_string(*D) : "dead";
+  }
+  return Ret;
+}
+
+} // namespace
+
+AttrSetClientPool::AttrSetClientPool(std::size_t Size,
+                                     std::function<int()> Action)
+    : Action(std::move(Action)), Workers(Size) {
+  assert(Size > 0 && "at least one worker is needed");
+  std::lock_guard _(Lock);
+  for (Worker &W : Workers)
+    launch(W);
+}
+
+void AttrSetClientPool::launch(Worker &W) {
+  W.Proc = std::make_shared<AttrSetClientProc>(Action);
+  W.StartedAt = Clock::now();
+  W.Warm = std::make_shared<std::atomic<bool>>(!LastExpr);
+  AttrSetClient *C = W.Proc->client();
+  if (!LastExpr || !C)
+    return;
+  log("attrset worker {0}: replaying the last expression", W.Proc->pid());
+  C->evalExpr(
+      *LastExpr, [Warm = W.Warm](llvm::Expected<EvalExprResponse> Resp) {
+        if (!Resp)
+          elog("attrset worker warm-up: {0}", Resp.takeError());
+        *Warm = true;
+      });
+}
+
+std::vector<std::shared_ptr<AttrSetClientProc>>
+AttrSetClientPool::supervise() {
+  std::vector<std::shared_ptr<AttrSetClientProc>> Dead;
+  Clock::time_point Now = Clock::now();
+  bool AnyAlive = false;
+  for (Worker &W : Workers) {
+    if (W.Proc && W.Proc->client()) {
+      AnyAlive = true;
+      continue;
+    }
+    if (W.Proc) {
+      if (Now - W.StartedAt > StableAfter)
+        W.Backoff = InitialBackoff;
+      W.Backoff = std::clamp(W.Backoff, InitialBackoff, MaxBackoff);
+      W.RetryAt = Now + W.Backoff;
+      elog("attrset worker {0} died, restarting in {1}ms", W.Proc->pid(),
+           W.Backoff.count());
+      W.Backoff *= 2;
+      Dead.emplace_back(std::move(W.Proc));
+    }
+    if (Now >= W.RetryAt) {
+      launch(W);
+      AnyAlive |= W.Proc->client() != nullptr;
+    }
+  }
+  if (AnyAlive)
+    return Dead;
+
+  // Requests would fail until some backoff expires. Restart the worker due
+  // first now, unless it died right after starting, e.g. it cannot start.
+  auto First = std::min_element(
+      Workers.begin(), Workers.end(), [](const Worker &A, const Worker &B) {
+        return A.RetryAt < B.RetryAt;
+      });
+  if (!First->Proc && Now - First->StartedAt >= InitialBackoff) {
+    log("all attrset workers are dead, restarting one now");
+    launch(*First);
+  }
+  return Dead;
+}
+
+std::shared_ptr<AttrSetClient> AttrSetClientPool::client() {
+  std::shared_ptr<AttrSetClient> Best;
+  std::vector<std::shared_ptr<AttrSetClientProc>> Dead;
+  {
+    std::lock_guard _(Lock);
+    Dead = supervise();
+
+    // Start from a rotating index, so that idle workers take turns.
+    std::size_t Start = Next++;
+    std::pair<bool, std::size_t> BestKey; // (cold, queue depth)
+    for (std::size_t I = 0; I < Workers.size(); ++I) {
+      const Worker &W = Workers[(Start + I) % Workers.size()];
+      AttrSetClient *C = W.Proc ? W.Proc->client() : nullptr;
+      if (!C)
+        continue;
+      std::pair<bool, std::size_t> Key{!*W.Warm, C->pendingCalls()};
+      if (!Best || Key < BestKey) {
+        // Shares the ownership of the process.
+        Best = std::shared_ptr<AttrSetClient>(W.Proc, C);
+        BestKey = Key;
+      }
+    }
+    if (Best && BestKey.second != 0 && Workers.size() > 1)
+      vlog("attrset pool: all workers busy, queue depths: {0}",
+           formatDepths(queueDepthsLocked()));
+  }
+  // Replies are never coming, callbacks may take the lock.
+  for (const std::shared_ptr<AttrSetClientProc> &P : Dead)
+    P->bury();
+  return Best;
+}
+
+void AttrSetClientPool::evalExpr(const EvalExprParams &Params,
+                                 Callback<EvalExprResponse> Reply) {
+  struct State {
+    std::mutex Lock;
+    std::size_t Pending; // GUARDED_BY(Lock)
+    llvm::Expected<EvalExprResponse> Result = EvalExprResponse{};
+    Callback<EvalExprResponse> Reply;
+  };
+  std::vector<std::shared_ptr<AttrSetClient>> Alive;
+  std::vector<std::shared_ptr<AttrSetClientProc>> Dead;
+  {
+    std::lock_guard _(Lock);
+    LastExpr = Params;
+    Dead = supervise();
+    for (const Worker &W : Workers) {
+      if (AttrSetClient *C = W.Proc ? W.Proc->client() : nullptr)
+        Alive.emplace_back(W.Proc, C);
+    }
+  }
+  for (const std::shared_ptr<AttrSetClientProc> &P : Dead)
+    P->bury();
+  if (Alive.empty())
+    return Reply(error("all workers are dead"));
+
+  auto S = std::make_shared<State>();
+  S->Pending = Alive.size();
+  S->Reply = std::move(Reply);
+  for (const std::shared_ptr<AttrSetClient> &C : Alive) {
+    C->evalExpr(Params, [S](llvm::Expected<EvalExprResponse> Resp) {
+      std::unique_lock L(S->Lock);
+      // Keep the first error.
+      if (!Resp && S->Result)
+        S->Result = Resp.takeError();
+      else if (!Resp)
+        llvm::consumeError(Resp.takeError());
+      else if (S->Result)
+        S->Result = std::move(*Resp);
+      if (--S->Pending != 0)
+        return;
+      L.unlock();
+      S->Reply(std::move(S->Result));
+    });
+  }
+}
+
+std::vector<std::optional<std::size_t>> AttrSetClientPool::queueDepthsLocked() {
+  std::vector<std::optional<std::size_t>> Depths;
+  Depths.reserve(Workers.size());
+  for (const Worker &W : Workers) {
+    if (AttrSetClient *C = W.Proc ? W.Proc->client() : nullptr)
+      Depths.emplace_back(C->pendingCalls());
+    else
+      Depths.emplace_back(std::nullopt);
+  }
+  return Depths;
+}
+
+std::vector<std::optional<std::size_t>> AttrSetClientPool::queueDepths() {
+  std::lock_guard _(Lock);
+  return queueDepthsLocked();
+}
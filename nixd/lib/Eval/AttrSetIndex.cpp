@@ -0,0 +1,323 @@
+/// \file
+/// \brief Implementation of the attrset index file format.
+///
+/// The file consists of a header, records sorted by their keys, and a string
+/// table. Keys are formed by the scope (components separated by "\x1f"), a
+/// "\0" and the attribute name. Indexed scopes themselves are recorded with
+/// empty names, so they are sorted right before their attributes.
+
+#include "nixd/Eval/AttrSetIndex.h"
+
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+using namespace nixd;
+using namespace lspserver;
+
+namespace {
+
+constexpr char Magic[8] = {'N', 'I', 'X', 'D', 'I', 'D', 'X', '\0'};
+constexpr std::uint32_t FormatVersion = 1;
+
+/// Size of absent strings.
+constexpr std::uint32_t None = UINT32_MAX;
+
+struct StrRef {
+  std::uint32_t Offset;
+  std::uint32_t Size;
+};
+
+struct Header {
+  char Magic[8];
+  std::uint32_t Version;
+  std::uint32_t NumRecords;
+  std::uint64_t StringsOffset;
+  std::uint64_t StringsSize;
+};
+
+enum RecordFlags : std::uint32_t {
+  RF_Scope = 1 << 0,
+  RF_Info = 1 << 1,
+  RF_Location = 1 << 2,
+};
+
+struct Record {
+  StrRef Key;
+  std::uint32_t Flags;
+  std::int32_t Type;
+  StrRef LocationFile;
+  std::uint32_t LocationLine;
+  std::uint32_t LocationColumn;
+  StrRef Name;
+  StrRef PName;
+  StrRef Version;
+  StrRef Description;
+  StrRef LongDescription;
+  StrRef Position;
+  StrRef Homepage;
+};
+
+static_assert(std::is_trivially_copyable_v<Header>);
+static_assert(std::is_trivially_copyable_v<Record>);
+
+std::string scopeKey(const Selector &Scope) {
+  std::string Key;
+  for (std::size_t I = 0; I < Scope.size(); ++I) {
+    if (I)
+      Key += '\x1f';
+    Key += Scope[I];
+  }
+  Key += '\0';
+  return Key;
+}
+
+/// Appends strings into the string table.
+class StringTable {
+  std::string Data;
+
+public:
+  StrRef add(std::string_view S) {
+    StrRef Ref{static_cast<std::uint32_t>(Data.size()),
+               static_cast<std::uint32_t>(S.size())};
+    Data += S;
+    return Ref;
+  }
+
+  StrRef addOptional(const std::optional<std::string> &S) {
+    return S ? add(*S) : StrRef{0, None};
+  }
+
+  [[nodiscard]] const std::string &data() const { return Data; }
+};
+
+} // namespace
+
+void AttrSetIndexBuilder::addScope(const Selector &Scope) {
+  Entries.emplace_back(Entry{scopeKey(Scope), true, std::nullopt});
+}
+
+void AttrSetIndexBuilder::addAttr(const Selector &Scope, std::string_view Name,
+                                  std::optional<AttrPathInfoResponse> Info) {
+  // Such names cannot be encoded in keys. Never mind, they are rare.
+  if (Name.empty() || Name.find_first_of(std::string_view("\0\x1f", 2)) !=
+                          std::string_view::npos)
+    return;
+  Entries.emplace_back(
+      Entry{scopeKey(Scope) + std::string(Name), false, std::move(Info)});
+}
+
+bool AttrSetIndexBuilder::write(const std::string &Path) {
+  std::sort(Entries.begin(), Entries.end(),
+            [](const Entry &L, const Entry &R) { return L.Key < R.Key; });
+
+  StringTable Strings;
+  std::vector<Record> Records;
+  Records.reserve(Entries.size());
+  for (const Entry &E : Entries) {
+    Record R{};
+    R.Key = Strings.add(E.Key);
+    R.Flags = E.IsScope ? RF_Scope : 0;
+    R.LocationFile = {0, None};
+    if (E.Info) {
+      const AttrPathInfoResponse &Info = *E.Info;
+      R.Flags |= RF_Info;
+      R.Type = Info.Meta.Type;
+      if (const std::optional<Location> &Loc = Info.Meta.Location) {
+        R.Flags |= RF_Location;
+        R.LocationFile = Strings.add(Loc->uri.file());
+        R.LocationLine = Loc->range.start.line;
+        R.LocationColumn = Loc->range.start.character;
+      }
+      const PackageDescription &Desc = Info.PackageDesc;
+      R.Name = Strings.addOptional(Desc.Name);
+      R.PName = Strings.addOptional(Desc.PName);
+      R.Version = Strings.addOptional(Desc.Version);
+      R.Description = Strings.addOptional(Desc.Description);
+      R.LongDescription = Strings.addOptional(Desc.LongDescription);
+      R.Position = Strings.addOptional(Desc.Position);
+      R.Homepage = Strings.addOptional(Desc.Homepage);
+    }
+    Records.emplace_back(R);
+  }
+
+  Header H{};
+  std::memcpy(H.Magic, Magic, sizeof(Magic));
+  H.Version = FormatVersion;
+  H.NumRecords = Records.size();
+  H.StringsOffset = sizeof(Header) + Records.size() * sizeof(Record);
+  H.StringsSize = Strings.data().size();
+
+  if (llvm::sys::fs::create_directories(llvm::sys::path::parent_path(Path)))
+    return false;
+
+  // Write to a temporary file first. Other processes may read it concurrently.
+  std::string Tmp = Path + ".tmp." + std::to_string(getpid());
+  {
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(Tmp, EC);
+    if (EC)
+      return false;
+    OS.write(reinterpret_cast<const char *>(&H), sizeof(H));
+    OS.write(reinterpret_cast<const char *>(Records.data()),
+             Records.size() * sizeof(Record));
+    OS << Strings.data();
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      llvm::sys::fs::remove(Tmp);
+      return false;
+    }
+  }
+  if (llvm::sys::fs::rename(Tmp, Path)) {
+    llvm::sys::fs::remove(Tmp);
+    return false;
+  }
+  return true;
+}
+
+std::optional<util::AutoCloseFD>
+AttrSetIndexBuilder::lock(const std::string &Path) {
+  if (llvm::sys::fs::create_directories(llvm::sys::path::parent_path(Path)))
+    return std::nullopt;
+  std::string LockPath = Path + ".lock";
+  int FD = ::open(LockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (FD < 0)
+    return std::nullopt;
+  util::AutoCloseFD Lock(FD);
+  while (flock(FD, LOCK_EX) < 0) {
+    if (errno != EINTR)
+      return std::nullopt;
+  }
+  return Lock;
+}
+
+std::unique_ptr<AttrSetIndex> AttrSetIndex::open(const std::string &Path) {
+  using namespace boost::interprocess;
+  if (!llvm::sys::fs::exists(Path))
+    return nullptr;
+  try {
+    file_mapping File(Path.c_str(), read_only);
+    mapped_region Region(File, read_only);
+    if (Region.get_size() < sizeof(Header))
+      return nullptr;
+    Header H;
+    std::memcpy(&H, Region.get_address(), sizeof(H));
+    if (std::memcmp(H.Magic, Magic, sizeof(Magic)) != 0 ||
+        H.Version != FormatVersion ||
+        H.StringsOffset != sizeof(Header) + H.NumRecords * sizeof(Record) ||
+        H.StringsOffset + H.StringsSize > Region.get_size())
+      return nullptr;
+    return std::unique_ptr<AttrSetIndex>(
+        new AttrSetIndex(std::move(File), std::move(Region)));
+  } catch (const interprocess_exception &) {
+    return nullptr;
+  }
+}
+
+namespace {
+
+const Header &header(const char *Data) {
+  return *reinterpret_cast<const Header *>(Data);
+}
+
+const Record &record(const char *Data, std::size_t I) {
+  return reinterpret_cast<const Record *>(Data + sizeof(Header))[I];
+}
+
+std::optional<std::string> str(const char *Data, StrRef Ref) {
+  const Header &H = header(Data);
+  if (Ref.Size == None ||
+      static_cast<std::uint64_t>(Ref.Offset) + Ref.Size > H.StringsSize)
+    return std::nullopt;
+  return std::string(Data + H.StringsOffset + Ref.Offset, Ref.Size);
+}
+
+} // namespace
+
+std::size_t AttrSetIndex::size() const { return header(data()).NumRecords; }
+
+std::string_view AttrSetIndex::key(std::size_t I) const {
+  const Header &H = header(data());
+  StrRef Ref = record(data(), I).Key;
+  if (static_cast<std::uint64_t>(Ref.Offset) + Ref.Size > H.StringsSize)
+    return {};
+  return {data() + H.StringsOffset + Ref.Offset, Ref.Size};
+}
+
+std::size_t AttrSetIndex::lowerBound(std::string_view Key) const {
+  std::size_t L = 0;
+  std::size_t R = size();
+  while (L < R) {
+    std::size_t Mid = L + (R - L) / 2;
+    if (key(Mid) < Key)
+      L = Mid + 1;
+    else
+      R = Mid;
+  }
+  return L;
+}
+
+bool AttrSetIndex::hasScope(const Selector &Scope) const {
+  std::string Key = scopeKey(Scope);
+  std::size_t I = lowerBound(Key);
+  return I < size() && key(I) == Key && (record(data(), I).Flags & RF_Scope);
+}
+
+std::vector<std::string> AttrSetIndex::names(const Selector &Scope) const {
+  std::string Key = scopeKey(Scope);
+  std::vector<std::string> Names;
+  for (std::size_t I = lowerBound(Key); I < size(); ++I) {
+    std::string_view K = key(I);
+    if (!K.starts_with(Key))
+      break;
+    if (record(data(), I).Flags & RF_Scope)
+      continue;
+    Names.emplace_back(K.substr(Key.size()));
+  }
+  return Names;
+}
+
+std::optional<AttrPathInfoResponse>
+AttrSetIndex::info(const Selector &AttrPath) const {
+  if (AttrPath.empty())
+    return std::nullopt;
+  std::string Key = scopeKey(Selector(AttrPath.begin(), AttrPath.end() - 1));
+  Key += AttrPath.back();
+  std::size_t I = lowerBound(Key);
+  if (I >= size() || key(I) != Key)
+    return std::nullopt;
+  const Record &R = record(data(), I);
+  if (!(R.Flags & RF_Info))
+    return std::nullopt;
+
+  AttrPathInfoResponse Info;
+  Info.Meta.Type = R.Type;
+  if (R.Flags & RF_Location) {
+    if (std::optional<std::string> File = str(data(), R.LocationFile)) {
+      Position Pos{static_cast<int64_t>(R.LocationLine),
+                   static_cast<int64_t>(R.LocationColumn)};
+      Info.Meta.Location = Location{
+          .uri = URIForFile::canonicalize(*File, *File),
+          .range = {Pos, Pos},
+      };
+    }
+  }
+  PackageDescription &Desc = Info.PackageDesc;
+  Desc.Name = str(data(), R.Name);
+  Desc.PName = str(data(), R.PName);
+  Desc.Version = str(data(), R.Version);
+  Desc.Description = str(data(), R.Description);
+  Desc.LongDescription = str(data(), R.LongDescription);
+  Desc.Position = str(data(), R.Position);
+  Desc.Homepage = str(data(), R.Homepage);
+  return Info;
+}
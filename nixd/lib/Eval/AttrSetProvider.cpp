@@ -3,12 +3,19 @@
 
 #include "lspserver/Protocol.h"
 
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/xxhash.h>
+
 #include <nix/cmd/common-eval-args.hh>
 #include <nix/expr/attr-path.hh>
 #include <nix/expr/nixexpr.hh>
 #include <nix/store/store-open.hh>
 #include <nixt/Value.h>
 
+#include <set>
+
 using namespace nixd;
 using namespace lspserver;
 
@@ -16,6 +23,9 @@ namespace {
 
 constexpr int MaxItems = 30;
 
+/// Maximum number of cached name indices.
+constexpr std::size_t MaxNameIndices = 64;
+
 void fillString(nix::EvalState &State, nix::Value &V,
                 const std::vector<std::string_view> &AttrPath,
                 std::optional<std::string> &Field) {
@@ -202,30 +212,6 @@ void fillOptionDescription(nix::EvalState &State, nix::Value &V,
   }
 }
 
-std::vector<std::string> completeNames(nix::Value &Scope,
-                                       const nix::EvalState &State,
-                                       std::string_view Prefix) {
-  int Num = 0;
-  std::vector<std::string> Names;
-
-  // FIXME: we may want to use "Trie" to speedup the string searching.
-  // However as my (roughtly) profiling the critical in this loop is
-  // evaluating package details.
-  // "Trie"s may not beneficial because it cannot speedup eval.
-  for (const auto *AttrPtr : Scope.attrs()->lexicographicOrder(State.symbols)) {
-    const nix::Attr &Attr = *AttrPtr;
-    const std::string_view Name = State.symbols[Attr.name];
-    if (Name.starts_with(Prefix)) {
-      ++Num;
-      Names.emplace_back(Name);
-      // We set this a very limited number as to speedup
-      if (Num > MaxItems)
-        break;
-    }
-  }
-  return Names;
-}
-
 std::optional<ValueDescription> describeValue(nix::EvalState &State,
                                               nix::Value &V) {
   if (V.isPrimOp()) {
@@ -258,6 +244,78 @@ std::optional<ValueDescription> describeValue(nix::EvalState &State,
   return std::nullopt;
 }
 
+/// Scopes stored in the index. Completion in other scopes is still served by
+/// evaluating them.
+const std::vector<Selector> IndexedScopes = {
+    {},
+    {"lib"},
+    {"python3Packages"},
+    {"haskellPackages"},
+    {"nodePackages"},
+    {"perlPackages"},
+};
+
+/// \brief Get the index file path of \p Scope, evaluated from \p Expr.
+///
+/// Only attribute sets defined entirely in the nix store are indexed, and the
+/// index is keyed by these store paths (e.g. nixpkgs revision). Others may be
+/// changed at any time.
+std::optional<std::string> indexPath(nix::EvalState &State, nix::Value &Scope,
+                                     std::string_view Expr) {
+  if (Scope.type() != nix::ValueType::nAttrs)
+    return std::nullopt;
+
+  std::set<std::string> Roots;
+  for (const nix::Attr &Attr : *Scope.attrs()) {
+    nix::Pos Pos = State.positions[Attr.pos];
+    const auto *SP = std::get_if<nix::SourcePath>(&Pos.origin);
+    if (!SP)
+      continue;
+    std::string Path = SP->path.abs();
+    if (!State.store->isInStore(Path))
+      return std::nullopt;
+    Roots.emplace(
+        State.store->printStorePath(State.store->toStorePath(Path).first));
+  }
+  if (Roots.empty())
+    return std::nullopt;
+
+  std::string Key(Expr);
+  for (const std::string &Root : Roots)
+    Key += '\0' + Root;
+
+  llvm::SmallString<128> Path;
+  if (!llvm::sys::path::cache_directory(Path))
+    return std::nullopt;
+  llvm::sys::path::append(Path, "nixd", "attrset-index",
+                          llvm::utohexstr(llvm::xxh3_64bits(Key)) + ".idx");
+  return std::string(Path);
+}
+
+/// Kinds of scopes, in keys of name indices.
+constexpr char AttrsKind = 'a';
+constexpr char OptionsKind = 'o';
+
+/// \brief Key of the name index of \p Scope.
+std::string nameIndexKey(char Kind, const Selector &Scope) {
+  std::string Key(1, Kind);
+  for (const std::string &Name : Scope) {
+    Key += '\0';
+    Key += Name;
+  }
+  return Key;
+}
+
+std::vector<std::string> attrNames(nix::EvalState &State,
+                                   const nix::Value &Scope) {
+  assert(Scope.type() == nix::ValueType::nAttrs);
+  std::vector<std::string> Names;
+  Names.reserve(Scope.attrs()->size());
+  for (const nix::Attr &Attr : *Scope.attrs())
+    Names.emplace_back(State.symbols[Attr.name]);
+  return Names;
+}
+
 } // namespace
 
 AttrSetProvider::AttrSetProvider(std::unique_ptr<InboundPort> In,
@@ -268,6 +326,8 @@ AttrSetProvider::AttrSetProvider(std::unique_ptr<InboundPort> In,
   Registry.addMethod(rpcMethod::EvalExpr, this, &AttrSetProvider::onEvalExpr);
   Registry.addMethod(rpcMethod::AttrPathInfo, this,
                      &AttrSetProvider::onAttrPathInfo);
+  Registry.addMethod(rpcMethod::AttrPathInfoBatch, this,
+                     &AttrSetProvider::onAttrPathInfoBatch);
   Registry.addMethod(rpcMethod::AttrPathComplete, this,
                      &AttrSetProvider::onAttrPathComplete);
   Registry.addMethod(rpcMethod::OptionInfo, this,
@@ -282,6 +342,10 @@ void AttrSetProvider::onEvalExpr(
   try {
     nix::Expr *AST = state().parseExprFromString(Name, state().rootPath("."));
     state().eval(AST, Nixpkgs);
+    Expr = Name;
+    Index = nullptr;
+    IndexPrepared = false;
+    NameIndices.clear();
     Reply(std::nullopt);
     return;
   } catch (const nix::BaseError &Err) {
@@ -293,44 +357,201 @@ void AttrSetProvider::onEvalExpr(
   }
 }
 
+const NameIndex &AttrSetProvider::nameIndex(
+    const std::string &Key,
+    llvm::function_ref<std::vector<std::string>()> Names) {
+  if (auto It = NameIndices.find(Key); It != NameIndices.end())
+    return It->second;
+
+  // Deep option trees may have many scopes. Do not let them grow without
+  // bound.
+  if (NameIndices.size() >= MaxNameIndices)
+    NameIndices.clear();
+
+  return NameIndices.try_emplace(Key, Names()).first->second;
+}
+
+void AttrSetProvider::prepareIndex() {
+  IndexPrepared = true;
+  IndexPath.clear();
+  try {
+    std::optional<std::string> Path = indexPath(state(), Nixpkgs, Expr);
+    if (!Path)
+      return;
+    IndexPath = std::move(*Path);
+  } catch (const std::exception &Err) {
+    lspserver::elog("cannot determine index path: {0}", Err.what());
+    return;
+  }
+
+  if ((Index = AttrSetIndex::open(IndexPath)))
+    return;
+
+  if (IndexBuilder)
+    return; // Do not build more than one index at a time.
+
+  // Builders of other workers may be running. Ours waits for them, and
+  // exits once the index is written.
+
+  std::string Exe = llvm::sys::fs::getMainExecutable(nullptr, nullptr);
+  std::string BuildIndexArg = "-build-index=" + IndexPath;
+  std::string ExprArg = "-index-expr=" + Expr;
+  llvm::StringRef Args[] = {Exe, BuildIndexArg, ExprArg};
+  // The builder must not write into our stdout, which is the RPC channel.
+  std::optional<llvm::StringRef> Redirects[] = {"", "", std::nullopt};
+  std::string ErrMsg;
+  llvm::sys::ProcessInfo PI = llvm::sys::ExecuteNoWait(
+      Exe, Args, /*Env=*/std::nullopt, Redirects, /*MemoryLimit=*/0, &ErrMsg);
+  if (PI.Pid == llvm::sys::ProcessInfo::InvalidPid) {
+    lspserver::elog("cannot launch index builder: {0}", ErrMsg);
+    return;
+  }
+  lspserver::log("building attrset index {0}, pid {1}", IndexPath, PI.Pid);
+  IndexBuilder = PI;
+}
+
+AttrSetIndex *AttrSetProvider::index() {
+  if (!IndexPrepared)
+    prepareIndex();
+  if (Index || !IndexBuilder)
+    return Index.get();
+
+  // Check if the builder has finished, without blocking.
+  llvm::sys::ProcessInfo PI =
+      llvm::sys::Wait(*IndexBuilder, /*SecondsToWait=*/0);
+  if (PI.Pid == 0)
+    return nullptr;
+  IndexBuilder.reset();
+  if (!IndexPath.empty())
+    Index = AttrSetIndex::open(IndexPath);
+  return Index.get();
+}
+
+int AttrSetProvider::buildIndex(const std::string &Expr,
+                                const std::string &Path) {
+  // Every worker of the pool may start a builder, only one of them builds.
+  std::optional<util::AutoCloseFD> Lock = AttrSetIndexBuilder::lock(Path);
+  if (!Lock) {
+    lspserver::elog("build index: cannot lock {0}", Path);
+    return 1;
+  }
+  if (AttrSetIndex::open(Path))
+    return 0; // Built by another builder, while we were waiting.
+  try {
+    nix::EvalState State({}, nix::openStore(), nix::fetchSettings,
+                         nix::evalSettings);
+    nix::Value Root;
+    State.eval(State.parseExprFromString(Expr, State.rootPath(".")), Root);
+
+    AttrSetIndexBuilder Builder;
+    for (const Selector &Scope : IndexedScopes) {
+      nix::Value *V;
+      try {
+        V = &nixt::selectStrings(State, Root, Scope);
+        State.forceValue(*V, nix::noPos);
+      } catch (const std::exception &) {
+        continue;
+      }
+      if (V->type() != nix::ValueType::nAttrs)
+        continue;
+      Builder.addScope(Scope);
+      for (const nix::Attr &Attr : *V->attrs()) {
+        std::optional<AttrPathInfoResponse> Info;
+        try {
+          State.forceValue(*Attr.value, nix::noPos);
+          if (nixt::isDerivation(State, *Attr.value))
+            Info = AttrPathInfoResponse{
+                .Meta = metadataOf(State, *Attr.value),
+                .PackageDesc = describePackage(State, *Attr.value),
+                .ValueDesc = std::nullopt,
+            };
+        } catch (const std::exception &) {
+          // Broken packages, aliases throwing errors, etc.
+        }
+        Builder.addAttr(Scope, State.symbols[Attr.name], std::move(Info));
+      }
+    }
+    return Builder.write(Path) ? 0 : 1;
+  } catch (const nix::BaseError &Err) {
+    lspserver::elog("build index: {0}", Err.info().msg.str());
+  } catch (const std::exception &Err) {
+    lspserver::elog("build index: {0}", Err.what());
+  }
+  return 1;
+}
+
+llvm::Expected<AttrPathInfoResponse>
+AttrSetProvider::attrpathInfo(const Selector &AttrPath) {
+  try {
+    if (AttrPath.empty())
+      return error("attrpath is empty!");
+
+    if (AttrSetIndex *Idx = index()) {
+      if (std::optional<AttrPathInfoResponse> Info = Idx->info(AttrPath))
+        return std::move(*Info);
+    }
+
+    nix::Value &V = nixt::selectStrings(state(), Nixpkgs, AttrPath);
+    state().forceValue(V, nix::noPos);
+    return AttrPathInfoResponse{
+        .Meta = metadataOf(state(), V),
+        .PackageDesc = describePackage(state(), V),
+        .ValueDesc = describeValue(state(), V),
+    };
+  } catch (const nix::BaseError &Err) {
+    return error(Err.info().msg.str());
+  } catch (const std::exception &Err) {
+    return error(Err.what());
+  }
+}
+
 void AttrSetProvider::onAttrPathInfo(
     const AttrPathInfoParams &AttrPath,
     lspserver::Callback<AttrPathInfoResponse> Reply) {
-  using RespT = AttrPathInfoResponse;
-  Reply([&]() -> llvm::Expected<RespT> {
-    try {
-      if (AttrPath.empty())
-        return error("attrpath is empty!");
-
-      nix::Value &V = nixt::selectStrings(state(), Nixpkgs, AttrPath);
-      state().forceValue(V, nix::noPos);
-      return RespT{
-          .Meta = metadataOf(state(), V),
-          .PackageDesc = describePackage(state(), V),
-          .ValueDesc = describeValue(state(), V),
-      };
-    } catch (const nix::BaseError &Err) {
-      return error(Err.info().msg.str());
-    } catch (const std::exception &Err) {
-      return error(Err.what());
+  Reply(attrpathInfo(AttrPath));
+}
+
+void AttrSetProvider::onAttrPathInfoBatch(
+    const AttrPathInfoBatchParams &AttrPaths,
+    lspserver::Callback<AttrPathInfoBatchResponse> Reply) {
+  AttrPathInfoBatchResponse Resp;
+  Resp.reserve(AttrPaths.size());
+  for (const Selector &AttrPath : AttrPaths) {
+    if (llvm::Expected<AttrPathInfoResponse> Info = attrpathInfo(AttrPath)) {
+      Resp.emplace_back(std::move(*Info));
+    } else {
+      llvm::consumeError(Info.takeError());
+      Resp.emplace_back(std::nullopt);
     }
-  }());
+  }
+  Reply(std::move(Resp));
 }
 
 void AttrSetProvider::onAttrPathComplete(
     const AttrPathCompleteParams &Params,
     lspserver::Callback<AttrPathCompleteResponse> Reply) {
   try {
-    nix::Value &Scope = nixt::selectStrings(state(), Nixpkgs, Params.Scope);
-
-    state().forceValue(Scope, nix::noPos);
+    std::string Key = nameIndexKey(AttrsKind, Params.Scope);
+    const NameIndex *Names = nullptr;
+    if (AttrSetIndex *Idx = index(); Idx && Idx->hasScope(Params.Scope)) {
+      Names = &nameIndex(Key, [&]() { return Idx->names(Params.Scope); });
+    } else {
+      nix::Value &Scope = nixt::selectStrings(state(), Nixpkgs, Params.Scope);
+
+      state().forceValue(Scope, nix::noPos);
+
+      if (Scope.type() != nix::ValueType::nAttrs) {
+        Reply(error("scope is not an attrset"));
+        return;
+      }
 
-    if (Scope.type() != nix::ValueType::nAttrs) {
-      Reply(error("scope is not an attrset"));
-      return;
+      Names = &nameIndex(Key, [&]() { return attrNames(state(), Scope); });
     }
 
-    return Reply(completeNames(Scope, state(), Params.Prefix));
+    std::vector<std::string> Result;
+    for (std::string_view Name : Names->complete(Params.Prefix, MaxItems + 1))
+      Result.emplace_back(Name);
+    return Reply(std::move(Result));
   } catch (const nix::BaseError &Err) {
     return Reply(error(Err.info().msg.str()));
   } catch (const std::exception &Err) {
@@ -386,29 +607,23 @@ void AttrSetProvider::onOptionComplete(
 
     std::vector<OptionField> Response;
 
-    // FIXME: we may want to use "Trie" to speedup the string searching.
-    // However as my (roughtly) profiling the critical in this loop is
-    // evaluating package details.
-    // "Trie"s may not beneficial becausae it cannot speedup eval.
-    for (const auto *AttrPtr :
-         Scope.attrs()->lexicographicOrder(state().symbols)) {
-      const nix::Attr &Attr = *AttrPtr;
-      std::string_view Name = state().symbols[Attr.name];
-      if (Name.starts_with(Params.Prefix)) {
-        // Add a new "OptionField", see it's type.
-        assert(Attr.value);
-        OptionField NewField;
-        NewField.Name = Name;
-        if (nixt::isOption(state(), *Attr.value)) {
-          OptionDescription Desc;
-          fillOptionDescription(state(), *Attr.value, Desc);
-          NewField.Description = std::move(Desc);
-        }
-        Response.emplace_back(std::move(NewField));
-        // We set this a very limited number as to speedup
-        if (Response.size() >= MaxItems)
-          break;
+    const NameIndex &Names =
+        nameIndex(nameIndexKey(OptionsKind, Params.Scope),
+                  [&]() { return attrNames(state(), Scope); });
+    for (std::string_view Name : Names.complete(Params.Prefix, MaxItems)) {
+      const nix::Attr *Attr =
+          Scope.attrs()->get(state().symbols.create(Name));
+      if (!Attr || !Attr->value)
+        continue;
+      // Add a new "OptionField", see it's type.
+      OptionField NewField;
+      NewField.Name = Name;
+      if (nixt::isOption(state(), *Attr->value)) {
+        OptionDescription Desc;
+        fillOptionDescription(state(), *Attr->value, Desc);
+        NewField.Description = std::move(Desc);
       }
+      Response.emplace_back(std::move(NewField));
     }
     Reply(std::move(Response));
     return;
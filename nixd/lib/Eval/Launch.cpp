@@ -3,6 +3,8 @@
 
 #include <llvm/Support/CommandLine.h>
 
+#include <algorithm>
+
 using namespace llvm::cl;
 using namespace nixd;
 
@@ -19,22 +21,28 @@ opt<std::string> NixpkgsWorkerStderr{
     desc("Writable file path for nixpkgs worker stderr (debugging)"),
     cat(NixdCategory), init(NULL_DEVICE)};
 
+opt<unsigned> EvalWorkers{
+    "eval-workers",
+    desc("Number of evaluator processes for nixpkgs, and each option set"),
+    cat(NixdCategory), init(1)};
+
 } // namespace
 
 void nixd::startAttrSetEval(const std::string &Name,
-                            std::unique_ptr<AttrSetClientProc> &Worker) {
-  Worker = std::make_unique<AttrSetClientProc>([&Name]() {
-    freopen(Name.c_str(), "w", stderr);
-    return execl(AttrSetClient::getExe(), "nixd-attrset-eval", nullptr);
-  });
+                            std::unique_ptr<AttrSetClientPool> &Worker) {
+  Worker = std::make_unique<AttrSetClientPool>(
+      std::max(1U, EvalWorkers.getValue()), [Name]() {
+        freopen(Name.c_str(), "w", stderr);
+        return execl(AttrSetClient::getExe(), "nixd-attrset-eval", nullptr);
+      });
 }
 
-void nixd::startNixpkgs(std::unique_ptr<AttrSetClientProc> &NixpkgsEval) {
+void nixd::startNixpkgs(std::unique_ptr<AttrSetClientPool> &NixpkgsEval) {
   startAttrSetEval(NixpkgsWorkerStderr, NixpkgsEval);
 }
 
 void nixd::startOption(const std::string &Name,
-                       std::unique_ptr<AttrSetClientProc> &Worker) {
+                       std::unique_ptr<AttrSetClientPool> &Worker) {
   std::string NewName = NULL_DEVICE;
   if (OptionWorkerStderr.getNumOccurrences())
     NewName = OptionWorkerStderr.getValue() + "/" + Name;
@@ -0,0 +1,83 @@
+#include "nixd/Eval/NameIndex.h"
+#include "nixd/Support/FuzzyMatch.h"
+
+#include <algorithm>
+#include <queue>
+#include <tuple>
+
+using namespace nixd;
+
+namespace {
+
+struct Candidate {
+  int Score;
+  std::string_view Name;
+
+  /// Better candidates are "less" than others.
+  bool operator<(const Candidate &RHS) const {
+    return std::forward_as_tuple(-Score, Name.size(), Name) <
+           std::forward_as_tuple(-RHS.Score, RHS.Name.size(), RHS.Name);
+  }
+};
+
+} // namespace
+
+NameIndex::NameIndex(std::vector<std::string> Names) : Names(std::move(Names)) {
+  std::sort(this->Names.begin(), this->Names.end());
+  this->Names.erase(std::unique(this->Names.begin(), this->Names.end()),
+                    this->Names.end());
+}
+
+std::vector<std::string_view> NameIndex::prefix(std::string_view Prefix,
+                                                std::size_t Limit) const {
+  std::vector<std::string_view> Result;
+  auto It = std::lower_bound(Names.begin(), Names.end(), Prefix);
+  for (; It != Names.end() && Result.size() < Limit; ++It) {
+    if (!It->starts_with(Prefix))
+      break;
+    Result.emplace_back(*It);
+  }
+  return Result;
+}
+
+std::vector<std::string_view> NameIndex::fuzzy(std::string_view Pattern,
+                                               std::size_t Limit) const {
+  if (!Limit)
+    return {};
+  // Keep the best "Limit" candidates, the worst one on the top.
+  std::priority_queue<Candidate> Heap;
+  for (const std::string &Name : Names) {
+    std::optional<int> Score = fuzzyMatch(Pattern, Name);
+    if (!Score)
+      continue;
+    Candidate C{*Score, Name};
+    if (Heap.size() < Limit) {
+      Heap.push(C);
+    } else if (C < Heap.top()) {
+      Heap.pop();
+      Heap.push(C);
+    }
+  }
+  std::vector<std::string_view> Result(Heap.size());
+  for (auto It = Result.rbegin(); It != Result.rend(); ++It) {
+    *It = Heap.top().Name;
+    Heap.pop();
+  }
+  return Result;
+}
+
+std::vector<std::string_view> NameIndex::complete(std::string_view Pattern,
+                                                  std::size_t Limit) const {
+  std::vector<std::string_view> Result = prefix(Pattern, Limit);
+  if (Pattern.empty() || Result.size() >= Limit)
+    return Result;
+  // Fill the rest with fuzzy matches, skipping prefix ones. All of them are
+  // already in "Result", so "Limit" fuzzy matches are enough.
+  for (std::string_view Name : fuzzy(Pattern, Limit)) {
+    if (Result.size() >= Limit)
+      break;
+    if (!Name.starts_with(Pattern))
+      Result.emplace_back(Name);
+  }
+  return Result;
+}
@@ -0,0 +1,97 @@
+#include "nixd/Support/FuzzyMatch.h"
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <vector>
+
+using namespace nixd;
+
+namespace {
+
+constexpr int Unmatched = INT_MIN / 2;
+
+constexpr int MatchScore = 1;
+constexpr int StartBonus = 8;
+constexpr int SegmentBonus = 6;
+constexpr int ConsecutiveBonus = 4;
+constexpr int CaseBonus = 1;
+constexpr int GapPenalty = 1;
+constexpr int MaxLeadingPenalty = 3;
+
+char lower(char C) {
+  return static_cast<char>(std::tolower(static_cast<unsigned char>(C)));
+}
+
+bool isUpper(char C) { return std::isupper(static_cast<unsigned char>(C)); }
+
+bool isDigit(char C) { return std::isdigit(static_cast<unsigned char>(C)); }
+
+/// Bonus of matching at \p Word[I], where a new "segment" begins.
+int positionBonus(std::string_view Word, std::size_t I) {
+  if (I == 0)
+    return StartBonus;
+  char Prev = Word[I - 1];
+  char Cur = Word[I];
+  if (Prev == '-' || Prev == '_' || Prev == '.' || Prev == '+')
+    return SegmentBonus;
+  if (isUpper(Cur) && !isUpper(Prev))
+    return SegmentBonus; // camelCase
+  if (isDigit(Cur) && !isDigit(Prev))
+    return SegmentBonus;
+  return 0;
+}
+
+/// Cheap check before computing the score.
+bool isSubsequence(std::string_view Pattern, std::string_view Word) {
+  std::size_t I = 0;
+  for (std::size_t J = 0; I < Pattern.size() && J < Word.size(); ++J) {
+    if (lower(Pattern[I]) == lower(Word[J]))
+      ++I;
+  }
+  return I == Pattern.size();
+}
+
+} // namespace
+
+std::optional<int> nixd::fuzzyMatch(std::string_view Pattern,
+                                    std::string_view Word) {
+  if (Pattern.empty())
+    return 0;
+  if (Pattern.size() > Word.size() || !isSubsequence(Pattern, Word))
+    return std::nullopt;
+
+  // Best[J]: best score of the pattern (so far) with its last character
+  // matched at Word[J].
+  std::vector<int> Prev(Word.size(), Unmatched);
+  std::vector<int> Best(Word.size(), Unmatched);
+  for (std::size_t I = 0; I < Pattern.size(); ++I) {
+    // Best score of the previous pattern character matched before J - 1,
+    // with gaps penalized.
+    int Gap = Unmatched;
+    for (std::size_t J = 0; J < Word.size(); ++J) {
+      if (I && J >= 2)
+        Gap = std::max(Gap, Prev[J - 2]) - GapPenalty;
+      Best[J] = Unmatched;
+      if (J < I || lower(Pattern[I]) != lower(Word[J]))
+        continue;
+      int Score = MatchScore + positionBonus(Word, J);
+      if (Pattern[I] == Word[J])
+        Score += CaseBonus;
+      if (I == 0) {
+        Best[J] = Score - std::min<int>(J, MaxLeadingPenalty);
+        continue;
+      }
+      int From = Gap;
+      if (J >= 1 && Prev[J - 1] != Unmatched)
+        From = std::max(From, Prev[J - 1] + ConsecutiveBonus);
+      if (From > Unmatched / 2)
+        Best[J] = From + Score;
+    }
+    std::swap(Prev, Best);
+  }
+  int Result = *std::max_element(Prev.begin(), Prev.end());
+  if (Result <= Unmatched / 2)
+    return std::nullopt;
+  return Result;
+}
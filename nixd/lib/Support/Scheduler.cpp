@@ -0,0 +1,161 @@
+#include "nixd/Support/Scheduler.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace nixd;
+
+namespace {
+
+/// The scheduler, and index of the worker running on this thread.
+thread_local const Scheduler *CurrentScheduler = nullptr;
+thread_local std::size_t CurrentWorker = 0;
+
+constexpr std::size_t index(Scheduler::Priority P) {
+  return static_cast<std::size_t>(P);
+}
+
+constexpr std::size_t Background = index(Scheduler::Priority::Background);
+
+} // namespace
+
+std::size_t Scheduler::defaultWorkers() {
+  return 2 * std::max(1U, std::thread::hardware_concurrency());
+}
+
+Scheduler::Scheduler(std::size_t NumWorkers)
+    : MaxBackground(std::max<std::size_t>(1, NumWorkers / 2)) {
+  assert(NumWorkers > 0 && "there must be some workers");
+  for (std::size_t I = 0; I < NumWorkers; ++I)
+    Workers.emplace_back(std::make_unique<Worker>());
+  // Workers look into each other's queues, so they are started once all
+  // queues exist.
+  for (std::size_t I = 0; I < NumWorkers; ++I)
+    Workers[I]->Thread = std::thread([this, I]() { run(I); });
+}
+
+void Scheduler::join() {
+  {
+    std::lock_guard _(SleepLock);
+    Stopping = true;
+  }
+  Wakeup.notify_all();
+  for (std::unique_ptr<Worker> &W : Workers) {
+    if (W->Thread.joinable())
+      W->Thread.join();
+  }
+}
+
+void Scheduler::post(Priority P, Task T) {
+  std::size_t I = CurrentScheduler == this
+                      ? CurrentWorker
+                      : NextWorker.fetch_add(1, std::memory_order_relaxed) %
+                            Workers.size();
+  {
+    // Counted under the queue lock, as it is taken, so the count never drops
+    // below zero.
+    Worker &W = *Workers[I];
+    std::lock_guard _(W.Lock);
+    W.Queues[index(P)].push_back(std::move(T));
+    Pending[index(P)].fetch_add(1);
+  }
+  wakeOne();
+}
+
+void Scheduler::wakeOne() {
+  // Sleeping workers check the counters under the lock, so they either see
+  // the change, or are notified.
+  { std::lock_guard _(SleepLock); }
+  Wakeup.notify_one();
+}
+
+void Scheduler::post(Priority P, llvm::StringRef Key,
+                     lspserver::CancellationToken Token, Task T) {
+  lspserver::CancellationToken Superseded;
+  {
+    std::lock_guard _(LatestLock);
+    lspserver::CancellationToken &Last = Latest[Key];
+    Superseded = std::move(Last);
+    Last = Token;
+  }
+  // Cancelling invokes callbacks, which may post tasks.
+  Superseded.supersede();
+  post(P, [this, Key = Key.str(), Token = std::move(Token),
+           T = std::move(T)]() mutable {
+    T();
+    // Forget the key, unless a newer task was posted with it.
+    std::lock_guard _(LatestLock);
+    auto It = Latest.find(Key);
+    if (It != Latest.end() && It->second == Token)
+      Latest.erase(It);
+  });
+}
+
+bool Scheduler::runnable() const {
+  for (std::size_t P = 0; P < NumPriorities; ++P) {
+    if (Pending[P] == 0)
+      continue;
+    if (P != Background || RunningBackground < MaxBackground)
+      return true;
+  }
+  return false;
+}
+
+bool Scheduler::take(std::size_t Self, Task &T, Priority &Taken) {
+  for (std::size_t P = 0; P < NumPriorities; ++P) {
+    if (Pending[P] == 0)
+      continue;
+    if (P == Background) {
+      // Reserve a slot for the task, before looking for it.
+      std::size_t Running = RunningBackground;
+      do {
+        if (Running >= MaxBackground)
+          return false;
+      } while (!RunningBackground.compare_exchange_weak(Running, Running + 1));
+    }
+    for (std::size_t K = 0; K < Workers.size(); ++K) {
+      Worker &W = *Workers[(Self + K) % Workers.size()];
+      std::lock_guard _(W.Lock);
+      std::deque<Task> &Queue = W.Queues[P];
+      if (Queue.empty())
+        continue;
+      T = std::move(Queue.front());
+      Queue.pop_front();
+      Pending[P].fetch_sub(1);
+      Taken = static_cast<Priority>(P);
+      return true;
+    }
+    if (P == Background) {
+      RunningBackground.fetch_sub(1);
+      wakeOne();
+    }
+  }
+  return false;
+}
+
+void Scheduler::run(std::size_t Self) {
+  CurrentScheduler = this;
+  CurrentWorker = Self;
+  for (;;) {
+    Task T;
+    Priority P;
+    if (take(Self, T, P)) {
+      T();
+      T = nullptr;
+      if (P == Priority::Background) {
+        RunningBackground.fetch_sub(1);
+        wakeOne();
+      }
+      continue;
+    }
+    // Nothing to do. Sleep, or stop if nothing is left at all.
+    auto Idle = [&]() {
+      return std::all_of(std::begin(Pending), std::end(Pending),
+                         [](const auto &N) { return N == 0; });
+    };
+    std::unique_lock L(SleepLock);
+    Wakeup.wait(L, [&]() { return runnable() || (Stopping && Idle()); });
+    if (Stopping && Idle())
+      return;
+  }
+}
@@ -11,7 +11,7 @@ std::unique_ptr<InboundPort> StreamProc::mkIn() const {
 }
 
 std::unique_ptr<OutboundPort> StreamProc::mkOut() const {
-  return std::make_unique<OutboundPort>(*Stream);
+  return std::make_unique<OutboundPort>(Proc->Stdin.get(), /*Pretty=*/false);
 }
 
 StreamProc::StreamProc(const std::function<int()> &Action) {
@@ -25,5 +25,4 @@ StreamProc::StreamProc(const std::function<int()> &Action) {
 
   // Parent process.
   Proc = std::make_unique<PipedProc>(Child, In, Out, Err);
-  Stream = std::make_unique<llvm::raw_fd_ostream>(In, false);
 }
@@ -0,0 +1,90 @@
+/// \file
+/// \brief Cancellation of requests, i.e. "$/cancelRequest".
+
+#pragma once
+
+#include <llvm/ADT/FunctionExtras.h>
+#include <llvm/Support/Error.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lspserver {
+
+/// \brief Shared by a request and everything done for it. It is cancelled
+/// when the client cancels the request, or the request is superseded.
+///
+/// Copies refer to the same state. Default constructed tokens are never
+/// cancelled.
+class CancellationToken {
+  struct State {
+    std::atomic<bool> Cancelled = false;
+    /// Set before "Cancelled", if the server cancelled the request.
+    std::atomic<bool> Superseded = false;
+    std::mutex Lock;
+    std::vector<llvm::unique_function<void()>> Callbacks; // GUARDED_BY(Lock)
+  };
+
+  std::shared_ptr<State> S;
+
+  void cancel(bool Superseded) const;
+
+public:
+  static CancellationToken create();
+
+  explicit operator bool() const { return S != nullptr; }
+
+  /// \brief Whether \p L and \p R are copies of the same token.
+  friend bool operator==(const CancellationToken &L,
+                         const CancellationToken &R) {
+    return L.S == R.S;
+  }
+
+  [[nodiscard]] bool isCancelled() const { return S && S->Cancelled; }
+
+  [[nodiscard]] bool isSuperseded() const { return S && S->Superseded; }
+
+  /// \brief Cancel the request, as the client asked, and invoke registered
+  /// callbacks.
+  void cancel() const { cancel(/*Superseded=*/false); }
+
+  /// \brief Cancel the request, because the server started a newer one in
+  /// place of it, e.g. completion at the next keystroke.
+  void supersede() const { cancel(/*Superseded=*/true); }
+
+  /// \brief Invoke \p F when the token is cancelled.
+  ///
+  /// \p F is invoked immediately if it was cancelled already.
+  void onCancel(llvm::unique_function<void()> F) const;
+
+  /// \brief The token of the request being handled on this thread.
+  static const CancellationToken &current();
+};
+
+/// \brief Make \p Token current for this thread, in the scope.
+///
+/// Calls sent to other servers (e.g. workers) in the scope are cancelled
+/// together with the token.
+class WithCancellation {
+  CancellationToken Saved;
+
+public:
+  explicit WithCancellation(CancellationToken Token);
+  ~WithCancellation();
+
+  WithCancellation(const WithCancellation &) = delete;
+  WithCancellation &operator=(const WithCancellation &) = delete;
+};
+
+/// \brief The error replied for requests cancelled by the client.
+llvm::Error cancelledError();
+
+/// \brief The error replied for the request cancelled by \p Token.
+///
+/// The client did not ask for superseded requests to be cancelled, so they
+/// are replied with "ContentModified" rather than "RequestCancelled".
+llvm::Error cancelledError(const CancellationToken &Token);
+
+} // namespace lspserver
@@ -3,10 +3,19 @@
 #include <cstdio>
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <llvm/ADT/STLFunctionalExtras.h>
+#include <llvm/ADT/SmallString.h>
 #include <llvm/Support/JSON.h>
 #include <llvm/Support/raw_ostream.h>
 #include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
 #include <unistd.h>
+#include <vector>
 
 namespace lspserver {
 
@@ -29,20 +38,66 @@ public:
                       llvm::json::Value ID) = 0;
   virtual bool onReply(llvm::json::Value ID,
                        llvm::Expected<llvm::json::Value> Result) = 0;
+
+  /// Handle a notification before its params are parsed, e.g. to decode a
+  /// large document straight into its destination. \p Params is the JSON
+  /// text, valid until this returns.
+  /// Returns std::nullopt to have the params parsed, and passed to onNotify().
+  virtual std::optional<bool> onRawNotify(llvm::StringRef Method,
+                                          llvm::StringRef Params) {
+    return std::nullopt;
+  }
 };
 
 class InboundPort {
 private:
   std::atomic<bool> Close;
 
+  /// Bytes read from \p In, but not consumed yet, are in
+  /// [ReadBegin, ReadEnd). The buffer is reused for all messages, so headers
+  /// and bodies are parsed in place, without a syscall per byte.
+  std::vector<char> ReadBuffer;
+  std::size_t ReadBegin = 0;
+  std::size_t ReadEnd = 0;
+
+  /// The last time we checked whether the client process is alive.
+  std::chrono::steady_clock::time_point LastAliveCheck;
+
+  /// Make sure there is space for at least \p Size unconsumed bytes, and
+  /// some more to read into.
+  void reserve(std::size_t Size);
+
+  /// Read available bytes into the buffer, waiting for them if necessary.
+  /// \returns false on EOF, errors, closing, or the client process died.
+  bool fill();
+
+  /// Read one line, excluding the "\n".
+  /// \p Line refers to the buffer, and is valid until the next read.
+  bool readLine(llvm::StringRef &Line);
+
 public:
+  /// Initial size of the read buffer. It grows for large messages.
+  static constexpr std::size_t InitialBufferSize = 64 * 1024;
+
   int In;
 
   JSONStreamStyle StreamStyle = JSONStreamStyle::Standard;
 
-  /// Read one message as specified in the LSP standard.
+  /// Read the JSON text of one message as specified in the LSP standard.
   /// A Language Server Protocol message starts with a set of
   /// HTTP headers, delimited  by \r\n, and terminated by an empty line (\r\n).
+  /// The text refers to the read buffer, and is valid until the next read.
+  llvm::Expected<llvm::StringRef> readStandardBody();
+
+  /// Read the JSON text of one message, expecting the input to be one of our
+  /// Markdown lit-tests. The text is kept in \p Buffer.
+  llvm::Expected<llvm::StringRef> readLitTestBody(std::string &Buffer);
+
+  /// Read the JSON text of one message depending on the configured
+  /// StreamStyle. It is valid until the next read.
+  llvm::Expected<llvm::StringRef> readBody(std::string &Buffer);
+
+  /// Read one message as specified in the LSP standard.
   llvm::Expected<llvm::json::Value> readStandardMessage(std::string &Buffer);
 
   /// Read one message, expecting the input to be one of our Markdown lit-tests.
@@ -51,9 +106,13 @@ public:
   /// \brief Notify the inbound port to close the connection
   void close() { Close = true; }
 
+  /// \brief Size of the read buffer, i.e. memory held between messages.
+  [[nodiscard]] std::size_t bufferSize() const { return ReadBuffer.size(); }
+
   InboundPort(int In = STDIN_FILENO,
               JSONStreamStyle StreamStyle = JSONStreamStyle::Standard)
-      : Close(false), In(In), StreamStyle(StreamStyle) {};
+      : Close(false), ReadBuffer(InitialBufferSize), In(In),
+        StreamStyle(StreamStyle) {};
 
   /// Read one LSP message depending on the configured StreamStyle.
   /// The parsed value is returned. The given \p Buffer is only used internally.
@@ -64,30 +123,121 @@ public:
   /// i.e. returns true to keep processing messages, or false to shut down.
   bool dispatch(llvm::json::Value Message, MessageHandler &Handler);
 
+  /// Dispatch the message in JSON text \p Message. Only the envelope is
+  /// scanned for notifications, which the handler may take before their
+  /// params are parsed, see MessageHandler::onRawNotify().
+  bool dispatchRaw(llvm::StringRef Message, MessageHandler &Handler);
+
   void loop(MessageHandler &Handler);
 };
 
+/// Writes a JSON value into the stream, e.g. the params of a notification.
+using JSONWriter = llvm::function_ref<void(llvm::json::OStream &)>;
+
+/// Messages are sent by a dedicated writer thread. Producers format the
+/// message, queue it, and return. The writer takes all queued messages at
+/// once, and writes them with a single writev(2) call.
 class OutboundPort {
+public:
+  /// Counters of the outbound path, since the port was created.
+  struct Metrics {
+    std::uint64_t Messages = 0;
+    std::uint64_t Bytes = 0;
+
+    /// Number of writes. A write carries all messages queued at that time.
+    std::uint64_t Writes = 0;
+
+    /// Number of times a producer waited, because the queue was full.
+    std::uint64_t Stalls = 0;
+
+    /// Time from queuing a message, until it is written.
+    std::chrono::nanoseconds TotalLatency{0};
+    std::chrono::nanoseconds MaxLatency{0};
+  };
+
+  /// Producers wait while this many bytes are queued, i.e. the client does
+  /// not read as fast as we write.
+  static constexpr std::size_t MaxQueuedBytes = 64 * 1024 * 1024;
+
 private:
-  llvm::raw_ostream &Outs;
+  struct Message {
+    llvm::SmallString<32> Header;
+    std::string Body;
+    std::chrono::steady_clock::time_point Queued;
+  };
+
+  /// Either messages are written to \p Out, or to \p Outs if it is set.
+  int Out = -1;
+  llvm::raw_ostream *Outs = nullptr;
 
-  llvm::SmallVector<char, 0> OutputBuffer;
+  bool Pretty = false;
 
   std::mutex Mutex;
 
-  bool Pretty = false;
+  /// Wakes the writer, when messages are queued or the port is closed.
+  std::condition_variable QueueCV;
+
+  /// Wakes producers, when the writer has written a batch.
+  std::condition_variable WrittenCV;
+
+  std::vector<Message> Queue;
+
+  /// Bytes queued, or being written.
+  std::size_t QueuedBytes = 0;
+
+  bool Closing = false;
+
+  /// The output is broken, e.g. the other side has exited.
+  bool Broken = false;
+
+  Metrics Stats;
+
+  std::thread Writer;
+
+  /// Queue the framed \p Body, waiting if the queue is full.
+  void enqueue(std::string Body);
+
+  void writeLoop();
+
+  /// Write \p Batch. \returns false if the output is broken.
+  bool write(std::vector<Message> &Batch);
 
 public:
-  explicit OutboundPort(bool Pretty = false)
-      : Outs(llvm::outs()), Pretty(Pretty) {}
-  OutboundPort(llvm::raw_ostream &Outs, bool Pretty = false)
-      : Outs(Outs), OutputBuffer(), Pretty(Pretty) {}
+  /// Write to stdout.
+  explicit OutboundPort(bool Pretty = false);
+
+  /// Write to the file descriptor \p Out, e.g. a pipe to a worker.
+  OutboundPort(int Out, bool Pretty);
+
+  /// Write to \p Outs, e.g. a string, for testing.
+  OutboundPort(llvm::raw_ostream &Outs, bool Pretty = false);
+
+  /// Write all queued messages, and stop the writer.
+  ~OutboundPort();
+
+  OutboundPort(const OutboundPort &) = delete;
+  OutboundPort &operator=(const OutboundPort &) = delete;
+
   void notify(llvm::StringRef Method, llvm::json::Value Params);
   void call(llvm::StringRef Method, llvm::json::Value Params,
             llvm::json::Value ID);
   void reply(llvm::json::Value ID, llvm::Expected<llvm::json::Value> Result);
 
+  /// \brief Notify, with params written directly into the output buffer.
+  void notify(llvm::StringRef Method, JSONWriter Params);
+
+  /// \brief Reply, with the result written directly into the output buffer.
+  void reply(llvm::json::Value ID, JSONWriter Result);
+
   void sendMessage(llvm::json::Value Message);
+
+  /// \brief Send the message written by \p Message, without building a tree.
+  void sendMessage(JSONWriter Message);
+
+  /// \brief Wait until all queued messages are written.
+  void flush();
+
+  [[nodiscard]] Metrics metrics();
 };
 
 } // namespace lspserver
@@ -9,6 +9,7 @@
 #pragma once
 
 #include "Path.h"
+#include "Rope.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/VirtualFileSystem.h"
 #include <mutex>
@@ -22,10 +23,13 @@ namespace lspserver {
 /// filenames. The contents are owned by the DraftStore.
 /// Each time a draft is updated, it is assigned a version. This can be
 /// specified by the caller or incremented from the previous version.
+///
+/// Contents are immutable ropes, so a draft is a cheap snapshot, and an edit
+/// shares the unchanged text with previous versions.
 class DraftStore {
 public:
   struct Draft {
-    std::shared_ptr<const std::string> Contents;
+    Rope Contents;
     std::string Version;
   };
 
@@ -39,8 +43,7 @@ public:
   /// Replace contents of the draft for \p File with \p Contents.
   /// If version is empty, one will be automatically assigned.
   /// Returns the version.
-  std::string addDraft(PathRef File, llvm::StringRef Version,
-                       llvm::StringRef Contents);
+  std::string addDraft(PathRef File, llvm::StringRef Version, Rope Contents);
 
   /// Remove the draft from the store.
   void removeDraft(PathRef File);
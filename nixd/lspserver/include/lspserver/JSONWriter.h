@@ -0,0 +1,59 @@
+/// \file
+/// \brief Serialize protocol structs directly into JSON text.
+///
+/// toJSON() builds a llvm::json::Value, with a node per field, which is then
+/// formatted. writeJSON() emits the same text into a llvm::json::OStream
+/// instead, for payloads that may be large, e.g. diagnostics, semantic tokens
+/// and completion lists. Other types fall back to toJSON().
+///
+/// Keys are written in sorted order, as llvm::json::Value prints them.
+
+#pragma once
+
+#include "Protocol.h"
+
+#include <llvm/Support/JSON.h>
+
+#include <optional>
+#include <vector>
+
+namespace lspserver {
+
+/// \brief Fallback, builds the tree of \p V with toJSON().
+template <class T> void writeJSON(llvm::json::OStream &J, const T &V) {
+  J.value(llvm::json::Value(V));
+}
+
+inline void writeJSON(llvm::json::OStream &J, const llvm::json::Value &V) {
+  J.value(V);
+}
+
+template <class T>
+void writeJSON(llvm::json::OStream &J, const std::vector<T> &V) {
+  J.array([&]() {
+    for (const T &E : V)
+      writeJSON(J, E);
+  });
+}
+
+template <class T>
+void writeJSON(llvm::json::OStream &J, const std::optional<T> &V) {
+  if (V)
+    writeJSON(J, *V);
+  else
+    J.value(nullptr);
+}
+
+void writeJSON(llvm::json::OStream &J, const Position &P);
+void writeJSON(llvm::json::OStream &J, const Range &R);
+void writeJSON(llvm::json::OStream &J, const Location &L);
+void writeJSON(llvm::json::OStream &J, const TextEdit &E);
+void writeJSON(llvm::json::OStream &J, const DiagnosticRelatedInformation &I);
+void writeJSON(llvm::json::OStream &J, const Diagnostic &D);
+void writeJSON(llvm::json::OStream &J, const PublishDiagnosticsParams &P);
+void writeJSON(llvm::json::OStream &J, const DocumentHighlight &H);
+void writeJSON(llvm::json::OStream &J, const CompletionItem &I);
+void writeJSON(llvm::json::OStream &J, const CompletionList &L);
+void writeJSON(llvm::json::OStream &J, const SemanticTokens &T);
+
+} // namespace lspserver
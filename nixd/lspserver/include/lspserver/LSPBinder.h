@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Function.h"
+#include "JSONWriter.h"
 #include "Logger.h"
 #include "Protocol.h"
 #include <llvm/ADT/FunctionExtras.h>
@@ -39,13 +40,18 @@ parseParam(const llvm::json::Value &Raw, llvm::StringRef PayloadName,
   return Raw;
 }
 
+/// Writes the result of a method into the reply, see writeJSON().
+using ReplyWriter = llvm::unique_function<void(llvm::json::OStream &)>;
+
 struct HandlerRegistry {
   using JSON = llvm::json::Value;
   template <typename HandlerT>
   using HandlerMap = llvm::StringMap<llvm::unique_function<HandlerT>>;
 
   HandlerMap<void(JSON)> NotificationHandlers;
-  HandlerMap<void(JSON, Callback<JSON>)> MethodHandlers;
+  /// Notifications with params parsed from their JSON text, see fromRawJSON().
+  HandlerMap<void(llvm::StringRef)> RawNotificationHandlers;
+  HandlerMap<void(JSON, Callback<ReplyWriter>)> MethodHandlers;
   HandlerMap<void(JSON, Callback<JSON>)> CommandHandlers;
 
 public:
@@ -56,12 +62,22 @@ public:
   template <typename Param, typename Result, typename ThisT>
   void addMethod(llvm::StringRef Method, ThisT *This,
                  void (ThisT::*Handler)(const Param &, Callback<Result>)) {
-    MethodHandlers[Method] = [Method, Handler, This](JSON RawParams,
-                                                     Callback<JSON> Reply) {
+    MethodHandlers[Method] = [Method, Handler,
+                              This](JSON RawParams,
+                                    Callback<ReplyWriter> Reply) {
       auto P = parseParam<Param>(RawParams, Method, "request");
       if (!P)
         return Reply(P.takeError());
-      (This->*Handler)(*P, std::move(Reply));
+      // The result is serialized when the reply is sent, without building a
+      // llvm::json::Value for it.
+      (This->*Handler)(
+          *P, [Reply = std::move(Reply)](llvm::Expected<Result> R) mutable {
+            if (!R)
+              return Reply(R.takeError());
+            Reply(ReplyWriter([V = std::move(*R)](llvm::json::OStream &J) {
+              writeJSON(J, V);
+            }));
+          });
     };
   }
 
@@ -72,12 +88,18 @@ public:
   template <typename Param, typename ThisT>
   void addNotification(llvm::StringLiteral Method, ThisT *This,
                        void (ThisT::*Handler)(const Param &)) {
-    NotificationHandlers[Method] = [Method, Handler, This](JSON RawParams) {
-      llvm::Expected<Param> P = parseParam<Param>(RawParams, Method, "request");
-      if (!P)
-        return llvm::consumeError(P.takeError());
-      (This->*Handler)(*P);
-    };
+    bindNotification<Param>(
+        Method, [Handler, This](Param &&P) { (This->*Handler)(P); });
+  }
+
+  /// Bind a handler taking the params by rvalue, which may move out of them,
+  /// e.g. the text of a document.
+  template <typename Param, typename ThisT>
+  void addNotification(llvm::StringLiteral Method, ThisT *This,
+                       void (ThisT::*Handler)(Param &&)) {
+    bindNotification<Param>(Method, [Handler, This](Param &&P) {
+      (This->*Handler)(std::move(P));
+    });
   }
 
   /// Bind a handler for an LSP command.
@@ -95,6 +117,37 @@ public:
       (This->*Handler)(*P, std::move(Reply));
     };
   }
+
+private:
+  template <typename Param, typename HandlerT>
+  void bindNotification(llvm::StringLiteral Method, HandlerT Handler) {
+    NotificationHandlers[Method] = [Method, Handler](JSON RawParams) {
+      llvm::Expected<Param> P = parseParam<Param>(RawParams, Method, "request");
+      if (!P)
+        return llvm::consumeError(P.takeError());
+      Handler(std::move(*P));
+    };
+    if constexpr (requires(llvm::StringRef Raw, Param &P) {
+                    fromRawJSON(Raw, P);
+                  }) {
+      RawNotificationHandlers[Method] = [Method,
+                                         Handler](llvm::StringRef RawParams) {
+        Param P;
+        if (fromRawJSON(RawParams, P))
+          return Handler(std::move(P));
+        // Parse it again, to report what is wrong.
+        llvm::Expected<JSON> V = llvm::json::parse(RawParams);
+        if (!V) {
+          elog("Failed to decode {0} request: {1}", Method, V.takeError());
+          return;
+        }
+        llvm::Expected<Param> Parsed = parseParam<Param>(*V, Method, "request");
+        if (!Parsed)
+          return llvm::consumeError(Parsed.takeError());
+        Handler(std::move(*Parsed));
+      };
+    }
+  }
 };
 
 } // namespace lspserver
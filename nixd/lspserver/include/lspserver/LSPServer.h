@@ -1,5 +1,6 @@
 #pragma once
 
+#include "lspserver/Cancellation.h"
 #include "lspserver/Connection.h"
 #include "lspserver/Function.h"
 #include "lspserver/LSPBinder.h"
@@ -8,7 +9,10 @@
 #include <llvm/Support/Error.h>
 #include <llvm/Support/JSON.h>
 
+#include <map>
 #include <memory>
+#include <optional>
+#include <set>
 
 namespace lspserver {
 
@@ -20,6 +24,8 @@ private:
   std::unique_ptr<OutboundPort> Out;
 
   bool onNotify(llvm::StringRef Method, llvm::json::Value) override;
+  std::optional<bool> onRawNotify(llvm::StringRef Method,
+                                  llvm::StringRef Params) override;
   bool onCall(llvm::StringRef Method, llvm::json::Value Params,
               llvm::json::Value ID) override;
   bool onReply(llvm::json::Value ID,
@@ -34,6 +40,10 @@ private:
   /// associated an error.
   std::map<int, Callback<llvm::json::Value>> PendingCalls;
 
+  /// Calls given up by cancellation, whose replies may still arrive. Those
+  /// replies are dropped quietly. GUARDED_BY(PendingCallsLock)
+  std::set<int> CancelledCalls;
+
   /// Number of maximum callbacks stored in the structure.
   /// Give an error to the oldest callback (least ID) while exceeding this
   /// value.
@@ -44,12 +54,34 @@ private:
   /// Allocate an "ID" (as returned value) for this callback.
   int bindReply(Callback<llvm::json::Value>);
 
+  std::mutex InflightLock;
+
+  /// Calls from the other side, being handled. Keyed by formatted IDs.
+  std::map<std::string, CancellationToken> Inflight; // GUARDED_BY(InflightLock)
+
+  /// Outlives the server. Cancellation callbacks check it before touching the
+  /// server, because tokens may outlive us.
+  struct Lifetime {
+    std::mutex Lock;
+    bool Alive = true; // GUARDED_BY(Lock)
+  };
+  std::shared_ptr<Lifetime> Life = std::make_shared<Lifetime>();
+
+  /// \brief Handle "$/cancelRequest".
+  void onCancelRequest(const llvm::json::Value &Params);
+
+  /// \brief Give up the pending call \p ID, and take its callback.
+  ///
+  /// The other side is not asked to cancel, workers handle calls one at a
+  /// time on their input thread, and would not read the request before
+  /// replying anyway.
+  std::optional<Callback<llvm::json::Value>> cancelCall(int ID);
+
+  /// \brief Send the call. It is cancelled together with the current
+  /// CancellationToken of this thread, and not sent at all if the token is
+  /// cancelled already.
   void callMethod(llvm::StringRef Method, llvm::json::Value Params,
-                  Callback<llvm::json::Value> CB, OutboundPort *O) {
-    llvm::json::Value ID(bindReply(std::move(CB)));
-    log("--> call {0}({1})", Method, ID.getAsInteger());
-    O->call(Method, Params, ID);
-  }
+                  Callback<llvm::json::Value> CB, OutboundPort *O);
 
 protected:
   HandlerRegistry Registry;
@@ -60,7 +92,8 @@ protected:
       O = Out.get();
     return [=](const T &Params) {
       log("--> notify {0}", Method);
-      O->notify(Method, Params);
+      O->notify(Method,
+                [&](llvm::json::OStream &J) { writeJSON(J, Params); });
     };
   }
 
@@ -87,8 +120,20 @@ public:
   LSPServer(std::unique_ptr<InboundPort> In, std::unique_ptr<OutboundPort> Out)
       : In(std::move(In)), Out(std::move(Out)) {};
 
+  ~LSPServer() override;
+
   /// \brief Close the inbound port.
   void closeInbound() { In->close(); }
+
+  /// \brief Fail all calls waiting for the response, because the other side
+  /// is known to be gone.
+  void abandonPendingCalls();
+
+  /// \brief Number of calls sent, and still waiting for the response.
+  std::size_t pendingCalls() {
+    std::lock_guard _(PendingCallsLock);
+    return PendingCalls.size();
+  }
   void run();
 
   void switchStreamStyle(JSONStreamStyle Style) { In->StreamStyle = Style; }
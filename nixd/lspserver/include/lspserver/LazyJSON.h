@@ -0,0 +1,94 @@
+/// \file
+/// \brief Scan JSON text, and parse parts of it on demand.
+///
+/// llvm::json::parse() builds the whole tree, and copies every string into
+/// it. For a message carrying a document, that is a copy of the document,
+/// which is copied again by fromJSON(). Here an object is only scanned for
+/// its members, which are parsed when they are used, and strings may be
+/// decoded straight into their destination.
+///
+/// Scanning checks the structure, i.e. strings, brackets, commas and colons,
+/// but not literals. Members are fully checked when they are parsed.
+
+#pragma once
+
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/JSON.h>
+
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace lspserver {
+
+/// \brief Decode the JSON string \p Raw, including its quotes, into \p Out.
+/// \returns false if it is not a valid string.
+bool decodeJSONString(llvm::StringRef Raw, std::string &Out);
+
+/// \brief Split the JSON array \p Raw into the text of its elements.
+bool scanJSONArray(llvm::StringRef Raw,
+                   llvm::SmallVectorImpl<llvm::StringRef> &Elements);
+
+/// \brief A JSON object, with members kept as text until they are used.
+///
+/// Members are mapped like llvm::json::ObjectMapper does.
+class LazyObject {
+  /// Keys, and text of their values.
+  llvm::SmallVector<std::pair<llvm::StringRef, llvm::StringRef>, 8> Members;
+
+public:
+  /// \brief Scan the object \p Raw, which must outlive this.
+  ///
+  /// \returns false if \p Raw is not an object, or it has a key with escapes,
+  /// which is left to llvm::json::parse().
+  bool scan(llvm::StringRef Raw);
+
+  /// \brief Text of the member \p Key, if it exists.
+  [[nodiscard]] std::optional<llvm::StringRef> get(llvm::StringRef Key) const;
+
+  /// \brief Parse member \p Key by fromJSON(). It must exist.
+  template <class T> bool map(llvm::StringRef Key, T &Out) const {
+    std::optional<llvm::StringRef> Raw = get(Key);
+    return Raw && parse(*Raw, Out);
+  }
+
+  /// \brief Decode the string member \p Key into \p Out. It must exist.
+  bool map(llvm::StringRef Key, std::string &Out) const {
+    std::optional<llvm::StringRef> Raw = get(Key);
+    return Raw && decodeJSONString(*Raw, Out);
+  }
+
+  /// \brief Parse member \p Key, or reset \p Out if it does not exist.
+  template <class T>
+  bool map(llvm::StringRef Key, std::optional<T> &Out) const {
+    std::optional<llvm::StringRef> Raw = get(Key);
+    if (!Raw) {
+      Out.reset();
+      return true;
+    }
+    return parse(*Raw, Out);
+  }
+
+  /// \brief Parse member \p Key, unless it does not exist or it is null.
+  template <class T> bool mapOptOrNull(llvm::StringRef Key, T &Out) const {
+    std::optional<llvm::StringRef> Raw = get(Key);
+    if (!Raw || *Raw == "null")
+      return true;
+    return parse(*Raw, Out);
+  }
+
+private:
+  template <class T> static bool parse(llvm::StringRef Raw, T &Out) {
+    llvm::Expected<llvm::json::Value> V = llvm::json::parse(Raw);
+    if (!V) {
+      llvm::consumeError(V.takeError());
+      return false;
+    }
+    llvm::json::Path::Root Root;
+    return fromJSON(*V, Out, Root);
+  }
+};
+
+} // namespace lspserver
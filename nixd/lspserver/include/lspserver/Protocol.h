@@ -576,6 +576,10 @@ struct ClientCapabilities {
   /// Supported encodings for LSP character offsets. (clangd extension).
   std::optional<std::vector<OffsetEncoding>> offsetEncoding;
 
+  /// Supported encodings for LSP character offsets.
+  /// general.positionEncodings
+  std::optional<std::vector<OffsetEncoding>> PositionEncodings;
+
   /// The content format that should be used for Hover requests.
   /// textDocument.hover.contentEncoding
   MarkupKind HoverContentFormat = MarkupKind::PlainText;
@@ -802,6 +806,8 @@ struct DidOpenTextDocumentParams {
 };
 bool fromJSON(const llvm::json::Value &, DidOpenTextDocumentParams &,
               llvm::json::Path);
+/// Parse \p Params lazily, decoding the text straight into \p R.
+bool fromRawJSON(llvm::StringRef Params, DidOpenTextDocumentParams &R);
 
 struct DidCloseTextDocumentParams {
   /// The document that was closed.
@@ -853,6 +859,8 @@ struct DidChangeTextDocumentParams {
 };
 bool fromJSON(const llvm::json::Value &, DidChangeTextDocumentParams &,
               llvm::json::Path);
+/// Parse \p Params lazily, decoding the texts straight into \p R.
+bool fromRawJSON(llvm::StringRef Params, DidChangeTextDocumentParams &R);
 
 enum class FileChangeType {
   /// The file got created.
@@ -0,0 +1,67 @@
+/// \file
+/// \brief Immutable document text, edited without copying the whole text.
+///
+/// A rope is a balanced tree of chunks of text. An edit copies the chunks it
+/// touches and the path to them, and shares the rest of the tree with the old
+/// rope, which is never modified. Each subtree counts its newlines, so the tree
+/// is a line index as well.
+
+#pragma once
+
+#include <llvm/ADT/StringRef.h>
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace lspserver {
+
+class Rope {
+public:
+  struct Node;
+  using NodePtr = std::shared_ptr<const Node>;
+
+private:
+  /// The tree of a snapshot, and its text flattened on demand.
+  struct Root {
+    NodePtr Tree;
+    mutable std::once_flag Flattened;
+    mutable std::shared_ptr<const std::string> Flat;
+  };
+
+  std::shared_ptr<const Root> R;
+
+  explicit Rope(NodePtr Tree);
+
+public:
+  /// \brief An empty text.
+  Rope();
+
+  explicit Rope(std::string Text);
+
+  /// \brief Size of the text in bytes.
+  [[nodiscard]] std::size_t size() const;
+
+  [[nodiscard]] bool empty() const { return size() == 0; }
+
+  /// \brief Number of lines, i.e. number of newlines plus one.
+  [[nodiscard]] std::size_t lines() const;
+
+  /// \brief Offset of the first byte of \p Line, in range [0, lines()).
+  [[nodiscard]] std::size_t lineStart(std::size_t Line) const;
+
+  /// \brief Copy of bytes in [Begin, End).
+  [[nodiscard]] std::string slice(std::size_t Begin, std::size_t End) const;
+
+  /// \brief A new rope, with bytes in [Begin, End) replaced by \p Text.
+  [[nodiscard]] Rope replace(std::size_t Begin, std::size_t End,
+                             llvm::StringRef Text) const;
+
+  /// \brief The text, contiguous.
+  ///
+  /// It is flattened once per snapshot, and then shared by all readers.
+  [[nodiscard]] std::shared_ptr<const std::string> str() const;
+};
+
+} // namespace lspserver
@@ -13,11 +13,14 @@
 #pragma once
 
 #include "Protocol.h"
+#include "Rope.h"
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/Support/Error.h"
 #include <optional>
 #include <string>
+#include <vector>
 
 namespace lspserver {
 
@@ -34,14 +37,17 @@ public:
   Key &operator=(Key &&) = delete;
 };
 
-// This context variable controls the behavior of functions in this file
-// that convert between LSP offsets and native clang byte offsets.
-// If not set, defaults to UTF-16 for backwards-compatibility.
-extern Key<OffsetEncoding> kCurrentOffsetEncoding;
+/// The encoding of LSP character offsets, used by functions in this file
+/// converting between LSP offsets and byte offsets.
+/// If not set, defaults to UTF-16 as required by the protocol.
+OffsetEncoding lspEncoding();
+
+/// Set the encoding negotiated with the client, i.e. "positionEncoding".
+void setLSPEncoding(OffsetEncoding Enc);
 
 // Counts the number of UTF-16 code units needed to represent a string (LSP
 // specifies string lengths in UTF-16 code units).
-// Use of UTF-16 may be overridden by kCurrentOffsetEncoding.
+// Use of UTF-16 may be overridden by setLSPEncoding().
 size_t lspLength(llvm::StringRef Code);
 
 /// Turn a [line, column] pair into an offset in Code.
@@ -55,10 +61,54 @@ llvm::Expected<size_t>
 positionToOffset(llvm::StringRef Code, Position P,
                  bool AllowColumnsBeyondLineLength = true);
 
+/// \see positionToOffset. The line is found with the line index of the rope,
+/// instead of scanning the text from its beginning.
+llvm::Expected<size_t>
+positionToOffset(const Rope &Code, Position P,
+                 bool AllowColumnsBeyondLineLength = true);
+
 /// Turn an offset in Code into a [line, column] pair.
 /// The offset must be in range [0, Code.size()].
 Position offsetToPosition(llvm::StringRef Code, size_t Offset);
 
+/// Start offsets of lines in a text, for converting many offsets and
+/// positions. Each conversion takes O(log n) to find the line, instead of
+/// scanning the text from its beginning.
+///
+/// Columns in all-ASCII lines are byte offsets, in every encoding, so only
+/// lines with non-ASCII characters are transcoded.
+///
+/// The table refers to Code, which must outlive it.
+class LineTable {
+  llvm::StringRef Code;
+
+  /// Offset of the first byte of each line.
+  std::vector<size_t> Starts;
+
+  /// Lines containing non-ASCII bytes.
+  llvm::BitVector NonASCII;
+
+  /// The line of Offset, which is in range [0, Code.size()].
+  [[nodiscard]] size_t lineOf(size_t Offset) const;
+
+  /// The line, without the trailing newline.
+  [[nodiscard]] llvm::StringRef line(size_t Line) const;
+
+public:
+  explicit LineTable(llvm::StringRef Code);
+
+  [[nodiscard]] llvm::StringRef code() const { return Code; }
+
+  [[nodiscard]] size_t lines() const { return Starts.size(); }
+
+  /// \see lspserver::offsetToPosition
+  [[nodiscard]] Position offsetToPosition(size_t Offset) const;
+
+  /// \see lspserver::positionToOffset
+  [[nodiscard]] llvm::Expected<size_t>
+  positionToOffset(Position P, bool AllowColumnsBeyondLineLength = true) const;
+};
+
 // Expand range `A` to also contain `B`.
 void unionRanges(Range &A, Range B);
 
@@ -66,6 +116,16 @@ void unionRanges(Range &A, Range B);
 llvm::Error applyChange(std::string &Contents,
                         const TextDocumentContentChangeEvent &Change);
 
+/// Apply an incremental update to a text document, sharing the unchanged text
+/// with the old rope.
+llvm::Error applyChange(Rope &Contents,
+                        const TextDocumentContentChangeEvent &Change);
+
+/// Apply an incremental update to a text document, taking the text of a full
+/// update without copying it.
+llvm::Error applyChange(Rope &Contents,
+                        TextDocumentContentChangeEvent &&Change);
+
 /// Collects words from the source code.
 /// Unlike collectIdentifiers:
 /// - also finds text in comments:
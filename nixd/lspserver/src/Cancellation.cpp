@@ -0,0 +1,69 @@
+#include "lspserver/Cancellation.h"
+#include "lspserver/Protocol.h"
+
+namespace lspserver {
+
+namespace {
+
+thread_local CancellationToken CurrentToken;
+
+} // namespace
+
+CancellationToken CancellationToken::create() {
+  CancellationToken Token;
+  Token.S = std::make_shared<State>();
+  return Token;
+}
+
+void CancellationToken::cancel(bool Superseded) const {
+  if (!S)
+    return;
+  std::vector<llvm::unique_function<void()>> Callbacks;
+  {
+    std::lock_guard _(S->Lock);
+    if (S->Cancelled)
+      return;
+    S->Superseded = Superseded;
+    S->Cancelled = true;
+    Callbacks = std::move(S->Callbacks);
+  }
+  // Invoke callbacks outside of the lock, they may register more.
+  for (auto &F : Callbacks)
+    F();
+}
+
+void CancellationToken::onCancel(llvm::unique_function<void()> F) const {
+  if (!S)
+    return;
+  {
+    std::lock_guard _(S->Lock);
+    if (!S->Cancelled) {
+      S->Callbacks.emplace_back(std::move(F));
+      return;
+    }
+  }
+  F();
+}
+
+const CancellationToken &CancellationToken::current() { return CurrentToken; }
+
+WithCancellation::WithCancellation(CancellationToken Token)
+    : Saved(std::move(CurrentToken)) {
+  CurrentToken = std::move(Token);
+}
+
+WithCancellation::~WithCancellation() { CurrentToken = std::move(Saved); }
+
+llvm::Error cancelledError() {
+  return llvm::make_error<LSPError>("Request cancelled",
+                                    ErrorCode::RequestCancelled);
+}
+
+llvm::Error cancelledError(const CancellationToken &Token) {
+  if (Token.isSuperseded())
+    return llvm::make_error<LSPError>("Request superseded",
+                                      ErrorCode::ContentModified);
+  return cancelledError();
+}
+
+} // namespace lspserver
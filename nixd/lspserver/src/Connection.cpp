@@ -1,17 +1,25 @@
 #include "lspserver/Connection.h"
+#include "lspserver/LazyJSON.h"
 #include "lspserver/Logger.h"
 #include "lspserver/Protocol.h"
 
 #include <llvm/ADT/SmallString.h>
+#include <llvm/Support/Chrono.h>
 #include <llvm/Support/CommandLine.h>
 
 #include <poll.h>
 #include <sys/poll.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
 #include <csignal>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <memory>
 #include <optional>
 #include <system_error>
@@ -24,12 +32,11 @@ llvm::cl::opt<int> ClientProcessID{
         "Client process ID, if this PID died, the server should exit."),
     llvm::cl::init(getppid())};
 
-std::string jsonToString(llvm::json::Value &Message) {
-  std::string Result;
-  llvm::raw_string_ostream OS(Result);
-  OS << Message;
-  return Result;
-}
+/// How often to check whether the client process is alive.
+constexpr std::chrono::seconds AliveCheckInterval{1};
+
+/// Read buffers larger than this are shrunk, once they are empty.
+constexpr std::size_t MaxRetainedBufferSize = 16 * 1024 * 1024;
 
 class ReadEOF : public llvm::ErrorInfo<ReadEOF> {
 public:
@@ -110,17 +117,193 @@ void OutboundPort::reply(llvm::json::Value ID,
   }
 }
 
+void OutboundPort::notify(llvm::StringRef Method, JSONWriter Params) {
+  // Keys are sorted, as llvm::json::Object prints them.
+  sendMessage([&](llvm::json::OStream &J) {
+    J.object([&]() {
+      J.attribute("jsonrpc", "2.0");
+      J.attribute("method", Method);
+      J.attributeBegin("params");
+      Params(J);
+      J.attributeEnd();
+    });
+  });
+}
+
+void OutboundPort::reply(llvm::json::Value ID, JSONWriter Result) {
+  sendMessage([&](llvm::json::OStream &J) {
+    J.object([&]() {
+      J.attribute("id", ID);
+      J.attribute("jsonrpc", "2.0");
+      J.attributeBegin("result");
+      Result(J);
+      J.attributeEnd();
+    });
+  });
+}
+
 void OutboundPort::sendMessage(llvm::json::Value Message) {
-  // Make sure our outputs are not interleaving between messages (json)
-  vlog(">>> {0}", Message);
-  std::lock_guard<std::mutex> Guard(Mutex);
-  OutputBuffer.clear();
-  llvm::raw_svector_ostream SVecOS(OutputBuffer);
-  SVecOS << (Pretty ? llvm::formatv("{0:2}", Message)
-                    : llvm::formatv("{0}", Message));
-  Outs << "Content-Length: " << OutputBuffer.size() << "\r\n\r\n"
-       << OutputBuffer;
-  Outs.flush();
+  sendMessage([&](llvm::json::OStream &J) { J.value(Message); });
+}
+
+void OutboundPort::sendMessage(JSONWriter Message) {
+  // Messages are formatted by the producer, so that producers do not wait
+  // for each other. The queue owns the text then, so it is not copied.
+  std::string Body;
+  {
+    llvm::raw_string_ostream OS(Body);
+    llvm::json::OStream J(OS, Pretty ? 2 : 0);
+    Message(J);
+  }
+  vlog(">>> {0}", Body);
+  enqueue(std::move(Body));
+}
+
+OutboundPort::OutboundPort(bool Pretty) : OutboundPort(STDOUT_FILENO, Pretty) {
+  // Nothing else writes to stdout, once the port is open.
+  llvm::outs().flush();
+}
+
+OutboundPort::OutboundPort(int Out, bool Pretty) : Out(Out), Pretty(Pretty) {
+  Writer = std::thread([this]() { writeLoop(); });
+}
+
+OutboundPort::OutboundPort(llvm::raw_ostream &Outs, bool Pretty)
+    : Outs(&Outs), Pretty(Pretty) {
+  Writer = std::thread([this]() { writeLoop(); });
+}
+
+OutboundPort::~OutboundPort() {
+  {
+    std::lock_guard _(Mutex);
+    Closing = true;
+  }
+  QueueCV.notify_one();
+  Writer.join();
+  if (Stats.Messages == 0)
+    return;
+  log("outbound: {0} messages, {1} bytes in {2} writes, {3} stalls, "
+      "latency: {4:us+} average, {5:us+} max",
+      Stats.Messages, Stats.Bytes, Stats.Writes, Stats.Stalls,
+      Stats.TotalLatency / static_cast<std::int64_t>(Stats.Messages),
+      Stats.MaxLatency);
+}
+
+void OutboundPort::enqueue(std::string Body) {
+  Message M;
+  llvm::raw_svector_ostream(M.Header)
+      << "Content-Length: " << Body.size() << "\r\n\r\n";
+  std::size_t Size = M.Header.size() + Body.size();
+  M.Body = std::move(Body);
+
+  std::unique_lock Lock(Mutex);
+  // A message larger than the limit is written alone.
+  auto HasRoom = [&]() {
+    return QueuedBytes == 0 || QueuedBytes + Size <= MaxQueuedBytes;
+  };
+  if (!HasRoom()) {
+    ++Stats.Stalls;
+    WrittenCV.wait(Lock, HasRoom);
+  }
+  M.Queued = std::chrono::steady_clock::now();
+  QueuedBytes += Size;
+  Queue.emplace_back(std::move(M));
+  Lock.unlock();
+  QueueCV.notify_one();
+}
+
+void OutboundPort::writeLoop() {
+  std::vector<Message> Batch;
+  for (;;) {
+    bool Skip;
+    {
+      std::unique_lock Lock(Mutex);
+      QueueCV.wait(Lock, [this]() { return !Queue.empty() || Closing; });
+      if (Queue.empty())
+        return;
+      std::swap(Batch, Queue);
+      Skip = Broken;
+    }
+
+    // Messages to a broken output are dropped.
+    bool Written = !Skip && write(Batch);
+    auto Now = std::chrono::steady_clock::now();
+
+    std::size_t Bytes = 0;
+    {
+      std::lock_guard _(Mutex);
+      for (const Message &M : Batch) {
+        Bytes += M.Header.size() + M.Body.size();
+        if (!Written)
+          continue;
+        auto Latency = Now - M.Queued;
+        Stats.TotalLatency += Latency;
+        Stats.MaxLatency = std::max(Stats.MaxLatency, Latency);
+      }
+      if (Written) {
+        Stats.Messages += Batch.size();
+        Stats.Bytes += Bytes;
+        ++Stats.Writes;
+      }
+      Broken |= !Written;
+      QueuedBytes -= Bytes;
+    }
+    WrittenCV.notify_all();
+    Batch.clear();
+  }
+}
+
+bool OutboundPort::write(std::vector<Message> &Batch) {
+  if (Outs) {
+    for (const Message &M : Batch)
+      *Outs << M.Header << M.Body;
+    Outs->flush();
+    return true;
+  }
+
+  llvm::SmallVector<iovec, 64> IOV;
+  for (Message &M : Batch) {
+    IOV.push_back({M.Header.data(), M.Header.size()});
+    if (!M.Body.empty())
+      IOV.push_back({M.Body.data(), M.Body.size()});
+  }
+  for (std::size_t I = 0; I < IOV.size();) {
+    std::size_t Count = std::min<std::size_t>(IOV.size() - I, IOV_MAX);
+    ssize_t N = writev(Out, &IOV[I], static_cast<int>(Count));
+    if (N < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        pollfd PFD{Out, POLLOUT, 0};
+        poll(&PFD, 1, -1);
+        continue;
+      }
+      log("cannot write to the output: {0}", std::strerror(errno));
+      return false;
+    }
+    // Skip buffers written, and the written part of the last one.
+    for (auto Left = static_cast<std::size_t>(N); Left > 0;) {
+      if (Left >= IOV[I].iov_len) {
+        Left -= IOV[I].iov_len;
+        ++I;
+        continue;
+      }
+      IOV[I].iov_base = static_cast<char *>(IOV[I].iov_base) + Left;
+      IOV[I].iov_len -= Left;
+      Left = 0;
+    }
+  }
+  return true;
+}
+
+void OutboundPort::flush() {
+  std::unique_lock Lock(Mutex);
+  WrittenCV.wait(Lock, [this]() { return QueuedBytes == 0; });
+}
+
+OutboundPort::Metrics OutboundPort::metrics() {
+  std::lock_guard _(Mutex);
+  return Stats;
 }
 
 bool InboundPort::dispatch(llvm::json::Value Message, MessageHandler &Handler) {
@@ -160,97 +343,167 @@ bool InboundPort::dispatch(llvm::json::Value Message, MessageHandler &Handler) {
   return Handler.onNotify(*Method, std::move(Params));
 }
 
-bool readLine(int fd, const std::atomic<bool> &Close,
-              llvm::SmallString<128> &Line) {
-  Line.clear();
+bool InboundPort::dispatchRaw(llvm::StringRef Message,
+                              MessageHandler &Handler) {
+  // Notifications, i.e. messages with a method and no ID, may be taken by
+  // the handler as text.
+  LazyObject Envelope;
+  std::string Version;
+  std::string Method;
+  if (Envelope.scan(Message) && !Envelope.get("id") &&
+      Envelope.map("jsonrpc", Version) && Version == "2.0" &&
+      Envelope.map("method", Method)) {
+    llvm::StringRef Params = Envelope.get("params").value_or("null");
+    if (std::optional<bool> Handled = Handler.onRawNotify(Method, Params))
+      return *Handled;
+  }
+  llvm::Expected<llvm::json::Value> Parsed = llvm::json::parse(Message);
+  if (!Parsed) {
+    elog("The received json cannot be parsed, reason: {0}",
+         Parsed.takeError());
+    return false;
+  }
+  return dispatch(std::move(*Parsed), Handler);
+}
 
-  std::vector<pollfd> FDs;
-  FDs.emplace_back(pollfd{
-      fd,
+void InboundPort::reserve(std::size_t Size) {
+  std::size_t Pending = ReadEnd - ReadBegin;
+  if (Pending == 0 && ReadBuffer.size() > MaxRetainedBufferSize) {
+    // Release memory held for a large message.
+    ReadBegin = ReadEnd = 0;
+    ReadBuffer.resize(InitialBufferSize);
+    ReadBuffer.shrink_to_fit();
+  }
+  if (ReadBuffer.size() - ReadBegin > Size && ReadEnd < ReadBuffer.size())
+    return;
+  // Move pending bytes to the front, so that there is room after them.
+  std::memmove(ReadBuffer.data(), ReadBuffer.data() + ReadBegin, Pending);
+  ReadBegin = 0;
+  ReadEnd = Pending;
+  if (ReadBuffer.size() <= Size)
+    ReadBuffer.resize(std::max(ReadBuffer.size() * 2, Size + 1));
+}
+
+bool InboundPort::fill() {
+  reserve(ReadEnd - ReadBegin);
+
+  pollfd FD{
+      In,
       POLLIN | POLLPRI,
       0,
-  });
+  };
   for (;;) {
-    char Ch;
-    // FIXME: inefficient
-    int Poll = poll(FDs.data(), FDs.size(), 1000);
-    if (Poll < 0)
+    int Poll = poll(&FD, 1, 1000);
+    if (Poll < 0 && errno != EINTR)
       return false;
     if (Close)
       return false;
 
-    // POLLHUB: hang up from the writer side
-    // POLLNVAL: invalid request (fd not open)
-    if (FDs[0].revents & (POLLHUP | POLLNVAL)) {
-      return false;
+    // Check the client on a timer, rather than for each read.
+    auto Now = std::chrono::steady_clock::now();
+    if (Now - LastAliveCheck >= AliveCheckInterval) {
+      LastAliveCheck = Now;
+      if (kill(ClientProcessID, 0) < 0) {
+        // Parent died.
+        return false;
+      }
     }
 
-    if (FDs[0].revents & POLLIN) {
-      ssize_t BytesRead = read(fd, &Ch, 1);
+    if (Poll <= 0)
+      continue;
+
+    if (FD.revents & POLLIN) {
+      ssize_t BytesRead = read(In, ReadBuffer.data() + ReadEnd,
+                               ReadBuffer.size() - ReadEnd);
       if (BytesRead == -1) {
-        if (errno != EINTR)
+        if (errno != EINTR && errno != EAGAIN)
           return false;
-      } else if (BytesRead == 0)
-        return false;
-      else {
-        if (Ch == '\n')
-          return true;
-        Line += Ch;
+        continue;
       }
+      if (BytesRead == 0)
+        return false;
+      ReadEnd += BytesRead;
+      return true;
     }
 
-    if (kill(ClientProcessID, 0) < 0) {
-      // Parent died.
+    // POLLHUB: hang up from the writer side
+    // POLLNVAL: invalid request (fd not open)
+    if (FD.revents & (POLLHUP | POLLNVAL | POLLERR))
       return false;
+  }
+}
+
+bool InboundPort::readLine(llvm::StringRef &Line) {
+  if (Close)
+    return false;
+  // Bytes already scanned, counted from ReadBegin.
+  std::size_t Scanned = 0;
+  for (;;) {
+    const char *Begin = ReadBuffer.data() + ReadBegin;
+    std::size_t Pending = ReadEnd - ReadBegin;
+    if (const void *NewLine =
+            std::memchr(Begin + Scanned, '\n', Pending - Scanned)) {
+      std::size_t Size = static_cast<const char *>(NewLine) - Begin;
+      Line = llvm::StringRef(Begin, Size);
+      ReadBegin += Size + 1;
+      return true;
     }
+    Scanned = Pending;
+    if (!fill())
+      return false;
   }
 }
 
-llvm::Expected<llvm::json::Value>
-InboundPort::readStandardMessage(std::string &Buffer) {
+llvm::Expected<llvm::StringRef> InboundPort::readStandardBody() {
   unsigned long long ContentLength = 0;
-  llvm::SmallString<128> Line;
+  llvm::StringRef Line;
   while (true) {
-    if (!readLine(In, Close, Line))
+    if (!readLine(Line))
       return llvm::make_error<ReadEOF>(); // EOF
 
-    llvm::StringRef LineRef = Line;
-
     // Content-Length is a mandatory header, and the only one we handle.
-    if (LineRef.consume_front("Content-Length: ")) {
-      llvm::getAsUnsignedInteger(LineRef.trim(), 0, ContentLength);
+    if (Line.consume_front("Content-Length: ")) {
+      llvm::getAsUnsignedInteger(Line.trim(), 0, ContentLength);
       continue;
     }
     // An empty line indicates the end of headers.
     // Go ahead and read the JSON.
-    if (LineRef.trim().empty())
+    if (Line.trim().empty())
       break;
     // It's another header, ignore it.
   }
 
-  Buffer.resize(ContentLength);
-  for (size_t Pos = 0, Read; Pos < ContentLength; Pos += Read) {
-
-    Read = read(In, Buffer.data() + Pos, ContentLength - Pos);
-
-    if (Read == 0) {
-      elog("Input was aborted. Read only {0} bytes of expected {1}.", Pos,
-           ContentLength);
+  // Parse the body in place, once it is entirely in the buffer.
+  reserve(ContentLength);
+  while (ReadEnd - ReadBegin < ContentLength) {
+    if (!fill()) {
+      elog("Input was aborted. Read only {0} bytes of expected {1}.",
+           ReadEnd - ReadBegin, ContentLength);
       return llvm::make_error<ReadEOF>();
     }
   }
-  return llvm::json::parse(Buffer);
+  llvm::StringRef Body(ReadBuffer.data() + ReadBegin, ContentLength);
+  ReadBegin += ContentLength;
+  return Body;
 }
 
 llvm::Expected<llvm::json::Value>
-InboundPort::readLitTestMessage(std::string &Buffer) {
+InboundPort::readStandardMessage(std::string & /*Buffer*/) {
+  llvm::Expected<llvm::StringRef> Body = readStandardBody();
+  if (!Body)
+    return Body.takeError();
+  return llvm::json::parse(*Body);
+}
+
+llvm::Expected<llvm::StringRef>
+InboundPort::readLitTestBody(std::string &Buffer) {
   enum class State { Prose, JSONBlock, NixBlock };
   State State = State::Prose;
   Buffer.clear();
-  llvm::SmallString<128> Line;
+  llvm::StringRef Line;
   std::string NixDocURI;
-  while (readLine(In, Close, Line)) {
-    auto LineRef = Line.str().trim();
+  while (readLine(Line)) {
+    auto LineRef = Line.trim();
     if (State == State::Prose) {
       if (LineRef.starts_with("```json"))
         State = State::JSONBlock;
@@ -265,17 +518,17 @@ InboundPort::readLitTestMessage(std::string &Buffer) {
 
       // End of the block
       if (LineRef.starts_with("```")) {
-        return llvm::json::parse(Buffer);
+        return llvm::StringRef(Buffer);
       }
 
-      Buffer += Line;
+      Buffer.append(Line.data(), Line.size());
     } else if (State == State::NixBlock) {
       // We are in a Nix block. (This was implemented to make the .md test
       // files more readable, particularly regarding multiline Nix documents,
       // so that the newlines don't have to be \n escaped.)
 
       if (LineRef.starts_with("```")) {
-        return llvm::json::Object{
+        llvm::json::Value Message = llvm::json::Object{
             {"jsonrpc", "2.0"},
             {"method", "textDocument/didOpen"},
             {
@@ -292,8 +545,11 @@ InboundPort::readLitTestMessage(std::string &Buffer) {
                     },
                 },
             }};
+        Buffer.clear();
+        llvm::raw_string_ostream(Buffer) << Message;
+        return llvm::StringRef(Buffer);
       }
-      Buffer += Line;
+      Buffer.append(Line.data(), Line.size());
       Buffer += "\n";
     } else {
       assert(false && "unreachable");
@@ -302,6 +558,25 @@ InboundPort::readLitTestMessage(std::string &Buffer) {
   return llvm::make_error<ReadEOF>(); // EOF
 }
 
+llvm::Expected<llvm::json::Value>
+InboundPort::readLitTestMessage(std::string &Buffer) {
+  llvm::Expected<llvm::StringRef> Body = readLitTestBody(Buffer);
+  if (!Body)
+    return Body.takeError();
+  return llvm::json::parse(*Body);
+}
+
+llvm::Expected<llvm::StringRef> InboundPort::readBody(std::string &Buffer) {
+  switch (StreamStyle) {
+  case JSONStreamStyle::Standard:
+    return readStandardBody();
+  case JSONStreamStyle::LitTest:
+    return readLitTestBody(Buffer);
+  }
+  assert(false && "Invalid stream style");
+  __builtin_unreachable();
+}
+
 llvm::Expected<llvm::json::Value>
 InboundPort::readMessage(std::string &Buffer) {
   switch (StreamStyle) {
@@ -319,9 +594,9 @@ void InboundPort::loop(MessageHandler &Handler) {
   std::string Buffer;
 
   for (;;) {
-    if (auto Message = readMessage(Buffer)) {
-      vlog("<<< {0}", jsonToString(*Message));
-      if (!dispatch(*Message, Handler))
+    if (auto Message = readBody(Buffer)) {
+      vlog("<<< {0}", *Message);
+      if (!dispatchRaw(*Message, Handler))
         return;
     } else {
       // Handle error while reading message.
@@ -86,13 +86,13 @@ std::string DraftStore::encodeVersion(std::optional<int64_t> LSPVersion) {
 }
 
 std::string DraftStore::addDraft(PathRef File, llvm::StringRef Version,
-                                 llvm::StringRef Contents) {
+                                 Rope Contents) {
   std::lock_guard<std::mutex> Lock(Mutex);
 
   auto &D = Drafts[File];
   updateVersion(D.D, Version);
   std::time(&D.MTime);
-  D.D.Contents = std::make_shared<std::string>(Contents);
+  D.D.Contents = std::move(Contents);
   return D.D.Version;
 }
 
@@ -134,7 +134,7 @@ llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> DraftStore::asVFS() const {
   for (const auto &Draft : Drafts)
     MemFS->addFile(Draft.getKey(), Draft.getValue().MTime,
                    std::make_unique<SharedStringBuffer>(
-                       Draft.getValue().D.Contents, Draft.getKey()));
+                       Draft.getValue().D.Contents.str(), Draft.getKey()));
   return MemFS;
 }
 
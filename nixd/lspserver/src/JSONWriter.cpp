@@ -0,0 +1,154 @@
+#include "lspserver/JSONWriter.h"
+
+namespace lspserver {
+
+using llvm::json::OStream;
+
+// Strings are written as llvm::StringRef, which llvm::json::Value refers to,
+// instead of copying.
+
+namespace {
+
+/// Write attribute \p Key, with \p V serialized by writeJSON().
+template <class T> void attribute(OStream &J, llvm::StringRef Key, const T &V) {
+  J.attributeBegin(Key);
+  writeJSON(J, V);
+  J.attributeEnd();
+}
+
+} // namespace
+
+void writeJSON(OStream &J, const Position &P) {
+  J.object([&]() {
+    J.attribute("character", P.character);
+    J.attribute("line", P.line);
+  });
+}
+
+void writeJSON(OStream &J, const Range &R) {
+  J.object([&]() {
+    attribute(J, "end", R.end);
+    attribute(J, "start", R.start);
+  });
+}
+
+void writeJSON(OStream &J, const Location &L) {
+  J.object([&]() {
+    attribute(J, "range", L.range);
+    J.attribute("uri", L.uri.uri());
+  });
+}
+
+void writeJSON(OStream &J, const TextEdit &E) {
+  J.object([&]() {
+    if (!E.annotationId.empty())
+      J.attribute("annotationId", llvm::StringRef(E.annotationId));
+    J.attribute("newText", llvm::StringRef(E.newText));
+    attribute(J, "range", E.range);
+  });
+}
+
+void writeJSON(OStream &J, const DiagnosticRelatedInformation &I) {
+  J.object([&]() {
+    attribute(J, "location", I.location);
+    J.attribute("message", llvm::StringRef(I.message));
+  });
+}
+
+void writeJSON(OStream &J, const Diagnostic &D) {
+  J.object([&]() {
+    if (D.category)
+      J.attribute("category", llvm::StringRef(*D.category));
+    if (!D.code.empty())
+      J.attribute("code", llvm::StringRef(D.code));
+    if (D.codeActions)
+      attribute(J, "codeActions", *D.codeActions);
+    if (D.codeDescription)
+      attribute(J, "codeDescription", *D.codeDescription);
+    if (!D.data.empty())
+      J.attribute("data", llvm::json::Object(D.data));
+    J.attribute("message", llvm::StringRef(D.message));
+    attribute(J, "range", D.range);
+    if (D.relatedInformation)
+      attribute(J, "relatedInformation", *D.relatedInformation);
+    J.attribute("severity", D.severity);
+    if (!D.source.empty())
+      J.attribute("source", llvm::StringRef(D.source));
+    if (!D.tags.empty()) {
+      J.attributeArray("tags", [&]() {
+        for (DiagnosticTag Tag : D.tags)
+          J.value(static_cast<int>(Tag));
+      });
+    }
+  });
+}
+
+void writeJSON(OStream &J, const PublishDiagnosticsParams &P) {
+  J.object([&]() {
+    attribute(J, "diagnostics", P.diagnostics);
+    J.attribute("uri", P.uri.uri());
+    if (P.version)
+      J.attribute("version", *P.version);
+  });
+}
+
+void writeJSON(OStream &J, const DocumentHighlight &H) {
+  J.object([&]() {
+    J.attribute("kind", static_cast<int>(H.kind));
+    attribute(J, "range", H.range);
+  });
+}
+
+void writeJSON(OStream &J, const CompletionItem &I) {
+  assert(!I.label.empty() && "completion item label is required");
+  J.object([&]() {
+    if (!I.additionalTextEdits.empty())
+      attribute(J, "additionalTextEdits", I.additionalTextEdits);
+    J.attribute("data", llvm::StringRef(I.data));
+    if (I.deprecated)
+      J.attribute("deprecated", I.deprecated);
+    if (!I.detail.empty())
+      J.attribute("detail", llvm::StringRef(I.detail));
+    if (I.documentation)
+      attribute(J, "documentation", *I.documentation);
+    if (!I.filterText.empty())
+      J.attribute("filterText", llvm::StringRef(I.filterText));
+    if (!I.insertText.empty())
+      J.attribute("insertText", llvm::StringRef(I.insertText));
+    if (I.insertTextFormat != InsertTextFormat::Missing)
+      J.attribute("insertTextFormat", static_cast<int>(I.insertTextFormat));
+    if (I.kind != CompletionItemKind::Missing)
+      J.attribute("kind", static_cast<int>(I.kind));
+    J.attribute("label", llvm::StringRef(I.label));
+    J.attribute("score", I.score);
+    if (!I.sortText.empty())
+      J.attribute("sortText", llvm::StringRef(I.sortText));
+    if (I.textEdit)
+      attribute(J, "textEdit", *I.textEdit);
+  });
+}
+
+void writeJSON(OStream &J, const CompletionList &L) {
+  J.object([&]() {
+    J.attribute("isIncomplete", L.isIncomplete);
+    attribute(J, "items", L.items);
+  });
+}
+
+void writeJSON(OStream &J, const SemanticTokens &T) {
+  J.object([&]() {
+    // Tokens are encoded as a flat integer array.
+    J.attributeArray("data", [&]() {
+      for (const SemanticToken &Tok : T.tokens) {
+        J.value(Tok.deltaLine);
+        J.value(Tok.deltaStart);
+        J.value(Tok.length);
+        J.value(Tok.tokenType);
+        J.value(Tok.tokenModifiers);
+      }
+    });
+    J.attribute("resultId", llvm::StringRef(T.resultId));
+  });
+}
+
+} // namespace lspserver
@@ -5,6 +5,7 @@
 #include <llvm/ADT/FunctionExtras.h>
 #include <llvm/Support/Compiler.h>
 #include <llvm/Support/Error.h>
+#include <llvm/Support/FormatVariadic.h>
 #include <llvm/Support/JSON.h>
 
 #include <mutex>
@@ -12,12 +13,98 @@
 
 namespace lspserver {
 
+namespace {
+
+std::string formatID(const llvm::json::Value &ID) {
+  return llvm::formatv("{0}", ID).str();
+}
+
+} // namespace
+
+LSPServer::~LSPServer() {
+  std::lock_guard _(Life->Lock);
+  Life->Alive = false;
+}
+
 void LSPServer::run() { In->loop(*this); }
 
+void LSPServer::abandonPendingCalls() {
+  std::map<int, Callback<llvm::json::Value>> Calls;
+  {
+    std::lock_guard _(PendingCallsLock);
+    Calls.swap(PendingCalls);
+    CancelledCalls.clear();
+  }
+  for (auto &[ID, CB] : Calls)
+    CB(error("no reply for request ({0}), the other side is gone", ID));
+}
+
+void LSPServer::onCancelRequest(const llvm::json::Value &Params) {
+  const llvm::json::Object *Obj = Params.getAsObject();
+  const llvm::json::Value *ID = Obj ? Obj->get("id") : nullptr;
+  if (!ID) {
+    elog("$/cancelRequest without an ID: {0}", Params);
+    return;
+  }
+  CancellationToken Token;
+  {
+    std::lock_guard _(InflightLock);
+    auto It = Inflight.find(formatID(*ID));
+    if (It == Inflight.end())
+      return; // Already replied.
+    Token = It->second;
+  }
+  Token.cancel();
+}
+
+std::optional<Callback<llvm::json::Value>> LSPServer::cancelCall(int ID) {
+  std::lock_guard _(PendingCallsLock);
+  auto It = PendingCalls.find(ID);
+  if (It == PendingCalls.end())
+    return std::nullopt; // Already replied.
+  Callback<llvm::json::Value> CB = std::move(It->second);
+  PendingCalls.erase(It);
+  CancelledCalls.insert(ID);
+  return CB;
+}
+
+void LSPServer::callMethod(llvm::StringRef Method, llvm::json::Value Params,
+                           Callback<llvm::json::Value> CB, OutboundPort *O) {
+  const CancellationToken &Token = CancellationToken::current();
+  if (Token.isCancelled()) {
+    log("--> call {0} skipped, cancelled", Method);
+    CB(cancelledError(Token));
+    return;
+  }
+  int ID = bindReply(std::move(CB));
+  log("--> call {0}({1})", Method, ID);
+  O->call(Method, Params, ID);
+  if (Token) {
+    Token.onCancel([Life = Life, ID, this]() {
+      // The callback is taken under the lock, and invoked without it, as it
+      // may reply and send messages.
+      std::optional<Callback<llvm::json::Value>> CB;
+      {
+        std::lock_guard _(Life->Lock);
+        if (Life->Alive)
+          CB = cancelCall(ID);
+      }
+      if (CB) {
+        log("--> cancel({0})", ID);
+        (*CB)(cancelledError());
+      }
+    });
+  }
+}
+
 bool LSPServer::onNotify(llvm::StringRef Method, llvm::json::Value Params) {
   log("<-- {0}", Method);
   if (Method == "exit")
     return false;
+  if (Method == "$/cancelRequest") {
+    onCancelRequest(Params);
+    return true;
+  }
   auto Handler = Registry.NotificationHandlers.find(Method);
   if (Handler != Registry.NotificationHandlers.end()) {
     Handler->second(std::move(Params));
@@ -27,26 +114,47 @@ bool LSPServer::onNotify(llvm::StringRef Method, llvm::json::Value Params) {
   return true;
 }
 
+std::optional<bool> LSPServer::onRawNotify(llvm::StringRef Method,
+                                           llvm::StringRef Params) {
+  auto Handler = Registry.RawNotificationHandlers.find(Method);
+  if (Handler == Registry.RawNotificationHandlers.end())
+    return std::nullopt;
+  log("<-- {0}", Method);
+  Handler->second(Params);
+  return true;
+}
+
 bool LSPServer::onCall(llvm::StringRef Method, llvm::json::Value Params,
                        llvm::json::Value ID) {
   log("<-- {0}({1})", Method, ID);
   auto Handler = Registry.MethodHandlers.find(Method);
-  if (Handler != Registry.MethodHandlers.end())
-    Handler->second(std::move(Params),
-                    [=, Method = std::string(Method),
-                     this](llvm::Expected<llvm::json::Value> Response) mutable {
-                      if (Response) {
-                        log("--> reply:{0}({1})", Method, ID);
-                        Out->reply(std::move(ID), std::move(Response));
-                      } else {
-                        llvm::Error Err = Response.takeError();
-                        log("--> reply:{0}({1}) {2:ms}, error: {3}", Method, ID,
-                            Err);
-                        Out->reply(std::move(ID), std::move(Err));
-                      }
-                    });
-  else
+  if (Handler == Registry.MethodHandlers.end())
     return false;
+
+  // Handlers may pick up the token, by CancellationToken::current().
+  CancellationToken Token = CancellationToken::create();
+  {
+    std::lock_guard _(InflightLock);
+    Inflight[formatID(ID)] = Token;
+  }
+  WithCancellation WithToken(std::move(Token));
+  Handler->second(std::move(Params),
+                  [=, Method = std::string(Method),
+                   this](llvm::Expected<ReplyWriter> Response) mutable {
+                    {
+                      std::lock_guard _(InflightLock);
+                      Inflight.erase(formatID(ID));
+                    }
+                    if (Response) {
+                      log("--> reply:{0}({1})", Method, ID);
+                      Out->reply(std::move(ID), JSONWriter(*Response));
+                    } else {
+                      llvm::Error Err = Response.takeError();
+                      log("--> reply:{0}({1}) {2:ms}, error: {3}", Method, ID,
+                          Err);
+                      Out->reply(std::move(ID), std::move(Err));
+                    }
+                  });
   return true;
 }
 
@@ -63,6 +171,10 @@ bool LSPServer::onReply(llvm::json::Value ID,
     if (PendingCalls.contains(I)) {
       CB = std::move(PendingCalls[I]);
       PendingCalls.erase(I);
+    } else if (CancelledCalls.erase(I)) {
+      log("dropped the reply({0}) of a cancelled call", ID);
+      llvm::consumeError(Result.takeError());
+      return true;
     }
   } else {
     throw std::logic_error("jsonrpc: not an integer message ID");
@@ -0,0 +1,297 @@
+#include "lspserver/LazyJSON.h"
+
+#include <llvm/ADT/StringExtras.h>
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace lspserver {
+
+namespace {
+
+bool isSpace(char C) { return C == ' ' || C == '\t' || C == '\n' || C == '\r'; }
+
+void skipSpace(llvm::StringRef S, std::size_t &I) {
+  while (I < S.size() && isSpace(S[I]))
+    ++I;
+}
+
+/// Skip the string starting at \p I, which is a quote.
+bool skipString(llvm::StringRef S, std::size_t &I) {
+  for (++I; I < S.size(); ++I) {
+    const void *Quote = std::memchr(S.data() + I, '"', S.size() - I);
+    if (!Quote)
+      return false;
+    I = static_cast<const char *>(Quote) - S.data();
+    // The quote is escaped, if it follows an odd number of backslashes.
+    std::size_t Backslashes = 0;
+    while (S[I - 1 - Backslashes] == '\\')
+      ++Backslashes;
+    if (Backslashes % 2 == 0) {
+      ++I;
+      return true;
+    }
+  }
+  return false;
+}
+
+/// Skip the value starting at \p I.
+bool skipValue(llvm::StringRef S, std::size_t &I) {
+  if (I >= S.size())
+    return false;
+  char C = S[I];
+  if (C == '"')
+    return skipString(S, I);
+  if (C != '{' && C != '[') {
+    // Numbers, and literals.
+    std::size_t Begin = I;
+    while (I < S.size() && (llvm::isAlnum(S[I]) || S[I] == '-' ||
+                            S[I] == '+' || S[I] == '.'))
+      ++I;
+    return I > Begin;
+  }
+  // Brackets are matched, their contents are checked when they are parsed.
+  llvm::SmallVector<char, 16> Closing;
+  while (I < S.size()) {
+    C = S[I];
+    if (C == '"') {
+      if (!skipString(S, I))
+        return false;
+      continue;
+    }
+    ++I;
+    if (C == '{' || C == '[') {
+      Closing.push_back(C == '{' ? '}' : ']');
+    } else if (C == '}' || C == ']') {
+      if (Closing.empty() || Closing.back() != C)
+        return false;
+      Closing.pop_back();
+      if (Closing.empty())
+        return true;
+    }
+  }
+  return false;
+}
+
+/// Scan comma separated items in \p S, from \p I to \p Close, by \p Item.
+template <class F>
+bool scanItems(llvm::StringRef S, std::size_t &I, char Close, F Item) {
+  skipSpace(S, I);
+  if (I < S.size() && S[I] == Close) {
+    ++I;
+    return true;
+  }
+  for (;;) {
+    if (!Item())
+      return false;
+    skipSpace(S, I);
+    if (I >= S.size())
+      return false;
+    if (S[I] == Close) {
+      ++I;
+      return true;
+    }
+    if (S[I] != ',')
+      return false;
+    ++I;
+    skipSpace(S, I);
+  }
+}
+
+/// Encode \p Code at \p W, and advance it.
+void appendUTF8(std::uint32_t Code, char *&W) {
+  if (Code < 0x80) {
+    *W++ = static_cast<char>(Code);
+  } else if (Code < 0x800) {
+    *W++ = static_cast<char>(0xC0 | (Code >> 6));
+    *W++ = static_cast<char>(0x80 | (Code & 0x3F));
+  } else if (Code < 0x10000) {
+    *W++ = static_cast<char>(0xE0 | (Code >> 12));
+    *W++ = static_cast<char>(0x80 | ((Code >> 6) & 0x3F));
+    *W++ = static_cast<char>(0x80 | (Code & 0x3F));
+  } else {
+    *W++ = static_cast<char>(0xF0 | (Code >> 18));
+    *W++ = static_cast<char>(0x80 | ((Code >> 12) & 0x3F));
+    *W++ = static_cast<char>(0x80 | ((Code >> 6) & 0x3F));
+    *W++ = static_cast<char>(0x80 | (Code & 0x3F));
+  }
+}
+
+/// Find the first backslash, quote or control character in [P, End).
+/// \p NonASCII is set if a non-ASCII character may have been skipped.
+const char *findSpecial(const char *P, const char *End, bool &NonASCII) {
+#if defined(__SSE2__)
+  const __m128i Backslash = _mm_set1_epi8('\\');
+  const __m128i Quote = _mm_set1_epi8('"');
+  const __m128i Control = _mm_set1_epi8(0x1F);
+  for (; End - P >= 16; P += 16) {
+    __m128i V = _mm_loadu_si128(reinterpret_cast<const __m128i *>(P));
+    NonASCII |= _mm_movemask_epi8(V) != 0;
+    // Bytes up to 0x1F are left as they are by the unsigned maximum.
+    __m128i Special = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(V, Backslash), _mm_cmpeq_epi8(V, Quote)),
+        _mm_cmpeq_epi8(_mm_max_epu8(V, Control), Control));
+    if (unsigned Mask = _mm_movemask_epi8(Special))
+      return P + __builtin_ctz(Mask);
+  }
+#endif
+  for (; P != End; ++P) {
+    auto C = static_cast<unsigned char>(*P);
+    if (C == '\\' || C == '"' || C < 0x20)
+      break;
+    NonASCII |= C >= 0x80;
+  }
+  return P;
+}
+
+/// Parse 4 hex digits at \p P, which is before \p End.
+bool parseHex4(const char *&P, const char *End, std::uint32_t &Out) {
+  if (End - P < 4)
+    return false;
+  Out = 0;
+  for (int I = 0; I < 4; ++I) {
+    unsigned Digit = llvm::hexDigitValue(*P++);
+    if (Digit == -1U)
+      return false;
+    Out = Out << 4 | Digit;
+  }
+  return true;
+}
+
+} // namespace
+
+bool decodeJSONString(llvm::StringRef Raw, std::string &Out) {
+  if (Raw.size() < 2 || Raw.front() != '"' || Raw.back() != '"')
+    return false;
+  const char *P = Raw.begin() + 1;
+  const char *End = Raw.end() - 1;
+  // Escapes are never shorter than what they stand for, so the string is
+  // decoded in place of its raw size, and shrunk at the end.
+  Out.resize(End - P);
+  char *W = Out.data();
+  // Escaped characters are valid UTF-8, others are checked if needed.
+  bool NonASCII = false;
+  while (P < End) {
+    const char *Run = P;
+    P = findSpecial(P, End, NonASCII);
+    std::memcpy(W, Run, P - Run);
+    W += P - Run;
+    if (P == End)
+      break;
+    if (*P != '\\' || ++P == End)
+      return false;
+    switch (*P++) {
+    case '"':
+      *W++ = '"';
+      break;
+    case '\\':
+      *W++ = '\\';
+      break;
+    case '/':
+      *W++ = '/';
+      break;
+    case 'b':
+      *W++ = '\b';
+      break;
+    case 'f':
+      *W++ = '\f';
+      break;
+    case 'n':
+      *W++ = '\n';
+      break;
+    case 'r':
+      *W++ = '\r';
+      break;
+    case 't':
+      *W++ = '\t';
+      break;
+    case 'u': {
+      std::uint32_t Code;
+      if (!parseHex4(P, End, Code))
+        return false;
+      // Surrogate pairs, and lone surrogates are replaced as
+      // llvm::json::parse() does.
+      if (Code >= 0xD800 && Code < 0xDC00 && End - P >= 6 && P[0] == '\\' &&
+          P[1] == 'u') {
+        const char *Low = P + 2;
+        std::uint32_t Second;
+        if (parseHex4(Low, End, Second) && Second >= 0xDC00 &&
+            Second < 0xE000) {
+          Code = 0x10000 + ((Code - 0xD800) << 10) + (Second - 0xDC00);
+          P = Low;
+        }
+      }
+      if (Code >= 0xD800 && Code < 0xE000)
+        Code = 0xFFFD;
+      appendUTF8(Code, W);
+      break;
+    }
+    default:
+      return false;
+    }
+  }
+  Out.resize(W - Out.data());
+  return !NonASCII || llvm::json::isUTF8(Out);
+}
+
+bool scanJSONArray(llvm::StringRef Raw,
+                   llvm::SmallVectorImpl<llvm::StringRef> &Elements) {
+  Elements.clear();
+  std::size_t I = 0;
+  skipSpace(Raw, I);
+  if (I >= Raw.size() || Raw[I] != '[')
+    return false;
+  ++I;
+  bool OK = scanItems(Raw, I, ']', [&]() {
+    std::size_t Begin = I;
+    if (!skipValue(Raw, I))
+      return false;
+    Elements.emplace_back(Raw.slice(Begin, I));
+    return true;
+  });
+  skipSpace(Raw, I);
+  return OK && I == Raw.size();
+}
+
+bool LazyObject::scan(llvm::StringRef Raw) {
+  Members.clear();
+  std::size_t I = 0;
+  skipSpace(Raw, I);
+  if (I >= Raw.size() || Raw[I] != '{')
+    return false;
+  ++I;
+  bool OK = scanItems(Raw, I, '}', [&]() {
+    std::size_t KeyBegin = I;
+    if (I >= Raw.size() || Raw[I] != '"' || !skipString(Raw, I))
+      return false;
+    llvm::StringRef Key = Raw.slice(KeyBegin + 1, I - 1);
+    if (Key.contains('\\'))
+      return false;
+    skipSpace(Raw, I);
+    if (I >= Raw.size() || Raw[I] != ':')
+      return false;
+    ++I;
+    skipSpace(Raw, I);
+    std::size_t ValueBegin = I;
+    if (!skipValue(Raw, I))
+      return false;
+    Members.emplace_back(Key, Raw.slice(ValueBegin, I));
+    return true;
+  });
+  skipSpace(Raw, I);
+  return OK && I == Raw.size();
+}
+
+std::optional<llvm::StringRef> LazyObject::get(llvm::StringRef Key) const {
+  // The last one wins, as in llvm::json::parse().
+  for (auto It = Members.rbegin(); It != Members.rend(); ++It) {
+    if (It->first == Key)
+      return It->second;
+  }
+  return std::nullopt;
+}
+
+} // namespace lspserver
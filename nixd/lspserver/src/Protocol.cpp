@@ -11,6 +11,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "lspserver/Protocol.h"
+#include "lspserver/LazyJSON.h"
 #include "lspserver/Logger.h"
 #include "lspserver/URI.h"
 #include <llvm/ADT/StringExtras.h>
@@ -589,6 +590,12 @@ bool fromJSON(const llvm::json::Value &Params, ClientCapabilities &R,
       if (auto Cancel = StaleRequestSupport->getBoolean("cancel"))
         R.CancelsStaleRequests = *Cancel;
     }
+    if (auto *Encodings = General->get("positionEncodings")) {
+      R.PositionEncodings.emplace();
+      if (!fromJSON(*Encodings, *R.PositionEncodings,
+                    P.field("general").field("positionEncodings")))
+        return false;
+    }
   }
   if (auto *OffsetEncoding = O->get("offsetEncoding")) {
     R.offsetEncoding.emplace();
@@ -669,6 +676,17 @@ bool fromJSON(const llvm::json::Value &Params, DidOpenTextDocumentParams &R,
   return O && O.map("textDocument", R.textDocument);
 }
 
+bool fromRawJSON(llvm::StringRef Params, DidOpenTextDocumentParams &R) {
+  LazyObject O;
+  LazyObject Doc;
+  std::optional<llvm::StringRef> TextDocument;
+  return O.scan(Params) && (TextDocument = O.get("textDocument")) &&
+         Doc.scan(*TextDocument) && Doc.map("uri", R.textDocument.uri) &&
+         Doc.map("languageId", R.textDocument.languageId) &&
+         Doc.map("version", R.textDocument.version) &&
+         Doc.map("text", R.textDocument.text);
+}
+
 bool fromJSON(const llvm::json::Value &Params, DidCloseTextDocumentParams &R,
               llvm::json::Path P) {
   llvm::json::ObjectMapper O(Params, P);
@@ -690,6 +708,27 @@ bool fromJSON(const llvm::json::Value &Params, DidChangeTextDocumentParams &R,
          mapOptOrNull(Params, "forceRebuild", R.forceRebuild, P);
 }
 
+bool fromRawJSON(llvm::StringRef Params, DidChangeTextDocumentParams &R) {
+  LazyObject O;
+  std::optional<llvm::StringRef> Changes;
+  llvm::SmallVector<llvm::StringRef, 4> Elements;
+  if (!O.scan(Params) || !O.map("textDocument", R.textDocument) ||
+      !(Changes = O.get("contentChanges")) ||
+      !scanJSONArray(*Changes, Elements))
+    return false;
+  R.contentChanges.resize(Elements.size());
+  for (std::size_t I = 0; I < Elements.size(); ++I) {
+    LazyObject Change;
+    TextDocumentContentChangeEvent &C = R.contentChanges[I];
+    if (!Change.scan(Elements[I]) || !Change.map("range", C.range) ||
+        !Change.map("rangeLength", C.rangeLength) ||
+        !Change.map("text", C.text))
+      return false;
+  }
+  return O.map("wantDiagnostics", R.wantDiagnostics) &&
+         O.mapOptOrNull("forceRebuild", R.forceRebuild);
+}
+
 bool fromJSON(const llvm::json::Value &E, FileChangeType &Out,
               llvm::json::Path P) {
   if (auto T = E.getAsInteger()) {
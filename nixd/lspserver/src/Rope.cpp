@@ -0,0 +1,259 @@
+#include "lspserver/Rope.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+namespace lspserver {
+
+/// Leaves have text, and inner nodes have two children.
+struct Rope::Node {
+  NodePtr Left;
+  NodePtr Right;
+  std::string Text;
+  std::size_t Size = 0;
+  std::size_t Newlines = 0;
+  int Height = 0;
+
+  [[nodiscard]] bool isLeaf() const { return !Left; }
+};
+
+namespace {
+
+using Node = Rope::Node;
+using NodePtr = Rope::NodePtr;
+
+/// Size of chunks, when a text is split into leaves.
+constexpr std::size_t ChunkSize = 512;
+
+/// Leaves grow up to this size, when edited in place.
+constexpr std::size_t MaxLeafSize = 2 * ChunkSize;
+
+int height(const NodePtr &T) { return T ? T->Height : -1; }
+
+NodePtr makeLeaf(std::string Text) {
+  if (Text.empty())
+    return nullptr;
+  auto Leaf = std::make_shared<Node>();
+  Leaf->Size = Text.size();
+  Leaf->Newlines = std::count(Text.begin(), Text.end(), '\n');
+  Leaf->Text = std::move(Text);
+  return Leaf;
+}
+
+NodePtr makeNode(NodePtr L, NodePtr R) {
+  auto N = std::make_shared<Node>();
+  N->Size = L->Size + R->Size;
+  N->Newlines = L->Newlines + R->Newlines;
+  N->Height = std::max(L->Height, R->Height) + 1;
+  N->Left = std::move(L);
+  N->Right = std::move(R);
+  return N;
+}
+
+/// Make a node of \p L and \p R, whose heights differ by at most 2.
+NodePtr balance(const NodePtr &L, const NodePtr &R) {
+  if (L->Height > R->Height + 1) {
+    if (height(L->Left) >= height(L->Right))
+      return makeNode(L->Left, makeNode(L->Right, R));
+    return makeNode(makeNode(L->Left, L->Right->Left),
+                    makeNode(L->Right->Right, R));
+  }
+  if (R->Height > L->Height + 1) {
+    if (height(R->Right) >= height(R->Left))
+      return makeNode(makeNode(L, R->Left), R->Right);
+    return makeNode(makeNode(L, R->Left->Left),
+                    makeNode(R->Left->Right, R->Right));
+  }
+  return makeNode(L, R);
+}
+
+/// Concatenate \p L and \p R, keeping the tree balanced. Small adjacent
+/// leaves are merged, so that typing does not leave a leaf per keystroke.
+NodePtr join(const NodePtr &L, const NodePtr &R) {
+  if (!L)
+    return R;
+  if (!R)
+    return L;
+  if (L->Height > R->Height + 1)
+    return balance(L->Left, join(L->Right, R));
+  if (R->Height > L->Height + 1)
+    return balance(join(L, R->Left), R->Right);
+  if (L->isLeaf() && R->isLeaf() && L->Size + R->Size <= MaxLeafSize)
+    return makeLeaf(L->Text + R->Text);
+  return makeNode(L, R);
+}
+
+/// Split \p T into bytes before \p Offset, and bytes after it.
+std::pair<NodePtr, NodePtr> split(const NodePtr &T, std::size_t Offset) {
+  if (!T || Offset == 0)
+    return {nullptr, T};
+  if (Offset >= T->Size)
+    return {T, nullptr};
+  if (T->isLeaf())
+    return {makeLeaf(T->Text.substr(0, Offset)),
+            makeLeaf(T->Text.substr(Offset))};
+  if (Offset <= T->Left->Size) {
+    auto [L, R] = split(T->Left, Offset);
+    return {L, join(R, T->Right)};
+  }
+  auto [L, R] = split(T->Right, Offset - T->Left->Size);
+  return {join(T->Left, L), R};
+}
+
+/// Balanced tree of \p Leaves in [Begin, End).
+NodePtr build(const std::vector<NodePtr> &Leaves, std::size_t Begin,
+              std::size_t End) {
+  if (Begin == End)
+    return nullptr;
+  if (End - Begin == 1)
+    return Leaves[Begin];
+  std::size_t Mid = Begin + (End - Begin) / 2;
+  return makeNode(build(Leaves, Begin, Mid), build(Leaves, Mid, End));
+}
+
+NodePtr build(llvm::StringRef Text) {
+  std::vector<NodePtr> Leaves;
+  Leaves.reserve(Text.size() / ChunkSize + 1);
+  for (std::size_t I = 0; I < Text.size(); I += ChunkSize)
+    Leaves.emplace_back(makeLeaf(Text.substr(I, ChunkSize).str()));
+  return build(Leaves, 0, Leaves.size());
+}
+
+/// Replace [Begin, End) by copying the path to the only leaf containing it,
+/// or return nullptr if the range spans leaves, or the leaf would be too
+/// large, or empty.
+NodePtr editLeaf(const NodePtr &T, std::size_t Begin, std::size_t End,
+                 llvm::StringRef Text) {
+  if (T->isLeaf()) {
+    std::size_t NewSize = T->Size - (End - Begin) + Text.size();
+    if (NewSize == 0 || NewSize > MaxLeafSize)
+      return nullptr;
+    std::string NewText;
+    NewText.reserve(NewSize);
+    NewText.append(T->Text, 0, Begin);
+    NewText.append(Text.data(), Text.size());
+    NewText.append(T->Text, End);
+    return makeLeaf(std::move(NewText));
+  }
+  std::size_t LeftSize = T->Left->Size;
+  if (End <= LeftSize) {
+    NodePtr L = editLeaf(T->Left, Begin, End, Text);
+    return L ? makeNode(std::move(L), T->Right) : nullptr;
+  }
+  if (Begin >= LeftSize) {
+    NodePtr R = editLeaf(T->Right, Begin - LeftSize, End - LeftSize, Text);
+    return R ? makeNode(T->Left, std::move(R)) : nullptr;
+  }
+  return nullptr;
+}
+
+void flattenInto(const Node &T, std::string &Out) {
+  if (T.isLeaf()) {
+    Out += T.Text;
+    return;
+  }
+  flattenInto(*T.Left, Out);
+  flattenInto(*T.Right, Out);
+}
+
+void sliceInto(const Node &T, std::size_t Begin, std::size_t End,
+               std::string &Out) {
+  if (T.isLeaf()) {
+    Out.append(T.Text, Begin, End - Begin);
+    return;
+  }
+  std::size_t LeftSize = T.Left->Size;
+  if (Begin < LeftSize)
+    sliceInto(*T.Left, Begin, std::min(End, LeftSize), Out);
+  if (End > LeftSize)
+    sliceInto(*T.Right, std::max(Begin, LeftSize) - LeftSize, End - LeftSize,
+              Out);
+}
+
+} // namespace
+
+Rope::Rope(NodePtr Tree) {
+  auto NewRoot = std::make_shared<Root>();
+  NewRoot->Tree = std::move(Tree);
+  R = std::move(NewRoot);
+}
+
+Rope::Rope() : Rope(NodePtr()) {}
+
+Rope::Rope(std::string Text) : Rope(build(Text)) {
+  // The text is at hand, so readers need not flatten it.
+  auto Flat = std::make_shared<const std::string>(std::move(Text));
+  std::call_once(R->Flattened, [&]() { R->Flat = std::move(Flat); });
+}
+
+std::size_t Rope::size() const { return R->Tree ? R->Tree->Size : 0; }
+
+std::size_t Rope::lines() const {
+  return (R->Tree ? R->Tree->Newlines : 0) + 1;
+}
+
+std::size_t Rope::lineStart(std::size_t Line) const {
+  assert(Line < lines() && "line out of range");
+  if (Line == 0)
+    return 0;
+  // Find the Line-th newline, counting from one.
+  std::size_t Offset = 0;
+  const Node *T = R->Tree.get();
+  while (!T->isLeaf()) {
+    if (Line <= T->Left->Newlines) {
+      T = T->Left.get();
+    } else {
+      Line -= T->Left->Newlines;
+      Offset += T->Left->Size;
+      T = T->Right.get();
+    }
+  }
+  const char *Begin = T->Text.data();
+  const char *NL = Begin;
+  for (;; ++NL) {
+    NL = static_cast<const char *>(
+        std::memchr(NL, '\n', T->Text.size() - (NL - Begin)));
+    assert(NL && "newlines are counted in the leaf");
+    if (--Line == 0)
+      break;
+  }
+  return Offset + (NL - Begin) + 1;
+}
+
+std::string Rope::slice(std::size_t Begin, std::size_t End) const {
+  End = std::min(End, size());
+  std::string Out;
+  if (Begin >= End)
+    return Out;
+  Out.reserve(End - Begin);
+  sliceInto(*R->Tree, Begin, End, Out);
+  return Out;
+}
+
+Rope Rope::replace(std::size_t Begin, std::size_t End,
+                   llvm::StringRef Text) const {
+  assert(Begin <= End && End <= size() && "range out of text");
+  // Typing usually edits a single leaf.
+  if (R->Tree && Text.size() <= ChunkSize) {
+    if (NodePtr Tree = editLeaf(R->Tree, Begin, End, Text))
+      return Rope(std::move(Tree));
+  }
+  auto [Left, Rest] = split(R->Tree, Begin);
+  auto [Removed, Right] = split(Rest, End - Begin);
+  return Rope(join(join(Left, build(Text)), Right));
+}
+
+std::shared_ptr<const std::string> Rope::str() const {
+  std::call_once(R->Flattened, [this]() {
+    auto Flat = std::make_shared<std::string>();
+    Flat->reserve(size());
+    if (R->Tree)
+      flattenInto(*R->Tree, *Flat);
+    R->Flat = std::move(Flat);
+  });
+  return R->Flat;
+}
+
+} // namespace lspserver
@@ -3,22 +3,82 @@
 #include <llvm/ADT/StringExtras.h>
 #include <llvm/Support/Errc.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <utility>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace lspserver {
 
-/// TODO: support more encodings (from clangd, using Context)
-static OffsetEncoding lspEncoding() { return OffsetEncoding::UTF16; }
+namespace {
+
+std::atomic<OffsetEncoding> CurrentEncoding = OffsetEncoding::UTF16;
+
+} // namespace
+
+OffsetEncoding lspEncoding() {
+  return CurrentEncoding.load(std::memory_order_relaxed);
+}
+
+void setLSPEncoding(OffsetEncoding Enc) {
+  assert(Enc != OffsetEncoding::UnsupportedEncoding);
+  CurrentEncoding.store(Enc, std::memory_order_relaxed);
+}
+
+// Returns the length of the leading run of ASCII characters in [Begin, End).
+//
+// Code is mostly ASCII, so this skips whole vectors of bytes at a time, and
+// only looks at bytes one by one near the first non-ASCII character.
+static size_t asciiPrefix(const char *Begin, const char *End) {
+  const char *I = Begin;
+#if defined(__AVX2__)
+  for (; End - I >= 32; I += 32) {
+    __m256i V = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(I));
+    if (unsigned Mask = _mm256_movemask_epi8(V))
+      return (I - Begin) + __builtin_ctz(Mask);
+  }
+#endif
+#if defined(__SSE2__)
+  for (; End - I >= 16; I += 16) {
+    __m128i V = _mm_loadu_si128(reinterpret_cast<const __m128i *>(I));
+    if (unsigned Mask = _mm_movemask_epi8(V))
+      return (I - Begin) + __builtin_ctz(Mask);
+  }
+#else
+  constexpr uint64_t HighBits = 0x8080808080808080ULL;
+  for (; End - I >= 8; I += 8) {
+    uint64_t Word;
+    std::memcpy(&Word, I, sizeof(Word));
+    if (Word & HighBits)
+      break;
+  }
+#endif
+  for (; I != End; ++I) {
+    if (static_cast<unsigned char>(*I) & 0x80)
+      break;
+  }
+  return I - Begin;
+}
 
+// Invokes CB(U8Len, U16Len, Chars) for each codepoint in U8, until CB returns
+// true. Runs of ASCII characters are passed at once, so Chars may be more
+// than one, and then the run may be split at any character.
 template <typename Callback>
 static bool iterateCodepoints(llvm::StringRef U8, const Callback &CB) {
   bool LoggedInvalid = false;
-  // A codepoint takes two UTF-16 code unit if it's astral (outside BMP).
-  // Astral codepoints are encoded as 4 bytes in UTF-8, starting with 11110xxx.
   for (size_t I = 0; I < U8.size();) {
     unsigned char C = static_cast<unsigned char>(U8[I]);
     if (LLVM_LIKELY(!(C & 0x80))) { // ASCII character.
-      if (CB(1, 1))
+      size_t Run = asciiPrefix(U8.data() + I, U8.data() + U8.size());
+      if (CB(Run, Run, Run))
         return true;
-      ++I;
+      I += Run;
       continue;
     }
     // This convenient property of UTF-8 holds for all non-ASCII characters.
@@ -33,7 +93,7 @@ static bool iterateCodepoints(llvm::StringRef U8, const Callback &CB) {
       // We can't give a correct result, but avoid returning something wild.
       // Pretend this is a valid ASCII byte, for lack of better options.
       // (Too late to get ISO-8859-* right, we've skipped some bytes already).
-      if (CB(1, 1))
+      if (CB(1, 1, 1))
         return true;
       ++I;
       continue;
@@ -41,7 +101,7 @@ static bool iterateCodepoints(llvm::StringRef U8, const Callback &CB) {
     I += UTF8Length; // Skip over all trailing bytes.
     // A codepoint takes two UTF-16 code unit if it's astral (outside BMP).
     // Astral codepoints are encoded as 4 bytes in UTF-8 (11110xxx ...)
-    if (CB(UTF8Length, UTF8Length == 4 ? 2 : 1))
+    if (CB(UTF8Length, UTF8Length == 4 ? 2 : 1, 1))
       return true;
   }
   return false;
@@ -55,14 +115,14 @@ size_t lspLength(llvm::StringRef Code) {
     Count = Code.size();
     break;
   case OffsetEncoding::UTF16:
-    iterateCodepoints(Code, [&](int U8Len, int U16Len) {
+    iterateCodepoints(Code, [&](size_t U8Len, size_t U16Len, size_t Chars) {
       Count += U16Len;
       return false;
     });
     break;
   case OffsetEncoding::UTF32:
-    iterateCodepoints(Code, [&](int U8Len, int U16Len) {
-      ++Count;
+    iterateCodepoints(Code, [&](size_t U8Len, size_t U16Len, size_t Chars) {
+      Count += Chars;
       return false;
     });
     break;
@@ -82,23 +142,39 @@ static size_t measureUnits(llvm::StringRef U8, int Units, OffsetEncoding Enc,
   if (Units <= 0)
     return 0;
   size_t Result = 0;
+  // Consume a run of ASCII characters, which takes one unit each.
+  auto TakeASCII = [&](size_t Chars) {
+    size_t Taken = std::min<size_t>(Chars, Units);
+    Result += Taken;
+    Units -= static_cast<int>(Taken);
+  };
   switch (Enc) {
   case OffsetEncoding::UTF8:
     Result = Units;
     break;
   case OffsetEncoding::UTF16:
-    Valid = iterateCodepoints(U8, [&](int U8Len, int U16Len) {
-      Result += U8Len;
-      Units -= U16Len;
+    Valid = iterateCodepoints(U8, [&](size_t U8Len, size_t U16Len,
+                                      size_t Chars) {
+      if (U8Len == Chars) {
+        TakeASCII(Chars);
+      } else {
+        Result += U8Len;
+        Units -= static_cast<int>(U16Len);
+      }
       return Units <= 0;
     });
     if (Units < 0) // Offset in the middle of a surrogate pair.
       Valid = false;
     break;
   case OffsetEncoding::UTF32:
-    Valid = iterateCodepoints(U8, [&](int U8Len, int U16Len) {
-      Result += U8Len;
-      Units--;
+    Valid = iterateCodepoints(U8, [&](size_t U8Len, size_t U16Len,
+                                      size_t Chars) {
+      if (U8Len == Chars) {
+        TakeASCII(Chars);
+      } else {
+        Result += U8Len;
+        Units--;
+      }
       return Units <= 0;
     });
     break;
@@ -113,24 +189,65 @@ static size_t measureUnits(llvm::StringRef U8, int Units, OffsetEncoding Enc,
   return Result;
 }
 
-llvm::Expected<size_t> positionToOffset(llvm::StringRef Code, Position P,
-                                        bool AllowColumnsBeyondLineLength) {
+/// Like positionToOffset, but start scanning at \p FromLine, which begins at
+/// \p FromOffset in Code. \p P must not be before \p FromLine.
+static llvm::Expected<size_t>
+positionToOffsetFrom(llvm::StringRef Code, Position P,
+                     bool AllowColumnsBeyondLineLength, int FromLine,
+                     size_t FromOffset) {
   if (P.line < 0)
     return error(llvm::errc::invalid_argument,
                  "Line value can't be negative ({0})", P.line);
   if (P.character < 0)
     return error(llvm::errc::invalid_argument,
                  "Character value can't be negative ({0})", P.character);
-  size_t StartOfLine = 0;
-  for (int I = 0; I != P.line; ++I) {
+  assert(FromLine <= P.line);
+  size_t StartOfLine = FromOffset;
+  for (int I = FromLine; I != P.line; ++I) {
     size_t NextNL = Code.find('\n', StartOfLine);
     if (NextNL == llvm::StringRef::npos)
       return error(llvm::errc::invalid_argument,
                    "Line value is out of range ({0})", P.line);
     StartOfLine = NextNL + 1;
   }
-  llvm::StringRef Line =
-      Code.substr(StartOfLine).take_until([](char C) { return C == '\n'; });
+  llvm::StringRef Line = Code.substr(StartOfLine);
+  Line = Line.take_front(Line.find('\n'));
+
+  // P.character may be in UTF-16, transcode if necessary.
+  bool Valid;
+  size_t ByteInLine = measureUnits(Line, P.character, lspEncoding(), Valid);
+  if (!Valid && !AllowColumnsBeyondLineLength)
+    return error(llvm::errc::invalid_argument,
+                 "{0} offset {1} is invalid for line {2}", lspEncoding(),
+                 P.character, P.line);
+  return StartOfLine + ByteInLine;
+}
+
+llvm::Expected<size_t> positionToOffset(llvm::StringRef Code, Position P,
+                                        bool AllowColumnsBeyondLineLength) {
+  return positionToOffsetFrom(Code, P, AllowColumnsBeyondLineLength, 0, 0);
+}
+
+llvm::Expected<size_t> positionToOffset(const Rope &Code, Position P,
+                                        bool AllowColumnsBeyondLineLength) {
+  if (P.line < 0)
+    return error(llvm::errc::invalid_argument,
+                 "Line value can't be negative ({0})", P.line);
+  if (P.character < 0)
+    return error(llvm::errc::invalid_argument,
+                 "Character value can't be negative ({0})", P.character);
+  if (static_cast<size_t>(P.line) >= Code.lines())
+    return error(llvm::errc::invalid_argument,
+                 "Line value is out of range ({0})", P.line);
+  size_t StartOfLine = Code.lineStart(P.line);
+  size_t EndOfLine = static_cast<size_t>(P.line) + 1 < Code.lines()
+                         ? Code.lineStart(P.line + 1) - 1
+                         : Code.size();
+  // A code unit takes at most 4 bytes, so only copy the prefix of the line
+  // that may contain P.character.
+  size_t MaxBytes = 4 * static_cast<size_t>(P.character);
+  std::string Line = Code.slice(
+      StartOfLine, StartOfLine + std::min(EndOfLine - StartOfLine, MaxBytes));
 
   // P.character may be in UTF-16, transcode if necessary.
   bool Valid;
@@ -154,6 +271,76 @@ Position offsetToPosition(llvm::StringRef Code, size_t Offset) {
   return Pos;
 }
 
+LineTable::LineTable(llvm::StringRef Code) : Code(Code) {
+  Starts.reserve(Code.size() / 32 + 1);
+  const char *Begin = Code.data();
+  const char *End = Begin + Code.size();
+  for (const char *Line = Begin;;) {
+    const auto *NL =
+        static_cast<const char *>(std::memchr(Line, '\n', End - Line));
+    const char *LineEnd = NL ? NL : End;
+    Starts.emplace_back(Line - Begin);
+    size_t Length = LineEnd - Line;
+    NonASCII.push_back(asciiPrefix(Line, LineEnd) != Length);
+    if (!NL)
+      break;
+    Line = NL + 1;
+  }
+}
+
+size_t LineTable::lineOf(size_t Offset) const {
+  // The last line starting at, or before Offset.
+  return std::upper_bound(Starts.begin(), Starts.end(), Offset) -
+         Starts.begin() - 1;
+}
+
+llvm::StringRef LineTable::line(size_t Line) const {
+  size_t End = Line + 1 < Starts.size() ? Starts[Line + 1] - 1 : Code.size();
+  return Code.slice(Starts[Line], End);
+}
+
+Position LineTable::offsetToPosition(size_t Offset) const {
+  Offset = std::min(Code.size(), Offset);
+  size_t Line = lineOf(Offset);
+  size_t Column = Offset - Starts[Line];
+  Position Pos;
+  Pos.line = static_cast<int>(Line);
+  Pos.character = NonASCII[Line]
+                      ? lspLength(Code.substr(Starts[Line], Column))
+                      : Column;
+  return Pos;
+}
+
+llvm::Expected<size_t>
+LineTable::positionToOffset(Position P,
+                            bool AllowColumnsBeyondLineLength) const {
+  if (P.line < 0)
+    return error(llvm::errc::invalid_argument,
+                 "Line value can't be negative ({0})", P.line);
+  if (P.character < 0)
+    return error(llvm::errc::invalid_argument,
+                 "Character value can't be negative ({0})", P.character);
+  if (static_cast<size_t>(P.line) >= Starts.size())
+    return error(llvm::errc::invalid_argument,
+                 "Line value is out of range ({0})", P.line);
+  llvm::StringRef Line = line(P.line);
+
+  bool Valid;
+  size_t ByteInLine;
+  if (NonASCII[P.line]) {
+    // P.character may be in UTF-16, transcode if necessary.
+    ByteInLine = measureUnits(Line, P.character, lspEncoding(), Valid);
+  } else {
+    Valid = static_cast<size_t>(P.character) <= Line.size();
+    ByteInLine = std::min<size_t>(P.character, Line.size());
+  }
+  if (!Valid && !AllowColumnsBeyondLineLength)
+    return error(llvm::errc::invalid_argument,
+                 "{0} offset {1} is invalid for line {2}", lspEncoding(),
+                 P.character, P.line);
+  return Starts[P.line] + ByteInLine;
+}
+
 // Workaround for editors that have buggy handling of newlines at end of file.
 //
 // The editor is supposed to expose document contents over LSP as an exact
@@ -201,8 +388,15 @@ llvm::Error applyChange(std::string &Contents,
   if (!StartIndex)
     return StartIndex.takeError();
 
+  // The end is usually on the line of the start, or shortly after it. Resume
+  // scanning from there rather than from the beginning of the document.
   const Position &End = Change.range->end;
-  llvm::Expected<size_t> EndIndex = positionToOffset(Contents, End, false);
+  size_t StartOfLine =
+      llvm::StringRef(Contents).substr(0, *StartIndex).rfind('\n') + 1;
+  llvm::Expected<size_t> EndIndex =
+      End.line >= Start.line
+          ? positionToOffsetFrom(Contents, End, false, Start.line, StartOfLine)
+          : positionToOffset(Contents, End, false);
   inferFinalNewline(EndIndex, Contents, End);
   if (!EndIndex)
     return EndIndex.takeError();
@@ -232,4 +426,73 @@ llvm::Error applyChange(std::string &Contents,
 
   return llvm::Error::success();
 }
+
+/// \see inferFinalNewline(llvm::Expected<size_t> &, std::string &, const
+/// Position &)
+static void inferFinalNewline(llvm::Expected<size_t> &Err, Rope &Contents,
+                              const Position &Pos) {
+  if (Err)
+    return;
+  if (!Contents.empty() &&
+      Contents.slice(Contents.size() - 1, Contents.size()) == "\n")
+    return;
+  if (Pos.character != 0)
+    return;
+  if (static_cast<size_t>(Pos.line) != Contents.lines())
+    return;
+  log("Editor sent invalid change coordinates, inferring newline at EOF");
+  Contents = Contents.replace(Contents.size(), Contents.size(), "\n");
+  consumeError(Err.takeError());
+  Err = Contents.size();
+}
+
+llvm::Error applyChange(Rope &Contents,
+                        const TextDocumentContentChangeEvent &Change) {
+  if (!Change.range) {
+    Contents = Rope(Change.text);
+    return llvm::Error::success();
+  }
+
+  const Position &Start = Change.range->start;
+  llvm::Expected<size_t> StartIndex = positionToOffset(Contents, Start, false);
+  inferFinalNewline(StartIndex, Contents, Start);
+  if (!StartIndex)
+    return StartIndex.takeError();
+
+  const Position &End = Change.range->end;
+  llvm::Expected<size_t> EndIndex = positionToOffset(Contents, End, false);
+  inferFinalNewline(EndIndex, Contents, End);
+  if (!EndIndex)
+    return EndIndex.takeError();
+
+  if (*EndIndex < *StartIndex)
+    return error(llvm::errc::invalid_argument,
+                 "Range's end position ({0}) is before start position ({1})",
+                 End, Start);
+
+  // Verify that the buffers of the client and server are in sync, as in
+  // applyChange(std::string &, ...).
+  if (Change.rangeLength) {
+    ssize_t ComputedRangeLength =
+        lspLength(Contents.slice(*StartIndex, *EndIndex));
+    if (ComputedRangeLength != *Change.rangeLength)
+      return error(llvm::errc::invalid_argument,
+                   "Change's rangeLength ({0}) doesn't match the "
+                   "computed range length ({1}).",
+                   *Change.rangeLength, ComputedRangeLength);
+  }
+
+  Contents = Contents.replace(*StartIndex, *EndIndex, Change.text);
+
+  return llvm::Error::success();
+}
+
+llvm::Error applyChange(Rope &Contents,
+                        TextDocumentContentChangeEvent &&Change) {
+  if (!Change.range) {
+    Contents = Rope(std::move(Change.text));
+    return llvm::Error::success();
+  }
+  return applyChange(Contents, std::as_const(Change));
+}
 } // namespace lspserver
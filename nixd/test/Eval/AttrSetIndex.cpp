@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+
+#include "nixd/Eval/AttrSetIndex.h"
+
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <fcntl.h>
+#include <sys/file.h>
+
+using namespace nixd;
+
+namespace {
+
+struct AttrSetIndexTest : testing::Test {
+  llvm::SmallString<128> Dir;
+  std::string Path;
+
+  void SetUp() override {
+    ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("nixd-index", Dir));
+    Path = std::string(Dir) + "/sub/nixpkgs.idx";
+  }
+
+  void TearDown() override { llvm::sys::fs::remove_directories(Dir); }
+
+  /// Write an index of nixpkgs-like attributes into "Path".
+  void writeIndex() {
+    AttrSetIndexBuilder Builder;
+    Builder.addScope({});
+    Builder.addAttr({}, "hello",
+                    AttrPathInfoResponse{
+                        .Meta = {.Type = 7, .Location = std::nullopt},
+                        .PackageDesc = {.Name = "hello-2.12",
+                                        .PName = "hello",
+                                        .Version = "2.12",
+                                        .Description = "A program"},
+                        .ValueDesc = std::nullopt,
+                    });
+    Builder.addAttr({}, "lib", std::nullopt);
+    Builder.addAttr({}, "python3Packages", std::nullopt);
+    Builder.addScope({"lib"});
+    Builder.addAttr({"lib"}, "mkIf", std::nullopt);
+    Builder.addAttr({"lib"}, "mkOption", std::nullopt);
+    // Not encodable, skipped.
+    Builder.addAttr({"lib"}, std::string_view("a\0b", 3), std::nullopt);
+    ASSERT_TRUE(Builder.write(Path));
+  }
+
+  /// Replace the file with the first \p Size bytes of it.
+  void truncate(std::size_t Size) {
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buf =
+        llvm::MemoryBuffer::getFile(Path);
+    ASSERT_TRUE(Buf);
+    std::string Data = (*Buf)->getBuffer().take_front(Size).str();
+    Buf->reset();
+    overwrite(Data);
+  }
+
+  void overwrite(llvm::StringRef Data) {
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(Path, EC);
+    ASSERT_FALSE(EC);
+    OS << Data;
+  }
+};
+
+TEST_F(AttrSetIndexTest, RoundTrip) {
+  writeIndex();
+  std::unique_ptr<AttrSetIndex> Index = AttrSetIndex::open(Path);
+  ASSERT_TRUE(Index);
+
+  ASSERT_TRUE(Index->hasScope({}));
+  ASSERT_TRUE(Index->hasScope({"lib"}));
+  ASSERT_FALSE(Index->hasScope({"python3Packages"}));
+
+  ASSERT_EQ(Index->names({}),
+            (std::vector<std::string>{"hello", "lib", "python3Packages"}));
+  ASSERT_EQ(Index->names({"lib"}),
+            (std::vector<std::string>{"mkIf", "mkOption"}));
+  ASSERT_TRUE(Index->names({"python3Packages"}).empty());
+
+  std::optional<AttrPathInfoResponse> Info = Index->info({"hello"});
+  ASSERT_TRUE(Info);
+  ASSERT_EQ(Info->Meta.Type, 7);
+  ASSERT_FALSE(Info->Meta.Location);
+  ASSERT_EQ(Info->PackageDesc.PName, "hello");
+  ASSERT_EQ(Info->PackageDesc.Version, "2.12");
+  ASSERT_EQ(Info->PackageDesc.Description, "A program");
+  ASSERT_FALSE(Info->PackageDesc.Homepage);
+
+  ASSERT_FALSE(Index->info({"lib"}));
+  ASSERT_FALSE(Index->info({"lib", "mkIf"}));
+  ASSERT_FALSE(Index->info({"missing"}));
+}
+
+TEST_F(AttrSetIndexTest, Missing) {
+  ASSERT_FALSE(AttrSetIndex::open(Path));
+}
+
+TEST_F(AttrSetIndexTest, Truncated) {
+  writeIndex();
+  uint64_t Size;
+  ASSERT_FALSE(llvm::sys::fs::file_size(Path, Size));
+  // Within the header, the records, and the string table.
+  for (std::size_t Keep : {std::size_t(0), std::size_t(10), Size / 2,
+                           static_cast<std::size_t>(Size - 1)}) {
+    writeIndex();
+    truncate(Keep);
+    ASSERT_FALSE(AttrSetIndex::open(Path)) << "truncated to " << Keep;
+  }
+}
+
+TEST_F(AttrSetIndexTest, Corrupt) {
+  ASSERT_FALSE(
+      llvm::sys::fs::create_directories(llvm::sys::path::parent_path(Path)));
+  overwrite(std::string(4096, 'x'));
+  ASSERT_FALSE(AttrSetIndex::open(Path));
+
+  // Valid header, but the version is unknown.
+  writeIndex();
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buf =
+      llvm::MemoryBuffer::getFile(Path);
+  ASSERT_TRUE(Buf);
+  std::string Data = (*Buf)->getBuffer().str();
+  Buf->reset();
+  Data[8] = '\x7f';
+  overwrite(Data);
+  ASSERT_FALSE(AttrSetIndex::open(Path));
+}
+
+TEST_F(AttrSetIndexTest, Lock) {
+  std::optional<util::AutoCloseFD> Lock = AttrSetIndexBuilder::lock(Path);
+  ASSERT_TRUE(Lock);
+
+  // Another builder would wait for it.
+  util::AutoCloseFD Other = open((Path + ".lock").c_str(), O_RDWR);
+  ASSERT_GE(Other.get(), 0);
+  ASSERT_NE(flock(Other.get(), LOCK_EX | LOCK_NB), 0);
+  ASSERT_EQ(errno, EWOULDBLOCK);
+
+  Lock.reset();
+  ASSERT_EQ(flock(Other.get(), LOCK_EX | LOCK_NB), 0);
+}
+
+} // namespace
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include "nixd/Eval/Launch.h"
+
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+
+#include <chrono>
+#include <future>
+#include <thread>
+
+#include <signal.h> // NOLINT(modernize-deprecated-headers)
+
+using namespace nixd;
+using namespace std::chrono_literals;
+
+namespace {
+
+template <class T> using Result = std::promise<llvm::Expected<T>>;
+
+template <class T> llvm::Expected<T> wait(Result<T> &R) {
+  std::future<llvm::Expected<T>> F = R.get_future();
+  if (F.wait_for(30s) != std::future_status::ready)
+    return lspserver::error("no reply from the worker");
+  return F.get();
+}
+
+TEST(Launch, RestartOptionWorker) {
+  // As nixd does, so that writing to dead workers does not kill us.
+  signal(SIGPIPE, SIG_IGN);
+
+  llvm::SmallString<128> Dir;
+  ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("nixd-launch", Dir));
+  std::string Arg = "-option-worker-stderr=" + std::string(Dir);
+  const char *Argv[] = {"unit-nixd-eval", Arg.c_str()};
+  ASSERT_TRUE(llvm::cl::ParseCommandLineOptions(2, Argv));
+
+  // The name of the stderr file is built on the stack of startOption(), and
+  // used again whenever the worker is restarted.
+  std::unique_ptr<AttrSetClientPool> Pool;
+  startOption("nixos", Pool);
+  std::string Stderr = std::string(Dir) + "/nixos";
+
+  Result<EvalExprResponse> Eval;
+  Pool->evalExpr("{ a = 1; b = 2; }",
+                 [&](llvm::Expected<EvalExprResponse> R) {
+                   Eval.set_value(std::move(R));
+                 });
+  ASSERT_TRUE(static_cast<bool>(wait(Eval)));
+  ASSERT_TRUE(llvm::sys::fs::exists(Stderr));
+  ASSERT_FALSE(llvm::sys::fs::remove(Stderr));
+
+  // Let the worker exit, as if it was killed.
+  std::shared_ptr<AttrSetClient> Dead = Pool->client();
+  ASSERT_TRUE(Dead);
+  Dead->exit();
+
+  // It is restarted.
+  std::shared_ptr<AttrSetClient> Restarted;
+  for (int I = 0; I < 100 && (!Restarted || Restarted == Dead); ++I) {
+    std::this_thread::sleep_for(100ms);
+    Restarted = Pool->client();
+  }
+  ASSERT_TRUE(Restarted);
+  ASSERT_NE(Restarted, Dead);
+
+  // The last expression is replayed on it.
+  Result<AttrPathCompleteResponse> Complete;
+  Restarted->attrpathComplete(
+      {.Scope = {}, .Prefix = "a"},
+      [&](llvm::Expected<AttrPathCompleteResponse> R) {
+        Complete.set_value(std::move(R));
+      });
+  llvm::Expected<AttrPathCompleteResponse> Names = wait(Complete);
+  ASSERT_TRUE(static_cast<bool>(Names));
+  ASSERT_EQ(*Names, AttrPathCompleteResponse{"a"});
+
+  // And its stderr is redirected to the same file.
+  ASSERT_TRUE(llvm::sys::fs::exists(Stderr));
+
+  Pool.reset();
+  llvm::sys::fs::remove_directories(Dir);
+}
+
+TEST(Launch, RestartLastWorkerAtOnce) {
+  signal(SIGPIPE, SIG_IGN);
+
+  std::unique_ptr<AttrSetClientPool> Pool;
+  startAttrSetEval("/dev/null", Pool);
+  ASSERT_EQ(Pool->size(), 1U);
+
+  // Workers dying right after starting are not restarted at once.
+  std::this_thread::sleep_for(1s);
+  std::shared_ptr<AttrSetClient> Dead = Pool->client();
+  ASSERT_TRUE(Dead);
+  Dead->exit();
+
+  // With no worker alive, requests do not wait out the backoff.
+  std::shared_ptr<AttrSetClient> Restarted;
+  for (int I = 0; I < 1000 && (!Restarted || Restarted == Dead); ++I) {
+    Restarted = Pool->client();
+    ASSERT_TRUE(Restarted);
+    std::this_thread::sleep_for(10ms);
+  }
+  ASSERT_NE(Restarted, Dead);
+
+  // The dead process is freed, once nobody holds its client.
+  std::weak_ptr<AttrSetClient> Retired = Dead;
+  Dead.reset();
+  ASSERT_TRUE(Retired.expired());
+}
+
+} // namespace
@@ -0,0 +1,38 @@
+#include <gtest/gtest.h>
+
+#include "nixd/Eval/NameIndex.h"
+
+using namespace nixd;
+
+namespace {
+
+using Names = std::vector<std::string_view>;
+
+const NameIndex Lib({"mkIf", "mkOption", "mkEnableOption", "mkDefault",
+                     "optional", "lists", "mkIf"});
+
+TEST(NameIndex, Prefix) {
+  ASSERT_EQ(Lib.size(), 6U);
+  ASSERT_EQ(Lib.prefix("mk", 10),
+            (Names{"mkDefault", "mkEnableOption", "mkIf", "mkOption"}));
+  ASSERT_EQ(Lib.prefix("mk", 2), (Names{"mkDefault", "mkEnableOption"}));
+  ASSERT_TRUE(Lib.prefix("x", 10).empty());
+}
+
+TEST(NameIndex, Fuzzy) {
+  // Matches at the beginning of words are preferred.
+  ASSERT_EQ(Lib.fuzzy("opt", 10),
+            (Names{"optional", "mkOption", "mkEnableOption"}));
+  ASSERT_EQ(Lib.fuzzy("opt", 1), (Names{"optional"}));
+  ASSERT_TRUE(Lib.fuzzy("opt", 0).empty());
+}
+
+TEST(NameIndex, Complete) {
+  // Prefix matches first, then fuzzy ones.
+  ASSERT_EQ(Lib.complete("mkO", 10), (Names{"mkOption", "mkEnableOption"}));
+  ASSERT_EQ(Lib.complete("mkop", 10), (Names{"mkOption", "mkEnableOption"}));
+  ASSERT_EQ(Lib.complete("mkO", 1), (Names{"mkOption"}));
+  ASSERT_EQ(Lib.complete("", 2), (Names{"lists", "mkDefault"}));
+}
+
+} // namespace
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include "nixd/Support/Scheduler.h"
+
+#include <future>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace nixd;
+using lspserver::CancellationToken;
+
+/// Keeps the only worker busy, until released.
+struct Blocker {
+  std::promise<void> Release;
+
+  explicit Blocker(Scheduler &S) {
+    std::promise<void> Started;
+    S.post(Scheduler::Priority::Interactive,
+           [&Started, Released = Release.get_future()]() {
+             Started.set_value();
+             Released.wait();
+           });
+    Started.get_future().wait();
+  }
+};
+
+TEST(Scheduler, Priority) {
+  Scheduler S(1);
+  std::vector<std::string> Order;
+  {
+    Blocker B(S);
+    S.post(Scheduler::Priority::Background,
+           [&]() { Order.emplace_back("background"); });
+    S.post(Scheduler::Priority::Normal,
+           [&]() { Order.emplace_back("normal"); });
+    S.post(Scheduler::Priority::Interactive,
+           [&]() { Order.emplace_back("interactive"); });
+    B.Release.set_value();
+  }
+  S.join();
+  ASSERT_EQ(Order,
+            (std::vector<std::string>{"interactive", "normal", "background"}));
+}
+
+TEST(Scheduler, Supersede) {
+  Scheduler S(1);
+  CancellationToken First = CancellationToken::create();
+  CancellationToken Second = CancellationToken::create();
+  CancellationToken Other = CancellationToken::create();
+  std::vector<bool> Superseded;
+  {
+    Blocker B(S);
+    S.post(Scheduler::Priority::Interactive, "completion", First,
+           [&]() { Superseded.emplace_back(First.isSuperseded()); });
+    S.post(Scheduler::Priority::Interactive, "hover", Other, []() {});
+    ASSERT_FALSE(First.isCancelled());
+
+    S.post(Scheduler::Priority::Interactive, "completion", Second,
+           [&]() { Superseded.emplace_back(Second.isSuperseded()); });
+    ASSERT_TRUE(First.isSuperseded());
+    ASSERT_TRUE(First.isCancelled());
+    ASSERT_FALSE(Second.isCancelled());
+    ASSERT_FALSE(Other.isCancelled());
+    B.Release.set_value();
+  }
+
+  // Superseded tasks still run, and give up by themselves.
+  std::promise<void> Done;
+  S.post(Scheduler::Priority::Interactive, [&]() { Done.set_value(); });
+  Done.get_future().wait();
+  ASSERT_EQ(Superseded, (std::vector<bool>{true, false}));
+
+  // Keys of finished tasks are forgotten, so they are not superseded later.
+  S.post(Scheduler::Priority::Interactive, "completion",
+         CancellationToken::create(), []() {});
+  ASSERT_FALSE(Second.isCancelled());
+}
+
+} // namespace
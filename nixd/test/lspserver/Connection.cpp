@@ -0,0 +1,264 @@
+#include <gtest/gtest.h>
+
+#include "lspserver/Connection.h"
+#include "lspserver/Logger.h"
+
+#include <chrono>
+#include <csignal>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+using namespace lspserver;
+
+/// Messages are logged, but not formatted, as with verbose logging off.
+class NullLogger : public Logger {
+  void log(Level, const char *, const llvm::formatv_object_base &) override {}
+};
+
+class ConnectionTest : public testing::Test {
+  NullLogger Log;
+  LoggingSession Session{Log};
+};
+
+using InboundPortTest = ConnectionTest;
+using OutboundPortTest = ConnectionTest;
+
+/// A pipe, written by the test, read by an InboundPort.
+struct Pipe {
+  int Read = -1;
+  int Write = -1;
+
+  Pipe() {
+    int Fds[2];
+    if (pipe(Fds) == 0) {
+      Read = Fds[0];
+      Write = Fds[1];
+    }
+  }
+
+  ~Pipe() {
+    ::close(Read);
+    closeWrite();
+  }
+
+  void write(llvm::StringRef Data) const {
+    while (!Data.empty()) {
+      ssize_t N = ::write(Write, Data.data(), Data.size());
+      ASSERT_GT(N, 0);
+      Data = Data.drop_front(N);
+    }
+  }
+
+  void closeWrite() {
+    if (Write != -1)
+      ::close(Write);
+    Write = -1;
+  }
+};
+
+std::string frame(llvm::StringRef Body) {
+  return "Content-Length: " + std::to_string(Body.size()) + "\r\n\r\n" +
+         Body.str();
+}
+
+/// Read one body, checking it is \p Expected.
+void expectBody(InboundPort &In, llvm::StringRef Expected) {
+  llvm::Expected<llvm::StringRef> Body = In.readStandardBody();
+  ASSERT_TRUE(bool(Body));
+  ASSERT_EQ(Body->size(), Expected.size());
+  ASSERT_TRUE(*Body == Expected);
+}
+
+/// Split framed messages, checking each header.
+std::vector<llvm::json::Value> parseFramed(llvm::StringRef Stream) {
+  std::vector<llvm::json::Value> Messages;
+  while (!Stream.empty()) {
+    auto [Header, Rest] = Stream.split("\r\n\r\n");
+    std::size_t Length;
+    EXPECT_TRUE(Header.consume_front("Content-Length: "));
+    EXPECT_FALSE(Header.getAsInteger(10, Length));
+    EXPECT_LE(Length, Rest.size());
+    llvm::Expected<llvm::json::Value> V =
+        llvm::json::parse(Rest.take_front(Length));
+    EXPECT_TRUE(bool(V));
+    if (!V) {
+      llvm::consumeError(V.takeError());
+      break;
+    }
+    Messages.emplace_back(std::move(*V));
+    Stream = Rest.drop_front(Length);
+  }
+  return Messages;
+}
+
+TEST_F(OutboundPortTest, Framing) {
+  std::string Text;
+  {
+    llvm::raw_string_ostream OS(Text);
+    OutboundPort Out(OS);
+    Out.notify("exit", llvm::json::Value(nullptr));
+  }
+  std::string Body = R"({"jsonrpc":"2.0","method":"exit","params":null})";
+  ASSERT_EQ(Text, "Content-Length: " + std::to_string(Body.size()) +
+                      "\r\n\r\n" + Body);
+}
+
+TEST_F(OutboundPortTest, Ordering) {
+  // Messages of each producer are written in the order they were sent.
+  constexpr int Threads = 8;
+  constexpr int Count = 500;
+  std::string Text;
+  {
+    llvm::raw_string_ostream OS(Text);
+    OutboundPort Out(OS);
+    std::vector<std::thread> Producers;
+    for (int T = 0; T < Threads; ++T) {
+      Producers.emplace_back([&, T]() {
+        for (int I = 0; I < Count; ++I)
+          Out.notify("$/progress", llvm::json::Object{
+                                       {"token", T},
+                                       {"value", I},
+                                   });
+      });
+    }
+    for (std::thread &P : Producers)
+      P.join();
+    Out.flush();
+    ASSERT_EQ(Out.metrics().Messages, std::uint64_t(Threads * Count));
+  }
+
+  std::vector<int> Next(Threads, 0);
+  std::vector<llvm::json::Value> Messages = parseFramed(Text);
+  ASSERT_EQ(Messages.size(), std::size_t(Threads * Count));
+  for (const llvm::json::Value &M : Messages) {
+    const llvm::json::Object *Params = M.getAsObject()->getObject("params");
+    ASSERT_TRUE(Params);
+    auto T = *Params->getInteger("token");
+    auto I = *Params->getInteger("value");
+    ASSERT_EQ(I, Next[T]++);
+  }
+}
+
+TEST_F(OutboundPortTest, Backpressure) {
+  // The reader starts draining only once a producer has waited. Messages
+  // queued but not written are counted, so the third message must wait.
+  int Pipe[2];
+  ASSERT_EQ(pipe(Pipe), 0);
+  const std::string Large(OutboundPort::MaxQueuedBytes / 2 - 1024, 'x');
+
+  std::size_t Read = 0;
+  OutboundPort::Metrics M;
+  {
+    OutboundPort Out(Pipe[1], /*Pretty=*/false);
+    std::thread Reader([&]() {
+      auto Deadline =
+          std::chrono::steady_clock::now() + std::chrono::seconds(10);
+      while (Out.metrics().Stalls == 0 &&
+             std::chrono::steady_clock::now() < Deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      std::vector<char> Buf(1 << 16);
+      for (ssize_t N; (N = read(Pipe[0], Buf.data(), Buf.size())) > 0;)
+        Read += N;
+    });
+    for (int I = 0; I < 3; ++I)
+      Out.notify("$/log", Large);
+    Out.flush();
+    M = Out.metrics();
+    close(Pipe[1]);
+    Reader.join();
+  }
+  close(Pipe[0]);
+
+  ASSERT_EQ(M.Messages, 3U);
+  ASSERT_GE(M.Stalls, 1U);
+  ASSERT_EQ(Read, M.Bytes);
+}
+
+TEST_F(OutboundPortTest, BrokenPipe) {
+  // Messages to a closed pipe are dropped, rather than blocking producers.
+  signal(SIGPIPE, SIG_IGN);
+  int Pipe[2];
+  ASSERT_EQ(pipe(Pipe), 0);
+  close(Pipe[0]);
+  {
+    OutboundPort Out(Pipe[1], /*Pretty=*/false);
+    for (int I = 0; I < 100; ++I)
+      Out.notify("$/progress", llvm::json::Object{{"value", I}});
+    Out.flush();
+    ASSERT_EQ(Out.metrics().Messages, 0U);
+    ASSERT_EQ(Out.metrics().Writes, 0U);
+  }
+  close(Pipe[1]);
+}
+
+TEST_F(InboundPortTest, SplitHeaders) {
+  // Headers and bodies arrive in pieces, as a client may write them.
+  Pipe P;
+  InboundPort In(P.Read);
+  std::thread Writer([&]() {
+    for (llvm::StringRef Piece :
+         {"Content-Len", "gth: 19\r", "\nContent-Type: x\r\n", "\r",
+          "\n{\"a\":", "[1,2,3],\"b\":4}"}) {
+      P.write(Piece);
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+  });
+  expectBody(In, R"({"a":[1,2,3],"b":4})");
+  Writer.join();
+}
+
+TEST_F(InboundPortTest, ManyMessagesInOneRead) {
+  Pipe P;
+  InboundPort In(P.Read);
+  P.write(frame("[1]") + frame("{}") + frame("\"three\""));
+  expectBody(In, "[1]");
+  expectBody(In, "{}");
+  expectBody(In, "\"three\"");
+}
+
+TEST_F(InboundPortTest, LargeBody) {
+  // The buffer grows for a body larger than it, then serves small ones.
+  Pipe P;
+  InboundPort In(P.Read);
+  const std::string Large =
+      "\"" + std::string(4 * InboundPort::InitialBufferSize, 'x') + "\"";
+  std::thread Writer([&]() { P.write(frame(Large) + frame("1")); });
+  expectBody(In, Large);
+  expectBody(In, "1");
+  Writer.join();
+  ASSERT_GT(In.bufferSize(), InboundPort::InitialBufferSize);
+}
+
+TEST_F(InboundPortTest, ShrinkAfterHugeBody) {
+  // Memory held for a body over 16 MiB is released, once it is consumed.
+  Pipe P;
+  InboundPort In(P.Read);
+  const std::string Huge = "\"" + std::string(17 * 1024 * 1024, 'x') + "\"";
+  std::thread Writer([&]() { P.write(frame(Huge)); });
+  expectBody(In, Huge);
+  Writer.join();
+  ASSERT_GT(In.bufferSize(), Huge.size());
+
+  P.write(frame("{}"));
+  expectBody(In, "{}");
+  ASSERT_EQ(In.bufferSize(), InboundPort::InitialBufferSize);
+}
+
+TEST_F(InboundPortTest, EOFInBody) {
+  Pipe P;
+  InboundPort In(P.Read);
+  P.write(frame("{}"));
+  P.write("Content-Length: 100\r\n\r\n{\"truncated\":");
+  P.closeWrite();
+  expectBody(In, "{}");
+  llvm::Expected<llvm::StringRef> Body = In.readStandardBody();
+  ASSERT_FALSE(bool(Body));
+  llvm::consumeError(Body.takeError());
+}
+
+} // namespace
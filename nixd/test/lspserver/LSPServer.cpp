@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include "lspserver/LSPServer.h"
+#include "lspserver/Logger.h"
+
+#include <optional>
+#include <string>
+
+namespace {
+
+using namespace lspserver;
+
+/// Messages are logged, but not formatted, as with verbose logging off.
+class NullLogger : public Logger {
+  void log(Level, const char *, const llvm::formatv_object_base &) override {}
+};
+
+/// Calls "test/call", writing messages into a string.
+class Server : public LSPServer {
+public:
+  llvm::unique_function<void(const llvm::json::Value &,
+                             Callback<llvm::json::Value>)>
+      Call;
+
+  Server(std::unique_ptr<OutboundPort> Out)
+      : LSPServer(std::make_unique<InboundPort>(), std::move(Out)) {
+    Call = mkOutMethod<llvm::json::Value, llvm::json::Value>("test/call");
+  }
+};
+
+class LSPServerTest : public testing::Test {
+  NullLogger Log;
+  LoggingSession Session{Log};
+
+protected:
+  std::string Text;
+  llvm::raw_string_ostream OS{Text};
+  OutboundPort *Out;
+  std::optional<Server> S;
+
+  /// The reply of the last call.
+  std::optional<llvm::Expected<llvm::json::Value>> Reply;
+
+  void SetUp() override {
+    auto Port = std::make_unique<OutboundPort>(OS);
+    Out = Port.get();
+    S.emplace(std::move(Port));
+  }
+
+  void call() {
+    S->Call(llvm::json::Object{}, [this](llvm::Expected<llvm::json::Value> R) {
+      Reply = std::move(R);
+    });
+  }
+
+  /// Text written so far.
+  std::string written() {
+    Out->flush();
+    return Text;
+  }
+
+  void TearDown() override {
+    if (Reply && !*Reply)
+      llvm::consumeError(Reply->takeError());
+  }
+};
+
+TEST_F(LSPServerTest, CallCancelledBefore) {
+  // Calls under a cancelled token are never sent.
+  CancellationToken Token = CancellationToken::create();
+  Token.supersede();
+  {
+    WithCancellation _(Token);
+    call();
+  }
+  ASSERT_TRUE(Reply);
+  ASSERT_FALSE(bool(*Reply));
+  ASSERT_EQ(written(), "");
+  ASSERT_EQ(S->pendingCalls(), 0U);
+}
+
+TEST_F(LSPServerTest, CallCancelledInFlight) {
+  CancellationToken Token = CancellationToken::create();
+  {
+    WithCancellation _(Token);
+    call();
+  }
+  ASSERT_FALSE(Reply);
+  std::string Sent = written();
+  ASSERT_NE(Sent.find("test/call"), std::string::npos);
+  ASSERT_EQ(S->pendingCalls(), 1U);
+
+  // The callback gets an error at once, and nothing is sent to the other
+  // side, which would not read it before replying anyway.
+  Token.cancel();
+  ASSERT_TRUE(Reply);
+  ASSERT_FALSE(bool(*Reply));
+  ASSERT_EQ(S->pendingCalls(), 0U);
+  ASSERT_EQ(written(), Sent);
+
+  // The reply arriving later is dropped, not passed to the callback.
+  llvm::consumeError(Reply->takeError());
+  Reply.reset();
+  InboundPort In;
+  ASSERT_TRUE(In.dispatch(
+      llvm::json::Object{{"jsonrpc", "2.0"}, {"id", 1}, {"result", 42}}, *S));
+  ASSERT_FALSE(Reply);
+}
+
+TEST_F(LSPServerTest, CallReplied) {
+  CancellationToken Token = CancellationToken::create();
+  {
+    WithCancellation _(Token);
+    call();
+  }
+  InboundPort In;
+  ASSERT_TRUE(In.dispatch(
+      llvm::json::Object{{"jsonrpc", "2.0"}, {"id", 1}, {"result", 42}}, *S));
+  ASSERT_TRUE(Reply);
+  ASSERT_TRUE(bool(*Reply));
+  ASSERT_EQ(**Reply, llvm::json::Value(42));
+
+  // Cancelling after the reply does nothing.
+  Token.cancel();
+  ASSERT_TRUE(bool(*Reply));
+}
+
+} // namespace
@@ -0,0 +1,330 @@
+#include <gtest/gtest.h>
+
+#include "lspserver/LSPServer.h"
+#include "lspserver/LazyJSON.h"
+#include "lspserver/Logger.h"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace lspserver;
+
+/// Messages are logged, but not formatted, as with verbose logging off.
+class NullLogger : public Logger {
+  void log(Level, const char *, const llvm::formatv_object_base &) override {}
+};
+
+class LazyJSONTest : public testing::Test {
+  NullLogger Log;
+  LoggingSession Session{Log};
+};
+
+/// Parse \p Raw by llvm::json::parse(), or nullopt if it is invalid.
+std::optional<llvm::json::Value> parse(llvm::StringRef Raw) {
+  llvm::Expected<llvm::json::Value> V = llvm::json::parse(Raw);
+  if (!V) {
+    llvm::consumeError(V.takeError());
+    return std::nullopt;
+  }
+  return std::move(*V);
+}
+
+/// Check decodeJSONString() of \p Raw against llvm::json::parse().
+void expectDecoded(const std::string &Raw) {
+  std::string Out = "left from before";
+  bool OK = decodeJSONString(Raw, Out);
+  std::optional<llvm::json::Value> V = parse(Raw);
+  ASSERT_EQ(OK, V.has_value()) << Raw;
+  if (OK) {
+    ASSERT_EQ(Out, *V->getAsString()) << Raw;
+  }
+}
+
+/// Contents of strings, between their quotes.
+const std::vector<std::string> StringContents = {
+    "",
+    "plain",
+    // Escapes.
+    R"(\"\\\/\b\f\n\r\t)",
+    R"(a\"b)",
+    R"(\\)",
+    R"(\\\")",
+    R"(\u0041\u00e9\u20ac)",
+    R"(\u0000)",
+    // Surrogate pairs, in either case.
+    R"(\ud83d\ude00)",
+    R"(\uD83D\uDE00x)",
+    // Lone surrogates.
+    R"(\ud800)",
+    R"(\udc00)",
+    R"(\ud800A)",
+    R"(\ud83d\ud83d\ude00)",
+    R"(\ude00\ud83d)",
+    R"(\ud800\)",
+    R"(\ud800\u12)",
+    // Invalid escapes.
+    R"(\)",
+    R"(\x41)",
+    R"(\u12)",
+    R"(\u12g4)",
+    R"(\U0041)",
+    // Unescaped quotes.
+    R"(a"b)",
+    "\"",
+    // Raw control characters.
+    "a\nb",
+    "\t",
+    "\x01",
+    "\x1f",
+    "\x7f",
+    // UTF-8, valid and invalid.
+    "é测试😀",
+    "\xff",
+    "a\xc3",
+    "\xc3(",
+    "\xed\xa0\x80",
+    "\xf0\x9f\x98",
+    "é\xff",
+};
+
+TEST_F(LazyJSONTest, DecodeString) {
+  for (const std::string &Contents : StringContents)
+    expectDecoded("\"" + Contents + "\"");
+}
+
+TEST_F(LazyJSONTest, DecodeLongString) {
+  // Strings of 16 bytes or more are scanned 16 bytes at a time. Padding
+  // moves the contents into each lane, and across blocks.
+  const std::string Padding(40, 'x');
+  for (const std::string &Contents : StringContents) {
+    for (std::size_t Before = 0; Before <= 17; ++Before) {
+      expectDecoded("\"" + Padding.substr(0, Before) + Contents +
+                    Padding.substr(0, 17) + "\"");
+      // Non-ASCII characters skipped earlier are checked too.
+      expectDecoded("\"é" + Padding.substr(0, Before) + Contents +
+                    Padding.substr(0, 17) + "\"");
+    }
+  }
+}
+
+TEST_F(LazyJSONTest, DecodeNotString) {
+  std::string Out;
+  for (llvm::StringRef Raw : {"", "\"", "'a'", "a", "\"a", "a\"", "1"})
+    ASSERT_FALSE(decodeJSONString(Raw, Out)) << Raw.str();
+}
+
+/// Check LazyObject::scan() of \p Raw against llvm::json::parse().
+void expectScanned(const std::string &Raw) {
+  LazyObject O;
+  ASSERT_TRUE(O.scan(Raw)) << Raw;
+  std::optional<llvm::json::Value> V = parse(Raw);
+  ASSERT_TRUE(V) << Raw;
+  const llvm::json::Object *Object = V->getAsObject();
+  ASSERT_TRUE(Object) << Raw;
+  for (const auto &[Key, Value] : *Object) {
+    std::optional<llvm::StringRef> Member = O.get(Key);
+    ASSERT_TRUE(Member) << Raw << ", key: " << Key.str();
+    ASSERT_EQ(parse(*Member), Value) << Raw << ", key: " << Key.str();
+  }
+  ASSERT_FALSE(O.get("missing"));
+}
+
+TEST_F(LazyJSONTest, ScanObject) {
+  for (llvm::StringRef Raw : {
+           "{}",
+           " \t\r\n{ \n} \n",
+           R"({"a":1})",
+           R"( { "a" : -1.5e+3 , "b" : true , "c" : null } )",
+           R"({"a":"x","b":"","c":"\"","d":"\\"})",
+           R"({"a":"}]{[,:","b":{"c":[1,{"d":"]"}],"e":{}},"f":[]})",
+           R"({"a":[[[]]],"b":[{},{}]})",
+           R"({"é":"测试","😀":"😀"})",
+           R"({"":1})",
+           // Duplicate keys, the last one wins.
+           R"({"a":1,"b":2,"a":3})",
+           R"({"a":{"x":1},"a":[2]})",
+       })
+    expectScanned(Raw.str());
+}
+
+TEST_F(LazyJSONTest, ScanObjectEscapedKey) {
+  // Keys with escapes are left to llvm::json::parse().
+  LazyObject O;
+  for (llvm::StringRef Raw : {
+           R"({"\u0061":1})",
+           R"({"a":1,"b\"":2})",
+           R"({"a\\":1})",
+       }) {
+    ASSERT_TRUE(parse(Raw)) << Raw.str();
+    ASSERT_FALSE(O.scan(Raw)) << Raw.str();
+  }
+}
+
+TEST_F(LazyJSONTest, ScanObjectInvalid) {
+  LazyObject O;
+  for (llvm::StringRef Raw : {
+           "",
+           "{",
+           "}",
+           R"({"a"})",
+           R"({"a":})",
+           R"({"a" 1})",
+           R"({"a":1,})",
+           R"({,})",
+           R"({"a":1 "b":2})",
+           R"({"a":1}})",
+           R"({"a":1} x)",
+           R"({a:1})",
+           R"({"a:1})",
+           R"({"a":"1})",
+           R"({"a":[1})",
+           R"({"a":{"b":1]})",
+           R"({"a":"\"})",
+       }) {
+    ASSERT_FALSE(parse(Raw)) << Raw.str();
+    ASSERT_FALSE(O.scan(Raw)) << Raw.str();
+  }
+}
+
+TEST_F(LazyJSONTest, ScanNotObject) {
+  LazyObject O;
+  llvm::SmallVector<llvm::StringRef> Elements;
+  for (llvm::StringRef Raw : {"[]", "1", "\"{}\"", "null"})
+    ASSERT_FALSE(O.scan(Raw)) << Raw.str();
+  for (llvm::StringRef Raw : {"{}", "1", "\"[]\"", "null"})
+    ASSERT_FALSE(scanJSONArray(Raw, Elements)) << Raw.str();
+}
+
+TEST_F(LazyJSONTest, ScanObjectLiterals) {
+  // Literals are not checked by scanning, but when the member is parsed.
+  LazyObject O;
+  ASSERT_TRUE(O.scan(R"({"a":tru,"b":1})"));
+  int B;
+  ASSERT_TRUE(O.map("b", B));
+  ASSERT_EQ(B, 1);
+  bool A;
+  ASSERT_FALSE(O.map("a", A));
+}
+
+/// Check scanJSONArray() of \p Raw against llvm::json::parse().
+void expectArray(const std::string &Raw) {
+  llvm::SmallVector<llvm::StringRef> Elements;
+  ASSERT_TRUE(scanJSONArray(Raw, Elements)) << Raw;
+  std::optional<llvm::json::Value> V = parse(Raw);
+  ASSERT_TRUE(V) << Raw;
+  const llvm::json::Array *Array = V->getAsArray();
+  ASSERT_TRUE(Array) << Raw;
+  ASSERT_EQ(Elements.size(), Array->size()) << Raw;
+  for (std::size_t I = 0; I < Elements.size(); ++I)
+    ASSERT_EQ(parse(Elements[I]), (*Array)[I]) << Raw << ", element: " << I;
+}
+
+TEST_F(LazyJSONTest, ScanArray) {
+  for (llvm::StringRef Raw : {
+           "[]",
+           " [ ] ",
+           "[1]",
+           R"([1, "a", true, null, -0.5, {}, []])",
+           R"([{"range":{"start":{"line":0}},"text":"]\"["},"]"])",
+           R"([[1,[2]],[[3]]])",
+       })
+    expectArray(Raw.str());
+}
+
+TEST_F(LazyJSONTest, ScanArrayInvalid) {
+  llvm::SmallVector<llvm::StringRef> Elements;
+  for (llvm::StringRef Raw : {
+           "",
+           "[",
+           "]",
+           "[1,]",
+           "[,1]",
+           "[1 2]",
+           "[1]]",
+           "[[1]",
+           "[1] x",
+           R"(["a])",
+           R"([{"a":1])",
+       }) {
+    ASSERT_FALSE(parse(Raw)) << Raw.str();
+    ASSERT_FALSE(scanJSONArray(Raw, Elements)) << Raw.str();
+  }
+}
+
+/// Records didChange notifications.
+class Server : public LSPServer {
+public:
+  std::vector<DidChangeTextDocumentParams> Changes;
+
+  Server()
+      : LSPServer(std::make_unique<InboundPort>(),
+                  std::make_unique<OutboundPort>(llvm::nulls())) {
+    Registry.addNotification("textDocument/didChange", this,
+                             &Server::onChange);
+  }
+
+  void onChange(DidChangeTextDocumentParams &&Params) {
+    Changes.emplace_back(std::move(Params));
+  }
+};
+
+/// \p Text, with the first \p From replaced by \p To.
+std::string replaced(std::string Text, llvm::StringRef From,
+                     llvm::StringRef To) {
+  return Text.replace(Text.find(From.str()), From.size(), To.str());
+}
+
+TEST_F(LazyJSONTest, DispatchRawFallback) {
+  // Messages the lazy path cannot take are parsed fully, with the same
+  // result.
+  const char *Change =
+      R"({"jsonrpc":"2.0","method":"textDocument/didChange","params":{)"
+      R"("textDocument":{"uri":"file:///a.nix","version":2},)"
+      R"("contentChanges":[{"range":{"start":{"line":0,"character":1},)"
+      R"("end":{"line":0,"character":2}},"rangeLength":1,"text":"x\né"}],)"
+      R"("wantDiagnostics":true}})";
+  for (const std::string &Message : {
+           std::string(Change),
+           // An escaped key in the envelope.
+           replaced(Change, R"("method")", R"("m\u0065thod")"),
+           // An escaped key in the params, i.e. fromRawJSON() fails.
+           replaced(Change, R"("text")", R"("t\u0065xt")"),
+       }) {
+    Server S;
+    InboundPort In;
+    ASSERT_TRUE(In.dispatchRaw(Message, S)) << Message;
+    ASSERT_EQ(S.Changes.size(), 1U) << Message;
+    const DidChangeTextDocumentParams &P = S.Changes.front();
+    ASSERT_EQ(P.textDocument.uri.file(), "/a.nix");
+    ASSERT_EQ(P.textDocument.version, 2);
+    ASSERT_EQ(P.contentChanges.size(), 1U);
+    ASSERT_TRUE(P.contentChanges[0].range);
+    ASSERT_EQ(P.contentChanges[0].range->start, (Position{0, 1}));
+    ASSERT_EQ(P.contentChanges[0].range->end, (Position{0, 2}));
+    ASSERT_EQ(P.contentChanges[0].rangeLength, 1);
+    ASSERT_EQ(P.contentChanges[0].text, "x\né");
+    ASSERT_EQ(P.wantDiagnostics, true);
+  }
+}
+
+TEST_F(LazyJSONTest, DispatchRawInvalidParams) {
+  // Params which are not valid are dropped, on either path.
+  for (llvm::StringRef Params : {
+           R"({"textDocument":{"uri":"file:///a.nix","version":"2"},)"
+           R"("contentChanges":[]})",
+           R"({"textDocument":tru,"contentChanges":[]})",
+       }) {
+    std::string Message =
+        R"({"jsonrpc":"2.0","method":"textDocument/didChange","params":)" +
+        Params.str() + "}";
+    Server S;
+    InboundPort In;
+    ASSERT_TRUE(In.dispatchRaw(Message, S)) << Message;
+    ASSERT_TRUE(S.Changes.empty()) << Message;
+  }
+}
+
+} // namespace
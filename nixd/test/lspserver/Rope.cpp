@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+
+#include "lspserver/Logger.h"
+#include "lspserver/Rope.h"
+#include "lspserver/SourceCode.h"
+
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace lspserver;
+
+/// Messages are logged, but not formatted, as with verbose logging off.
+class NullLogger : public Logger {
+  void log(Level, const char *, const llvm::formatv_object_base &) override {}
+};
+
+class RopeTest : public testing::Test {
+  NullLogger Log;
+  LoggingSession Session{Log};
+};
+
+/// Text of \p Size bytes, with a newline now and then.
+std::string makeText(std::size_t Size, std::mt19937 &Gen) {
+  std::string Text;
+  for (std::size_t I = 0; I < Size; ++I)
+    Text += Gen() % 16 == 0 ? '\n' : char('a' + Gen() % 26);
+  return Text;
+}
+
+/// Check every accessor of \p R against \p Text.
+void expectText(const Rope &R, const std::string &Text) {
+  ASSERT_EQ(R.size(), Text.size());
+  ASSERT_EQ(R.empty(), Text.empty());
+  ASSERT_EQ(*R.str(), Text);
+
+  std::vector<std::size_t> Starts = {0};
+  for (std::size_t I = 0; I < Text.size(); ++I)
+    if (Text[I] == '\n')
+      Starts.emplace_back(I + 1);
+  ASSERT_EQ(R.lines(), Starts.size());
+  for (std::size_t Line = 0; Line < Starts.size(); ++Line)
+    ASSERT_EQ(R.lineStart(Line), Starts[Line]) << "line: " << Line;
+}
+
+TEST_F(RopeTest, Empty) {
+  Rope R;
+  expectText(R, "");
+  ASSERT_EQ(R.slice(0, 10), "");
+  expectText(R.replace(0, 0, "a\nb"), "a\nb");
+  expectText(Rope("a").replace(0, 1, ""), "");
+}
+
+TEST_F(RopeTest, Lines) {
+  Rope R("ab\n\ncd\n");
+  ASSERT_EQ(R.lines(), 4U);
+  ASSERT_EQ(R.lineStart(0), 0U);
+  ASSERT_EQ(R.lineStart(1), 3U);
+  ASSERT_EQ(R.lineStart(2), 4U);
+  ASSERT_EQ(R.lineStart(3), 7U);
+  expectText(R, "ab\n\ncd\n");
+}
+
+TEST_F(RopeTest, SliceAcrossLeaves) {
+  // Texts are split into leaves of hundreds of bytes, so these slices span
+  // several of them.
+  std::mt19937 Gen(1);
+  const std::string Text = makeText(8000, Gen);
+  Rope R(Text);
+  for (std::size_t Begin : {0, 1, 500, 511, 512, 513, 1023, 4000}) {
+    for (std::size_t Length : {0, 1, 2, 600, 1500, 8000}) {
+      std::size_t End = std::min(Begin + Length, Text.size());
+      ASSERT_EQ(R.slice(Begin, End), Text.substr(Begin, End - Begin))
+          << "slice: " << Begin << ", " << End;
+    }
+  }
+  // The end is clamped to the size.
+  ASSERT_EQ(R.slice(7990, 9000), Text.substr(7990));
+  ASSERT_EQ(R.slice(9000, 9010), "");
+}
+
+TEST_F(RopeTest, RandomReplace) {
+  // Small edits, as when typing, and large ones, as when pasting.
+  std::mt19937 Gen(42);
+  std::string Text = makeText(3000, Gen);
+  Rope R(Text);
+  for (int I = 0; I < 2000; ++I) {
+    std::size_t Begin = Gen() % (Text.size() + 1);
+    std::size_t Max = I % 10 == 0 ? 4000 : 8;
+    std::size_t End = std::min(Text.size(), Begin + Gen() % (Max + 1));
+    std::string New = makeText(Gen() % (Max + 1), Gen);
+    R = R.replace(Begin, End, New);
+    Text.replace(Begin, End - Begin, New);
+    ASSERT_EQ(R.size(), Text.size()) << "edit: " << I;
+    if (I % 50 == 0)
+      expectText(R, Text);
+  }
+  expectText(R, Text);
+}
+
+TEST_F(RopeTest, Snapshots) {
+  // Edits make new ropes, and leave old ones as they were.
+  std::mt19937 Gen(7);
+  std::vector<std::string> Texts = {makeText(5000, Gen)};
+  std::vector<Rope> Ropes = {Rope(Texts[0])};
+  for (int I = 0; I < 100; ++I) {
+    std::string Text = Texts.back();
+    std::size_t Begin = Gen() % (Text.size() + 1);
+    std::size_t End = std::min(Text.size(), Begin + Gen() % 700);
+    std::string New = makeText(Gen() % 700, Gen);
+    Text.replace(Begin, End - Begin, New);
+    Ropes.emplace_back(Ropes.back().replace(Begin, End, New));
+    Texts.emplace_back(std::move(Text));
+  }
+  for (std::size_t I = 0; I < Ropes.size(); ++I)
+    expectText(Ropes[I], Texts[I]);
+}
+
+TEST_F(RopeTest, StrIsShared) {
+  std::mt19937 Gen(3);
+  Rope R = Rope(makeText(4000, Gen)).replace(10, 20, "edited\n");
+
+  // Flattened once, and shared by all readers of the snapshot, and copies of
+  // it.
+  std::shared_ptr<const std::string> First = R.str();
+  Rope Copy = R;
+  ASSERT_EQ(R.str().get(), First.get());
+  ASSERT_EQ(Copy.str().get(), First.get());
+
+  // The text outlives the rope.
+  std::string Text = *First;
+  R = Rope();
+  Copy = Rope();
+  ASSERT_EQ(*First, Text);
+
+  // A rope made of a string shares it at once.
+  Rope FromString(Text);
+  ASSERT_EQ(FromString.str().get(), FromString.str().get());
+  ASSERT_EQ(*FromString.str(), Text);
+}
+
+/// Apply \p Change to both a rope and a string of \p Text, checking that
+/// they agree. Returns the error, or the text after the change.
+llvm::Expected<std::string>
+applyBoth(const std::string &Text,
+          const TextDocumentContentChangeEvent &Change) {
+  Rope R(Text);
+  std::string S = Text;
+  llvm::Error RopeErr = applyChange(R, Change);
+  llvm::Error StringErr = applyChange(S, Change);
+  EXPECT_EQ(bool(RopeErr), bool(StringErr)) << Text;
+  if (RopeErr || StringErr) {
+    llvm::consumeError(std::move(StringErr));
+    return std::move(RopeErr);
+  }
+  EXPECT_EQ(*R.str(), S);
+  return *R.str();
+}
+
+TextDocumentContentChangeEvent change(Position Start, Position End,
+                                      std::string Text,
+                                      std::optional<int> RangeLength = {}) {
+  return {Range{Start, End}, RangeLength, std::move(Text)};
+}
+
+/// Expect \p Change to \p Text to give \p Result.
+void expectChange(const std::string &Text,
+                  const TextDocumentContentChangeEvent &Change,
+                  const std::string &Result) {
+  llvm::Expected<std::string> Got = applyBoth(Text, Change);
+  ASSERT_TRUE(bool(Got)) << llvm::toString(Got.takeError());
+  ASSERT_EQ(*Got, Result);
+}
+
+/// Expect \p Change to \p Text to fail.
+void expectError(const std::string &Text,
+                 const TextDocumentContentChangeEvent &Change) {
+  llvm::Expected<std::string> Got = applyBoth(Text, Change);
+  ASSERT_FALSE(bool(Got));
+  llvm::consumeError(Got.takeError());
+}
+
+TEST_F(RopeTest, ApplyChange) {
+  expectChange("let\n  x = 1;\nin x\n", change({1, 6}, {1, 7}, "42"),
+               "let\n  x = 42;\nin x\n");
+  expectChange("ab\ncd", change({0, 1}, {1, 1}, ""), "ad");
+  expectChange("ab\ncd", change({1, 2}, {1, 2}, "\n"), "ab\ncd\n");
+
+  // The whole text.
+  TextDocumentContentChangeEvent Full;
+  Full.text = "new";
+  expectChange("old", Full, "new");
+
+  // Ranges are in UTF-16 code units.
+  expectChange("a😀b\n", change({0, 1}, {0, 3}, "c"), "acb\n");
+}
+
+TEST_F(RopeTest, ApplyChangeRangeLength) {
+  expectChange("ab\ncd", change({0, 1}, {1, 1}, "", 3), "ad");
+  // Astral characters are two code units, though four bytes.
+  expectChange("a😀b", change({0, 1}, {0, 3}, "", 2), "ab");
+
+  expectError("ab\ncd", change({0, 1}, {1, 1}, "", 2));
+  expectError("ab\ncd", change({0, 1}, {1, 1}, "", 4));
+  expectError("a😀b", change({0, 1}, {0, 3}, "", 4));
+}
+
+TEST_F(RopeTest, ApplyChangeInvalidRange) {
+  expectError("ab\ncd", change({1, 1}, {0, 1}, ""));
+  expectError("ab\ncd", change({0, 3}, {0, 3}, "x"));
+  expectError("ab\ncd", change({3, 0}, {3, 0}, "x"));
+}
+
+TEST_F(RopeTest, ApplyChangeFinalNewline) {
+  // Some editors address the line after the last, as if the text ended with
+  // a newline. The newline is inferred.
+  expectChange("ab", change({1, 0}, {1, 0}, "cd"), "ab\ncd");
+  expectChange("ab\ncd", change({1, 2}, {2, 0}, ""), "ab\ncd");
+  expectChange("", change({1, 0}, {1, 0}, "x"), "\nx");
+
+  // Only at the start of that line.
+  expectError("ab", change({1, 1}, {1, 1}, "cd"));
+  // And not after an existing newline.
+  expectError("ab\n", change({2, 0}, {2, 0}, "cd"));
+}
+
+} // namespace
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include "lspserver/SourceCode.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace lspserver;
+
+/// Runs each test in the encoding of its parameter, then restores UTF-16.
+class LineTableTest : public testing::TestWithParam<OffsetEncoding> {
+protected:
+  void SetUp() override { setLSPEncoding(GetParam()); }
+  void TearDown() override { setLSPEncoding(OffsetEncoding::UTF16); }
+};
+
+const std::vector<std::string> Texts = {
+    "",
+    "\n",
+    "\n\n",
+    "abc",
+    "a\nbc\n",
+    "let\n  x = 1;\nin x\n",
+    "{ a = 1; 测试文本 }",
+    "é\n😀x\n\nlast",
+    "ascii\n𝔸𝔹ℂ\nascii again",
+    "a😀b\r\nc",
+};
+
+TEST_P(LineTableTest, OffsetToPosition) {
+  // Every offset, including those on '\n' and at EOF.
+  for (const std::string &Text : Texts) {
+    LineTable Lines(Text);
+    for (size_t Offset = 0; Offset <= Text.size(); ++Offset) {
+      ASSERT_EQ(Lines.offsetToPosition(Offset),
+                offsetToPosition(Text, Offset))
+          << "text: " << Text << ", offset: " << Offset;
+    }
+  }
+}
+
+TEST_P(LineTableTest, PositionToOffset) {
+  // Lines one past the end, and columns past the end of lines.
+  for (const std::string &Text : Texts) {
+    LineTable Lines(Text);
+    for (int64_t Line = 0; Line <= int64_t(Lines.lines()); ++Line) {
+      for (int64_t Char = 0; Char < 16; ++Char) {
+        for (bool Beyond : {true, false}) {
+          Position P{Line, Char};
+          llvm::Expected<size_t> Got = Lines.positionToOffset(P, Beyond);
+          llvm::Expected<size_t> Want = positionToOffset(Text, P, Beyond);
+          ASSERT_EQ(bool(Got), bool(Want))
+              << "text: " << Text << ", position: " << Line << ":" << Char
+              << ", beyond: " << Beyond;
+          if (Got)
+            ASSERT_EQ(*Got, *Want);
+          else {
+            llvm::consumeError(Got.takeError());
+            llvm::consumeError(Want.takeError());
+          }
+        }
+      }
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Encodings, LineTableTest,
+                         testing::Values(OffsetEncoding::UTF16,
+                                         OffsetEncoding::UTF8,
+                                         OffsetEncoding::UTF32));
+
+struct Case {
+  OffsetEncoding Encoding;
+  const char *Text;
+  size_t Offset;
+  Position Pos;
+};
+
+TEST(LineTable, Table) {
+  const Case Cases[] = {
+      // ASCII lines are counted in bytes, in all encodings.
+      {OffsetEncoding::UTF16, "ab\ncd", 1, {0, 1}},
+      {OffsetEncoding::UTF32, "ab\ncd", 4, {1, 1}},
+      // On '\n', and at EOF.
+      {OffsetEncoding::UTF16, "ab\ncd", 2, {0, 2}},
+      {OffsetEncoding::UTF16, "ab\ncd", 3, {1, 0}},
+      {OffsetEncoding::UTF16, "ab\ncd", 5, {1, 2}},
+      {OffsetEncoding::UTF16, "ab\n", 3, {1, 0}},
+      // Non-ASCII lines.
+      {OffsetEncoding::UTF16, "x\né!", 5, {1, 2}},
+      {OffsetEncoding::UTF8, "x\né!", 5, {1, 3}},
+      {OffsetEncoding::UTF32, "x\né!", 5, {1, 2}},
+      // Astral characters are two code units in UTF-16.
+      {OffsetEncoding::UTF16, "a😀b", 5, {0, 3}},
+      {OffsetEncoding::UTF8, "a😀b", 5, {0, 5}},
+      {OffsetEncoding::UTF32, "a😀b", 5, {0, 2}},
+      {OffsetEncoding::UTF16, "😀\n😀", 9, {1, 2}},
+  };
+  for (const Case &C : Cases) {
+    setLSPEncoding(C.Encoding);
+    LineTable Lines(C.Text);
+    EXPECT_EQ(Lines.offsetToPosition(C.Offset), C.Pos) << C.Text;
+    llvm::Expected<size_t> Offset = Lines.positionToOffset(C.Pos);
+    ASSERT_TRUE(bool(Offset)) << C.Text;
+    EXPECT_EQ(*Offset, C.Offset) << C.Text;
+  }
+  setLSPEncoding(OffsetEncoding::UTF16);
+}
+
+TEST(LineTable, BeyondLineLength) {
+  LineTable Lines("ab\ncd😀");
+
+  // Clamped to the end of the line, i.e. the '\n'.
+  llvm::Expected<size_t> Clamped = Lines.positionToOffset({0, 10});
+  ASSERT_TRUE(bool(Clamped));
+  ASSERT_EQ(*Clamped, 2U);
+
+  // Or to EOF on the last line.
+  llvm::Expected<size_t> Last = Lines.positionToOffset({1, 10});
+  ASSERT_TRUE(bool(Last));
+  ASSERT_EQ(*Last, 9U);
+
+  // Columns beyond the line are errors, if not allowed.
+  llvm::Expected<size_t> Strict = Lines.positionToOffset({0, 3}, false);
+  ASSERT_FALSE(bool(Strict));
+  llvm::consumeError(Strict.takeError());
+  llvm::Expected<size_t> End = Lines.positionToOffset({1, 4}, false);
+  ASSERT_TRUE(bool(End));
+  ASSERT_EQ(*End, 9U);
+
+  // Lines past the end are always errors.
+  llvm::Expected<size_t> NoLine = Lines.positionToOffset({2, 0});
+  ASSERT_FALSE(bool(NoLine));
+  llvm::consumeError(NoLine.takeError());
+}
+
+} // namespace
@@ -42,6 +42,15 @@ opt<Logger::Level> LogLevel{
 opt<bool> PrettyPrint{"pretty", desc("Pretty-print JSON output"), init(false),
                       cat(Debug)};
 
+opt<std::string> BuildIndex{
+    "build-index",
+    desc("Build attrset index into this file, then exit (internal use)"),
+    cat(Debug), Hidden};
+
+opt<std::string> IndexExpr{"index-expr",
+                           desc("Expression to be indexed (internal use)"),
+                           cat(Debug), Hidden};
+
 const OptionCategory *Catogories[] = {&Misc, &Debug};
 
 } // namespace
@@ -72,6 +81,10 @@ int main(int Argc, const char *Argv[]) {
   LoggingSession Session(Logger);
 
   nixt::initEval();
+
+  if (!BuildIndex.empty())
+    return AttrSetProvider::buildIndex(IndexExpr, BuildIndex);
+
   auto In = std::make_unique<lspserver::InboundPort>(STDIN_FILENO, InputStyle);
 
   auto Out = std::make_unique<lspserver::OutboundPort>(PrettyPrint);
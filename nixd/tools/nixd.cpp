@@ -9,6 +9,8 @@
 #include <llvm/ADT/ArrayRef.h>
 #include <llvm/Support/CommandLine.h>
 
+#include <csignal>
+
 using namespace lspserver;
 using namespace nixd;
 
@@ -67,6 +69,10 @@ int main(int argc, char *argv[]) {
     PrettyPrint = true;
   }
 
+  // Workers may die at any time (e.g. killed on memory pressure). Writing to
+  // them should fail, instead of killing us.
+  signal(SIGPIPE, SIG_IGN);
+
   StreamLogger Logger(llvm::errs(), LogLevel);
   LoggingSession Session(Logger);
 